@@ -0,0 +1,150 @@
+/* evtbench.c: event queue benchmark
+
+   This is a minimal simulator built on the SCP package, whose only purpose
+   is to time the event queue.  Its "CPU" just counts down sim_interval, as
+   a real CPU does; each of NUNITS units reschedules itself with a pseudo-
+   random delay every time it fires, so the queue always holds NUNITS
+   entries.  RUN stops after EVENTS events and prints the cost per event.
+
+   Typical use (see evtbench.ini):
+
+        d nunits 1000
+        run
+*/
+
+#include "sim_defs.h"
+
+#define EVB_MAXU        16384                           /* max units */
+
+extern int32 sim_interval;
+
+uint32 evb_nunits = 1000;                               /* units in use */
+uint32 evb_events = 2000000;                            /* events per run */
+uint32 evb_count = 0;                                   /* events so far */
+uint32 evb_seed = 1;                                    /* random state */
+UNIT evb_unit[EVB_MAXU];
+
+t_stat evb_svc (UNIT *uptr);
+t_stat evb_reset (DEVICE *dptr);
+
+/* Benchmark data structures
+
+   evb_dev      device descriptor
+   evb_unit     unit descriptors
+   evb_reg      register list
+*/
+
+REG evb_reg[] = {
+    { DRDATA (COUNT, evb_count, 32), PV_LEFT },
+    { DRDATA (NUNITS, evb_nunits, 15), PV_LEFT + REG_NZ },
+    { DRDATA (EVENTS, evb_events, 32), PV_LEFT + REG_NZ },
+    { DRDATA (SEED, evb_seed, 32), PV_LEFT },
+    { NULL }
+    };
+
+DEVICE evb_dev = {
+    "EVB", evb_unit, evb_reg, NULL,
+    EVB_MAXU, 10, 31, 1, 8, 8,
+    NULL, NULL, &evb_reset,
+    NULL, NULL, NULL,
+    NULL, 0
+    };
+
+/* SCP data structures and interface routines */
+
+char sim_name[] = "Event queue benchmark";
+
+REG *sim_PC = &evb_reg[0];
+
+int32 sim_emax = 1;
+
+DEVICE *sim_devices[] = {
+    &evb_dev,
+    NULL
+    };
+
+const char *sim_stop_messages[] = {
+    "Unknown error",
+    "Benchmark done"
+    };
+
+#define STOP_DONE       1
+
+/* Delay for the next event of a unit: uniform in 1..8*nunits, so that
+   on average an event falls due every 4 "instructions" */
+
+static int32 evb_delay (void)
+{
+evb_seed = evb_seed * 1103515245 + 12345;
+return 1 + (int32) ((evb_seed >> 8) % (evb_nunits * 8));
+}
+
+/* Instruction loop */
+
+t_stat sim_instr (void)
+{
+uint32 i, ms;
+t_stat reason = 0;
+
+if ((evb_nunits == 0) || (evb_nunits > EVB_MAXU))
+    return SCPE_ARG;
+for (i = 0; i < evb_nunits; i++)                        /* fill the queue */
+    sim_activate (&evb_unit[i], evb_delay ());
+evb_count = 0;
+ms = sim_os_msec ();
+while (reason == 0) {
+    if (sim_interval <= 0) {                            /* events due? */
+        if ((reason = sim_process_event ()))
+            break;
+        if (evb_count >= evb_events)
+            reason = STOP_DONE;
+        }
+    sim_interval = sim_interval - 1;
+    }
+ms = sim_os_msec () - ms;
+printf ("%5d units: %d events in %d ms, %.1f ns/event\n",
+    evb_nunits, evb_count, ms,
+    ((double) ms * 1000000.0) / (double) (evb_count? evb_count: 1));
+for (i = 0; i < evb_nunits; i++)                        /* empty the queue */
+    sim_cancel (&evb_unit[i]);
+return reason;
+}
+
+/* Unit service - count and reschedule */
+
+t_stat evb_svc (UNIT *uptr)
+{
+evb_count = evb_count + 1;
+return sim_activate (uptr, evb_delay ());
+}
+
+/* Reset routine */
+
+t_stat evb_reset (DEVICE *dptr)
+{
+int32 i;
+
+for (i = 0; i < EVB_MAXU; i++) {
+    sim_cancel (&evb_unit[i]);
+    evb_unit[i].action = &evb_svc;
+    }
+return SCPE_OK;
+}
+
+/* Loader and symbolic input/output are not supported */
+
+t_stat sim_load (FILE *fileref, char *cptr, char *fnam, int flag)
+{
+return SCPE_NOFNC;
+}
+
+t_stat fprint_sym (FILE *of, t_addr addr, t_value *val,
+    UNIT *uptr, int32 sw)
+{
+return SCPE_ARG;
+}
+
+t_stat parse_sym (char *cptr, t_addr addr, UNIT *uptr, t_value *val, int32 sw)
+{
+return SCPE_ARG;
+}
@@ -241,6 +241,11 @@
 #define HIST_VLD        1                               /* make PC odd */
 #define HIST_ILNT       4                               /* max inst length */
 
+#define PROF_MAX        (1u << 20)                      /* max sample interval */
+#define PROF_SHOW       20                              /* default hot spots */
+#define PROF_NCLS       12                              /* opcode classes */
+#define PROF_NOPC       (1u << 13)                      /* opcode bins, IR<15:3> */
+
 typedef struct {
     uint16              pc;
     uint16              psw;
@@ -249,6 +254,33 @@ typedef struct {
     uint16              inst[HIST_ILNT];
     } InstHistory;
 
+#define PDC_SIZE        (1u << 16)                      /* predecode entries, 2**n */
+#define PDC_MASK        (PDC_SIZE - 1)
+#define PDC_TAG(pa)     ((((uint32) (pa)) >> 1) + 1)     /* word addr + 1, 0 = empty */
+#define PDC_INVAL(pa)   if (pdc_active) { \
+                            PDCENT *ep = &pdc[((pa) >> 1) & PDC_MASK]; \
+                            if (ep->tag == PDC_TAG (pa)) \
+                                ep->tag = 0; \
+                            }
+
+#define TLB_RD          1                               /* TLB entry readable */
+#define TLB_WR          2                               /* TLB entry writeable */
+
+typedef void (*PDCOP) (int32 IR);                       /* predecoded handler */
+
+typedef struct {
+    uint32              tag;                            /* physical word tag */
+    int32               ir;                             /* instruction */
+    PDCOP               op;                             /* handler, NULL = classic */
+    } PDCENT;
+
+typedef struct {
+    int32               acc;                            /* TLB_RD, TLB_WR */
+    int32               lo;                             /* lowest valid offset */
+    uint32              span;                           /* valid offsets - 1 */
+    int32               base;                           /* pa of offset 0 */
+    } TLBENT;
+
 /* Global state */
 
 extern FILE *sim_log;
@@ -298,6 +330,23 @@ jmp_buf save_env;                                       /* abort handler */
 int32 hst_p = 0;                                        /* history pointer */
 int32 hst_lnt = 0;                                      /* history length */
 InstHistory *hst = NULL;                                /* instruction history */
+int32 cpu_pdc = 0;                                      /* predecode enable */
+int32 pdc_active = 0;                                   /* predecode in use */
+PDCENT *pdc = NULL;                                     /* predecode cache */
+TLBENT tlb[64];                                         /* translation cache */
+t_uint64 tlb_hit = 0, tlb_miss = 0;                     /* TLB statistics */
+int32 prof_ival = 0;                                    /* profile interval */
+int32 prof_cnt = 0;                                     /* instr to next sample */
+t_uint64 *prof_pc = NULL;                               /* samples per word */
+uint32 prof_lnt = 0;                                    /* words profiled */
+t_uint64 prof_tot = 0;                                  /* total samples */
+t_uint64 prof_nxm = 0;                                  /* samples outside M */
+t_uint64 prof_ipl[8];                                   /* samples per IPL */
+t_uint64 prof_mode[4];                                  /* samples per mode */
+t_uint64 prof_opc[PROF_NOPC];                           /* samples per IR<15:3> */
+uint32 perf_msec = 0;                                   /* run time, msec */
+double perf_inst = 0;                                   /* instructions run */
+t_uint64 perf_dma = 0;                                  /* bytes moved by DMA */
 int32 dsmask[4] = { MMR3_KDS, MMR3_SDS, 0, MMR3_UDS };  /* dspace enables */
 t_addr cpu_memsize = INIMEMSIZE;                        /* last mem addr */
 
@@ -315,10 +364,21 @@ extern CPUTAB cpu_tab[];
 
 t_stat cpu_ex (t_value *vptr, t_addr addr, UNIT *uptr, int32 sw);
 t_stat cpu_dep (t_value val, t_addr addr, UNIT *uptr, int32 sw);
+void *cpu_membuf (UNIT *uptr, t_addr *lnt);
 t_stat cpu_reset (DEVICE *dptr);
 t_stat cpu_set_hist (UNIT *uptr, int32 val, char *cptr, void *desc);
 t_stat cpu_show_hist (FILE *st, UNIT *uptr, int32 val, void *desc);
 t_stat cpu_show_virt (FILE *st, UNIT *uptr, int32 val, void *desc);
+t_stat cpu_set_pdc (UNIT *uptr, int32 val, char *cptr, void *desc);
+t_stat cpu_show_pdc (FILE *st, UNIT *uptr, int32 val, void *desc);
+t_stat cpu_show_tlb (FILE *st, UNIT *uptr, int32 val, void *desc);
+t_stat cpu_show_perf (FILE *st, UNIT *uptr, int32 val, void *desc);
+t_stat cpu_set_prof (UNIT *uptr, int32 val, char *cptr, void *desc);
+t_stat cpu_show_prof (FILE *st, UNIT *uptr, int32 val, void *desc);
+void cpu_prof_sample (void);
+static PDCENT *pdc_fetch (int32 va);
+PDCOP pdc_decode (int32 IR);
+void pdc_flush (void);
 int32 GeteaB (int32 spec);
 int32 GeteaW (int32 spec);
 int32 relocR (int32 addr);
@@ -327,6 +387,8 @@ void relocR_test (int32 va, int32 apridx);
 void relocW_test (int32 va, int32 apridx);
 t_bool PLF_test (int32 va, int32 apr);
 void reloc_abort (int32 err, int32 apridx);
+void tlb_fill (int32 apridx);
+void tlb_flush (void);
 int32 ReadE (int32 addr);
 int32 ReadW (int32 addr);
 int32 ReadB (int32 addr);
@@ -622,6 +684,18 @@ MTAB cpu_mod[] = {
       &set_autocon, NULL },
     { MTAB_XTD|MTAB_VDV|MTAB_NMO|MTAB_SHP, 0, "HISTORY", "HISTORY",
       &cpu_set_hist, &cpu_show_hist },
+    { MTAB_XTD|MTAB_VDV, 1, "PREDECODE", "PREDECODE",
+      &cpu_set_pdc, &cpu_show_pdc },
+    { MTAB_XTD|MTAB_VDV, 0, NULL, "NOPREDECODE",
+      &cpu_set_pdc, NULL },
+    { MTAB_XTD|MTAB_VDV, 0, "TLB", NULL,
+      NULL, &cpu_show_tlb },
+    { MTAB_XTD|MTAB_VDV|MTAB_NMO, 0, "PERFORMANCE", NULL,
+      NULL, &cpu_show_perf },
+    { MTAB_XTD|MTAB_VDV|MTAB_NMO|MTAB_SHP, 1, "PROFILE", "PROFILE",
+      &cpu_set_prof, &cpu_show_prof },
+    { MTAB_XTD|MTAB_VDV, 0, NULL, "NOPROFILE",
+      &cpu_set_prof, NULL },
     { MTAB_XTD|MTAB_VDV|MTAB_NMO|MTAB_SHP, 0, "VIRTUAL", NULL,
       NULL, &cpu_show_virt },
     { 0 }
@@ -633,7 +707,8 @@ DEVICE cpu_dev = {
     &cpu_ex, &cpu_dep, &cpu_reset,
     NULL, NULL, NULL,
     NULL, DEV_DYNM | DEV_DEBUG, 0,
-    NULL, &cpu_set_size, NULL
+    NULL, &cpu_set_size, NULL,
+    &cpu_membuf
     };
 
 t_stat sim_instr (void)
@@ -641,6 +716,8 @@ t_stat sim_instr (void)
 int abortval, i;
 volatile int32 trapea;                                  /* used by setjmp */
 t_stat reason;
+uint32 start_msec;
+double start_inst;
 
 /* Restore register state
 
@@ -666,9 +743,16 @@ for (i = 0; i < 6; i++)
 SP = STACKFILE[cm];
 isenable = calc_is (cm);
 dsenable = calc_ds (cm);
+tlb_flush ();                                           /* APRs may have changed */
 put_PIRQ (PIRQ);                                        /* rewrite PIRQ */
 STKLIM = STKLIM & STKLIM_RW;                            /* clean up STKLIM */
 MMR0 = MMR0 | MMR0_IC;                                  /* usually on */
+pdc_active = cpu_pdc && (pdc != NULL) &&                /* predecode usable? */
+    (hst_lnt == 0) && !(sim_deb && cpu_dev.dctrl);
+if (pdc_active)
+    pdc_flush ();                                       /* mem may have changed */
+start_msec = sim_os_msec ();                            /* start of run */
+start_inst = sim_gtime ();
 
 trap_req = calc_ints (ipl, trap_req);                   /* upd int req */
 trapea = 0;
@@ -823,8 +907,22 @@ while (reason == 0)  {
         MMR1 = 0;
         MMR2 = PC;
         }
-    IR = ReadE (PC | isenable);                         /* fetch instruction */
-    sim_interval = sim_interval - 1;
+    if (prof_ival && (--prof_cnt <= 0))                 /* profile sample? */
+        cpu_prof_sample ();
+    if (pdc_active) {                                   /* predecoded? */
+        PDCENT *ep = pdc_fetch (PC | isenable);
+        sim_interval = sim_interval - 1;
+        if (ep->op) {                                   /* have handler? */
+            PC = (PC + 2) & 0177777;
+            ep->op (ep->ir);
+            continue;
+            }
+        IR = ep->ir;                                    /* no, classic path */
+        }
+    else {
+        IR = ReadE (PC | isenable);                     /* fetch instruction */
+        sim_interval = sim_interval - 1;
+        }
     srcspec = (IR >> 6) & 077;                          /* src, dst specs */
     dstspec = IR & 077;
     srcreg = (srcspec <= 07);                           /* src, dst = rmode? */
@@ -930,6 +1028,7 @@ while (reason == 0)  {
                     MMR0 = 0;                           /* clear MMR0 */
                     MMR3 = 0;                           /* clear MMR3 */
                     cpu_bme = 0;                        /* (also clear bme) */
+                    tlb_flush ();                       /* mmgt now off */
                     for (i = 0; i < IPL_HLVL; i++)
                         int_req[i] = 0;
                     trap_req = trap_req & ~TRAP_INT;
@@ -2148,9 +2247,675 @@ STACKFILE[cm] = SP;
 saved_PC = PC & 0177777;
 pcq_r->qptr = pcq_p;                                    /* update pc q ptr */
 set_r_display (rs, cm);
+perf_msec = perf_msec + (sim_os_msec () - start_msec);  /* account run */
+perf_inst = perf_inst + (sim_gtime () - start_inst);
 return reason;
 }
 
+/* Predecoded instruction cache
+
+   The cache is a direct mapped table indexed by the physical word address
+   of an instruction.  Each entry holds the instruction word and a pointer
+   to a routine that executes it without going through the opcode decode
+   cascade in sim_instr.  Only the most frequent instructions have such
+   routines; the rest have a NULL handler and fall through to the classic
+   interpreter with the already fetched instruction word.
+
+   Because the cache is keyed by physical address, the fetch still goes
+   through relocR, so changes to the memory management registers and the
+   PSW mode do not require invalidation.  Entries are invalidated on every
+   write to memory: by the CPU (WriteW, WriteB, PWriteW, PWriteB) and by
+   DMA (Map_WriteB, Map_WriteW, mba_wrbufW).  Writes done while the CPU is
+   stopped (deposits, bootstraps, memory resizing) are covered by flushing
+   the cache at the start of sim_instr.
+
+   The handlers below must stay in step with the corresponding cases of
+   the classic interpreter.
+*/
+
+static void pdc_br (int32 IR);
+static void pdc_bne (int32 IR);
+static void pdc_beq (int32 IR);
+static void pdc_bge (int32 IR);
+static void pdc_blt (int32 IR);
+static void pdc_bgt (int32 IR);
+static void pdc_ble (int32 IR);
+static void pdc_bpl (int32 IR);
+static void pdc_bmi (int32 IR);
+static void pdc_bhi (int32 IR);
+static void pdc_blos (int32 IR);
+static void pdc_bvc (int32 IR);
+static void pdc_bvs (int32 IR);
+static void pdc_bcc (int32 IR);
+static void pdc_bcs (int32 IR);
+static void pdc_jmp (int32 IR);
+static void pdc_rts (int32 IR);
+static void pdc_jsr (int32 IR);
+static void pdc_sob (int32 IR);
+static void pdc_clr (int32 IR);
+static void pdc_inc (int32 IR);
+static void pdc_dec (int32 IR);
+static void pdc_tst (int32 IR);
+static void pdc_clrb (int32 IR);
+static void pdc_tstb (int32 IR);
+static void pdc_mov (int32 IR);
+static void pdc_cmp (int32 IR);
+static void pdc_bit (int32 IR);
+static void pdc_bic (int32 IR);
+static void pdc_bis (int32 IR);
+static void pdc_add (int32 IR);
+static void pdc_sub (int32 IR);
+static void pdc_movb (int32 IR);
+static void pdc_cmpb (int32 IR);
+static void pdc_bitb (int32 IR);
+static void pdc_bicb (int32 IR);
+static void pdc_bisb (int32 IR);
+
+/* Fetch instruction through the predecode cache */
+
+static PDCENT *pdc_fetch (int32 va)
+{
+static PDCENT pdc_io;
+int32 pa, data;
+PDCENT *ep;
+
+if ((va & 1) && CPUT (HAS_ODD)) {                       /* odd address? */
+    setCPUERR (CPUE_ODD);
+    ABORT (TRAP_ODD);
+    }
+pa = relocR (va);                                       /* relocate */
+if (ADDR_IS_MEM (pa)) {                                 /* memory address? */
+    ep = &pdc[(pa >> 1) & PDC_MASK];
+    if (ep->tag != PDC_TAG (pa)) {                      /* miss? */
+        ep->tag = PDC_TAG (pa);
+        ep->ir = M[pa >> 1];
+        ep->op = pdc_decode (ep->ir);
+        }
+    return ep;
+    }
+if ((pa < IOPAGEBASE) ||                                /* not I/O address */
+    (CPUT (CPUT_J) && (pa >= IOBA_CPU))) {              /* or J11 int reg? */
+        setCPUERR (CPUE_NXM);
+        ABORT (TRAP_NXM);
+        }
+if (iopageR (&data, pa, READ) != SCPE_OK) {             /* invalid I/O addr? */
+    setCPUERR (CPUE_TMO);
+    ABORT (TRAP_NXM);
+    }
+pdc_io.ir = data;                                       /* never cached */
+pdc_io.op = pdc_decode (data);
+return &pdc_io;
+}
+
+/* Invalidate predecoded entries for a range of physical memory */
+
+void cpu_pdc_inval (uint32 pa, int32 bc)
+{
+uint32 wa, lim;
+PDCENT *ep;
+
+if (!pdc_active)
+    return;
+lim = (pa + bc + 1) >> 1;
+for (wa = pa >> 1; wa < lim; wa++) {
+    ep = &pdc[wa & PDC_MASK];
+    if (ep->tag == wa + 1)
+        ep->tag = 0;
+    }
+return;
+}
+
+/* Flush the whole predecode cache */
+
+void pdc_flush (void)
+{
+if (pdc)
+    memset (pdc, 0, PDC_SIZE * sizeof (PDCENT));
+return;
+}
+
+/* Select handler for an instruction, NULL for the classic interpreter */
+
+PDCOP pdc_decode (int32 IR)
+{
+switch ((IR >> 12) & 017) {                             /* decode IR<15:12> */
+
+    case 000:
+        switch ((IR >> 6) & 077) {                      /* decode IR<11:6> */
+        case 001:                                       /* JMP */
+            return &pdc_jmp;
+        case 002:                                       /* RTS */
+            return (IR < 000210)? &pdc_rts: NULL;
+        case 004: case 005: case 006: case 007:         /* BR */
+            return &pdc_br;
+        case 010: case 011: case 012: case 013:         /* BNE */
+            return &pdc_bne;
+        case 014: case 015: case 016: case 017:         /* BEQ */
+            return &pdc_beq;
+        case 020: case 021: case 022: case 023:         /* BGE */
+            return &pdc_bge;
+        case 024: case 025: case 026: case 027:         /* BLT */
+            return &pdc_blt;
+        case 030: case 031: case 032: case 033:         /* BGT */
+            return &pdc_bgt;
+        case 034: case 035: case 036: case 037:         /* BLE */
+            return &pdc_ble;
+        case 040: case 041: case 042: case 043:         /* JSR */
+        case 044: case 045: case 046: case 047:
+            return &pdc_jsr;
+        case 050:                                       /* CLR */
+            return &pdc_clr;
+        case 052:                                       /* INC */
+            return &pdc_inc;
+        case 053:                                       /* DEC */
+            return &pdc_dec;
+        case 057:                                       /* TST */
+            return &pdc_tst;
+            }
+        return NULL;
+
+    case 001:                                           /* MOV */
+        return &pdc_mov;
+    case 002:                                           /* CMP */
+        return &pdc_cmp;
+    case 003:                                           /* BIT */
+        return &pdc_bit;
+    case 004:                                           /* BIC */
+        return &pdc_bic;
+    case 005:                                           /* BIS */
+        return &pdc_bis;
+    case 006:                                           /* ADD */
+        return &pdc_add;
+
+    case 007:
+        return (((IR >> 9) & 07) == 7)? &pdc_sob: NULL; /* SOB */
+
+    case 010:
+        switch ((IR >> 6) & 077) {                      /* decode IR<11:6> */
+        case 000: case 001: case 002: case 003:         /* BPL */
+            return &pdc_bpl;
+        case 004: case 005: case 006: case 007:         /* BMI */
+            return &pdc_bmi;
+        case 010: case 011: case 012: case 013:         /* BHI */
+            return &pdc_bhi;
+        case 014: case 015: case 016: case 017:         /* BLOS */
+            return &pdc_blos;
+        case 020: case 021: case 022: case 023:         /* BVC */
+            return &pdc_bvc;
+        case 024: case 025: case 026: case 027:         /* BVS */
+            return &pdc_bvs;
+        case 030: case 031: case 032: case 033:         /* BCC */
+            return &pdc_bcc;
+        case 034: case 035: case 036: case 037:         /* BCS */
+            return &pdc_bcs;
+        case 050:                                       /* CLRB */
+            return &pdc_clrb;
+        case 057:                                       /* TSTB */
+            return &pdc_tstb;
+            }
+        return NULL;
+
+    case 011:                                           /* MOVB */
+        return &pdc_movb;
+    case 012:                                           /* CMPB */
+        return &pdc_cmpb;
+    case 013:                                           /* BITB */
+        return &pdc_bitb;
+    case 014:                                           /* BICB */
+        return &pdc_bicb;
+    case 015:                                           /* BISB */
+        return &pdc_bisb;
+    case 016:                                           /* SUB */
+        return &pdc_sub;
+        }
+return NULL;
+}
+
+/* Branches: the displacement sign selects forward or backward */
+
+#define PDC_BRANCH(nm,cond) \
+    static void nm (int32 IR) \
+    { \
+    if (cond) { \
+        if (IR & 0200) { \
+            BRANCH_B (IR); \
+            } \
+        else { \
+            BRANCH_F (IR); \
+            } \
+        } \
+    }
+
+PDC_BRANCH (pdc_br, 1)
+PDC_BRANCH (pdc_bne, Z == 0)
+PDC_BRANCH (pdc_beq, Z)
+PDC_BRANCH (pdc_bge, (N ^ V) == 0)
+PDC_BRANCH (pdc_blt, N ^ V)
+PDC_BRANCH (pdc_bgt, (Z | (N ^ V)) == 0)
+PDC_BRANCH (pdc_ble, Z | (N ^ V))
+PDC_BRANCH (pdc_bpl, N == 0)
+PDC_BRANCH (pdc_bmi, N)
+PDC_BRANCH (pdc_bhi, (C | Z) == 0)
+PDC_BRANCH (pdc_blos, C | Z)
+PDC_BRANCH (pdc_bvc, V == 0)
+PDC_BRANCH (pdc_bvs, V)
+PDC_BRANCH (pdc_bcc, C == 0)
+PDC_BRANCH (pdc_bcs, C)
+
+/* Jumps and subroutine linkage */
+
+static void pdc_jmp (int32 IR)
+{
+int32 dstspec = IR & 077;
+int32 dst;
+
+if (dstspec <= 07)
+    setTRAP (CPUT (HAS_JREG4)? TRAP_PRV: TRAP_ILL);
+else {
+    dst = GeteaW (dstspec) & 0177777;                   /* get eff addr */
+    if (CPUT (CPUT_05|CPUT_20) &&                       /* 11/05, 11/20 */
+        ((dstspec & 070) == 020))                       /* JMP (R)+? */
+        dst = R[dstspec & 07];                          /* use post incr */
+    JMP_PC (dst);
+    }
+}
+
+static void pdc_rts (int32 IR)
+{
+int32 dstspec = IR & 07;
+
+JMP_PC (R[dstspec]);
+R[dstspec] = ReadW (SP | dsenable);
+if (dstspec != 6)
+    SP = (SP + 2) & 0177777;
+}
+
+static void pdc_jsr (int32 IR)
+{
+int32 srcspec = (IR >> 6) & 07;
+int32 dstspec = IR & 077;
+int32 dst;
+
+if (dstspec <= 07)
+    setTRAP (CPUT (HAS_JREG4)? TRAP_PRV: TRAP_ILL);
+else {
+    dst = GeteaW (dstspec);
+    if (CPUT (CPUT_05|CPUT_20) &&                       /* 11/05, 11/20 */
+        ((dstspec & 070) == 020))                       /* JSR (R)+? */
+        dst = R[dstspec & 07];                          /* use post incr */
+    SP = (SP - 2) & 0177777;
+    if (update_MM)
+        MMR1 = calc_MMR1 (0366);
+    WriteW (R[srcspec], SP | dsenable);
+    if ((cm == MD_KER) && (SP < (STKLIM + STKL_Y)))
+        set_stack_trap (SP);
+    R[srcspec] = PC;
+    JMP_PC (dst & 0177777);
+    }
+}
+
+static void pdc_sob (int32 IR)
+{
+int32 srcspec = (IR >> 6) & 07;
+int32 dstspec = IR & 077;
+
+if (CPUT (HAS_SXS)) {
+    R[srcspec] = (R[srcspec] - 1) & 0177777;
+    if (R[srcspec]) {
+        JMP_PC ((PC - dstspec - dstspec) & 0177777);
+        }
+    }
+else setTRAP (TRAP_ILL);
+}
+
+/* Single operand instructions */
+
+static void pdc_clr (int32 IR)
+{
+int32 dstspec = IR & 077;
+
+N = V = C = 0;
+Z = 1;
+if (dstspec <= 07)
+    R[dstspec] = 0;
+else WriteW (0, GeteaW (dstspec));
+}
+
+static void pdc_inc (int32 IR)
+{
+int32 dstspec = IR & 077;
+int32 dstreg = (dstspec <= 07);
+int32 dst;
+
+dst = dstreg? R[dstspec]: ReadMW (GeteaW (dstspec));
+dst = (dst + 1) & 0177777;
+N = GET_SIGN_W (dst);
+Z = GET_Z (dst);
+V = (dst == 0100000);
+if (dstreg)
+    R[dstspec] = dst;
+else PWriteW (dst, last_pa);
+}
+
+static void pdc_dec (int32 IR)
+{
+int32 dstspec = IR & 077;
+int32 dstreg = (dstspec <= 07);
+int32 dst;
+
+dst = dstreg? R[dstspec]: ReadMW (GeteaW (dstspec));
+dst = (dst - 1) & 0177777;
+N = GET_SIGN_W (dst);
+Z = GET_Z (dst);
+V = (dst == 077777);
+if (dstreg)
+    R[dstspec] = dst;
+else PWriteW (dst, last_pa);
+}
+
+static void pdc_tst (int32 IR)
+{
+int32 dstspec = IR & 077;
+int32 dst;
+
+dst = (dstspec <= 07)? R[dstspec]: ReadW (GeteaW (dstspec));
+N = GET_SIGN_W (dst);
+Z = GET_Z (dst);
+V = C = 0;
+}
+
+static void pdc_clrb (int32 IR)
+{
+int32 dstspec = IR & 077;
+
+N = V = C = 0;
+Z = 1;
+if (dstspec <= 07)
+    R[dstspec] = R[dstspec] & 0177400;
+else WriteB (0, GeteaB (dstspec));
+}
+
+static void pdc_tstb (int32 IR)
+{
+int32 dstspec = IR & 077;
+int32 dst;
+
+dst = (dstspec <= 07)? R[dstspec] & 0377: ReadB (GeteaB (dstspec));
+N = GET_SIGN_B (dst);
+Z = GET_Z (dst);
+V = C = 0;
+}
+
+/* Double operand word instructions */
+
+static void pdc_mov (int32 IR)
+{
+int32 srcspec = (IR >> 6) & 077, dstspec = IR & 077;
+int32 srcreg = (srcspec <= 07), dstreg = (dstspec <= 07);
+int32 dst, ea = 0;
+
+if (CPUT (IS_SDSD) && srcreg && !dstreg) {              /* R,not R */
+    ea = GeteaW (dstspec);
+    dst = R[srcspec];
+    }
+else {
+    dst = srcreg? R[srcspec]: ReadW (GeteaW (srcspec));
+    if (!dstreg) ea = GeteaW (dstspec);
+    }
+N = GET_SIGN_W (dst);
+Z = GET_Z (dst);
+V = 0;
+if (dstreg)
+    R[dstspec] = dst;
+else WriteW (dst, ea);
+}
+
+static void pdc_cmp (int32 IR)
+{
+int32 srcspec = (IR >> 6) & 077, dstspec = IR & 077;
+int32 srcreg = (srcspec <= 07), dstreg = (dstspec <= 07);
+int32 src, src2, dst;
+
+if (CPUT (IS_SDSD) && srcreg && !dstreg) {              /* R,not R */
+    src2 = ReadW (GeteaW (dstspec));
+    src = R[srcspec];
+    }
+else {
+    src = srcreg? R[srcspec]: ReadW (GeteaW (srcspec));
+    src2 = dstreg? R[dstspec]: ReadW (GeteaW (dstspec));
+    }
+dst = (src - src2) & 0177777;
+N = GET_SIGN_W (dst);
+Z = GET_Z (dst);
+V = GET_SIGN_W ((src ^ src2) & (~src2 ^ dst));
+C = (src < src2);
+}
+
+static void pdc_bit (int32 IR)
+{
+int32 srcspec = (IR >> 6) & 077, dstspec = IR & 077;
+int32 srcreg = (srcspec <= 07), dstreg = (dstspec <= 07);
+int32 src, src2, dst;
+
+if (CPUT (IS_SDSD) && srcreg && !dstreg) {              /* R,not R */
+    src2 = ReadW (GeteaW (dstspec));
+    src = R[srcspec];
+    }
+else {
+    src = srcreg? R[srcspec]: ReadW (GeteaW (srcspec));
+    src2 = dstreg? R[dstspec]: ReadW (GeteaW (dstspec));
+    }
+dst = src2 & src;
+N = GET_SIGN_W (dst);
+Z = GET_Z (dst);
+V = 0;
+}
+
+static void pdc_bic (int32 IR)
+{
+int32 srcspec = (IR >> 6) & 077, dstspec = IR & 077;
+int32 srcreg = (srcspec <= 07), dstreg = (dstspec <= 07);
+int32 src, src2, dst;
+
+if (CPUT (IS_SDSD) && srcreg && !dstreg) {              /* R,not R */
+    src2 = ReadMW (GeteaW (dstspec));
+    src = R[srcspec];
+    }
+else {
+    src = srcreg? R[srcspec]: ReadW (GeteaW (srcspec));
+    src2 = dstreg? R[dstspec]: ReadMW (GeteaW (dstspec));
+    }
+dst = src2 & ~src;
+N = GET_SIGN_W (dst);
+Z = GET_Z (dst);
+V = 0;
+if (dstreg)
+    R[dstspec] = dst;
+else PWriteW (dst, last_pa);
+}
+
+static void pdc_bis (int32 IR)
+{
+int32 srcspec = (IR >> 6) & 077, dstspec = IR & 077;
+int32 srcreg = (srcspec <= 07), dstreg = (dstspec <= 07);
+int32 src, src2, dst;
+
+if (CPUT (IS_SDSD) && srcreg && !dstreg) {              /* R,not R */
+    src2 = ReadMW (GeteaW (dstspec));
+    src = R[srcspec];
+    }
+else {
+    src = srcreg? R[srcspec]: ReadW (GeteaW (srcspec));
+    src2 = dstreg? R[dstspec]: ReadMW (GeteaW (dstspec));
+    }
+dst = src2 | src;
+N = GET_SIGN_W (dst);
+Z = GET_Z (dst);
+V = 0;
+if (dstreg)
+    R[dstspec] = dst;
+else PWriteW (dst, last_pa);
+}
+
+static void pdc_add (int32 IR)
+{
+int32 srcspec = (IR >> 6) & 077, dstspec = IR & 077;
+int32 srcreg = (srcspec <= 07), dstreg = (dstspec <= 07);
+int32 src, src2, dst;
+
+if (CPUT (IS_SDSD) && srcreg && !dstreg) {              /* R,not R */
+    src2 = ReadMW (GeteaW (dstspec));
+    src = R[srcspec];
+    }
+else {
+    src = srcreg? R[srcspec]: ReadW (GeteaW (srcspec));
+    src2 = dstreg? R[dstspec]: ReadMW (GeteaW (dstspec));
+    }
+dst = (src2 + src) & 0177777;
+N = GET_SIGN_W (dst);
+Z = GET_Z (dst);
+V = GET_SIGN_W ((~src ^ src2) & (src ^ dst));
+C = (dst < src);
+if (dstreg)
+    R[dstspec] = dst;
+else PWriteW (dst, last_pa);
+}
+
+static void pdc_sub (int32 IR)
+{
+int32 srcspec = (IR >> 6) & 077, dstspec = IR & 077;
+int32 srcreg = (srcspec <= 07), dstreg = (dstspec <= 07);
+int32 src, src2, dst;
+
+if (CPUT (IS_SDSD) && srcreg && !dstreg) {              /* R,not R */
+    src2 = ReadMW (GeteaW (dstspec));
+    src = R[srcspec];
+    }
+else {
+    src = srcreg? R[srcspec]: ReadW (GeteaW (srcspec));
+    src2 = dstreg? R[dstspec]: ReadMW (GeteaW (dstspec));
+    }
+dst = (src2 - src) & 0177777;
+N = GET_SIGN_W (dst);
+Z = GET_Z (dst);
+V = GET_SIGN_W ((src ^ src2) & (~src ^ dst));
+C = (src2 < src);
+if (dstreg)
+    R[dstspec] = dst;
+else PWriteW (dst, last_pa);
+}
+
+/* Double operand byte instructions */
+
+static void pdc_movb (int32 IR)
+{
+int32 srcspec = (IR >> 6) & 077, dstspec = IR & 077;
+int32 srcreg = (srcspec <= 07), dstreg = (dstspec <= 07);
+int32 dst, ea = 0;
+
+if (CPUT (IS_SDSD) && srcreg && !dstreg) {              /* R,not R */
+    ea = GeteaB (dstspec);
+    dst = R[srcspec] & 0377;
+    }
+else {
+    dst = srcreg? R[srcspec] & 0377: ReadB (GeteaB (srcspec));
+    if (!dstreg) ea = GeteaB (dstspec);
+    }
+N = GET_SIGN_B (dst);
+Z = GET_Z (dst);
+V = 0;
+if (dstreg)
+    R[dstspec] = (dst & 0200)? 0177400 | dst: dst;
+else WriteB (dst, ea);
+}
+
+static void pdc_cmpb (int32 IR)
+{
+int32 srcspec = (IR >> 6) & 077, dstspec = IR & 077;
+int32 srcreg = (srcspec <= 07), dstreg = (dstspec <= 07);
+int32 src, src2, dst;
+
+if (CPUT (IS_SDSD) && srcreg && !dstreg) {              /* R,not R */
+    src2 = ReadB (GeteaB (dstspec));
+    src = R[srcspec] & 0377;
+    }
+else {
+    src = srcreg? R[srcspec] & 0377: ReadB (GeteaB (srcspec));
+    src2 = dstreg? R[dstspec] & 0377: ReadB (GeteaB (dstspec));
+    }
+dst = (src - src2) & 0377;
+N = GET_SIGN_B (dst);
+Z = GET_Z (dst);
+V = GET_SIGN_B ((src ^ src2) & (~src2 ^ dst));
+C = (src < src2);
+}
+
+static void pdc_bitb (int32 IR)
+{
+int32 srcspec = (IR >> 6) & 077, dstspec = IR & 077;
+int32 srcreg = (srcspec <= 07), dstreg = (dstspec <= 07);
+int32 src, src2, dst;
+
+if (CPUT (IS_SDSD) && srcreg && !dstreg) {              /* R,not R */
+    src2 = ReadB (GeteaB (dstspec));
+    src = R[srcspec] & 0377;
+    }
+else {
+    src = srcreg? R[srcspec] & 0377: ReadB (GeteaB (srcspec));
+    src2 = dstreg? R[dstspec] & 0377: ReadB (GeteaB (dstspec));
+    }
+dst = (src2 & src) & 0377;
+N = GET_SIGN_B (dst);
+Z = GET_Z (dst);
+V = 0;
+}
+
+static void pdc_bicb (int32 IR)
+{
+int32 srcspec = (IR >> 6) & 077, dstspec = IR & 077;
+int32 srcreg = (srcspec <= 07), dstreg = (dstspec <= 07);
+int32 src, src2, dst;
+
+if (CPUT (IS_SDSD) && srcreg && !dstreg) {              /* R,not R */
+    src2 = ReadMB (GeteaB (dstspec));
+    src = R[srcspec];
+    }
+else {
+    src = srcreg? R[srcspec]: ReadB (GeteaB (srcspec));
+    src2 = dstreg? R[dstspec]: ReadMB (GeteaB (dstspec));
+    }
+dst = (src2 & ~src) & 0377;
+N = GET_SIGN_B (dst);
+Z = GET_Z (dst);
+V = 0;
+if (dstreg)
+    R[dstspec] = (R[dstspec] & 0177400) | dst;
+else PWriteB (dst, last_pa);
+}
+
+static void pdc_bisb (int32 IR)
+{
+int32 srcspec = (IR >> 6) & 077, dstspec = IR & 077;
+int32 srcreg = (srcspec <= 07), dstreg = (dstspec <= 07);
+int32 src, src2, dst;
+
+if (CPUT (IS_SDSD) && srcreg && !dstreg) {              /* R,not R */
+    src2 = ReadMB (GeteaB (dstspec));
+    src = R[srcspec];
+    }
+else {
+    src = srcreg? R[srcspec]: ReadB (GeteaB (srcspec));
+    src2 = dstreg? R[dstspec]: ReadMB (GeteaB (dstspec));
+    }
+dst = (src2 | src) & 0377;
+N = GET_SIGN_B (dst);
+Z = GET_Z (dst);
+V = 0;
+if (dstreg)
+    R[dstspec] = (R[dstspec] & 0177400) | dst;
+else PWriteB (dst, last_pa);
+}
+
 /* Effective address calculations
 
    Inputs:
@@ -2449,6 +3214,7 @@ if (ADDR_IS_MEM (pa)) {                                 /* memory address? */
         fprintf (sim_log, "    write %06o := %06o\n", pa, data);
 #endif
     M[pa >> 1] = data;
+    PDC_INVAL (pa);
     return;
     }
 if (pa < IOPAGEBASE) {                                  /* not I/O address? */
@@ -2477,6 +3243,7 @@ if (ADDR_IS_MEM (pa)) {                                 /* memory address? */
         fprintf (sim_log, "    write %06o := %06o\n", pa, data);
 #endif
     M[pa >> 1] = data;
+    PDC_INVAL (pa);
     return;
     }
 if (pa < IOPAGEBASE) {                                  /* not I/O address? */
@@ -2499,6 +3266,7 @@ if (ADDR_IS_MEM (pa)) {                                 /* memory address? */
         fprintf (sim_log, "    write %06o := %06o\n", pa, data);
 #endif
     M[pa >> 1] = data;
+    PDC_INVAL (pa);
     return;
     }
 if (pa < IOPAGEBASE) {                                  /* not I/O address? */
@@ -2524,6 +3292,7 @@ if (ADDR_IS_MEM (pa)) {                                 /* memory address? */
         fprintf (sim_log, "    write %06o := %06o\n", pa, data);
 #endif
     M[pa >> 1] = data;
+    PDC_INVAL (pa);
     return;
     }
 if (pa < IOPAGEBASE) {                                  /* not I/O address? */
@@ -2556,10 +3325,18 @@ return;
 int32 relocR (int32 va)
 {
 int32 apridx, apr, pa;
+TLBENT *tp;
 
 if (MMR0 & MMR0_MME) {                                  /* if mmgt */
     apridx = (va >> VA_V_APF) & 077;                    /* index into APR */
-    apr = APRFILE[apridx];                              /* with va<18:13> */
+    tp = &tlb[apridx];                                  /* with va<18:13> */
+    if ((tp->acc & TLB_RD) &&                           /* cached, in range? */
+        ((uint32) ((va & VA_DF) - tp->lo) <= tp->span)) {
+        tlb_hit++;
+        return tp->base + (va & VA_DF);
+        }
+    tlb_miss++;
+    apr = APRFILE[apridx];
     if ((apr & PDR_PRD) != 2)                           /* not 2, 6? */
          relocR_test (va, apridx);                      /* long test */
     if (PLF_test (va, apr))                             /* pg lnt error? */
@@ -2570,6 +3347,7 @@ if (MMR0 & MMR0_MME) {                                  /* if mmgt */
         if (pa >= 0760000)
             pa = 017000000 | pa;
         }
+    tlb_fill (apridx);
     }
 else {
     pa = va & 0177777;                                  /* mmgt off */
@@ -2663,10 +3441,18 @@ return;
 int32 relocW (int32 va)
 {
 int32 apridx, apr, pa;
+TLBENT *tp;
 
 if (MMR0 & MMR0_MME) {                                  /* if mmgt */
     apridx = (va >> VA_V_APF) & 077;                    /* index into APR */
-    apr = APRFILE[apridx];                              /* with va<18:13> */
+    tp = &tlb[apridx];                                  /* with va<18:13> */
+    if ((tp->acc & TLB_WR) &&                           /* cached, in range? */
+        ((uint32) ((va & VA_DF) - tp->lo) <= tp->span)) {
+        tlb_hit++;
+        return tp->base + (va & VA_DF);
+        }
+    tlb_miss++;
+    apr = APRFILE[apridx];
     if ((apr & PDR_ACF) != 6)                           /* not writeable? */
         relocW_test (va, apridx);                       /* long test */
     if (PLF_test (va, apr))                             /* pg lnt error? */
@@ -2678,6 +3464,7 @@ if (MMR0 & MMR0_MME) {                                  /* if mmgt */
         if (pa >= 0760000)
             pa = 017000000 | pa;
         }
+    tlb_fill (apridx);
     }
 else {
     pa = va & 0177777;                                  /* mmgt off */
@@ -2737,6 +3524,60 @@ reloc_abort (err, apridx);
 return;
 }
 
+/* Translation cache
+
+   With memory management on, the TLB caches, for each APR index (mode,
+   I/D space, page), the result of relocation for the ordinary cases: a
+   page that is plainly readable (ACF 2 or 6) and, for writes, plainly
+   writeable (ACF 6) with the W bit already set, and whose valid range
+   does not wrap or hit the 18b I/O page remapping.  A hit is then a
+   range check and an add.  Everything else (trap pages, aborts, page
+   length errors) misses and takes the full path in relocR/relocW, which
+   refills the entry.
+
+   Since the index includes the mode and I/D space, PSW mode changes need
+   no flush.  The TLB is flushed when MMR0 or MMR3 is written, on RESET
+   and on entry to sim_instr; an entry is dropped when its APR is written.
+*/
+
+void tlb_fill (int32 apridx)
+{
+TLBENT *tp = &tlb[apridx];
+int32 apr = APRFILE[apridx];
+int32 lo, hi, base;
+
+tp->acc = 0;
+if ((apr & PDR_PRD) != 2)                               /* not 2, 6? */
+    return;
+if (apr & PDR_ED) {                                     /* expand down? */
+    lo = (apr & PDR_PLF) >> 2;
+    hi = VA_DF;
+    }
+else {
+    lo = 0;
+    hi = ((apr & PDR_PLF) >> 2) | (VA_DF & ~VA_BN);
+    }
+base = (apr >> 10) & 017777700;
+if ((base + hi) >= ((MMR3 & MMR3_M22E)? MAXMEMSIZE: 0760000))
+    return;                                             /* wraps or I/O */
+tp->lo = lo;
+tp->span = hi - lo;
+tp->base = base;
+tp->acc = TLB_RD;
+if (((apr & PDR_ACF) == 6) && (apr & PDR_W))            /* writeable, W set? */
+    tp->acc = TLB_RD | TLB_WR;
+return;
+}
+
+void tlb_flush (void)
+{
+int32 i;
+
+for (i = 0; i < 64; i++)
+    tlb[i].acc = 0;
+return;
+}
+
 /* Relocate virtual address, console access
 
    Inputs:
@@ -2828,6 +3669,7 @@ switch ((pa >> 1) & 3) {                                /* decode pa<2:1> */
             data = (pa & 1)? (MMR0 & 0377) | (data << 8): (MMR0 & ~0377) | data;
         data = data & cpu_tab[cpu_model].mm0;
         MMR0 = (MMR0 & ~MMR0_WR) | (data & MMR0_WR);
+        tlb_flush ();
         return SCPE_OK;
 
     default:                                            /* MMR1, MMR2 */
@@ -2848,6 +3690,7 @@ if (pa & 1)
 MMR3 = data & cpu_tab[cpu_model].mm3;
 cpu_bme = (MMR3 & MMR3_BME) && (cpu_opt & OPT_UBM);
 dsenable = calc_ds (cm);
+tlb_flush ();
 return SCPE_OK;
 }
 
@@ -2905,6 +3748,7 @@ if (left)
         (((uint32) (data & cpu_tab[cpu_model].par)) << 16)) & ~(PDR_A|PDR_W);
 else APRFILE[idx] = ((APRFILE[idx] & ~0177777) |
     (data & cpu_tab[cpu_model].pdr)) & ~(PDR_A|PDR_W);
+tlb[idx].acc = 0;                                       /* drop TLB entry */
 return SCPE_OK;
 }
 
@@ -3067,6 +3911,11 @@ MMR2 = 0;
 MMR3 = 0;
 trap_req = 0;
 wait_state = 0;
+tlb_flush ();
+tlb_hit = tlb_miss = 0;
+perf_msec = 0;
+perf_inst = 0;
+perf_dma = 0;
 if (M == NULL)
     M = (uint16 *) calloc (MEMSIZE >> 1, sizeof (uint16));
 if (M == NULL)
@@ -3127,6 +3976,14 @@ if (addr < IOPAGEBASE)
 return iopageW ((int32) val, addr, WRITEC);
 }
 
+/* Memory block for fast snapshots */
+
+void *cpu_membuf (UNIT *uptr, t_addr *lnt)
+{
+*lnt = MEMSIZE;
+return M;
+}
+
 /* Set R, SP register display addresses */
 
 void set_r_display (int32 rs, int32 cm)
@@ -3220,6 +4077,294 @@ for (k = 0; k < lnt; k++) {                             /* print specified */
 return SCPE_OK;
 }
 
+/* Set predecode cache */
+
+t_stat cpu_set_pdc (UNIT *uptr, int32 val, char *cptr, void *desc)
+{
+if (cptr != NULL)
+    return SCPE_ARG;
+if (val && (pdc == NULL)) {
+    pdc = (PDCENT *) calloc (PDC_SIZE, sizeof (PDCENT));
+    if (pdc == NULL)
+        return SCPE_MEM;
+    }
+cpu_pdc = val;
+return SCPE_OK;
+}
+
+/* Show predecode cache */
+
+t_stat cpu_show_pdc (FILE *st, UNIT *uptr, int32 val, void *desc)
+{
+fprintf (st, "predecode ");
+fprintf (st, cpu_pdc? "enabled": "disabled");
+return SCPE_OK;
+}
+
+/* Show TLB statistics */
+
+t_stat cpu_show_tlb (FILE *st, UNIT *uptr, int32 val, void *desc)
+{
+double tot = (double) tlb_hit + (double) tlb_miss;
+
+fprintf (st, "TLB hits=%.0f, misses=%.0f", (double) tlb_hit, (double) tlb_miss);
+if (tot > 0)
+    fprintf (st, " (%.1f%% hit)", ((double) tlb_hit * 100.0) / tot);
+return SCPE_OK;
+}
+
+/* Show performance
+
+   Wall clock time spent in sim_instr since the last reset, the simulated
+   time it covered (one unit per instruction; a WAIT counts the time to
+   the next event), and the bytes moved through Map_ReadB..Map_WriteW.
+   Used by the benchmarks in bench/.
+*/
+
+t_stat cpu_show_perf (FILE *st, UNIT *uptr, int32 val, void *desc)
+{
+double sec = (double) perf_msec / 1000.0;
+
+fprintf (st, "Elapsed %.3f sec, %.0f instructions", sec, perf_inst);
+if (perf_msec)
+    fprintf (st, ", %.2f MIPS", perf_inst / sec / 1000000.0);
+fprintf (st, "\nDMA %.0f bytes", (double) perf_dma);
+if (perf_msec)
+    fprintf (st, ", %.2f MB/s", (double) perf_dma / sec / 1000000.0);
+fputc ('\n', st);
+return SCPE_OK;
+}
+
+/* Profiler
+
+   SET CPU PROFILE{=n} clears the profile and samples the PC of every
+   n'th instruction (default every one, i.e. an exact count); SET CPU
+   NOPROFILE turns sampling off and frees the histogram.  A sample is
+   charged to the physical address of the instruction, to its opcode
+   class, to the processor priority and to the current mode.  The
+   wait state is not sampled.
+
+   SHOW CPU PROFILE{=n} lists the totals and the n hottest addresses
+   (default 20, 0 for all), one per line as
+
+        physical-address  samples  percent  instruction
+
+   with the instruction decoded by fprint_sym, as in SHOW CPU HISTORY.
+   PC-relative operands are shown relative to the physical address.
+*/
+
+void cpu_prof_sample (void)
+{
+static const int32 msw[4] = {
+    SWMASK ('K'), SWMASK ('S'), SWMASK ('K'), SWMASK ('U')
+    };
+int32 pa;
+
+prof_cnt = prof_ival;                                   /* restart count */
+prof_tot = prof_tot + 1;
+prof_ipl[ipl] = prof_ipl[ipl] + 1;
+prof_mode[cm] = prof_mode[cm] + 1;
+pa = relocC (PC, msw[cm]);                              /* phys addr, no abort */
+if ((uint32) (pa >> 1) >= prof_lnt) {                   /* not in memory? */
+    prof_nxm = prof_nxm + 1;
+    return;
+    }
+prof_pc[pa >> 1] = prof_pc[pa >> 1] + 1;
+prof_opc[M[pa >> 1] >> 3] = prof_opc[M[pa >> 1] >> 3] + 1;
+return;
+}
+
+/* Opcode class of an instruction; samples are kept per IR<15:3>, and
+   every class boundary falls on a multiple of 8 */
+
+static const char *prof_cname[PROF_NCLS] = {
+    "double operand", "single operand", "branch", "jump/subroutine",
+    "trap/system", "condition code", "PSW/memory mgt", "EIS",
+    "FIS", "CIS", "floating point", "other"
+    };
+
+static int32 prof_class (int32 ir)
+{
+if (ir < 0000100)                                       /* HALT..MFPT */
+    return 4;
+if (ir < 0000210)                                       /* JMP, RTS */
+    return 3;
+if (ir < 0000230)
+    return 11;
+if (ir < 0000240)                                       /* SPL */
+    return 6;
+if (ir < 0000300)                                       /* CLx, SEx */
+    return 5;
+if (ir < 0000400)                                       /* SWAB */
+    return 1;
+if (ir < 0004000)                                       /* BR..BLE */
+    return 2;
+if (ir < 0005000)                                       /* JSR */
+    return 3;
+if (ir < 0006400)                                       /* CLR..ASL */
+    return 1;
+if (ir < 0006500)                                       /* MARK */
+    return 3;
+if (ir < 0006700)                                       /* MFPI, MTPI */
+    return 6;
+if (ir < 0007000)                                       /* SXT */
+    return 1;
+if (ir < 0010000)                                       /* CSM, TSTSET.. */
+    return 11;
+if (ir < 0070000)                                       /* MOV..ADD */
+    return 0;
+if (ir < 0075000)                                       /* MUL..XOR */
+    return 7;
+if (ir < 0075040)                                       /* FADD..FDIV */
+    return 8;
+if (ir < 0076000)
+    return 11;
+if (ir < 0077000)                                       /* CIS */
+    return 9;
+if (ir < 0104000)                                       /* SOB, BPL..BCS */
+    return 2;
+if (ir < 0105000)                                       /* EMT, TRAP */
+    return 4;
+if (ir < 0106400)                                       /* CLRB..ASLB */
+    return 1;
+if (ir < 0107000)                                       /* MTPS..MFPS */
+    return 6;
+if (ir < 0110000)
+    return 11;
+if (ir < 0170000)                                       /* MOVB..SUB */
+    return 0;
+return 10;                                              /* FP11 */
+}
+
+/* Set profile */
+
+t_stat cpu_set_prof (UNIT *uptr, int32 val, char *cptr, void *desc)
+{
+int32 i, ival;
+t_stat r;
+
+if (val == 0) {                                         /* NOPROFILE */
+    if (cptr != NULL)
+        return SCPE_ARG;
+    free (prof_pc);
+    prof_pc = NULL;
+    prof_lnt = 0;
+    prof_ival = 0;
+    return SCPE_OK;
+    }
+if (cptr != NULL) {
+    ival = (int32) get_uint (cptr, 10, PROF_MAX, &r);
+    if ((r != SCPE_OK) || (ival == 0))
+        return SCPE_ARG;
+    }
+else ival = 1;
+free (prof_pc);                                         /* (re)allocate */
+prof_lnt = (uint32) (MEMSIZE >> 1);
+prof_pc = (t_uint64 *) calloc (prof_lnt, sizeof (t_uint64));
+if (prof_pc == NULL) {
+    prof_lnt = 0;
+    prof_ival = 0;
+    return SCPE_MEM;
+    }
+prof_tot = prof_nxm = 0;
+for (i = 0; i < 8; i++)
+    prof_ipl[i] = 0;
+for (i = 0; i < 4; i++)
+    prof_mode[i] = 0;
+for (i = 0; i < PROF_NOPC; i++)
+    prof_opc[i] = 0;
+prof_ival = prof_cnt = ival;
+return SCPE_OK;
+}
+
+/* Show profile */
+
+static t_uint64 *prof_sort_base;
+
+static int prof_cmp (const void *a, const void *b)
+{
+t_uint64 ca = prof_sort_base[*(const uint32 *) a];
+t_uint64 cb = prof_sort_base[*(const uint32 *) b];
+
+if (ca != cb)
+    return (ca < cb)? 1: -1;
+return (*(const uint32 *) a < *(const uint32 *) b)? -1: 1;
+}
+
+t_stat cpu_show_prof (FILE *st, UNIT *uptr, int32 val, void *desc)
+{
+static const char *mname[4] = { "kernel", "supervisor", "undefined", "user" };
+char *cptr = (char *) desc;
+t_uint64 cls[PROF_NCLS];
+t_value ev[HIST_ILNT];
+double tot;
+uint32 i, j, nhot, lnt, *hot;
+t_stat r;
+
+if (prof_ival == 0)                                     /* enabled? */
+    return SCPE_NOFNC;
+if (cptr) {
+    lnt = (uint32) get_uint (cptr, 10, prof_lnt, &r);
+    if (r != SCPE_OK)
+        return SCPE_ARG;
+    }
+else lnt = PROF_SHOW;
+tot = (prof_tot != 0)? (double) prof_tot: 1.0;
+fprintf (st, "%.0f samples, 1 per %d instructions, %.0f outside memory\n",
+    (double) prof_tot, prof_ival, (double) prof_nxm);
+fprintf (st, "\nIPL               samples\n");
+for (i = 0; i < 8; i++) {
+    if (prof_ipl[i])
+        fprintf (st, "%-15d %12.0f %7.2f%%\n", i, (double) prof_ipl[i],
+            ((double) prof_ipl[i] * 100.0) / tot);
+    }
+fprintf (st, "\nMode              samples\n");
+for (i = 0; i < 4; i++) {
+    if (prof_mode[i])
+        fprintf (st, "%-15s %12.0f %7.2f%%\n", mname[i], (double) prof_mode[i],
+            ((double) prof_mode[i] * 100.0) / tot);
+    }
+for (i = 0; i < PROF_NCLS; i++)
+    cls[i] = 0;
+for (i = 0; i < PROF_NOPC; i++)
+    cls[prof_class (i << 3)] += prof_opc[i];
+fprintf (st, "\nClass             samples\n");
+for (i = 0; i < PROF_NCLS; i++) {
+    if (cls[i])
+        fprintf (st, "%-15s %12.0f %7.2f%%\n", prof_cname[i], (double) cls[i],
+            ((double) cls[i] * 100.0) / tot);
+    }
+for (i = nhot = 0; i < prof_lnt; i++) {                 /* count hot spots */
+    if (prof_pc[i])
+        nhot++;
+    }
+if ((lnt == 0) || (lnt > nhot))                         /* 0 = all */
+    lnt = nhot;
+if (lnt == 0)
+    return SCPE_OK;
+hot = (uint32 *) calloc (nhot, sizeof (uint32));
+if (hot == NULL)
+    return SCPE_MEM;
+for (i = j = 0; i < prof_lnt; i++) {
+    if (prof_pc[i])
+        hot[j++] = i;
+    }
+prof_sort_base = prof_pc;
+qsort (hot, nhot, sizeof (uint32), prof_cmp);           /* hottest first */
+fprintf (st, "\nPA            samples\n\n");
+for (i = 0; i < lnt; i++) {
+    for (j = 0; j < HIST_ILNT; j++)                     /* get instruction */
+        ev[j] = ((hot[i] + j) < prof_lnt)? M[hot[i] + j]: 0;
+    fprintf (st, "%08o %12.0f %7.2f%%  ", hot[i] << 1,
+        (double) prof_pc[hot[i]], ((double) prof_pc[hot[i]] * 100.0) / tot);
+    if ((fprint_sym (st, hot[i] << 1, ev, &cpu_unit, SWMASK ('M'))) > 0)
+        fprintf (st, "(undefined) %06o", (int32) ev[0]);
+    fputc ('\n', st);
+    }
+free (hot);
+return SCPE_OK;
+}
+
 /* Virtual address translation */
 
 t_stat cpu_show_virt (FILE *of, UNIT *uptr, int32 val, void *desc)
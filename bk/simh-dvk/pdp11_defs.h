@@ -851,6 +851,8 @@ t_stat mba_show_num (FILE *st, UNIT *uptr, int32 val, void *desc);
 
 int32 clk_cosched (int32 wait);
 
+void cpu_pdc_inval (uint32 pa, int32 bc);
+
 #include "pdp11_io_lib.h"
 
 #endif
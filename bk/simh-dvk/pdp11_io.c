@@ -55,6 +55,7 @@ extern int32 cpu_opt, cpu_bme;
 extern int32 trap_req, ipl;
 extern int32 cpu_log;
 extern int32 autcon_enb;
+extern t_uint64 perf_dma;
 extern int32 uba_last;
 extern FILE *sim_log;
 extern FILE *sim_deb;
@@ -280,6 +281,7 @@ int32 Map_ReadB (uint32 ba, int32 bc, uint8 *buf)
 {
 uint32 alim, lim, ma;
 
+perf_dma = perf_dma + bc;                               /* count traffic */
 ba = ba & BUSMASK;                                      /* trim address */
 lim = ba + bc;
 if (cpu_bme) {                                          /* map enabled? */
@@ -312,6 +314,7 @@ int32 Map_ReadW (uint32 ba, int32 bc, uint16 *buf)
 {
 uint32 alim, lim, ma;
 
+perf_dma = perf_dma + bc;                               /* count traffic */
 ba = (ba & BUSMASK) & ~01;                              /* trim, align addr */
 lim = ba + (bc & ~01);
 if (cpu_bme) {                                          /* map enabled? */
@@ -340,6 +343,7 @@ int32 Map_WriteB (uint32 ba, int32 bc, uint8 *buf)
 {
 uint32 alim, lim, ma;
 
+perf_dma = perf_dma + bc;                               /* count traffic */
 ba = ba & BUSMASK;                                      /* trim address */
 lim = ba + bc;
 if (cpu_bme) {                                          /* map enabled? */
@@ -350,6 +354,7 @@ if (cpu_bme) {                                          /* map enabled? */
         if (ma & 1) M[ma >> 1] = (M[ma >> 1] & 0377) |
             ((uint16) *buf++ << 8);
         else M[ma >> 1] = (M[ma >> 1] & ~0377) | *buf++;
+        cpu_pdc_inval (ma, 1);
         }
     return 0;
     }
@@ -359,6 +364,7 @@ else {                                                  /* physical */
     else if (ADDR_IS_MEM (ba))                          /* no, strt ok? */
         alim = cpu_memsize;
     else return bc;                                     /* no, err */
+    cpu_pdc_inval (ba, alim - ba);
     for ( ; ba < alim; ba++) {                          /* by bytes */
         if (ba & 1)
             M[ba >> 1] = (M[ba >> 1] & 0377) | ((uint16) *buf++ << 8);
@@ -372,6 +378,7 @@ int32 Map_WriteW (uint32 ba, int32 bc, uint16 *buf)
 {
 uint32 alim, lim, ma;
 
+perf_dma = perf_dma + bc;                               /* count traffic */
 ba = (ba & BUSMASK) & ~01;                              /* trim, align addr */
 lim = ba + (bc & ~01);
 if (cpu_bme) {                                          /* map enabled? */
@@ -380,6 +387,7 @@ if (cpu_bme) {                                          /* map enabled? */
         if (!ADDR_IS_MEM (ma))                          /* NXM? err */
             return (lim - ba);
         M[ma >> 1] = *buf++;
+        cpu_pdc_inval (ma, 2);
         }
     return 0;
     }
@@ -389,6 +397,7 @@ else {                                                  /* physical */
     else if (ADDR_IS_MEM (ba))                          /* no, strt ok? */
         alim = cpu_memsize;
     else return bc;                                     /* no, err */
+    cpu_pdc_inval (ba, alim - ba);
     for ( ; ba < alim; ba = ba + 2) {                   /* by words */
         M[ba >> 1] = *buf++;
         }
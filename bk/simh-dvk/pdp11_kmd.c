@@ -210,6 +210,7 @@ void kmd_io ()
     switch (kmd_cr & CR_CMD_MASK) {
     case CR_CMD_RD:             /* read */
         fseek (u->fileref, seek, SEEK_SET);
+        cpu_pdc_inval (addr, nbytes);
         if (sim_fread (&M[addr>>1], 1, nbytes, u->fileref) != nbytes) {
             /* Reading uninitialized media. */
             kmd_cr |= CR_ERR;
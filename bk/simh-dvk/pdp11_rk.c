@@ -202,6 +202,7 @@ void rk_go (void);
 void rk_set_done (int32 error);
 void rk_clr_done (void);
 t_stat rk_boot (int32 unitno, DEVICE *dptr);
+t_stat rk_attach (UNIT *uptr, char *cptr);
 
 /* RK11 data structures
 
@@ -270,7 +271,7 @@ DEVICE rk_dev = {
     "RK", rk_unit, rk_reg, rk_mod,
     RK_NUMDR, 8, 24, 1, 8, 16,
     NULL, NULL, &rk_reset,
-    &rk_boot, NULL, NULL,
+    &rk_boot, &rk_attach, NULL,
     &rk_dib, DEV_DISABLE | DEV_UBUS | DEV_Q18
     };
 
@@ -482,7 +483,7 @@ t_stat rk_svc (UNIT *uptr)
 int32 i, drv, err, awc, wc, cma, cda, t;
 int32 da, cyl, track, sect;
 uint32 ma;
-uint16 comp;
+uint16 comp, *xb;
 
 drv = (int32) (uptr - rk_dev.units);                    /* get drv number */
 if (uptr->FUNC == RKCS_SEEK) {                          /* seek */
@@ -521,12 +522,20 @@ if ((da + wc) > (int32) uptr->capac) {                  /* overrun? */
     rker = rker | RKER_OVR;                             /* set overrun err */
     }
 
-err = fseek (uptr->fileref, da * sizeof (int16), SEEK_SET);
+if (uptr->flags & UNIT_MMAP) {                          /* mapped image? */
+    xb = (uint16 *) uptr->filebuf + da;                 /* xfer in place */
+    err = 0;
+    }
+else {
+    xb = rkxb;                                          /* via buffer */
+    err = fseek (uptr->fileref, da * sizeof (int16), SEEK_SET);
+    }
 if (wc && (err == 0)) {                                 /* seek ok? */
     switch (uptr->FUNC) {                               /* case on function */
 
     case RKCS_READ:                                     /* read */
         if (rkcs & RKCS_FMT) {                          /* format? */
+            xb = rkxb;                                  /* not from disk */
             for (i = 0, cda = da; i < wc; i++) {        /* fill buffer with cyl #s */
                 if (cda >= (int32) uptr->capac) {       /* overrun? */
                     rker = rker | RKER_OVR;             /* set overrun err */
@@ -537,20 +546,20 @@ if (wc && (err == 0)) {                                 /* seek ok? */
                 cda = cda + RK_NUMWD;                   /* next sector */
                 }                                       /* end for wc */
             }                                           /* end if format */
-        else {                                          /* normal read */
+        else if (xb == rkxb) {                          /* normal read */
             i = fxread (rkxb, sizeof (int16), wc, uptr->fileref);
             err = ferror (uptr->fileref);               /* read file */
             for ( ; i < wc; i++)                        /* fill buf */
                 rkxb[i] = 0;
             }
         if (rkcs & RKCS_INH) {                          /* incr inhibit? */
-            if (t = Map_WriteW (ma, 2, &rkxb[wc - 1])) { /* store last */
+            if (t = Map_WriteW (ma, 2, &xb[wc - 1])) {  /* store last */
                 rker = rker | RKER_NXM;                 /* NXM? set flag */
                 wc = 0;                                 /* no transfer */
                 }
             }
         else {                                          /* normal store */
-            if (t = Map_WriteW (ma, wc << 1, rkxb)) {   /* store buf */
+            if (t = Map_WriteW (ma, wc << 1, xb)) {     /* store buf */
                 rker = rker | RKER_NXM;                 /* NXM? set flag */
                 wc = wc - t;                            /* adj wd cnt */
                 }
@@ -564,10 +573,10 @@ if (wc && (err == 0)) {                                 /* seek ok? */
                 wc = 0;                                 /* no transfer */
                 }
             for (i = 0; i < wc; i++)                    /* all words same */
-                rkxb[i] = comp;
+                xb[i] = comp;
             }
         else {                                          /* normal fetch */
-            if (t = Map_ReadW (ma, wc << 1, rkxb)) {    /* get buf */
+            if (t = Map_ReadW (ma, wc << 1, xb)) {      /* get buf */
                 rker = rker | RKER_NXM;                 /* NXM? set flg */
                 wc = wc - t;                            /* adj wd cnt */
                 }
@@ -575,27 +584,31 @@ if (wc && (err == 0)) {                                 /* seek ok? */
         if (wc) {                                       /* any xfer? */
             awc = (wc + (RK_NUMWD - 1)) & ~(RK_NUMWD - 1); /* clr to */
             for (i = wc; i < awc; i++)                  /* end of blk */
-                rkxb[i] = 0;
-            fxwrite (rkxb, sizeof (int16), awc, uptr->fileref);
-            err = ferror (uptr->fileref);
+                xb[i] = 0;
+            if (xb == rkxb) {                           /* not mapped? */
+                fxwrite (rkxb, sizeof (int16), awc, uptr->fileref);
+                err = ferror (uptr->fileref);
+                }
             }
         break;                                          /* end write */
 
     case RKCS_WCHK:                                     /* write check */
-        i = fxread (rkxb, sizeof (int16), wc, uptr->fileref);
-        if (err = ferror (uptr->fileref)) {             /* read error? */
-            wc = 0;                                     /* no transfer */
-            break;
+        if (xb == rkxb) {                               /* not mapped? */
+            i = fxread (rkxb, sizeof (int16), wc, uptr->fileref);
+            if (err = ferror (uptr->fileref)) {         /* read error? */
+                wc = 0;                                 /* no transfer */
+                break;
+                }
+            for ( ; i < wc; i++)                        /* fill buf */
+                rkxb[i] = 0;
             }
-        for ( ; i < wc; i++)                            /* fill buf */
-            rkxb[i] = 0;
         awc = wc;                                       /* save wc */
         for (wc = 0, cma = ma; wc < awc; wc++)  {       /* loop thru buf */
             if (Map_ReadW (cma, 2, &comp)) {            /* mem wd */
                 rker = rker | RKER_NXM;                 /* NXM? set flg */
                 break;
                 }
-            if (comp != rkxb[wc])  {                    /* match to disk? */
+            if (comp != xb[wc])  {                      /* match to disk? */
                 rker = rker | RKER_WCE;                 /* no, err */
                 if (rkcs & RKCS_SSE)
                     break;
@@ -709,6 +722,18 @@ if (rkxb == NULL)
 return SCPE_OK;
 }
 
+/* Device attach */
+
+t_stat rk_attach (UNIT *uptr, char *cptr)
+{
+t_stat r;
+
+r = attach_unit (uptr, cptr);                           /* attach unit */
+if (r != SCPE_OK)                                       /* error? */
+    return r;
+return attach_mmap (uptr, uptr->capac * sizeof (int16));
+}
+
 /* Device bootstrap */
 
 #define BOOT_START      02000                           /* start */
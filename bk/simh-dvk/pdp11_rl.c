@@ -440,7 +440,7 @@ t_stat rl_svc (UNIT *uptr)
 int32 err, wc, maxwc, t;
 int32 i, func, da, awc;
 uint32 ma;
-uint16 comp;
+uint16 comp, *xb;
 
 func = GET_FUNC (rlcs);                                 /* get function */
 if (func == RLCS_GSTA) {                                /* get status */
@@ -495,45 +495,59 @@ wc = 0200000 - rlmp;                                    /* get true wc */
 maxwc = (RL_NUMSC - GET_SECT (rlda)) * RL_NUMWD;        /* max transfer */
 if (wc > maxwc)                                         /* track overrun? */
     wc = maxwc;
-err = fseek (uptr->fileref, da * sizeof (int16), SEEK_SET);
+if ((uptr->flags & UNIT_MMAP) &&                        /* mapped image */
+    (((da + wc) * sizeof (int16)) <= uptr->hwmark)) {   /* and in range? */
+    xb = (uint16 *) uptr->filebuf + da;                 /* xfer in place */
+    err = 0;
+    }
+else {
+    xb = rlxb;                                          /* via buffer */
+    err = fseek (uptr->fileref, da * sizeof (int16), SEEK_SET);
+    }
 
 if ((func >= RLCS_READ) && (err == 0)) {                /* read (no hdr)? */
-    i = fxread (rlxb, sizeof (int16), wc, uptr->fileref);
-    err = ferror (uptr->fileref);
-    for ( ; i < wc; i++)                                /* fill buffer */
-        rlxb[i] = 0;
-    if (t = Map_WriteW (ma, wc << 1, rlxb)) {           /* store buffer */
+    if (xb == rlxb) {                                   /* not mapped? */
+        i = fxread (rlxb, sizeof (int16), wc, uptr->fileref);
+        err = ferror (uptr->fileref);
+        for ( ; i < wc; i++)                            /* fill buffer */
+            rlxb[i] = 0;
+        }
+    if (t = Map_WriteW (ma, wc << 1, xb)) {             /* store buffer */
         rlcs = rlcs | RLCS_ERR | RLCS_NXM;              /* nxm */
         wc = wc - t;                                    /* adjust wc */
         }
     }                                                   /* end read */
 
 if ((func == RLCS_WRITE) && (err == 0)) {               /* write? */
-    if (t = Map_ReadW (ma, wc << 1, rlxb)) {            /* fetch buffer */
+    if (t = Map_ReadW (ma, wc << 1, xb)) {              /* fetch buffer */
         rlcs = rlcs | RLCS_ERR | RLCS_NXM;              /* nxm */
         wc = wc - t;                                    /* adj xfer lnt */
         }
     if (wc) {                                           /* any xfer? */
         awc = (wc + (RL_NUMWD - 1)) & ~(RL_NUMWD - 1);  /* clr to */
         for (i = wc; i < awc; i++)                      /* end of blk */
-            rlxb[i] = 0;
-        fxwrite (rlxb, sizeof (int16), awc, uptr->fileref);
-        err = ferror (uptr->fileref);
+            xb[i] = 0;
+        if (xb == rlxb) {                               /* not mapped? */
+            fxwrite (rlxb, sizeof (int16), awc, uptr->fileref);
+            err = ferror (uptr->fileref);
+            }
         }
     }                                                   /* end write */
 
 if ((func == RLCS_WCHK) && (err == 0)) {                /* write check? */
-    i = fxread (rlxb, sizeof (int16), wc, uptr->fileref);
-    err = ferror (uptr->fileref);
-    for ( ; i < wc; i++)                                /* fill buffer */
-        rlxb[i] = 0;
+    if (xb == rlxb) {                                   /* not mapped? */
+        i = fxread (rlxb, sizeof (int16), wc, uptr->fileref);
+        err = ferror (uptr->fileref);
+        for ( ; i < wc; i++)                            /* fill buffer */
+            rlxb[i] = 0;
+        }
     awc = wc;                                           /* save wc */
     for (wc = 0; (err == 0) && (wc < awc); wc++)  {     /* loop thru buf */
         if (Map_ReadW (ma + (wc << 1), 2, &comp)) {     /* mem wd */
             rlcs = rlcs | RLCS_ERR | RLCS_NXM;          /* nxm */
             break;
             }
-        if (comp != rlxb[wc])                           /* check to buf */
+        if (comp != xb[wc])                             /* check to buf */
             rlcs = rlcs | RLCS_ERR | RLCS_CRC;
         }                                               /* end for */
     }                                                   /* end wcheck */
@@ -608,19 +622,21 @@ uptr->STAT = RLDS_VCK;                                  /* new volume */
 if ((p = sim_fsize (uptr->fileref)) == 0) {             /* new disk image? */
     if (uptr->flags & UNIT_RO)                          /* if ro, done */
         return SCPE_OK;
-    return pdp11_bad_block (uptr, RL_NUMSC, RL_NUMWD);
-    }
-if ((uptr->flags & UNIT_AUTO) == 0)                     /* autosize? */
-    return SCPE_OK;
-if (p > (RL01_SIZE * sizeof (int16))) {
-    uptr->flags = uptr->flags | UNIT_RL02;
-    uptr->capac = RL02_SIZE;
+    r = pdp11_bad_block (uptr, RL_NUMSC, RL_NUMWD);
+    if (r != SCPE_OK)
+        return r;
     }
-else {
-    uptr->flags = uptr->flags & ~UNIT_RL02;
-    uptr->capac = RL01_SIZE;
+else if (uptr->flags & UNIT_AUTO) {                     /* autosize? */
+    if (p > (RL01_SIZE * sizeof (int16))) {
+        uptr->flags = uptr->flags | UNIT_RL02;
+        uptr->capac = RL02_SIZE;
+        }
+    else {
+        uptr->flags = uptr->flags & ~UNIT_RL02;
+        uptr->capac = RL01_SIZE;
+        }
     }
-return SCPE_OK;
+return attach_mmap (uptr, uptr->capac * sizeof (int16));
 }
 
 /* Set size routine */
@@ -778,6 +778,7 @@ t_stat rp_svc (UNIT *uptr)
 {
 int32 i, fnc, dtype, drv, err;
 int32 wc, abc, awc, mbc, da;
+uint16 *xb;
 
 dtype = GET_DTYPE (uptr->flags);                        /* get drive type */
 drv = (int32) (uptr - rp_dev.units);                    /* get drv number */
@@ -837,25 +838,34 @@ switch (fnc) {                                          /* case on function */
                 break;
                 }
             }
+        xb = rpxb;                                      /* via buffer */
+        if ((uptr->flags & UNIT_MMAP) &&                /* mapped image */
+            ((((da + wc + (RP_NUMWD - 1)) & ~(RP_NUMWD - 1)) *
+            sizeof (uint16)) <= uptr->hwmark)) {        /* and in range? */
+            xb = (uint16 *) uptr->filebuf + da;         /* xfer in place */
+            err = 0;
+            }
         if (fnc == FNC_WRITE) {                         /* write? */
-            abc = mba_rdbufW (rp_dib.ba, mbc, rpxb);    /* get buffer */
+            abc = mba_rdbufW (rp_dib.ba, mbc, xb);      /* get buffer */
             wc = (abc + 1) >> 1;                        /* actual # wds */
             awc = (wc + (RP_NUMWD - 1)) & ~(RP_NUMWD - 1);
             for (i = wc; i < awc; i++)                  /* fill buf */
-                rpxb[i] = 0;
-            if (wc && !err) {                           /* write buf */
+                xb[i] = 0;
+            if (wc && !err && (xb == rpxb)) {           /* write buf */
                 fxwrite (rpxb, sizeof (uint16), awc, uptr->fileref);
                 err = ferror (uptr->fileref);
                 }
             }                                           /* end if wr */
         else {                                          /* read or wchk */
-            awc = fxread (rpxb, sizeof (uint16), wc, uptr->fileref);
-            err = ferror (uptr->fileref);
-            for (i = awc; i < wc; i++)                  /* fill buf */
-                rpxb[i] = 0;
+            if (xb == rpxb) {                           /* not mapped? */
+                awc = fxread (rpxb, sizeof (uint16), wc, uptr->fileref);
+                err = ferror (uptr->fileref);
+                for (i = awc; i < wc; i++)              /* fill buf */
+                    rpxb[i] = 0;
+                }
             if (fnc == FNC_WCHK)                        /* write check? */
-                mba_chbufW (rp_dib.ba, mbc, rpxb);      /* check vs mem */
-            else mba_wrbufW (rp_dib.ba, mbc, rpxb);     /* store in mem */
+                mba_chbufW (rp_dib.ba, mbc, xb);        /* check vs mem */
+            else mba_wrbufW (rp_dib.ba, mbc, xb);       /* store in mem */
             }                                           /* end if read */
         da = da + wc + (RP_NUMWD - 1);
         if (da >= drv_tab[dtype].size)
@@ -991,19 +1001,21 @@ rp_update_ds (DS_ATA, drv);                             /* upd ctlr status */
 if ((p = sim_fsize (uptr->fileref)) == 0) {             /* new disk image? */
     if (uptr->flags & UNIT_RO)
         return SCPE_OK;
-    return pdp11_bad_block (uptr,
+    r = pdp11_bad_block (uptr,
         drv_tab[GET_DTYPE (uptr->flags)].sect, RP_NUMWD);
+    if (r != SCPE_OK)
+        return r;
     }
-if ((uptr->flags & UNIT_AUTO) == 0)                     /* autosize? */
-    return SCPE_OK;
-for (i = 0; drv_tab[i].sect != 0; i++) {
-    if (p <= (drv_tab[i].size * (int) sizeof (int16))) {
-        uptr->flags = (uptr->flags & ~UNIT_DTYPE) | (i << UNIT_V_DTYPE);
-        uptr->capac = drv_tab[i].size;
-        return SCPE_OK;
+else if (uptr->flags & UNIT_AUTO) {                     /* autosize? */
+    for (i = 0; drv_tab[i].sect != 0; i++) {
+        if (p <= (drv_tab[i].size * (int) sizeof (int16))) {
+            uptr->flags = (uptr->flags & ~UNIT_DTYPE) | (i << UNIT_V_DTYPE);
+            uptr->capac = drv_tab[i].size;
+            break;
+            }
         }
     }
-return SCPE_OK;
+return attach_mmap (uptr, uptr->capac * sizeof (int16));
 }
 
 /* Device detach */
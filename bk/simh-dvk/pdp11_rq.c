@@ -96,6 +96,7 @@ extern int32 cpu_opt;
 
 #include "pdp11_uqssp.h"
 #include "pdp11_mscp.h"
+#include "sim_aio.h"
 
 #define UF_MSK          (UF_CMR|UF_CMW)                 /* settable flags */
 
@@ -128,9 +129,11 @@ extern int32 cpu_opt;
 #define UNIT_V_ATP      (UNIT_V_UF + 2)                 /* attn pending */
 #define UNIT_V_DTYPE    (UNIT_V_UF + 3)                 /* drive type */
 #define UNIT_M_DTYPE    0xF
+#define UNIT_V_AIO      (UNIT_V_UF + 7)                 /* async I/O */
 #define UNIT_ONL        (1 << UNIT_V_ONL)
 #define UNIT_WLK        (1 << UNIT_V_WLK)
 #define UNIT_ATP        (1 << UNIT_V_ATP)
+#define UNIT_AIO        (1 << UNIT_V_AIO)
 #define UNIT_DTYPE      (UNIT_M_DTYPE << UNIT_V_DTYPE)
 #define GET_DTYPE(x)    (((x) >> UNIT_V_DTYPE) & UNIT_M_DTYPE)
 #define cpkt            u3                              /* current packet */
@@ -592,6 +595,7 @@ t_stat rq_detach (UNIT *uptr);
 t_stat rq_boot (int32 unitno, DEVICE *dptr);
 t_stat rq_set_wlk (UNIT *uptr, int32 val, char *cptr, void *desc);
 t_stat rq_set_type (UNIT *uptr, int32 val, char *cptr, void *desc);
+t_stat rq_set_aio (UNIT *uptr, int32 val, char *cptr, void *desc);
 t_stat rq_show_type (FILE *st, UNIT *uptr, int32 val, void *desc);
 t_stat rq_show_wlk (FILE *st, UNIT *uptr, int32 val, void *desc);
 t_stat rq_show_ctrl (FILE *st, UNIT *uptr, int32 val, void *desc);
@@ -622,6 +626,9 @@ t_bool rq_getdesc (MSC *cp, struct uq_ring *ring, uint32 *desc);
 t_bool rq_putdesc (MSC *cp, struct uq_ring *ring, uint32 desc);
 int32 rq_rw_valid (MSC *cp, int32 pkt, UNIT *uptr, uint32 cmd);
 t_bool rq_rw_end (MSC *cp, UNIT *uptr, uint32 flg, uint32 sts);
+t_bool rq_fio (UNIT *uptr, SIM_AIO *ap, uint32 cmd, t_addr da,
+    uint16 *xb, uint32 wc, uint32 *err);
+t_stat rq_aio_io (SIM_AIO *ap);
 void rq_putr (MSC *cp, int32 pkt, uint32 cmd, uint32 flg,
     uint32 sts, uint32 lnt, uint32 typ);
 void rq_putr_unit (MSC *cp, int32 pkt, UNIT *uptr, uint32 lu, t_bool all);
@@ -718,6 +725,8 @@ MTAB rq_mod[] = {
       NULL, &rq_show_unitq, 0 },
     { MTAB_XTD | MTAB_VUN, 0, "WRITE", NULL,
       NULL, &rq_show_wlk, NULL },
+    { UNIT_AIO, UNIT_AIO, "async I/O", "ASYNC", &rq_set_aio },
+    { UNIT_AIO, 0, NULL, "NOASYNC", &rq_set_aio },
     { MTAB_XTD | MTAB_VUN, RX50_DTYPE, NULL, "RX50",
       &rq_set_type, NULL, NULL },
     { MTAB_XTD | MTAB_VUN, RX33_DTYPE, NULL, "RX33",
@@ -1662,6 +1671,9 @@ MSC *cp = rq_ctxmap[uptr->cnum];
 
 uint32 i, t, tbc, abc, wwc;
 uint32 err = 0;
+uint16 *xb = rqxb;                                      /* xfer buffer */
+t_bool fio = TRUE;                                      /* file I/O needed */
+SIM_AIO *ap = NULL;                                     /* async request */
 int32 pkt = uptr->cpkt;                                 /* get packet */
 uint32 cmd = GETP (pkt, CMD_OPC, OPC);                  /* get cmd */
 uint32 ba = GETP32 (pkt, RW_WBAL);                      /* buf addr */
@@ -1673,6 +1685,14 @@ if ((cp == NULL) || (pkt == 0))                         /* what??? */
     return STOP_RQ;
 tbc = (bc > RQ_MAXFR)? RQ_MAXFR: bc;                    /* trim cnt to max */
 
+if ((uptr->flags & (UNIT_AIO | UNIT_MMAP)) == UNIT_AIO) { /* async unit? */
+    ap = sim_aio_unit (uptr, RQ_MAXFR);
+    if ((ap != NULL) && sim_aio_busy (ap)) {            /* xfer in progress? */
+        sim_activate (uptr, rq_xtime);                  /* poll again */
+        return SCPE_OK;
+        }
+    }
+
 if ((uptr->flags & UNIT_ATT) == 0) {                    /* not attached? */
     rq_rw_end (cp, uptr, 0, ST_OFL | SB_OFL_NV);        /* offl no vol */
     return SCPE_OK;
@@ -1693,26 +1713,35 @@ if ((cmd == OP_ERS) || (cmd == OP_WR)) {                /* write op? */
         }
     }
 
+if ((uptr->flags & UNIT_MMAP) &&                        /* mapped image */
+    ((da + ((tbc + (RQ_NUMBY - 1)) & ~(RQ_NUMBY - 1))) <= uptr->hwmark)) {
+    xb = (uint16 *) ((uint8 *) uptr->filebuf + da);     /* xfer in place */
+    fio = FALSE;
+    }
+else if (ap != NULL)                                    /* async? */
+    xb = (uint16 *) ap->buf;                            /* unit's own buffer */
+
 if (cmd == OP_ERS) {                                    /* erase? */
     wwc = ((tbc + (RQ_NUMBY - 1)) & ~(RQ_NUMBY - 1)) >> 1;
     for (i = 0; i < wwc; i++)                           /* clr buf */
-        rqxb[i] = 0;
-    err = sim_fseek (uptr->fileref, da, SEEK_SET);      /* set pos */
-    if (!err)
-        sim_fwrite (rqxb, sizeof (int16), wwc, uptr->fileref);
-    err = ferror (uptr->fileref);                       /* end if erase */
+        xb[i] = 0;
+    if (fio && rq_fio (uptr, ap, cmd, da, xb, wwc, &err)) /* not mapped? */
+        return SCPE_OK;                                 /* end if erase */
     }
 
 else if (cmd == OP_WR) {                                /* write? */
-    t = Map_ReadW (ba, tbc, rqxb);                      /* fetch buffer */
+    if ((ap == NULL) || (ap->state == AIO_IDLE)) {      /* not yet queued? */
+        t = Map_ReadW (ba, tbc, xb);                    /* fetch buffer */
+        if (ap != NULL)                                 /* save for finish */
+            ap->res = t;
+        }
+    else t = ap->res;
     if (abc = tbc - t) {                                /* any xfer? */
         wwc = ((abc + (RQ_NUMBY - 1)) & ~(RQ_NUMBY - 1)) >> 1;
         for (i = (abc >> 1); i < wwc; i++)
-            rqxb[i] = 0;
-        err = sim_fseek (uptr->fileref, da, SEEK_SET);
-        if (!err)
-            sim_fwrite (rqxb, sizeof (int16), wwc, uptr->fileref);
-        err = ferror (uptr->fileref);
+            xb[i] = 0;
+        if (fio && rq_fio (uptr, ap, cmd, da, xb, wwc, &err)) /* not mapped? */
+            return SCPE_OK;
         }
     if (t) {                                            /* nxm? */
         PUTP32 (pkt, RW_WBCL, bc - abc);                /* adj bc */
@@ -1724,15 +1753,10 @@ else if (cmd == OP_WR) {                                /* write? */
     }
 
 else {
-    err = sim_fseek (uptr->fileref, da, SEEK_SET);      /* set pos */
-    if (!err) {
-        i = sim_fread (rqxb, sizeof (int16), tbc >> 1, uptr->fileref);
-        for ( ; i < (tbc >> 1); i++)                    /* fill */
-            rqxb[i] = 0;
-        err = ferror (uptr->fileref);
-        }
+    if (fio && rq_fio (uptr, ap, cmd, da, xb, tbc >> 1, &err)) /* not mapped? */
+        return SCPE_OK;
     if ((cmd == OP_RD) && !err) {                       /* read? */
-        if (t = Map_WriteW (ba, tbc, rqxb)) {           /* store, nxm? */
+        if (t = Map_WriteW (ba, tbc, xb)) {             /* store, nxm? */
             PUTP32 (pkt, RW_WBCL, bc - (tbc - t));      /* adj bc */
             PUTP32 (pkt, RW_WBAL, ba + (tbc - t));      /* adj ba */
             if (rq_hbe (cp, uptr))                      /* post err log */
@@ -1750,7 +1774,7 @@ else {
                     rq_rw_end (cp, uptr, EF_LOG, ST_HST | SB_HST_NXM);
                 return SCPE_OK;
                 }
-            dby = (rqxb[i >> 1] >> ((i & 1)? 8: 0)) & 0xFF;
+            dby = (xb[i >> 1] >> ((i & 1)? 8: 0)) & 0xFF;
             if (mby != dby) {                           /* cmp err? */
                 PUTP32 (pkt, RW_WBCL, bc - i);          /* adj bc */
                 rq_rw_end (cp, uptr, 0, ST_CMP);        /* done */
@@ -1778,6 +1802,64 @@ else rq_rw_end (cp, uptr, 0, ST_SUC);                   /* done! */
 return SCPE_OK;
 }
 
+/* Transfer between a buffer and the disk file
+
+   A synchronous unit does the transfer in line and returns FALSE.  For
+   an asynchronous unit the first call queues the transfer on the I/O
+   thread, leaves the unit scheduled to poll for it and returns TRUE;
+   rq_svc then runs again with the same packet and, once the transfer
+   is done, the call at the same place collects the status instead.
+*/
+
+t_bool rq_fio (UNIT *uptr, SIM_AIO *ap, uint32 cmd, t_addr da,
+    uint16 *xb, uint32 wc, uint32 *err)
+{
+SIM_AIO io;
+
+if (ap == NULL) {                                       /* synchronous? */
+    io.uptr = uptr;
+    io.buf = xb;
+    io.pos = da;
+    io.cmd = cmd;
+    io.len = wc;
+    *err = rq_aio_io (&io);
+    return FALSE;
+    }
+if (ap->state == AIO_IDLE) {                            /* start xfer */
+    ap->pos = da;
+    ap->cmd = cmd;
+    ap->len = wc;
+    sim_aio_start (ap, &rq_aio_io);
+    sim_activate (uptr, rq_xtime);                      /* poll for done */
+    return TRUE;
+    }
+*err = sim_aio_end (ap);                                /* collect status */
+return FALSE;
+}
+
+/* Disk file I/O, on the I/O thread for an asynchronous unit */
+
+t_stat rq_aio_io (SIM_AIO *ap)
+{
+FILE *fileref = ap->uptr->fileref;
+uint16 *xb = (uint16 *) ap->buf;
+uint32 i, err;
+
+err = sim_fseek (fileref, ap->pos, SEEK_SET);           /* set pos */
+if ((ap->cmd == OP_ERS) || (ap->cmd == OP_WR)) {        /* write op? */
+    if (!err)
+        sim_fwrite (xb, sizeof (int16), ap->len, fileref);
+    err = ferror (fileref);
+    }
+else if (!err) {                                        /* read, compare */
+    i = sim_fread (xb, sizeof (int16), ap->len, fileref);
+    for ( ; i < ap->len; i++)                           /* fill */
+        xb[i] = 0;
+    err = ferror (fileref);
+    }
+return err;
+}
+
 /* Transfer command complete */
 
 t_bool rq_rw_end (MSC *cp, UNIT *uptr, uint32 flg, uint32 sts)
@@ -2256,6 +2338,15 @@ if (drv_tab[dtyp].flgs & RQDF_RO)                       /* not on read only */
 return SCPE_OK;
 }
 
+/* Set/clear asynchronous I/O; a transfer done but not yet collected
+   is dropped and will simply be redone */
+
+t_stat rq_set_aio (UNIT *uptr, int32 val, char *cptr, void *desc)
+{
+sim_aio_cancel (uptr);
+return SCPE_OK;
+}
+
 /* Show write lock status */
 
 t_stat rq_show_wlk (FILE *st, UNIT *uptr, int32 val, void *desc)
@@ -2315,7 +2406,7 @@ if (r != SCPE_OK)
     return r;
 if (cp->csta == CST_UP)
     uptr->flags = uptr->flags | UNIT_ATP;
-return SCPE_OK;
+return attach_mmap (uptr, uptr->capac);
 }
 
 /* Device detach */
@@ -2324,6 +2415,7 @@ t_stat rq_detach (UNIT *uptr)
 {
 t_stat r;
 
+sim_aio_cancel (uptr);                                  /* drop async xfer */
 r = detach_unit (uptr);                                 /* detach unit */
 if (r != SCPE_OK)
     return r;
@@ -2384,6 +2476,7 @@ rq_clrint (cp);                                         /* clr intr req */
 for (i = 0; i < (RQ_NUMDR + 2); i++) {                  /* init units */
     uptr = dptr->units + i;
     sim_cancel (uptr);                                  /* clr activity */
+    sim_aio_cancel (uptr);                              /* drop async xfer */
     uptr->cnum = cidx;                                  /* set ctrl index */
     uptr->flags = uptr->flags & ~(UNIT_ONL | UNIT_ATP);
     uptr->uf = 0;                                       /* clr unit flags */
@@ -69,6 +69,7 @@ extern int32 cpu_opt;
 #include "pdp11_uqssp.h"
 #include "pdp11_mscp.h"
 #include "sim_tape.h"
+#include "sim_aio.h"
 
 #define UF_MSK          (UF_SCH|UF_VSS|UF_CMR|UF_CMW)   /* settable flags */
 
@@ -92,11 +93,13 @@ extern int32 cpu_opt;
 #define UNIT_V_SXC      (MTUF_V_UF + 2)                 /* serious exc */
 #define UNIT_V_POL      (MTUF_V_UF + 3)                 /* position lost */
 #define UNIT_V_TMK      (MTUF_V_UF + 4)                 /* tape mark seen */
+#define UNIT_V_AIO      (MTUF_V_UF + 5)                 /* async I/O */
 #define UNIT_ONL        (1 << UNIT_V_ONL)
 #define UNIT_ATP        (1 << UNIT_V_ATP)
 #define UNIT_SXC        (1 << UNIT_V_SXC)
 #define UNIT_POL        (1 << UNIT_V_POL)
 #define UNIT_TMK        (1 << UNIT_V_TMK)
+#define UNIT_AIO        (1 << UNIT_V_AIO)
 #define cpkt            u3                              /* current packet */
 #define pktq            u4                              /* packet queue */
 #define uf              buf                             /* settable unit flags */
@@ -228,6 +231,7 @@ extern FILE *sim_deb;
 extern uint32 sim_taddr_64;
 
 uint8 *tqxb = NULL;                                     /* xfer buffer */
+UNIT tq_aiou[TQ_NUMDR];                                 /* async I/O units */
 uint32 tq_sa = 0;                                       /* status, addr */
 uint32 tq_saw = 0;                                      /* written data */
 uint32 tq_s1dat = 0;                                    /* S1 data */
@@ -331,10 +335,13 @@ t_bool tq_una (UNIT *uptr);
 uint32 tq_map_status (UNIT *uptr, t_stat st);
 uint32 tq_spacef (UNIT *uptr, uint32 cnt, uint32 *skipped, t_bool qrec);
 uint32 tq_skipff (UNIT *uptr, uint32 cnt, uint32 *skipped);
-uint32 tq_rdbuff (UNIT *uptr, t_mtrlnt *tbc);
+uint32 tq_rdbuff (UNIT *uptr, t_stat st);
 uint32 tq_spacer (UNIT *uptr, uint32 cnt, uint32 *skipped, t_bool qrec);
 uint32 tq_skipfr (UNIT *uptr, uint32 cnt, uint32 *skipped);
-uint32 tq_rdbufr (UNIT *uptr, t_mtrlnt *tbc);
+uint32 tq_rdbufr (UNIT *uptr, t_stat st);
+t_bool tq_aio (UNIT *uptr, SIM_AIO *ap, uint32 cmd, t_mtrlnt *tbc, t_stat *st);
+t_stat tq_aio_io (SIM_AIO *ap);
+t_stat tq_set_aio (UNIT *uptr, int32 val, char *cptr, void *desc);
 t_bool tq_deqf (int32 *pkt);
 int32 tq_deqh (int32 *lh);
 void tq_enqh (int32 *lh, int32 pkt);
@@ -422,6 +429,8 @@ REG tq_reg[] = {
 MTAB tq_mod[] = {
     { MTUF_WLK, 0, "write enabled", "WRITEENABLED", NULL },
     { MTUF_WLK, MTUF_WLK, "write locked", "LOCKED", NULL },
+    { UNIT_AIO, UNIT_AIO, "async I/O", "ASYNC", &tq_set_aio },
+    { UNIT_AIO, 0, NULL, "NOASYNC", &tq_set_aio },
     { MTAB_XTD | MTAB_VDV, TQ5_TYPE, NULL, "TK50",
       &tq_set_type, NULL, NULL },
     { MTAB_XTD | MTAB_VDV, TQ7_TYPE, NULL, "TK70",
@@ -1147,9 +1156,22 @@ uint32 ba = GETP32 (pkt, RW_BAL);                       /* buf addr */
 t_mtrlnt bc = GETP32 (pkt, RW_BCL);                     /* byte count */
 uint32 nrec = GETP32 (pkt, POS_RCL);                    /* #rec to skip */
 uint32 ntmk = GETP32 (pkt, POS_TMCL);                   /* #tmk to skp */
+uint8 *xb = tqxb;                                       /* xfer buffer */
+SIM_AIO *ap = NULL;                                     /* async request */
+t_stat st;
 
 if (pkt == 0)                                           /* what??? */
     return SCPE_IERR;
+if (uptr->flags & UNIT_AIO) {                           /* async unit? */
+    ap = sim_aio_unit (uptr, TQ_MAXFR);
+    if (ap != NULL) {
+        if (sim_aio_busy (ap)) {                        /* xfer in progress? */
+            sim_activate (uptr, tq_xtime);              /* poll again */
+            return SCPE_OK;
+            }
+        xb = (uint8 *) ap->buf;                         /* unit's own buffer */
+        }
+    }
 if ((uptr->flags & UNIT_ATT) == 0) {                    /* not attached? */
     tq_mot_end (uptr, 0, ST_OFL | SB_OFL_NV, 0);        /* offl no vol */
     return SCPE_OK;
@@ -1172,9 +1194,17 @@ tbc = 0;                                                /* assume zero rec */
 switch (cmd) {                                          /* case on command */
 
     case OP_RD:case OP_ACC:case OP_CMP:                 /* read-like op */
-        if (mdf & MD_REV)                               /* read record */
-            sts = tq_rdbufr (uptr, &tbc);
-        else sts = tq_rdbuff (uptr, &tbc);
+        if (ap == NULL) {                               /* synchronous? */
+            if (mdf & MD_REV)                           /* read record */
+                st = sim_tape_rdrecr (uptr, xb, &tbc, MT_MAXFR);
+            else st = sim_tape_rdrecf (uptr, xb, &tbc, MT_MAXFR);
+            }
+        else if (tq_aio (uptr, ap, (mdf & MD_REV)? OP_RD | MD_REV: OP_RD,
+            &tbc, &st))                                 /* queued? */
+            return SCPE_OK;
+        if (mdf & MD_REV)                               /* update position */
+            sts = tq_rdbufr (uptr, st);
+        else sts = tq_rdbuff (uptr, st);
         if (sts == ST_DRV) {                            /* read error? */
             PUTP32 (pkt, RW_BCL, 0);                    /* no bytes processed */
             return tq_mot_err (uptr, tbc);              /* log, done */
@@ -1190,7 +1220,7 @@ switch (cmd) {                                          /* case on command */
             }
         else wbc = tbc;
         if (cmd == OP_RD) {                             /* read? */
-            if (t = Map_WriteB (ba, wbc, tqxb)) {       /* store, nxm? */
+            if (t = Map_WriteB (ba, wbc, xb)) {         /* store, nxm? */
                 PUTP32 (pkt, RW_BCL, wbc - t);          /* adj bc */
                 if (tq_hbe (uptr, ba + wbc - t))        /* post err log */
                     tq_mot_end (uptr, EF_LOG, ST_HST | SB_HST_NXM, tbc);        
@@ -1203,11 +1233,11 @@ switch (cmd) {                                          /* case on command */
             for (i = 0; i < wbc; i++) {                 /* loop */
                 if (mdf & MD_REV) {                     /* reverse? */
                     mba = ba + bc - 1 - i;              /* mem addr */
-                    dby = tqxb[tbc - 1 - i];            /* byte */
+                    dby = xb[tbc - 1 - i];              /* byte */
                     }
                 else {
                     mba = ba + i;
-                    dby = tqxb[i];
+                    dby = xb[i];
                     }
                 if (Map_ReadB (mba, 1, &mby)) {         /* fetch, nxm? */
                     PUTP32 (pkt, RW_BCL, i);            /* adj bc */
@@ -1227,13 +1257,18 @@ switch (cmd) {                                          /* case on command */
         break;
 
     case OP_WR:                                         /* write */
-        if (t = Map_ReadB (ba, bc, tqxb)) {             /* fetch buf, nxm? */
+        if (((ap == NULL) || (ap->state == AIO_IDLE)) && /* not yet queued? */
+            (t = Map_ReadB (ba, bc, xb))) {             /* fetch buf, nxm? */
             PUTP32 (pkt, RW_BCL, 0);                    /* no bytes xfer'd */
             if (tq_hbe (uptr, ba + bc - t))             /* post err log */
                 tq_mot_end (uptr, EF_LOG, ST_HST | SB_HST_NXM, bc);     
             return SCPE_OK;                             /* end else wr */
             }
-        if (sim_tape_wrrecf (uptr, tqxb, bc))           /* write rec fwd, err? */
+        if (ap == NULL)                                 /* synchronous? */
+            st = sim_tape_wrrecf (uptr, xb, bc);        /* write rec fwd */
+        else if (tq_aio (uptr, ap, OP_WR, &bc, &st))    /* queued? */
+            return SCPE_OK;
+        if (st)                                         /* err? */
             return tq_mot_err (uptr, bc);               /* log, end */
         uptr->objp = uptr->objp + 1;                    /* upd obj pos */
         if (TEST_EOT (uptr))                            /* EOT on write? */
@@ -1463,11 +1498,11 @@ return ST_SUC;
 
 /* Read buffer - can return ST_TMK, ST_FMT, or ST_DRV */
 
-uint32 tq_rdbuff (UNIT *uptr, t_mtrlnt *tbc)
-{
-t_stat st;
+/* Update unit state after a record read forward or reverse; st is the
+   status of sim_tape_rdrecf or sim_tape_rdrecr */
 
-st = sim_tape_rdrecf (uptr, tqxb, tbc, MT_MAXFR);       /* read rec fwd */
+uint32 tq_rdbuff (UNIT *uptr, t_stat st)
+{
 if (st == MTSE_TMK) {                                   /* tape mark? */
     uptr->flags = uptr->flags | UNIT_SXC | UNIT_TMK;    /* serious exc */
     uptr->objp = uptr->objp + 1;                        /* update obj cnt */
@@ -1480,11 +1515,8 @@ uptr->objp = uptr->objp + 1;                            /* upd obj cnt */
 return ST_SUC;
 }
 
-uint32 tq_rdbufr (UNIT *uptr, t_mtrlnt *tbc)
+uint32 tq_rdbufr (UNIT *uptr, t_stat st)
 {
-t_stat st;
-
-st = sim_tape_rdrecr (uptr, tqxb, tbc, MT_MAXFR);       /* read rec rev */
 if (st == MTSE_TMK) {                                   /* tape mark? */
     uptr->flags = uptr->flags | UNIT_SXC;               /* serious exc */
     uptr->objp = uptr->objp - 1;                        /* update obj cnt */
@@ -1496,6 +1528,53 @@ uptr->objp = uptr->objp - 1;                            /* upd obj cnt */
 return ST_SUC;
 }
 
+/* Asynchronous record transfer
+
+   The first call queues the read or write on the I/O thread, leaves the
+   unit scheduled to poll for it and returns TRUE; tq_svc then runs again
+   with the same packet and, once the transfer is done, the call at the
+   same place returns FALSE with the tape status in st and the record
+   length in tbc.  The I/O thread works on a copy of the unit in tq_aiou,
+   since sim_tape updates the position and flags while the simulator may
+   be changing other unit flags; both are copied back here.
+*/
+
+t_bool tq_aio (UNIT *uptr, SIM_AIO *ap, uint32 cmd, t_mtrlnt *tbc, t_stat *st)
+{
+UNIT *aptr = &tq_aiou[uptr - tq_dev.units];
+
+if (ap->state == AIO_IDLE) {                            /* start xfer */
+    *aptr = *uptr;                                      /* copy for thread */
+    ap->cmd = cmd;
+    ap->len = *tbc;
+    sim_aio_start (ap, &tq_aio_io);
+    sim_activate (uptr, tq_xtime);                      /* poll for done */
+    return TRUE;
+    }
+*st = sim_aio_end (ap);                                 /* collect status */
+*tbc = ap->res;
+uptr->pos = aptr->pos;                                  /* copy back posn */
+uptr->flags = (uptr->flags & ~MTUF_PNU) | (aptr->flags & MTUF_PNU);
+return FALSE;
+}
+
+/* Tape file I/O on the I/O thread */
+
+t_stat tq_aio_io (SIM_AIO *ap)
+{
+UNIT *aptr = &tq_aiou[ap->uptr - tq_dev.units];
+t_mtrlnt tbc = ap->len;
+t_stat st;
+
+if (ap->cmd == OP_WR)                                   /* write rec fwd */
+    st = sim_tape_wrrecf (aptr, (uint8 *) ap->buf, tbc);
+else if (ap->cmd & MD_REV)                              /* read rec rev */
+    st = sim_tape_rdrecr (aptr, (uint8 *) ap->buf, &tbc, MT_MAXFR);
+else st = sim_tape_rdrecf (aptr, (uint8 *) ap->buf, &tbc, MT_MAXFR);
+ap->res = tbc;
+return st;
+}
+
 /* Data transfer error log packet */
 
 t_bool tq_dte (UNIT *uptr, uint32 err)
@@ -1908,6 +1987,7 @@ t_stat tq_detach (UNIT *uptr)
 {
 t_stat r;
 
+sim_aio_cancel (uptr);                                  /* drop async xfer */
 r = sim_tape_detach (uptr);                             /* detach unit */
 if (r != SCPE_OK)
     return r;
@@ -1950,6 +2030,7 @@ CLR_INT (TQ);                                           /* clr intr req */
 for (i = 0; i < TQ_NUMDR + 2; i++) {                    /* init units */
     uptr = tq_dev.units + i;
     sim_cancel (uptr);                                  /* clr activity */
+    sim_aio_cancel (uptr);                              /* drop async xfer */
     sim_tape_reset (uptr);
     uptr->flags = uptr->flags &                         /* not online */
         ~(UNIT_ONL|UNIT_ATP|UNIT_SXC|UNIT_POL|UNIT_TMK);
@@ -1963,6 +2044,15 @@ if (tqxb == NULL)
 return SCPE_OK;
 }
 
+/* Set/clear asynchronous I/O; a transfer done but not yet collected
+   is dropped and will simply be redone */
+
+t_stat tq_set_aio (UNIT *uptr, int32 val, char *cptr, void *desc)
+{
+sim_aio_cancel (uptr);
+return SCPE_OK;
+}
+
 /* Device bootstrap */
 
 #if defined (VM_PDP11)
@@ -180,6 +180,7 @@
 
 #include "sim_defs.h"
 #include "sim_rev.h"
+#include "sim_aio.h"
 #include <signal.h>
 #include <ctype.h>
 
@@ -203,10 +204,19 @@
 
 #define DO_NEST_LVL     10                              /* DO cmd nesting level */
 #define SRBSIZ          1024                            /* save/restore buffer */
+#define SNAP_PGSIZ      4096                            /* snapshot page, bytes */
+#define SNAP_NEST       64                              /* snapshot chain depth */
+#define SNAP_BLK        0                               /* memory as blocks */
+#define SNAP_RAW        1                               /* memory in one block */
+#define SNAP_PAG        2                               /* non-zero pages */
+#define SNAP_DIF        3                               /* changed pages */
+#define SNAP_END        0xFFFFFFFF                      /* end of pages */
 #define SIM_BRK_INILNT  4096                            /* bpt tbl length */
+#define SIM_EVT_INILNT  64                              /* event tbl length */
 #define SIM_BRK_ALLTYP  0xFFFFFFFF
 #define UPDATE_SIM_TIME(x) sim_time = sim_time + (x - sim_interval); \
     sim_rtime = sim_rtime + ((uint32) (x - sim_interval)); \
+    sim_qtime = sim_qtime + (x - sim_interval); \
     x = sim_interval
 
 #define SZ_D(dp) (size_map[((dp)->dwidth + CHAR_BIT - 1) / CHAR_BIT])
@@ -293,6 +303,10 @@ t_stat show_one_mod (FILE *st, DEVICE *dptr, UNIT *uptr, MTAB *mptr, char *cptr,
 t_stat sim_check_console (int32 sec);
 t_stat sim_save (FILE *sfile);
 t_stat sim_rest (FILE *rfile);
+static t_stat sim_save_blk (FILE *sfile, DEVICE *dptr, UNIT *uptr);
+static t_stat sim_save_mem (FILE *sfile, DEVICE *dptr, UNIT *uptr, int32 sw);
+static t_stat sim_rest_blk (FILE *rfile, DEVICE *dptr, UNIT *uptr);
+static t_stat sim_rest_mem (FILE *rfile, DEVICE *dptr, UNIT *uptr);
 
 /* Breakpoint package */
 
@@ -375,6 +389,16 @@ int32 sim_step = 0;
 static double sim_time;
 static uint32 sim_rtime;
 static int32 noqueue_time;
+static t_int64 sim_qtime;                               /* event queue time */
+static EVTTAB *sim_evt_tab = NULL;                      /* event heap */
+static int32 sim_evt_ent = 0;                           /* entries in heap */
+static int32 sim_evt_lnt = 0;                           /* heap length */
+static t_uint64 sim_evt_seq = 0;                        /* insertion order */
+static char sim_snap_base[CBUFSIZE] = "";               /* last fast snapshot */
+static UNIT *sim_snap_uptr = NULL;                      /* unit in shadow */
+static uint8 *sim_snap_shadow = NULL;                   /* its memory then */
+static t_addr sim_snap_lnt = 0;                         /* shadow length */
+static int32 sim_snap_nest = 0;                         /* restore chain depth */
 volatile int32 stop_cpu = 0;
 t_value *sim_eval = NULL;
 int32 sim_deb_close = 0;                                /* 1 = close debug */
@@ -402,6 +426,7 @@ static const char *sim_snet = "no Ethernet";
 /* Tables and strings */
 
 const char save_vercur[] = "V3.5";
+const char save_verfst[] = "V3.5F";
 const char save_ver32[] = "V3.2";
 const char save_ver30[] = "V3.0";
 const char *scp_error_messages[] = {
@@ -516,7 +541,9 @@ static CTAB cmd_table[] = {
     { "DEASSIGN", &deassign_cmd, 0,
       "dea{ssign} <device>      deassign logical name for device\n" },
     { "SAVE", &save_cmd, 0,
-      "sa{ve} <file>            save simulator to file\n" },
+      "sa{ve} <file>            save simulator to file\n"
+      "sa{ve} -f{z}{i} <file>   save fast snapshot (zero pages skipped,\n"
+      "                         only changed since last snapshot)\n" },
     { "RESTORE", &restore_cmd, 0,
       "rest{ore}|ge{t} <file>   restore simulator from file\n" },
     { "GET", &restore_cmd, 0, NULL },
@@ -623,6 +650,8 @@ stop_cpu = 0;
 sim_interval = 0;
 sim_time = sim_rtime = 0;
 noqueue_time = 0;
+sim_qtime = 0;
+sim_evt_ent = 0;
 sim_clock_queue = NULL;
 sim_is_running = 0;
 sim_log = NULL;
@@ -1538,11 +1567,22 @@ else if (!flag)
 return SCPE_OK;
 }
 
+static int sim_evt_cmp (const void *pa, const void *pb)
+{
+const EVTTAB *a = (const EVTTAB *) pa;
+const EVTTAB *b = (const EVTTAB *) pb;
+
+if (a->when != b->when)
+    return (a->when < b->when)? -1: 1;
+return (a->seq < b->seq)? -1: (a->seq > b->seq);
+}
+
 t_stat show_queue (FILE *st, DEVICE *dnotused, UNIT *unotused, int32 flag, char *cptr)
 {
 DEVICE *dptr;
 UNIT *uptr;
-int32 accum;
+EVTTAB *evt;
+int32 i;
 
 if (cptr && (*cptr != 0))
     return SCPE_2MARG;
@@ -1553,8 +1593,14 @@ if (sim_clock_queue == NULL) {
     }
 fprintf (st, "%s event queue status, time = %.0f\n",
      sim_name, sim_time);
-accum = 0;
-for (uptr = sim_clock_queue; uptr != NULL; uptr = uptr->next) {
+evt = (EVTTAB *) calloc (sim_evt_ent, sizeof (EVTTAB));
+if (evt == NULL)
+    return SCPE_MEM;
+for (i = 0; i < sim_evt_ent; i++)                       /* sort a copy */
+    evt[i] = sim_evt_tab[i];
+qsort (evt, sim_evt_ent, sizeof (EVTTAB), sim_evt_cmp);
+for (i = 0; i < sim_evt_ent; i++) {
+    uptr = evt[i].uptr;
     if (uptr == &sim_step_unit)
         fprintf (st, "  Step timer");
     else if ((dptr = find_dev_from_unit (uptr)) != NULL) {
@@ -1563,9 +1609,10 @@ for (uptr = sim_clock_queue; uptr != NULL; uptr = uptr->next) {
             (int32) (uptr - dptr->units));
         }
     else fprintf (st, "  Unknown");
-    fprintf (st, " at %d\n", accum + uptr->time);
-    accum = accum + uptr->time;
+    fprintf (st, " at %d\n", noqueue_time +
+        (int32) (evt[i].when - evt[0].when));
     }
+free (evt);
 return SCPE_OK;
 }
 
@@ -2001,6 +2048,30 @@ uptr->pos = 0;
 return SCPE_OK;
 }
 
+/* Map an attached disk image if ATTACH -M was given
+
+   Called by disk attach routines once the unit capacity (size, in bytes)
+   is final.  Failure to map is not an error; the unit just stays on
+   ordinary file I/O.
+*/
+
+t_stat attach_mmap (UNIT *uptr, t_addr size)
+{
+DEVICE *dptr;
+
+if (!(sim_switches & SWMASK ('M')) || !(uptr->flags & UNIT_ATT))
+    return SCPE_OK;
+if ((dptr = find_dev_from_unit (uptr)) == NULL)
+    return SCPE_OK;
+if (sim_fmap (uptr, size) == SCPE_OK) {
+    if (!sim_quiet)
+        printf ("%s: mapping file in memory\n", sim_dname (dptr));
+    }
+else if (!sim_quiet)
+    printf ("%s: unable to map file, using file I/O\n", sim_dname (dptr));
+return SCPE_OK;
+}
+
 t_stat attach_err (UNIT *uptr, t_stat stat)
 {
 free (uptr->filename);
@@ -2113,6 +2184,10 @@ if (uptr->flags & UNIT_BUF) {
         }
     uptr->flags = uptr->flags & ~UNIT_BUF;
     }
+if (uptr->flags & UNIT_MMAP) {                          /* mapped image? */
+    if (sim_funmap (uptr) != SCPE_OK)
+        perror ("I/O error");
+    }
 uptr->flags = uptr->flags & ~(UNIT_ATT | UNIT_RO);
 free (uptr->filename);
 uptr->filename = NULL;
@@ -2199,6 +2274,16 @@ return (dptr->lname? dptr->lname: dptr->name);
 /* Save command
 
    sa[ve] filename              save state to specified file
+   sa[ve] -f{z}{i} filename     save fast snapshot
+
+   A fast snapshot (-f) writes the memory of devices that supply a
+   membuf routine as one block, rather than examining it a word at a
+   time; everything else is saved as usual.  With -z, only the pages
+   that are not all zero are written.  With -i, only the pages that
+   changed since the last fast snapshot saved or restored are written,
+   and the file names that snapshot as its base; restoring it restores
+   the base chain first.  Without a base, -i saves a full snapshot;
+   an incremental snapshot may not be saved over its own base.
 */
 
 t_stat save_cmd (int32 flag, char *cptr)
@@ -2209,34 +2294,47 @@ GET_SWITCHES (cptr);                                    /* get switches */
 if (*cptr == 0)                                         /* must be more */
     return SCPE_2FARG;
 sim_trim_endspc (cptr);
+if ((sim_switches & SWMASK ('F')) && (sim_switches & SWMASK ('I')) &&
+    (strcmp (cptr, sim_snap_base) == 0)) {              /* would overwrite base */
+    printf ("Incremental snapshot cannot replace its base: %s\n", cptr);
+    return SCPE_ARG;
+    }
 if ((sfile = sim_fopen (cptr, "wb")) == NULL)
     return SCPE_OPENERR;
 r = sim_save (sfile);
 fclose (sfile);
+if ((r == SCPE_OK) && (sim_switches & SWMASK ('F')))    /* new snapshot base */
+    strncpy (sim_snap_base, cptr, CBUFSIZE - 1);
+else sim_snap_base[0] = 0;                              /* no base */
 return r;
 }
 
 t_stat sim_save (FILE *sfile)
 {
-void *mbuf;
-int32 l, t;
+int32 t, sw;
 uint32 i, j;
-t_addr k, high;
+t_addr high;
 t_value val;
 t_stat r;
-t_bool zeroflg;
-size_t sz;
 DEVICE *dptr;
 UNIT *uptr;
 REG *rptr;
 
 #define WRITE_I(xx) sim_fwrite (&(xx), sizeof (xx), 1, sfile)
 
+sw = sim_switches;                                      /* save switches */
+if ((sw & SWMASK ('I')) &&                              /* incremental */
+    ((sim_snap_base[0] == 0) || (sim_snap_uptr == NULL))) {
+    printf ("No base snapshot, saving full snapshot\n");
+    sw = sw & ~SWMASK ('I');
+    }
 fprintf (sfile, "%s\n%s\n%s\n%s\n%s\n%.0f\n",
-    save_vercur,                                        /* [V2.5] save format */
+    (sw & SWMASK ('F'))? save_verfst: save_vercur,      /* [V2.5] save format */
     sim_name,                                           /* sim name */
     sim_si64, sim_sa64, sim_snet,                       /* [V3.5] options */
     sim_time);                                          /* [V3.2] sim time */
+if (sw & SWMASK ('F'))                                  /* fast: base */
+    fprintf (sfile, "%s\n", (sw & SWMASK ('I'))? sim_snap_base: "");
 WRITE_I (sim_rtime);                                    /* [V2.6] sim rel time */
 
 for (i = 0; (dptr = sim_devices[i]) != NULL; i++) {     /* loop thru devices */
@@ -2264,31 +2362,11 @@ for (i = 0; (dptr = sim_devices[i]) != NULL; i++) {     /* loop thru devices */
              (dptr->examine != NULL) &&
              ((high = uptr->capac) != 0)) {             /* memory-like unit? */
             WRITE_I (high);                             /* [V2.5] write size */
-            sz = SZ_D (dptr);
-            if ((mbuf = calloc (SRBSIZ, sz)) == NULL) {
-                fclose (sfile);
-                return SCPE_MEM;
-                }
-            for (k = 0; k < high; ) {                   /* loop thru mem */
-                zeroflg = TRUE;
-                for (l = 0; (l < SRBSIZ) && (k < high); l++,
-                     k = k + (dptr->aincr)) {           /* check for 0 block */
-                    r = dptr->examine (&val, k, uptr, SIM_SW_REST);
-                    if (r != SCPE_OK)
-                        return r;
-                    if (val) zeroflg = FALSE;
-                    SZ_STORE (sz, val, mbuf, l);
-                    }                                   /* end for l */
-                if (zeroflg) {                          /* all zero's? */
-                    l = -l;                             /* invert block count */
-                    WRITE_I (l);                        /* write only count */
-                    }
-                else {
-                    WRITE_I (l);                        /* block count */
-                    sim_fwrite (mbuf, sz, l, sfile);
-                    }
-                }                                       /* end for k */
-            free (mbuf);                                /* dealloc buffer */
+            if (sw & SWMASK ('F'))                      /* fast snapshot? */
+                r = sim_save_mem (sfile, dptr, uptr, sw);
+            else r = sim_save_blk (sfile, dptr, uptr);
+            if (r != SCPE_OK)
+                return r;
             }                                           /* end if mem */
         else {                                          /* no memory */
             high = 0;                                   /* write 0 */
@@ -2313,6 +2391,119 @@ fputc ('\n', sfile);                                    /* end devices */
 return (ferror (sfile))? SCPE_IOERR: SCPE_OK;           /* error during save? */
 }
 
+/* Save memory-like unit as blocks of SRBSIZ values, examined one at a
+   time; a block of zeroes is written as its negated count only */
+
+static t_stat sim_save_blk (FILE *sfile, DEVICE *dptr, UNIT *uptr)
+{
+void *mbuf;
+int32 l;
+t_addr k, high;
+t_value val;
+t_stat r;
+t_bool zeroflg;
+size_t sz;
+
+high = uptr->capac;
+sz = SZ_D (dptr);
+if ((mbuf = calloc (SRBSIZ, sz)) == NULL)
+    return SCPE_MEM;
+for (k = 0; k < high; ) {                               /* loop thru mem */
+    zeroflg = TRUE;
+    for (l = 0; (l < SRBSIZ) && (k < high); l++,
+         k = k + (dptr->aincr)) {                       /* check for 0 block */
+        r = dptr->examine (&val, k, uptr, SIM_SW_REST);
+        if (r != SCPE_OK) {
+            free (mbuf);
+            return r;
+            }
+        if (val) zeroflg = FALSE;
+        SZ_STORE (sz, val, mbuf, l);
+        }                                               /* end for l */
+    if (zeroflg) {                                      /* all zero's? */
+        l = -l;                                         /* invert block count */
+        WRITE_I (l);                                    /* write only count */
+        }
+    else {
+        WRITE_I (l);                                    /* block count */
+        sim_fwrite (mbuf, sz, l, sfile);
+        }
+    }                                                   /* end for k */
+free (mbuf);                                            /* dealloc buffer */
+return SCPE_OK;
+}
+
+/* Save memory-like unit in a fast snapshot
+
+   The memory block supplied by the device's membuf routine is an array
+   of SZ_D values.  It is written, after a format word and its length in
+   bytes, as one block (SNAP_RAW), or as a list of SNAP_PGSIZ byte pages,
+   each preceded by its page number and ended by SNAP_END: all the
+   pages that are not zero (SNAP_PAG), or those that differ from the
+   shadow copy taken at the last fast snapshot (SNAP_DIF).  The shadow
+   is then brought up to date.  Devices without membuf are saved as
+   blocks (SNAP_BLK).
+*/
+
+static t_stat sim_save_mem (FILE *sfile, DEVICE *dptr, UNIT *uptr, int32 sw)
+{
+uint8 *mem, *zero;
+int32 fmt;
+uint32 pg, npg, lnt, plnt;
+t_addr mlnt;
+size_t sz;
+
+mem = (dptr->membuf)? (uint8 *) dptr->membuf (uptr, &mlnt): NULL;
+if (mem == NULL) {                                      /* no direct access? */
+    fmt = SNAP_BLK;
+    WRITE_I (fmt);
+    return sim_save_blk (sfile, dptr, uptr);
+    }
+sz = SZ_D (dptr);
+lnt = (uint32) mlnt;
+if ((sw & SWMASK ('I')) && (sim_snap_uptr == uptr) &&   /* shadow usable? */
+    (sim_snap_lnt == mlnt))
+    fmt = SNAP_DIF;
+else if (sw & (SWMASK ('I') | SWMASK ('Z')))
+    fmt = SNAP_PAG;
+else fmt = SNAP_RAW;
+WRITE_I (fmt);
+WRITE_I (lnt);
+zero = NULL;
+if (fmt == SNAP_RAW)                                    /* one block */
+    sim_fwrite (mem, sz, lnt / sz, sfile);
+else {
+    if ((zero = (uint8 *) calloc (SNAP_PGSIZ, 1)) == NULL)
+        return SCPE_MEM;
+    npg = (lnt + SNAP_PGSIZ - 1) / SNAP_PGSIZ;
+    for (pg = 0; pg < npg; pg++) {                      /* loop thru pages */
+        plnt = lnt - pg * SNAP_PGSIZ;
+        if (plnt > SNAP_PGSIZ)
+            plnt = SNAP_PGSIZ;
+        if (memcmp (mem + pg * SNAP_PGSIZ, (fmt == SNAP_DIF)?
+            sim_snap_shadow + pg * SNAP_PGSIZ: zero, plnt) == 0)
+            continue;                                   /* unchanged, skip */
+        WRITE_I (pg);
+        sim_fwrite (mem + pg * SNAP_PGSIZ, sz, plnt / sz, sfile);
+        }
+    pg = SNAP_END;                                      /* end of pages */
+    WRITE_I (pg);
+    }
+if ((sim_snap_uptr != uptr) || (sim_snap_lnt != mlnt)) {/* new shadow? */
+    free (sim_snap_shadow);
+    sim_snap_uptr = NULL;
+    if ((sim_snap_shadow = (uint8 *) malloc (mlnt)) == NULL) {
+        free (zero);
+        return SCPE_MEM;
+        }
+    sim_snap_uptr = uptr;
+    sim_snap_lnt = mlnt;
+    }
+memcpy (sim_snap_shadow, mem, mlnt);                    /* remember contents */
+free (zero);
+return SCPE_OK;
+}
+
 /* Restore command
 
    re[store] filename           restore state from specified file
@@ -2331,20 +2522,23 @@ if ((rfile = sim_fopen (cptr, "rb")) == NULL)
     return SCPE_OPENERR;
 r = sim_rest (rfile);
 fclose (rfile);
+if ((r == SCPE_OK) && (sim_snap_uptr != NULL))          /* was a snapshot? */
+    strncpy (sim_snap_base, cptr, CBUFSIZE - 1);
+else sim_snap_base[0] = 0;
 return r;
 }
 
 t_stat sim_rest (FILE *rfile)
 {
 char buf[CBUFSIZE];
-void *mbuf;
-int32 j, blkcnt, limit, unitno, time, flg;
+int32 unitno, time, flg;
 uint32 us, depth;
-t_addr k, high, old_capac;
+t_addr high, old_capac;
 t_value val, mask;
 t_stat r;
-size_t sz;
-t_bool v35, v32;
+t_bool v35, v32, fast;
+double top_time;
+FILE *bfile;
 DEVICE *dptr;
 UNIT *uptr;
 REG *rptr;
@@ -2355,8 +2549,10 @@ REG *rptr;
     return SCPE_IOERR;
 
 READ_S (buf);                                           /* [V2.5+] read version */
-v35 = v32 = FALSE;
-if (strcmp (buf, save_vercur) == 0)                     /* version 3.5? */
+v35 = v32 = fast = FALSE;
+if (strcmp (buf, save_verfst) == 0)                     /* fast snapshot? */
+    v35 = v32 = fast = TRUE;
+else if (strcmp (buf, save_vercur) == 0)                /* version 3.5? */
     v35 = v32 = TRUE;
 else if (strcmp (buf, save_ver32) == 0)                 /* version 3.2? */
     v32 = TRUE;
@@ -2387,6 +2583,28 @@ if (v32) {                                              /* [V3.2+] time as strin
     sscanf (buf, "%lf", &sim_time);
     }
 else READ_I (sim_time);                                 /* sim time */
+sim_snap_uptr = NULL;                                   /* shadow invalid */
+if (fast) {                                             /* snapshot base */
+    READ_S (buf);
+    if (buf[0] != 0) {                                  /* restore it first */
+        if (sim_snap_nest >= SNAP_NEST) {
+            printf ("Snapshot chain too long: %s\n", buf);
+            return SCPE_INCOMP;
+            }
+        if ((bfile = sim_fopen (buf, "rb")) == NULL) {
+            printf ("Can't open base snapshot: %s\n", buf);
+            return SCPE_OPENERR;
+            }
+        top_time = sim_time;                            /* base sets its own */
+        sim_snap_nest = sim_snap_nest + 1;
+        r = sim_rest (bfile);
+        sim_snap_nest = sim_snap_nest - 1;
+        fclose (bfile);
+        if (r != SCPE_OK)
+            return r;
+        sim_time = top_time;
+        }
+    }
 READ_I (sim_rtime);                                     /* [V2.6+] sim rel time */
 
 for ( ;; ) {                                            /* device loop */
@@ -2475,26 +2693,11 @@ for ( ;; ) {                                            /* device loop */
                 fprint_capac (stdout, dptr, uptr);
                 printf ("\n");
                 }
-            sz = SZ_D (dptr);                           /* allocate buffer */
-            if ((mbuf = calloc (SRBSIZ, sz)) == NULL)
-                return SCPE_MEM;
-            for (k = 0; k < high; ) {                   /* loop thru mem */
-                READ_I (blkcnt);                        /* block count */
-                if (blkcnt < 0)                         /* compressed? */
-                    limit = -blkcnt;
-                else limit = sim_fread (mbuf, sz, blkcnt, rfile);
-                if (limit <= 0)                         /* invalid or err? */
-                    return SCPE_IOERR;
-                for (j = 0; j < limit; j++, k = k + (dptr->aincr)) {
-                    if (blkcnt < 0)                     /* compressed? */
-                        val = 0;
-                    else SZ_LOAD (sz, val, mbuf, j);    /* saved value */
-                    r = dptr->deposit (val, k, uptr, SIM_SW_REST);
-                    if (r != SCPE_OK)
-                        return r;
-                    }                                   /* end for j */
-                }                                       /* end for k */
-            free (mbuf);                                /* dealloc buffer */
+            if (fast)                                   /* fast snapshot? */
+                r = sim_rest_mem (rfile, dptr, uptr);
+            else r = sim_rest_blk (rfile, dptr, uptr);
+            if (r != SCPE_OK)
+                return r;
             }                                           /* end if high */
         }                                               /* end unit loop */
     for ( ;; ) {                                        /* register loop */
@@ -2525,6 +2728,108 @@ for ( ;; ) {                                            /* device loop */
 return SCPE_OK;
 }
 
+/* Restore memory-like unit from blocks written by sim_save_blk */
+
+static t_stat sim_rest_blk (FILE *rfile, DEVICE *dptr, UNIT *uptr)
+{
+void *mbuf;
+int32 j, blkcnt, limit;
+t_addr k, high;
+t_value val;
+t_stat r;
+size_t sz;
+
+high = uptr->capac;
+sz = SZ_D (dptr);                                       /* allocate buffer */
+if ((mbuf = calloc (SRBSIZ, sz)) == NULL)
+    return SCPE_MEM;
+for (k = 0; k < high; ) {                               /* loop thru mem */
+    if (sim_fread (&blkcnt, sizeof (blkcnt), 1, rfile) == 0) {
+        free (mbuf);                                    /* block count */
+        return SCPE_IOERR;
+        }
+    if (blkcnt < 0)                                     /* compressed? */
+        limit = -blkcnt;
+    else limit = sim_fread (mbuf, sz, blkcnt, rfile);
+    if (limit <= 0) {                                   /* invalid or err? */
+        free (mbuf);
+        return SCPE_IOERR;
+        }
+    for (j = 0; j < limit; j++, k = k + (dptr->aincr)) {
+        if (blkcnt < 0)                                 /* compressed? */
+            val = 0;
+        else SZ_LOAD (sz, val, mbuf, j);                /* saved value */
+        r = dptr->deposit (val, k, uptr, SIM_SW_REST);
+        if (r != SCPE_OK) {
+            free (mbuf);
+            return r;
+            }
+        }                                               /* end for j */
+    }                                                   /* end for k */
+free (mbuf);                                            /* dealloc buffer */
+return SCPE_OK;
+}
+
+/* Restore memory-like unit from a fast snapshot written by sim_save_mem;
+   the memory read becomes the shadow for the next incremental save */
+
+static t_stat sim_rest_mem (FILE *rfile, DEVICE *dptr, UNIT *uptr)
+{
+uint8 *mem;
+int32 fmt;
+uint32 pg, lnt, plnt;
+t_addr mlnt;
+size_t sz;
+
+READ_I (fmt);                                           /* format */
+if (fmt == SNAP_BLK)
+    return sim_rest_blk (rfile, dptr, uptr);
+READ_I (lnt);                                           /* length */
+mem = (dptr->membuf)? (uint8 *) dptr->membuf (uptr, &mlnt): NULL;
+if ((mem == NULL) || (mlnt != lnt) || (fmt > SNAP_DIF)) {
+    printf ("Can't restore memory: %s%d\n", sim_dname (dptr),
+        (int32) (uptr - dptr->units));
+    return SCPE_INCOMP;
+    }
+sz = SZ_D (dptr);
+if (fmt == SNAP_RAW) {                                  /* one block */
+    if (sim_fread (mem, sz, lnt / sz, rfile) != (lnt / sz))
+        return SCPE_IOERR;
+    }
+else {
+    if (fmt == SNAP_PAG)                                /* absent = zero */
+        memset (mem, 0, mlnt);
+    else if ((sim_snap_uptr != uptr) || (sim_snap_lnt != mlnt)) {
+        printf ("No base snapshot for memory: %s%d\n", sim_dname (dptr),
+            (int32) (uptr - dptr->units));
+        return SCPE_INCOMP;
+        }
+    for ( ;; ) {                                        /* loop thru pages */
+        READ_I (pg);
+        if (pg == SNAP_END)
+            break;
+        if (pg >= (lnt + SNAP_PGSIZ - 1) / SNAP_PGSIZ)
+            return SCPE_IOERR;
+        plnt = lnt - pg * SNAP_PGSIZ;
+        if (plnt > SNAP_PGSIZ)
+            plnt = SNAP_PGSIZ;
+        if (sim_fread (mem + pg * SNAP_PGSIZ, sz, plnt / sz, rfile) !=
+            (plnt / sz))
+            return SCPE_IOERR;
+        }
+    }
+if ((sim_snap_uptr != uptr) || (sim_snap_lnt != mlnt)) {/* new shadow? */
+    free (sim_snap_shadow);
+    sim_snap_uptr = NULL;
+    if ((sim_snap_shadow = (uint8 *) malloc (mlnt)) == NULL)
+        return SCPE_MEM;
+    sim_snap_lnt = mlnt;
+    }
+memcpy (sim_snap_shadow, mem, mlnt);                    /* remember contents */
+sim_snap_uptr = uptr;
+return SCPE_OK;
+}
+
 /* Run, go, cont, step commands
 
    ru[n] [new PC]       reset and start simulation
@@ -2637,12 +2942,8 @@ sim_ttcmd ();                                           /* restore console */
 signal (SIGINT, SIG_DFL);                               /* cancel WRU */
 sim_cancel (&sim_step_unit);                            /* cancel step timer */
 sim_throt_cancel ();                                    /* cancel throttle */
-if (sim_clock_queue != NULL) {                          /* update sim time */
-    UPDATE_SIM_TIME (sim_clock_queue->time);
-    }
-else {
-    UPDATE_SIM_TIME (noqueue_time);
-    }
+UPDATE_SIM_TIME (noqueue_time);                         /* update sim time */
+sim_aio_drain ();                                       /* finish async I/O */
 if (sim_log)                                            /* flush console log */
     fflush (sim_log);
 if (sim_deb)                                            /* flush debug log */
@@ -2654,8 +2955,10 @@ for (i = 1; (dptr = sim_devices[i]) != NULL; i++) {     /* flush attached files
             !(uptr->flags & UNIT_BUF) &&                /* not buffered, */
             (uptr->fileref) &&                          /* real file, */
             !(uptr->flags & UNIT_RAW) &&                /* not raw, */
-            !(uptr->flags & UNIT_RO))                   /* not read only? */
+            !(uptr->flags & UNIT_RO)) {                 /* not read only? */
             fflush (uptr->fileref);
+            sim_fmsync (uptr, FALSE);                   /* start mapped wb */
+            }
         }
     }
 #if defined (VMS)
@@ -2674,6 +2977,8 @@ t_stat run_boot_prep (void)
 sim_interval = 0;                                       /* reset queue */
 sim_time = sim_rtime = 0;
 noqueue_time = 0;
+sim_qtime = 0;
+sim_evt_ent = 0;
 sim_clock_queue = NULL;
 return reset_all (0);
 }
@@ -4142,8 +4447,19 @@ return SCPE_OK;
    and to see if further events need to be processed, or sim_interval
    reset to count the next one.
 
-   The event queue is maintained in clock order; entry timeouts are
-   RELATIVE to the time in the previous entry.
+   The event queue is a binary heap of (due time, insertion order) pairs
+   in table sim_evt_tab, so that activation and cancellation are O(log n)
+   in the number of pending events rather than a scan of a sorted list.
+   Due times are absolute in queue time sim_qtime, which advances with
+   sim_time; events due at the same time run in the order they were
+   activated.  sim_clock_queue always points to the unit at the top of the
+   heap (the next to run), or is NULL if the queue is empty; noqueue_time
+   holds the value of sim_interval at the last time update.  A unit's
+   time field holds its heap slot + 1 while it is on the queue.
+
+   As with the original sorted list, an event that is serviced late
+   (sim_interval went negative) does not make later events late: queue
+   time is set to the due time of the event being serviced.
 
    sim_process_event - process event
 
@@ -4154,6 +4470,100 @@ return SCPE_OK;
                         or 0 (SCPE_OK) if no exceptions
 */
 
+/* Heap maintenance - move entry at slot k up or down to its place */
+
+static t_bool sim_evt_before (EVTTAB *a, EVTTAB *b)
+{
+return (a->when < b->when) || ((a->when == b->when) && (a->seq < b->seq));
+}
+
+static void sim_evt_put (int32 k, EVTTAB *ep)
+{
+sim_evt_tab[k] = *ep;
+ep->uptr->time = k + 1;                                 /* remember slot */
+return;
+}
+
+static void sim_evt_up (int32 k)
+{
+EVTTAB e = sim_evt_tab[k];
+int32 p;
+
+while (k > 0) {
+    p = (k - 1) >> 1;                                   /* parent */
+    if (!sim_evt_before (&e, &sim_evt_tab[p]))
+        break;
+    sim_evt_put (k, &sim_evt_tab[p]);
+    k = p;
+    }
+sim_evt_put (k, &e);
+return;
+}
+
+static void sim_evt_down (int32 k)
+{
+EVTTAB e = sim_evt_tab[k];
+int32 c;
+
+while ((c = (k << 1) + 1) < sim_evt_ent) {              /* left child */
+    if (((c + 1) < sim_evt_ent) &&                      /* right earlier? */
+        sim_evt_before (&sim_evt_tab[c + 1], &sim_evt_tab[c]))
+        c = c + 1;
+    if (!sim_evt_before (&sim_evt_tab[c], &e))
+        break;
+    sim_evt_put (k, &sim_evt_tab[c]);
+    k = c;
+    }
+sim_evt_put (k, &e);
+return;
+}
+
+/* Find a unit's heap slot, -1 if not queued */
+
+static int32 sim_evt_slot (UNIT *uptr)
+{
+int32 k = uptr->time - 1;
+
+if ((k >= 0) && (k < sim_evt_ent) && (sim_evt_tab[k].uptr == uptr))
+    return k;
+return -1;
+}
+
+/* Remove the entry at slot k */
+
+static void sim_evt_del (int32 k)
+{
+UNIT *uptr = sim_evt_tab[k].uptr;
+
+sim_evt_ent = sim_evt_ent - 1;
+if (k != sim_evt_ent) {                                 /* not last? */
+    sim_evt_put (k, &sim_evt_tab[sim_evt_ent]);         /* fill the hole */
+    if ((k > 0) && sim_evt_before (&sim_evt_tab[k],
+        &sim_evt_tab[(k - 1) >> 1]))
+        sim_evt_up (k);
+    else sim_evt_down (k);
+    }
+uptr->next = NULL;                                      /* hygiene */
+uptr->time = 0;
+return;
+}
+
+/* Reload sim_interval from the top of the heap */
+
+static void sim_evt_sched (void)
+{
+if (sim_evt_ent > 0) {
+    sim_clock_queue = sim_evt_tab[0].uptr;
+    sim_interval = noqueue_time =
+        (int32) (sim_evt_tab[0].when - sim_qtime);
+    }
+else {
+    sim_clock_queue = NULL;
+    sim_interval = noqueue_time = NOQUEUE_WAIT;
+    }
+return;
+}
+
 t_stat sim_process_event (void)
 {
 UNIT *uptr;
@@ -4161,20 +4571,16 @@ t_stat reason;
 
 if (stop_cpu)                                           /* stop CPU? */
     return SCPE_STOP;
-if (sim_clock_queue == NULL) {                          /* queue empty? */
-    UPDATE_SIM_TIME (noqueue_time);                     /* update sim time */
+UPDATE_SIM_TIME (noqueue_time);                         /* update sim time */
+if (sim_evt_ent == 0) {                                 /* queue empty? */
     sim_interval = noqueue_time = NOQUEUE_WAIT;         /* flag queue empty */
     return SCPE_OK;
     }
-UPDATE_SIM_TIME (sim_clock_queue->time);                /* update sim time */
+sim_qtime = sim_evt_tab[0].when;                        /* late is on time */
 do {
-    uptr = sim_clock_queue;                             /* get first */
-    sim_clock_queue = uptr->next;                       /* remove first */
-    uptr->next = NULL;                                  /* hygiene */
-    uptr->time = 0;
-    if (sim_clock_queue != NULL)
-        sim_interval = sim_clock_queue->time;
-    else sim_interval = noqueue_time = NOQUEUE_WAIT;
+    uptr = sim_evt_tab[0].uptr;                         /* get first */
+    sim_evt_del (0);                                    /* remove first */
+    sim_evt_sched ();
     if (uptr->action != NULL)
         reason = uptr->action (uptr);
     else reason = SCPE_OK;
@@ -4196,40 +4602,33 @@ return reason;
 
 t_stat sim_activate (UNIT *uptr, int32 event_time)
 {
-UNIT *cptr, *prvptr;
-int32 accum;
+EVTTAB e, *newp;
+int32 i, t;
 
 if (event_time < 0)
     return SCPE_IERR;
-if (sim_is_active (uptr))                               /* already active? */
+if (sim_evt_slot (uptr) >= 0)                           /* already active? */
     return SCPE_OK;
-if (sim_clock_queue == NULL) {
-    UPDATE_SIM_TIME (noqueue_time);
-    }
-else  {                                                 /* update sim time */
-    UPDATE_SIM_TIME (sim_clock_queue->time);
-    }
-
-prvptr = NULL;
-accum = 0;
-for (cptr = sim_clock_queue; cptr != NULL; cptr = cptr->next) {
-    if (event_time < (accum + cptr->time))
-        break;
-    accum = accum + cptr->time;
-    prvptr = cptr;
-    }
-if (prvptr == NULL) {                                   /* insert at head */
-    cptr = uptr->next = sim_clock_queue;
-    sim_clock_queue = uptr;
-    }
-else {
-    cptr = uptr->next = prvptr->next;                   /* insert at prvptr */
-    prvptr->next = uptr;
-    }
-uptr->time = event_time - accum;
-if (cptr != NULL)
-    cptr->time = cptr->time - uptr->time;
-sim_interval = sim_clock_queue->time;
+UPDATE_SIM_TIME (noqueue_time);                         /* update sim time */
+if (sim_evt_ent >= sim_evt_lnt) {                       /* out of space? */
+    t = (sim_evt_lnt > 0)? sim_evt_lnt * 2: SIM_EVT_INILNT;
+    newp = (EVTTAB *) calloc (t, sizeof (EVTTAB));      /* new table */
+    if (newp == NULL)                                   /* can't extend */
+        return SCPE_MEM;
+    for (i = 0; i < sim_evt_ent; i++)                   /* copy table */
+        newp[i] = sim_evt_tab[i];
+    free (sim_evt_tab);                                 /* free old table */
+    sim_evt_tab = newp;                                 /* new base, lnt */
+    sim_evt_lnt = t;
+    }
+e.when = sim_qtime + event_time;
+e.seq = sim_evt_seq++;
+e.uptr = uptr;
+uptr->next = NULL;
+sim_evt_put (sim_evt_ent, &e);
+sim_evt_ent = sim_evt_ent + 1;
+sim_evt_up (sim_evt_ent - 1);
+sim_evt_sched ();
 return SCPE_OK;
 }
 
@@ -4259,29 +4658,14 @@ return sim_activate (uptr, event_time);
 
 t_stat sim_cancel (UNIT *uptr)
 {
-UNIT *cptr, *nptr;
+int32 k;
 
-if (sim_clock_queue == NULL)
+if (sim_evt_ent == 0)
     return SCPE_OK;
-UPDATE_SIM_TIME (sim_clock_queue->time);                /* update sim time */
-nptr = NULL;
-if (sim_clock_queue == uptr)
-    nptr = sim_clock_queue = uptr->next;
-else {
-    for (cptr = sim_clock_queue; cptr != NULL; cptr = cptr->next) {
-        if (cptr->next == uptr) {
-            nptr = cptr->next = uptr->next;
-            break;                                      /* end queue scan */
-            }
-        }
-    }
-if (nptr != NULL)
-    nptr->time = nptr->time + uptr->time;
-uptr->next = NULL;                                      /* hygiene */
-uptr->time = 0;
-if (sim_clock_queue != NULL)
-    sim_interval = sim_clock_queue->time;
-else sim_interval = noqueue_time = NOQUEUE_WAIT;
+UPDATE_SIM_TIME (noqueue_time);                         /* update sim time */
+if ((k = sim_evt_slot (uptr)) >= 0)
+    sim_evt_del (k);
+sim_evt_sched ();
 return SCPE_OK;
 }
 
@@ -4295,20 +4679,14 @@ return SCPE_OK;
 
 int32 sim_is_active (UNIT *uptr)
 {
-UNIT *cptr;
-int32 accum;
+int32 k, accum;
 
-accum = 0;
-for (cptr = sim_clock_queue; cptr != NULL; cptr = cptr->next) {
-    if (cptr == sim_clock_queue) {
-        if (sim_interval > 0)
-            accum = accum + sim_interval;
-        }
-    else accum = accum + cptr->time;
-    if (cptr == uptr)
-        return accum + 1;
-    }
-return 0;
+if ((k = sim_evt_slot (uptr)) < 0)
+    return 0;
+accum = (int32) (sim_evt_tab[k].when - sim_evt_tab[0].when);
+if (sim_interval > 0)
+    accum = accum + sim_interval;
+return accum + 1;
 }
 
 /* sim_gtime - return global time
@@ -4321,23 +4699,13 @@ return 0;
 
 double sim_gtime (void)
 {
-if (sim_clock_queue == NULL) {
-    UPDATE_SIM_TIME (noqueue_time);
-    }
-else  {
-    UPDATE_SIM_TIME (sim_clock_queue->time);
-    }
+UPDATE_SIM_TIME (noqueue_time);
 return sim_time;
 }
 
 uint32 sim_grtime (void)
 {
-if (sim_clock_queue == NULL) {
-    UPDATE_SIM_TIME (noqueue_time);
-    }
-else  {
-    UPDATE_SIM_TIME (sim_clock_queue->time);
-    }
+UPDATE_SIM_TIME (noqueue_time);
 return sim_rtime;
 }
 
@@ -4350,13 +4718,7 @@ return sim_rtime;
 
 int32 sim_qcount (void)
 {
-int32 cnt;
-UNIT *uptr;
-
-cnt = 0;
-for (uptr = sim_clock_queue; uptr != NULL; uptr = uptr->next)
-    cnt++;
-return cnt;
+return sim_evt_ent;
 }
 
 /* Breakpoint package.  This module replaces the VM-implemented one
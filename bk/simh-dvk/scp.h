@@ -85,6 +85,7 @@ double sim_gtime (void);
 uint32 sim_grtime (void);
 int32 sim_qcount (void);
 t_stat attach_unit (UNIT *uptr, char *cptr);
+t_stat attach_mmap (UNIT *uptr, t_addr size);
 t_stat detach_unit (UNIT *uptr);
 t_stat assign_device (DEVICE *dptr, char *cptr);
 t_stat deassign_device (DEVICE *dptr);
@@ -0,0 +1,195 @@
+/* sim_aio.c: simulator asynchronous I/O library
+
+   This library runs host file transfers for devices on a single I/O
+   thread, so that a slow host disk or a long tape record overlaps with
+   instruction execution instead of stalling the simulator.  Requests are
+   served first in, first out; each unit has at most one request in
+   flight, held in a request block that is allocated the first time the
+   unit asks for one and kept for the life of the simulator.
+
+   Hosts without POSIX threads run each request synchronously inside
+   sim_aio_start; the device sees the same state sequence either way.
+
+   sim_aio_unit         get a unit's request block
+   sim_aio_start        queue a request
+   sim_aio_busy         test for a request still in progress
+   sim_aio_end          collect a completed request
+   sim_aio_cancel       wait for and discard a unit's request
+   sim_aio_drain        wait for all requests
+*/
+
+#include "sim_defs.h"
+#include "sim_aio.h"
+
+#if !defined (_WIN32) && !defined (VMS)
+#define USE_AIO_THREAD
+#include <pthread.h>
+#endif
+
+static SIM_AIO **sim_aio_tab = NULL;                    /* request blocks */
+static int32 sim_aio_nblk = 0;
+
+#if defined (USE_AIO_THREAD)
+
+static pthread_t sim_aio_thread;
+static pthread_mutex_t sim_aio_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sim_aio_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t sim_aio_done = PTHREAD_COND_INITIALIZER;
+static SIM_AIO *sim_aio_head = NULL;                    /* request queue */
+static SIM_AIO *sim_aio_tail = NULL;
+static t_bool sim_aio_run = FALSE;                      /* thread started */
+
+/* I/O thread: take requests off the queue and run them */
+
+static void *sim_aio_worker (void *arg)
+{
+SIM_AIO *ap;
+t_stat r;
+
+pthread_mutex_lock (&sim_aio_lock);
+for ( ;; ) {
+    while (sim_aio_head == NULL)
+        pthread_cond_wait (&sim_aio_work, &sim_aio_lock);
+    ap = sim_aio_head;                                  /* dequeue */
+    sim_aio_head = ap->next;
+    if (sim_aio_head == NULL)
+        sim_aio_tail = NULL;
+    ap->next = NULL;
+    pthread_mutex_unlock (&sim_aio_lock);
+    r = ap->io (ap);                                    /* do the I/O */
+    pthread_mutex_lock (&sim_aio_lock);
+    ap->stat = r;
+    ap->state = AIO_DONE;
+    pthread_cond_broadcast (&sim_aio_done);
+    }
+return NULL;
+}
+
+#endif
+
+/* Get the request block of a unit, allocating it and a private buffer
+   of bufsize bytes on first use */
+
+SIM_AIO *sim_aio_unit (UNIT *uptr, size_t bufsize)
+{
+int32 i;
+SIM_AIO *ap, **nt;
+
+for (i = 0; i < sim_aio_nblk; i++) {
+    if (sim_aio_tab[i]->uptr == uptr)
+        return sim_aio_tab[i];
+    }
+nt = (SIM_AIO **) realloc (sim_aio_tab, (sim_aio_nblk + 1) * sizeof (SIM_AIO *));
+if (nt == NULL)
+    return NULL;
+sim_aio_tab = nt;
+ap = (SIM_AIO *) calloc (1, sizeof (SIM_AIO));
+if (ap == NULL)
+    return NULL;
+ap->buf = calloc (bufsize, 1);
+if (ap->buf == NULL) {
+    free (ap);
+    return NULL;
+    }
+ap->uptr = uptr;
+ap->state = AIO_IDLE;
+sim_aio_tab[sim_aio_nblk] = ap;
+sim_aio_nblk = sim_aio_nblk + 1;
+return ap;
+}
+
+/* Queue a request; io runs on the I/O thread and returns the status
+   that sim_aio_end will hand back */
+
+t_stat sim_aio_start (SIM_AIO *ap, t_stat (*io)(SIM_AIO *ap))
+{
+ap->io = io;
+ap->next = NULL;
+#if defined (USE_AIO_THREAD)
+pthread_mutex_lock (&sim_aio_lock);
+if (!sim_aio_run) {                                     /* first request? */
+    if (pthread_create (&sim_aio_thread, NULL, &sim_aio_worker, NULL) == 0) {
+        pthread_detach (sim_aio_thread);
+        sim_aio_run = TRUE;
+        }
+    }
+if (sim_aio_run) {                                      /* thread running? */
+    ap->state = AIO_BUSY;
+    if (sim_aio_tail)                                   /* enqueue at tail */
+        sim_aio_tail->next = ap;
+    else sim_aio_head = ap;
+    sim_aio_tail = ap;
+    pthread_cond_signal (&sim_aio_work);
+    pthread_mutex_unlock (&sim_aio_lock);
+    return SCPE_OK;
+    }
+pthread_mutex_unlock (&sim_aio_lock);                   /* no thread, do it now */
+#endif
+ap->stat = io (ap);
+ap->state = AIO_DONE;
+return SCPE_OK;
+}
+
+/* Test whether a request is still queued or running */
+
+t_bool sim_aio_busy (SIM_AIO *ap)
+{
+t_bool r;
+
+#if defined (USE_AIO_THREAD)
+pthread_mutex_lock (&sim_aio_lock);
+r = (ap->state == AIO_BUSY);
+pthread_mutex_unlock (&sim_aio_lock);
+#else
+r = (ap->state == AIO_BUSY);
+#endif
+return r;
+}
+
+/* Collect a completed request, waiting for it if need be */
+
+t_stat sim_aio_end (SIM_AIO *ap)
+{
+#if defined (USE_AIO_THREAD)
+pthread_mutex_lock (&sim_aio_lock);
+while (ap->state == AIO_BUSY)
+    pthread_cond_wait (&sim_aio_done, &sim_aio_lock);
+pthread_mutex_unlock (&sim_aio_lock);
+#endif
+ap->state = AIO_IDLE;
+return ap->stat;
+}
+
+/* Wait for a unit's request and throw away its result (detach, reset) */
+
+void sim_aio_cancel (UNIT *uptr)
+{
+int32 i;
+
+for (i = 0; i < sim_aio_nblk; i++) {
+    if (sim_aio_tab[i]->uptr == uptr) {
+        if (sim_aio_tab[i]->state != AIO_IDLE)
+            sim_aio_end (sim_aio_tab[i]);
+        return;
+        }
+    }
+return;
+}
+
+/* Wait until no request is in progress, so that SCP may touch the
+   attached files again; completed requests stay to be collected */
+
+void sim_aio_drain (void)
+{
+#if defined (USE_AIO_THREAD)
+int32 i;
+
+pthread_mutex_lock (&sim_aio_lock);
+for (i = 0; i < sim_aio_nblk; i++) {
+    while (sim_aio_tab[i]->state == AIO_BUSY)
+        pthread_cond_wait (&sim_aio_done, &sim_aio_lock);
+    }
+pthread_mutex_unlock (&sim_aio_lock);
+#endif
+return;
+}
@@ -0,0 +1,45 @@
+/* sim_aio.h: simulator asynchronous I/O library definitions
+
+   A device opts a unit into asynchronous transfers by getting the unit's
+   request block with sim_aio_unit, filling in the transfer parameters and
+   passing it to sim_aio_start together with the routine that does the
+   host I/O.  That routine runs on the I/O thread and must touch nothing
+   but the request block and its own private state.
+
+   Completion is not injected into the event queue from the I/O thread;
+   instead the unit keeps itself scheduled and, while sim_aio_busy is
+   true, simply reschedules.  Once the request is done, the next service
+   call collects the status with sim_aio_end and finishes the transfer
+   (memory copies, status packets) on the simulator thread.
+*/
+
+#ifndef _SIM_AIO_H_
+#define _SIM_AIO_H_     0
+
+#define AIO_IDLE        0                               /* no request */
+#define AIO_BUSY        1                               /* queued or running */
+#define AIO_DONE        2                               /* done, not collected */
+
+typedef struct sim_aio SIM_AIO;
+
+struct sim_aio {
+    UNIT                *uptr;                          /* owning unit */
+    t_stat              (*io)(SIM_AIO *ap);             /* host I/O routine */
+    void                *buf;                           /* private buffer */
+    t_addr              pos;                            /* file position */
+    uint32              cmd;                            /* device command */
+    uint32              len;                            /* transfer length */
+    uint32              res;                            /* device result */
+    t_stat              stat;                           /* I/O status */
+    volatile int32      state;                          /* AIO_xxx */
+    SIM_AIO             *next;                          /* queue link */
+    };
+
+SIM_AIO *sim_aio_unit (UNIT *uptr, size_t bufsize);
+t_stat sim_aio_start (SIM_AIO *ap, t_stat (*io)(SIM_AIO *ap));
+t_bool sim_aio_busy (SIM_AIO *ap);
+t_stat sim_aio_end (SIM_AIO *ap);
+void sim_aio_cancel (UNIT *uptr);
+void sim_aio_drain (void);
+
+#endif
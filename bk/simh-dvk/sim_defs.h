@@ -299,6 +299,8 @@ struct sim_device {
     t_stat              (*msize)(struct sim_unit *up, int32 v, char *cp, void *dp);
                                                         /* mem size routine */
     char                *lname;                         /* logical name */
+    void                *(*membuf)(struct sim_unit *up, t_addr *lnt);
+                                                        /* memory block */
     };
 
 /* Device flags */
@@ -342,7 +344,7 @@ struct sim_unit {
     FILE                *fileref;                       /* file reference */
     void                *filebuf;                       /* memory buffer */
     uint32              hwmark;                         /* high water mark */
-    int32               time;                           /* time out */
+    int32               time;                           /* event queue slot */
     uint32              flags;                          /* flags */
     t_addr              capac;                          /* capacity */
     t_addr              pos;                            /* file position */
@@ -375,6 +377,7 @@ struct sim_unit {
 #define UNIT_RAW        010000                          /* raw mode */
 #define UNIT_TEXT       020000                          /* text mode */
 #define UNIT_IDLE       040000                          /* idle eligible */
+#define UNIT_MMAP       0100000                         /* image mapped */
 
 #define UNIT_UFMASK_31  (((1u << UNIT_V_RSV) - 1) & ~((1u << UNIT_V_UF_31) - 1))
 #define UNIT_UFMASK     (((1u << UNIT_V_RSV) - 1) & ~((1u << UNIT_V_UF) - 1))
@@ -472,6 +475,14 @@ struct sim_brktab {
     char                *act;                           /* action string */
     };
 
+/* Event queue table */
+
+struct sim_evttab {
+    t_int64             when;                           /* due time */
+    t_uint64            seq;                            /* insertion order */
+    struct sim_unit     *uptr;                          /* unit */
+    };
+
 /* Debug table */
 
 struct sim_debtab {
@@ -519,6 +530,7 @@ typedef struct sim_shtab SHTAB;
 typedef struct sim_mtab MTAB;
 typedef struct sim_schtab SCHTAB;
 typedef struct sim_brktab BRKTAB;
+typedef struct sim_evttab EVTTAB;
 typedef struct sim_debtab DEBTAB;
 
 /* Function prototypes */
@@ -41,8 +41,12 @@
    sim_write    -       endian independent write (formerly fxwrite)
    sim_fseek    -       extended (>32b) seek (formerly fseek_ext)
    sim_fsize    -       get file size
+   sim_fmap     -       map an attached disk image into memory
+   sim_fmsync   -       write back a mapped image
+   sim_funmap   -       write back and unmap a mapped image
 
-   sim_fopen and sim_fseek are OS-dependent.  The other routines are not.
+   sim_fopen, sim_fseek and sim_fmap are OS-dependent.  The other routines
+   are not.
    sim_fsize is always a 32b routine (it is used only with small capacity random
    access devices like fixed head disks and DECtapes).
 */
@@ -327,3 +331,95 @@ return fseek (st, (int32) xpos, origin);
 #endif
 
 uint32 sim_taddr_64 = _SIM_IO_FSEEK_EXT_;
+
+/* Memory-mapped disk images
+
+   ATTACH -M asks a disk controller to map its image into memory rather
+   than go through stdio for every transfer.  The controller's attach
+   routine calls sim_fmap once the unit capacity (size, in bytes) is
+   settled.  A writeable image is extended to the full capacity, so that
+   every block can be addressed; a read only image must already be that
+   long.  On success the unit is flagged UNIT_MMAP, filebuf points to the
+   image and hwmark holds its size; the controller then moves data
+   directly between filebuf and simulated memory with Map_ReadW and
+   Map_WriteW.  fileref stays open, so examine and deposit of the unit
+   still work.  Images are stored little endian, so mapping is refused on
+   big endian hosts, as it is on hosts without mmap; the caller reports
+   the error and carries on with ordinary file I/O.
+*/
+
+#if defined (__unix__) || defined (__APPLE__)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+t_stat sim_fmap (UNIT *uptr, t_addr size)
+{
+int fd, prot;
+void *mp;
+struct stat st;
+
+if (!sim_end || (size == 0) || (uptr->fileref == NULL))
+    return SCPE_NOFNC;
+fflush (uptr->fileref);                                 /* flush stdio */
+fd = fileno (uptr->fileref);
+if (fstat (fd, &st) < 0)
+    return SCPE_IOERR;
+if ((t_addr) st.st_size < size) {                       /* short image? */
+    if (uptr->flags & UNIT_RO)
+        return SCPE_NOFNC;
+    if (ftruncate (fd, size) < 0)                       /* extend it */
+        return SCPE_IOERR;
+    }
+prot = (uptr->flags & UNIT_RO)? PROT_READ: PROT_READ | PROT_WRITE;
+mp = mmap (NULL, size, prot, MAP_SHARED, fd, 0);
+if (mp == MAP_FAILED)
+    return SCPE_IOERR;
+uptr->filebuf = mp;
+uptr->hwmark = (uint32) size;
+uptr->flags = uptr->flags | UNIT_MMAP;
+return SCPE_OK;
+}
+
+t_stat sim_fmsync (UNIT *uptr, t_bool wait)
+{
+if (!(uptr->flags & UNIT_MMAP) || (uptr->flags & UNIT_RO))
+    return SCPE_OK;
+if (msync (uptr->filebuf, uptr->hwmark, wait? MS_SYNC: MS_ASYNC) < 0)
+    return SCPE_IOERR;
+return SCPE_OK;
+}
+
+t_stat sim_funmap (UNIT *uptr)
+{
+t_stat r;
+
+if (!(uptr->flags & UNIT_MMAP))
+    return SCPE_OK;
+r = sim_fmsync (uptr, TRUE);
+munmap (uptr->filebuf, uptr->hwmark);
+uptr->filebuf = NULL;
+uptr->hwmark = 0;
+uptr->flags = uptr->flags & ~UNIT_MMAP;
+return r;
+}
+
+#else                                                   /* no mmap */
+
+t_stat sim_fmap (UNIT *uptr, t_addr size)
+{
+return SCPE_NOFNC;
+}
+
+t_stat sim_fmsync (UNIT *uptr, t_bool wait)
+{
+return SCPE_OK;
+}
+
+t_stat sim_funmap (UNIT *uptr)
+{
+return SCPE_OK;
+}
+
+#endif
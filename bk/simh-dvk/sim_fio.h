@@ -42,5 +42,8 @@ size_t sim_fread (void *bptr, size_t size, size_t count, FILE *fptr);
 size_t sim_fwrite (void *bptr, size_t size, size_t count, FILE *fptr);
 uint32 sim_fsize (FILE *fptr);
 uint32 sim_fsize_name (char *fname);
+t_stat sim_fmap (UNIT *uptr, t_addr size);
+t_stat sim_fmsync (UNIT *uptr, t_bool wait);
+t_stat sim_funmap (UNIT *uptr);
 
 #endif
@@ -0,0 +1,358 @@
+/*
+ * Lane-parallel versions of the General Purpose Hash Functions.
+ *
+ * A batch holds up to LANES keys, transposed so that row i contains
+ * byte i of every key, widened to a lane.  All keys are transposed
+ * once by lanes_load(), and the batches are reused for every
+ * function.  Each kernel walks the rows, computing the next state of
+ * all lanes, and keeps the old state in the lanes whose key has
+ * already ended.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "GeneralHashFunctions.h"
+#include "HashLanes.h"
+
+typedef unsigned int lane_t __attribute__ ((vector_size (LANES * 4)));
+
+struct batch {
+	unsigned int	nkeys;			/* keys in batch */
+	unsigned int	maxlen;			/* longest key */
+	lane_t		len;			/* key lengths */
+	lane_t		*row;			/* transposed keys, maxlen rows */
+};
+
+struct lanekeys {
+	unsigned int	nkeys;			/* keys */
+	unsigned int	nbatch;			/* batches */
+	char		**key;			/* keys, for the long ones */
+	unsigned int	*len;			/* key lengths */
+	struct batch	*batch;			/* transposed batches */
+	lane_t		*rows;			/* rows of all batches */
+};
+
+static const hash_function_t scalar [NHASH] = {
+	RSHash, JSHash, PJWHash, ELFHash, BKDRHash,
+	SDBMHash, DJBHash, DEKHash, APHash,
+};
+
+/*
+ * Keep new state t in the lanes selected by mask m, old state h elsewhere.
+ */
+#define SELECT(m, t, h)	(((t) & (m)) | ((h) & ~(m)))
+
+/*
+ * Broadcast a scalar to all lanes.
+ */
+#define SPLAT(x)	((lane_t) {} + (x))
+
+/*
+ * Row i of a batch (already widened to 32 bits), and the mask
+ * of lanes whose key is longer than i.
+ */
+#define ROW(b, i)	((b)->row[i])
+#define MASK(b, i)	((lane_t) ((b)->len > (i)))
+
+/*
+ * Length of a key in a lane: keys longer than LANE_MAXLEN get 0
+ * and are hashed by the scalar function.
+ */
+#define LANELEN(len, j, n) \
+	(((j) < (n) && (len)[j] <= LANE_MAXLEN) ? (len)[j] : 0)
+
+/*
+ * Transpose up to LANES keys into a batch, its rows are
+ * supplied by the caller.  Bytes past the end of a key
+ * are masked off, so they are left as they are.
+ */
+static void batch_load (struct batch *b, lane_t *row, char **key,
+	unsigned int *len, unsigned int n)
+{
+	unsigned int j, i, l;
+
+	b->nkeys = n;
+	b->maxlen = 0;
+	b->row = row;
+	for (j=0; j<LANES; ++j) {
+		l = LANELEN (len, j, n);
+		b->len[j] = l;
+		if (l > b->maxlen)
+			b->maxlen = l;
+		for (i=0; i<l; ++i)
+			row[i][j] = (unsigned char) key[j][i];
+	}
+}
+
+static void rs_lanes (struct batch *b, lane_t *hp)
+{
+	lane_t h = SPLAT (0), a = SPLAT (63689), c, m;
+	unsigned int i;
+
+	for (i=0; i<b->maxlen; ++i) {
+		c = ROW (b, i);
+		m = MASK (b, i);
+		h = SELECT (m, h * a + c, h);
+		a = a * 378551;
+	}
+	*hp = h;
+}
+
+static void js_lanes (struct batch *b, lane_t *hp)
+{
+	lane_t h = SPLAT (1315423911), c, m;
+	unsigned int i;
+
+	for (i=0; i<b->maxlen; ++i) {
+		c = ROW (b, i);
+		m = MASK (b, i);
+		h = SELECT (m, h ^ ((h << 5) + c + (h >> 2)), h);
+	}
+	*hp = h;
+}
+
+static void pjw_lanes (struct batch *b, lane_t *hp)
+{
+	lane_t h = SPLAT (0), t, c, m;
+	unsigned int i;
+
+	for (i=0; i<b->maxlen; ++i) {
+		c = ROW (b, i);
+		m = MASK (b, i);
+		t = (h << 4) + c;
+		t = (t ^ ((t & 0xF0000000) >> 24)) & ~0xF0000000;
+		h = SELECT (m, t, h);
+	}
+	*hp = h;
+}
+
+static void elf_lanes (struct batch *b, lane_t *hp)
+{
+	lane_t h = SPLAT (0), t, x, c, m;
+	unsigned int i;
+
+	for (i=0; i<b->maxlen; ++i) {
+		c = ROW (b, i);
+		m = MASK (b, i);
+		t = (h << 4) + c;
+		x = t & 0xF0000000;
+		t = (t ^ (x >> 24)) & ~x;
+		h = SELECT (m, t, h);
+	}
+	*hp = h;
+}
+
+static void bkdr_lanes (struct batch *b, lane_t *hp)
+{
+	lane_t h = SPLAT (0), c, m;
+	unsigned int i;
+
+	for (i=0; i<b->maxlen; ++i) {
+		c = ROW (b, i);
+		m = MASK (b, i);
+		h = SELECT (m, h * 131 + c, h);
+	}
+	*hp = h;
+}
+
+static void sdbm_lanes (struct batch *b, lane_t *hp)
+{
+	lane_t h = SPLAT (0), c, m;
+	unsigned int i;
+
+	for (i=0; i<b->maxlen; ++i) {
+		c = ROW (b, i);
+		m = MASK (b, i);
+		h = SELECT (m, c + (h << 6) + (h << 16) - h, h);
+	}
+	*hp = h;
+}
+
+static void djb_lanes (struct batch *b, lane_t *hp)
+{
+	lane_t h = SPLAT (5381), c, m;
+	unsigned int i;
+
+	for (i=0; i<b->maxlen; ++i) {
+		c = ROW (b, i);
+		m = MASK (b, i);
+		h = SELECT (m, (h << 5) + h + c, h);
+	}
+	*hp = h;
+}
+
+static void dek_lanes (struct batch *b, lane_t *hp)
+{
+	lane_t h = b->len, c, m;
+	unsigned int i;
+
+	for (i=0; i<b->maxlen; ++i) {
+		c = ROW (b, i);
+		m = MASK (b, i);
+		h = SELECT (m, ((h << 5) ^ (h >> 27)) ^ c, h);
+	}
+	*hp = h;
+}
+
+static void ap_lanes (struct batch *b, lane_t *hp)
+{
+	lane_t h = SPLAT (0), t, c, m;
+	unsigned int i;
+
+	for (i=0; i<b->maxlen; ++i) {
+		c = ROW (b, i);
+		m = MASK (b, i);
+		if ((i & 1) == 0)
+			t = (h << 7) ^ c ^ (h >> 3);
+		else
+			t = ~((h << 11) ^ c ^ (h >> 5));
+		h = SELECT (m, h ^ t, h);
+	}
+	*hp = h;
+}
+
+static void (*const kernel [NHASH]) (struct batch*, lane_t*) = {
+	rs_lanes, js_lanes, pjw_lanes, elf_lanes, bkdr_lanes,
+	sdbm_lanes, djb_lanes, dek_lanes, ap_lanes,
+};
+
+/*
+ * Store the lanes of a batch; long keys are hashed by the scalar function.
+ */
+static void batch_store (struct batch *b, int f, char **key,
+	unsigned int *len, lane_t *h, unsigned int *out)
+{
+	unsigned int j;
+
+	for (j=0; j<b->nkeys; ++j) {
+		if (len[j] > LANE_MAXLEN)
+			out[j] = scalar[f] (key[j], len[j]);
+		else
+			out[j] = (*h)[j];
+	}
+}
+
+/*
+ * Transpose all keys once; the batches are then hashed
+ * by any number of functions.
+ */
+struct lanekeys *lanes_load (char **key, unsigned int *len, unsigned int n)
+{
+	struct lanekeys *lk;
+	unsigned int k, nb, j, l, maxlen, nrows;
+
+	lk = malloc (sizeof (*lk));
+	if (! lk)
+		return 0;
+	lk->nkeys = n;
+	lk->nbatch = (n + LANES - 1) / LANES;
+	lk->key = key;
+	lk->len = len;
+	nrows = 0;
+	for (k=0; k<n; k+=LANES) {
+		nb = (n - k < LANES) ? n - k : LANES;
+		maxlen = 0;
+		for (j=0; j<nb; ++j) {
+			l = LANELEN (len + k, j, nb);
+			if (l > maxlen)
+				maxlen = l;
+		}
+		nrows += maxlen;
+	}
+	/* Vectors need their natural alignment, wider than malloc's. */
+	if (posix_memalign ((void**) &lk->batch, sizeof (lane_t),
+	    (lk->nbatch + 1) * sizeof (struct batch)) != 0)
+		lk->batch = 0;
+	if (posix_memalign ((void**) &lk->rows, sizeof (lane_t),
+	    (nrows + 1) * sizeof (lane_t)) != 0)
+		lk->rows = 0;
+	if (! lk->batch || ! lk->rows) {
+		lanes_free (lk);
+		return 0;
+	}
+	memset (lk->rows, 0, (nrows + 1) * sizeof (lane_t));
+	nrows = 0;
+	for (k=0; k<n; k+=nb) {
+		nb = (n - k < LANES) ? n - k : LANES;
+		batch_load (lk->batch + k / LANES, lk->rows + nrows,
+			key + k, len + k, nb);
+		nrows += lk->batch[k / LANES].maxlen;
+	}
+	return lk;
+}
+
+void lanes_free (struct lanekeys *lk)
+{
+	free (lk->batch);
+	free (lk->rows);
+	free (lk);
+}
+
+void lanes_run (struct lanekeys *lk, int f, unsigned int *out)
+{
+	unsigned int n;
+	lane_t h;
+
+	for (n=0; n<lk->nbatch; ++n) {
+		kernel[f] (lk->batch + n, &h);
+		batch_store (lk->batch + n, f, lk->key + n * LANES,
+			lk->len + n * LANES, &h, out + n * LANES);
+	}
+}
+
+/*
+ * All functions at once: each row is widened once,
+ * then feeds the NHASH states.
+ */
+void lanes_run_all (struct lanekeys *lk, unsigned int *out[NHASH])
+{
+	struct batch b;
+	lane_t rs, rsa, js, pjw, elf, bkdr, sdbm, djb, dek, ap, t, c, m;
+	unsigned int n, k, i;
+	char **key;
+	unsigned int *len;
+
+	key = lk->key;
+	len = lk->len;
+	for (n=0; n<lk->nbatch; ++n) {
+		b = lk->batch[n];
+		k = n * LANES;
+
+		rs = pjw = elf = bkdr = sdbm = ap = SPLAT (0);
+		rsa = SPLAT (63689);
+		js = SPLAT (1315423911);
+		djb = SPLAT (5381);
+		dek = b.len;
+		for (i=0; i<b.maxlen; ++i) {
+			c = ROW (&b, i);
+			m = MASK (&b, i);
+			rs = SELECT (m, rs * rsa + c, rs);
+			rsa = rsa * 378551;
+			js = SELECT (m, js ^ ((js << 5) + c + (js >> 2)), js);
+			t = (pjw << 4) + c;
+			t = (t ^ ((t & 0xF0000000) >> 24)) & ~0xF0000000;
+			pjw = SELECT (m, t, pjw);
+			t = (elf << 4) + c;
+			t = (t ^ ((t & 0xF0000000) >> 24)) & ~(t & 0xF0000000);
+			elf = SELECT (m, t, elf);
+			bkdr = SELECT (m, bkdr * 131 + c, bkdr);
+			sdbm = SELECT (m, c + (sdbm << 6) + (sdbm << 16) - sdbm,
+				sdbm);
+			djb = SELECT (m, (djb << 5) + djb + c, djb);
+			dek = SELECT (m, ((dek << 5) ^ (dek >> 27)) ^ c, dek);
+			if ((i & 1) == 0)
+				t = (ap << 7) ^ c ^ (ap >> 3);
+			else
+				t = ~((ap << 11) ^ c ^ (ap >> 5));
+			ap = SELECT (m, ap ^ t, ap);
+		}
+		batch_store (&b, 0, key + k, len + k, &rs, out[0] + k);
+		batch_store (&b, 1, key + k, len + k, &js, out[1] + k);
+		batch_store (&b, 2, key + k, len + k, &pjw, out[2] + k);
+		batch_store (&b, 3, key + k, len + k, &elf, out[3] + k);
+		batch_store (&b, 4, key + k, len + k, &bkdr, out[4] + k);
+		batch_store (&b, 5, key + k, len + k, &sdbm, out[5] + k);
+		batch_store (&b, 6, key + k, len + k, &djb, out[6] + k);
+		batch_store (&b, 7, key + k, len + k, &dek, out[7] + k);
+		batch_store (&b, 8, key + k, len + k, &ap, out[8] + k);
+	}
+}
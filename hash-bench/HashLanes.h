@@ -0,0 +1,43 @@
+/*
+ * Lane-parallel versions of the General Purpose Hash Functions.
+ *
+ * Keys are hashed LANES at a time: batches of keys are transposed
+ * into rows of bytes once, and every step of a hash function updates
+ * the state of all lanes at once, using GCC vector extensions.
+ * The results are the same as of the scalar functions.
+ */
+#ifndef INCLUDE_HASHLANES_H
+#define INCLUDE_HASHLANES_H
+
+/* Keys hashed at once: 32-bit lanes filling one native vector */
+#if defined (__AVX512F__)
+#define LANES		16
+#elif defined (__AVX2__)
+#define LANES		8
+#else
+#define LANES		4
+#endif
+#define LANE_MAXLEN	512		/* longer keys are hashed one by one */
+#define NHASH		9		/* rs js pjw elf bkdr sdbm djb dek ap */
+
+struct lanekeys;
+
+/*
+ * Transpose n keys into batches of LANES; returns 0 if out of memory.
+ * The keys must stay in place while the batches are used.
+ */
+struct lanekeys *lanes_load (char **key, unsigned int *len, unsigned int n);
+void lanes_free (struct lanekeys *lk);
+
+/*
+ * Compute hash function number f for all loaded keys.
+ */
+void lanes_run (struct lanekeys *lk, int f, unsigned int *out);
+
+/*
+ * Compute all NHASH functions for the loaded keys in a single pass;
+ * out[f] receives the values of function f.
+ */
+void lanes_run_all (struct lanekeys *lk, unsigned int *out[NHASH]);
+
+#endif
@@ -0,0 +1,149 @@
+/*
+ * Quality metrics of hash functions.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HashStats.h"
+
+static int compare_uint (const void *a, const void *b)
+{
+	unsigned int x = *(const unsigned int*) a;
+	unsigned int y = *(const unsigned int*) b;
+
+	return (x > y) - (x < y);
+}
+
+static void *xalloc (unsigned int nbytes)
+{
+	void *p;
+
+	p = calloc (1, nbytes);
+	if (! p) {
+		perror ("malloc");
+		exit (-1);
+	}
+	return p;
+}
+
+/*
+ * The same as "sort +1 | uniq -d -f1 | wc -l".
+ */
+unsigned int hash_collisions (unsigned int *hash, unsigned int n)
+{
+	unsigned int *v, i, count;
+
+	v = xalloc (n * sizeof (*v) + 1);
+	memcpy (v, hash, n * sizeof (*v));
+	qsort (v, n, sizeof (*v), compare_uint);
+	count = 0;
+	for (i=1; i<n; ++i)
+		if (v[i] == v[i-1] && (i == 1 || v[i-1] != v[i-2]))
+			++count;
+	free (v);
+	return count;
+}
+
+double hash_chisquare (unsigned int *hash, unsigned int n,
+	unsigned int size, int prime)
+{
+	unsigned int *load, i;
+	double expect, d, chi2;
+
+	if (size < 2 || n == 0)
+		return 0;
+	load = xalloc (size * sizeof (*load));
+	for (i=0; i<n; ++i)
+		++load [prime ? hash[i] % size : hash[i] & (size - 1)];
+
+	expect = (double) n / size;
+	chi2 = 0;
+	for (i=0; i<size; ++i) {
+		d = load[i] - expect;
+		chi2 += d * d;
+	}
+	free (load);
+	return chi2 / expect / (size - 1);
+}
+
+unsigned int prime_below (unsigned int n)
+{
+	unsigned int d;
+
+	for (; n > 2; --n) {
+		if (! (n & 1))
+			continue;
+		for (d=3; d*d<=n; d+=2)
+			if (n % d == 0)
+				break;
+		if (d*d > n)
+			return n;
+	}
+	return 2;
+}
+
+void hash_avalanche (hash_function_t f, char **key, unsigned int *len,
+	unsigned int n, unsigned int nsample,
+	double prob [AVAL_INBITS][AVAL_OUTBITS])
+{
+	static unsigned int count [AVAL_INBITS][AVAL_OUTBITS];
+	unsigned int trials [AVAL_INBITS];
+	unsigned int k, step, i, j, nbits, h, diff, maxlen;
+	char *buf;
+
+	memset (count, 0, sizeof (count));
+	memset (trials, 0, sizeof (trials));
+	maxlen = 0;
+	for (k=0; k<n; ++k)
+		if (len[k] > maxlen)
+			maxlen = len[k];
+	buf = xalloc (maxlen + 1);
+
+	step = (nsample && n > nsample) ? n / nsample : 1;
+	for (k=0; k<n; k+=step) {
+		memcpy (buf, key[k], len[k]);
+		h = f (buf, len[k]);
+		nbits = len[k] * 8;
+		if (nbits > AVAL_INBITS)
+			nbits = AVAL_INBITS;
+		for (i=0; i<nbits; ++i) {
+			buf [i/8] ^= 1 << (i%8);
+			diff = h ^ f (buf, len[k]);
+			buf [i/8] ^= 1 << (i%8);
+			for (j=0; j<AVAL_OUTBITS; ++j)
+				count[i][j] += (diff >> j) & 1;
+			++trials[i];
+		}
+	}
+	free (buf);
+
+	for (i=0; i<AVAL_INBITS; ++i)
+		for (j=0; j<AVAL_OUTBITS; ++j)
+			prob[i][j] = trials[i] ?
+				(double) count[i][j] / trials[i] : -1;
+}
+
+void avalanche_bias (double prob [AVAL_INBITS][AVAL_OUTBITS],
+	double *mean, double *worst)
+{
+	unsigned int i, j, ncells;
+	double b;
+
+	*mean = *worst = 0;
+	ncells = 0;
+	for (i=0; i<AVAL_INBITS; ++i) {
+		if (prob[i][0] < 0)
+			continue;
+		for (j=0; j<AVAL_OUTBITS; ++j) {
+			b = prob[i][j] * 2 - 1;
+			if (b < 0)
+				b = -b;
+			*mean += b;
+			if (b > *worst)
+				*worst = b;
+			++ncells;
+		}
+	}
+	if (ncells)
+		*mean /= ncells;
+}
@@ -0,0 +1,53 @@
+/*
+ * Quality metrics of hash functions.
+ *
+ * Collisions count equal 32-bit values.  The chi-square test checks
+ * how evenly the keys fall into the buckets of a table, indexed
+ * by the low bits for a power-of-two size or by the remainder
+ * for a prime size.  The avalanche matrix shows, for every input
+ * bit, how often flipping it changes each bit of the hash.
+ */
+#ifndef INCLUDE_HASHSTATS_H
+#define INCLUDE_HASHSTATS_H
+
+#include "GeneralHashFunctions.h"
+
+#define AVAL_INBITS	64		/* input bits tested: first 8 bytes */
+#define AVAL_OUTBITS	32		/* bits of hash value */
+
+/*
+ * Number of hash values which occur more than once.
+ */
+unsigned int hash_collisions (unsigned int *hash, unsigned int n);
+
+/*
+ * Chi-square of bucket loads, divided by the degrees of freedom:
+ * near 1 for a uniform hash, larger for a skewed one.
+ * With prime == 0 the size must be a power of two.
+ */
+double hash_chisquare (unsigned int *hash, unsigned int n,
+	unsigned int size, int prime);
+
+/*
+ * Largest prime not above n.
+ */
+unsigned int prime_below (unsigned int n);
+
+/*
+ * Avalanche matrix: prob[i][j] is the share of keys where flipping
+ * input bit i changes output bit j; 0.5 is ideal.  Bits past the end
+ * of a key are not tested; rows never tested get -1.  At most
+ * nsample keys are used, spread over the whole set.
+ */
+void hash_avalanche (hash_function_t f, char **key, unsigned int *len,
+	unsigned int n, unsigned int nsample,
+	double prob [AVAL_INBITS][AVAL_OUTBITS]);
+
+/*
+ * Mean and maximum of |2p - 1| over the tested cells of the matrix:
+ * 0 is a perfect avalanche, 1 means bits that never or always change.
+ */
+void avalanche_bias (double prob [AVAL_INBITS][AVAL_OUTBITS],
+	double *mean, double *worst);
+
+#endif
@@ -2,7 +2,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <getopt.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "GeneralHashFunctions.h"
+#include "HashLanes.h"
+#include "HashStats.h"
 
 const char version[] = "1.0";
 const char copyright[] = "Copyright (C) 2006 Serge Vakulenko";
@@ -10,19 +17,43 @@ const char copyright[] = "Copyright (C) 2006 Serge Vakulenko";
 char *progname;
 
 hash_function_t func = 0;
+int throughput;
+int analyze;
+int repeat = 10;
+int sample = 10000;
 
-/* options descriptor */
+/* hash functions, in the order of HashLanes.h */
+static const struct {
+	const char	*name;
+	hash_function_t	func;
+} functab [NHASH] = {
+	{ "rs",		RSHash },
+	{ "js",		JSHash },
+	{ "pjw",	PJWHash },
+	{ "elf",	ELFHash },
+	{ "bkdr",	BKDRHash },
+	{ "sdbm",	SDBMHash },
+	{ "djb",	DJBHash },
+	{ "dek",	DEKHash },
+	{ "ap",		APHash },
+};
+
+/* options descriptor; a hash function option returns its index + 1 */
 static struct option longopts[] = {
-	{ "rs",		no_argument,	(int*) &func,	(int) RSHash, },
-	{ "js",		no_argument,	(int*) &func,	(int) JSHash, },
-	{ "pjw",	no_argument,	(int*) &func,	(int) PJWHash, },
-	{ "elf",	no_argument,	(int*) &func,	(int) ELFHash, },
-	{ "bkdr",	no_argument,	(int*) &func,	(int) BKDRHash, },
-	{ "sdbm",	no_argument,	(int*) &func,	(int) SDBMHash, },
-	{ "djb",	no_argument,	(int*) &func,	(int) DJBHash, },
-	{ "dek",	no_argument,	(int*) &func,	(int) DEKHash, },
-	{ "ap",		no_argument,	(int*) &func,	(int) APHash, },
-	{ 0,		0,		0,		0, },
+	{ "rs",		no_argument,		0,	1, },
+	{ "js",		no_argument,		0,	2, },
+	{ "pjw",	no_argument,		0,	3, },
+	{ "elf",	no_argument,		0,	4, },
+	{ "bkdr",	no_argument,		0,	5, },
+	{ "sdbm",	no_argument,		0,	6, },
+	{ "djb",	no_argument,		0,	7, },
+	{ "dek",	no_argument,		0,	8, },
+	{ "ap",		no_argument,		0,	9, },
+	{ "throughput",	no_argument,		0,	't', },
+	{ "repeat",	required_argument,	0,	'r', },
+	{ "analyze",	no_argument,		0,	'a', },
+	{ "sample",	required_argument,	0,	's', },
+	{ 0,		0,			0,	0, },
 };
 
 void usage ()
@@ -32,6 +63,10 @@ void usage ()
         fprintf (stderr, "\t%s [--rs | --js | --pjw | --elf | --bkdr | --sdbm |\n",
                 progname);
         fprintf (stderr, "\t\t\t--djb | --dek | --ap] [file]\n");
+        fprintf (stderr, "\t%s --throughput [--repeat=N] [file]\n",
+                progname);
+        fprintf (stderr, "\t%s --analyze [--sample=N] [--rs | ... | --ap] [file]\n",
+                progname);
 	exit (-1);
 }
 
@@ -50,21 +85,286 @@ void bench ()
 	}
 }
 
+/*
+ * Time in nanoseconds.
+ */
+double now ()
+{
+	struct timespec ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+struct word {
+	char		*key;
+	unsigned int	len;
+};
+
+int compare_len (const void *a, const void *b)
+{
+	unsigned int x = ((const struct word*) a)->len;
+	unsigned int y = ((const struct word*) b)->len;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * Map the input and collect the words, the same as in bench():
+ * the beginning of each line up to the first delimiter.
+ * Keys are sorted by length, so that similar ones fill the lanes evenly.
+ */
+unsigned int load_words (int fd, char ***keyp, unsigned int **lenp,
+	double *nbytes)
+{
+	struct stat st;
+	char *text, *p, *end, **key;
+	struct word *word;
+	unsigned int *len, nkeys, i;
+
+	if (fstat (fd, &st) < 0 || st.st_size == 0) {
+		fprintf (stderr, "%s: empty input\n", progname);
+		exit (-1);
+	}
+	text = mmap (0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (text == MAP_FAILED) {
+		perror ("mmap");
+		exit (-1);
+	}
+	end = text + st.st_size;
+
+	nkeys = 0;
+	for (p=text; p<end; ++p)
+		if (*p == '\n')
+			++nkeys;
+	word = malloc ((nkeys + 1) * sizeof (*word));
+	key = malloc ((nkeys + 1) * sizeof (*key));
+	len = malloc ((nkeys + 1) * sizeof (*len));
+	if (! word || ! key || ! len) {
+		perror ("malloc");
+		exit (-1);
+	}
+	nkeys = 0;
+	for (p=text; p<end; ) {
+		for (i=0; p+i<end && ! strchr ("/ \t\f\r\n", p[i]); ++i)
+			continue;
+		if (i > 0) {
+			word[nkeys].key = p;
+			word[nkeys].len = i;
+			++nkeys;
+		}
+		p = memchr (p, '\n', end - p);
+		if (! p)
+			break;
+		++p;
+	}
+	qsort (word, nkeys, sizeof (*word), compare_len);
+	*nbytes = 0;
+	for (i=0; i<nkeys; ++i) {
+		key[i] = word[i].key;
+		len[i] = word[i].len;
+		*nbytes += len[i];
+	}
+	free (word);
+	*keyp = key;
+	*lenp = len;
+	return nkeys;
+}
+
+/*
+ * Throughput mode: hash all words with every function,
+ * scalar and by lanes, and report the speed.
+ */
+void bench_throughput (char **key, unsigned int *len, unsigned int nkeys,
+	double nbytes)
+{
+	unsigned int *hash, *lhash, *all [NHASH];
+	struct lanekeys *lk;
+	unsigned int i, f, r, coll;
+	double t, ts, tl;
+
+	hash = malloc ((nkeys + 1) * sizeof (*hash));
+	lhash = malloc ((nkeys + 1) * sizeof (*lhash));
+	if (! hash || ! lhash) {
+		perror ("malloc");
+		exit (-1);
+	}
+	for (f=0; f<NHASH; ++f) {
+		all[f] = malloc ((nkeys + 1) * sizeof (*all[f]));
+		if (! all[f]) {
+			perror ("malloc");
+			exit (-1);
+		}
+	}
+
+	/* The keys are transposed once for all functions. */
+	t = now ();
+	lk = lanes_load (key, len, nkeys);
+	t = now () - t;
+	if (! lk) {
+		perror ("malloc");
+		exit (-1);
+	}
+	printf ("%u keys, %.0f bytes, %d repeats, %d lanes\n",
+		nkeys, nbytes, repeat, LANES);
+	printf ("transposed once in %.2f ns/key\n\n", t / nkeys);
+	printf ("func    coll    scalar ns/key    GB/s    lanes ns/key    GB/s\n");
+
+	for (f=0; f<NHASH; ++f) {
+		t = now ();
+		for (r=0; r<repeat; ++r)
+			for (i=0; i<nkeys; ++i)
+				hash[i] = functab[f].func (key[i], len[i]);
+		ts = (now () - t) / repeat;
+
+		t = now ();
+		for (r=0; r<repeat; ++r)
+			lanes_run (lk, f, lhash);
+		tl = (now () - t) / repeat;
+
+		if (memcmp (hash, lhash, nkeys * sizeof (*hash)) != 0) {
+			fprintf (stderr, "%s: lanes differ from scalar\n",
+				functab[f].name);
+			exit (-1);
+		}
+		coll = hash_collisions (hash, nkeys);
+		printf ("%-6s %6u  %10.2f     %7.3f  %10.2f     %7.3f\n",
+			functab[f].name, coll, ts / nkeys, nbytes / ts,
+			tl / nkeys, nbytes / tl);
+	}
+
+	/* All functions in a single pass over the keys. */
+	t = now ();
+	for (r=0; r<repeat; ++r)
+		lanes_run_all (lk, all);
+	tl = (now () - t) / repeat;
+	for (f=0; f<NHASH; ++f) {
+		lanes_run (lk, f, lhash);
+		if (memcmp (all[f], lhash, nkeys * sizeof (*lhash)) != 0) {
+			fprintf (stderr, "%s: single pass differs\n",
+				functab[f].name);
+			exit (-1);
+		}
+	}
+	printf ("\nall %d in one pass: %.2f ns/key, %.3f GB/s\n",
+		NHASH, tl / nkeys, nbytes * NHASH / tl);
+	lanes_free (lk);
+}
+
+/*
+ * Print the avalanche matrix, one row per input bit, output bit 0 first.
+ * A digit is the probability of a change in tenths: 5 is ideal.
+ */
+void print_avalanche (double prob [AVAL_INBITS][AVAL_OUTBITS])
+{
+	unsigned int i, j;
+	int d;
+
+	printf ("\nbit  output bits 0..%d\n", AVAL_OUTBITS - 1);
+	for (i=0; i<AVAL_INBITS; ++i) {
+		if (prob[i][0] < 0)
+			continue;
+		printf ("%3u  ", i);
+		for (j=0; j<AVAL_OUTBITS; ++j) {
+			d = prob[i][j] * 10 + 0.5;
+			putchar (d > 9 ? '9' : '0' + d);
+		}
+		putchar ('\n');
+	}
+}
+
+/*
+ * Analysis mode: for every function (or the selected one),
+ * full 32-bit collisions, bucket-load chi-square for a table
+ * with load factor 1, sized a power of two and a prime,
+ * and the avalanche bias.  For a selected function
+ * the whole avalanche matrix is printed.
+ */
+void bench_analyze (char **key, unsigned int *len, unsigned int nkeys)
+{
+	static double prob [AVAL_INBITS][AVAL_OUTBITS];
+	unsigned int *hash, i, f, pow2, prime;
+	double mean, worst;
+
+	hash = malloc ((nkeys + 1) * sizeof (*hash));
+	if (! hash) {
+		perror ("malloc");
+		exit (-1);
+	}
+	for (pow2=2; pow2<nkeys && pow2<0x80000000; pow2<<=1)
+		continue;
+	prime = prime_below (pow2);
+	printf ("%u keys, table sizes %u and %u, avalanche on %u keys\n\n",
+		nkeys, pow2, prime, (sample && nkeys > sample) ? sample : nkeys);
+	printf ("func    coll  chi2/%-8u chi2/%-8u  aval.mean  worst\n",
+		pow2, prime);
+
+	for (f=0; f<NHASH; ++f) {
+		if (func && func != functab[f].func)
+			continue;
+		for (i=0; i<nkeys; ++i)
+			hash[i] = functab[f].func (key[i], len[i]);
+		hash_avalanche (functab[f].func, key, len, nkeys, sample, prob);
+		avalanche_bias (prob, &mean, &worst);
+		printf ("%-6s %6u  %10.3f    %10.3f     %8.3f  %5.3f\n",
+			functab[f].name, hash_collisions (hash, nkeys),
+			hash_chisquare (hash, nkeys, pow2, 0),
+			hash_chisquare (hash, nkeys, prime, 1),
+			mean, worst);
+		if (func)
+			print_avalanche (prob);
+	}
+	free (hash);
+}
+
 int main (int argc, char **argv)
 {
+	char **key;
+	unsigned int *len, nkeys;
+	double nbytes;
+	int c;
+
 	progname = *argv;
-	while (getopt_long (argc, argv, "", longopts, 0) >= 0)
-		continue;
+	while ((c = getopt_long (argc, argv, "tr:as:", longopts, 0)) >= 0) {
+		switch (c) {
+		case 't':
+			throughput = 1;
+			break;
+		case 'a':
+			analyze = 1;
+			break;
+		case 's':
+			sample = atoi (optarg);
+			break;
+		case 'r':
+			repeat = atoi (optarg);
+			if (repeat < 1)
+				usage ();
+			break;
+		default:
+			if (c < 1 || c > NHASH)
+				usage ();
+			func = functab[c-1].func;
+			break;
+		}
+	}
 	argc -= optind;
 	argv += optind;
 
-	if (! func || argc > 1)
+	if ((! func && ! throughput && ! analyze) || argc > 1)
 		usage ();
 
 	if (argc > 0 && ! freopen (argv[0], "r", stdin)) {
 		perror (argv[0]);
 		exit (-1);
 	}
-	bench ();
+	if (throughput || analyze) {
+		nkeys = load_words (fileno (stdin), &key, &len, &nbytes);
+		if (throughput)
+			bench_throughput (key, len, nkeys, nbytes);
+		if (analyze)
+			bench_analyze (key, len, nkeys);
+	} else
+		bench ();
 	return (0);
 }
@@ -0,0 +1,102 @@
+// ReRap Version 0.9
+// Copyright 2011 Matthew Mikolay.
+//
+// This file is part of ReRap.
+//
+// ReRap is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ReRap is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "chunk.h"
+
+/*** Names of the instructions, for dump() ***/
+static const char* opNames[] =
+{
+	"exec", "eval", "int", "pop", "load", "store", "add", "subtract",
+	"multiply", "divide", "intdivide", "remainder", "exponent", "equal",
+	"unequal", "greater", "less", "greateq", "lesseq", "and", "or", "not",
+	"negate", "length", "chklog", "select", "selvar", "slice", "seq",
+	"call", "chkindex", "setelem", "jump", "jumpf", "jumpt", "caseeq",
+	"output", "newline", "return", "end", "forinit", "fortest", "forstep",
+	"forinc", "repinit", "reptest", "repdec", "chkint", "line"
+};
+
+/*** Constructor ***/
+Instruction::Instruction(unsigned char pOp, int pArg, int pName, int pSlot, Node* pNode)
+{
+	op = pOp;
+	arg = pArg;
+	name = pName;
+	slot = pSlot;
+	node = pNode;
+}
+
+/*** Constructor ***/
+Chunk::Chunk()
+{
+}
+
+/*** Append an instruction, return its address ***/
+unsigned int Chunk::emit(unsigned char op, int arg, int name, int slot, Node* node)
+{
+	code.push_back(Instruction(op, arg, name, slot, node));
+	return code.size() - 1;
+}
+
+/*** Get the address of the next instruction ***/
+unsigned int Chunk::getLength()
+{
+	return code.size();
+}
+
+/*** Get an instruction ***/
+Instruction& Chunk::getInstruction(unsigned int addr)
+{
+	return code[addr];
+}
+
+/*** Get the index of a name, adding it if needed ***/
+int Chunk::getNameIndex(std::string name)
+{
+	for(unsigned int i = 0; i < names.size(); i++)
+		if(names[i] == name)
+			return i;
+	names.push_back(name);
+	return names.size() - 1;
+}
+
+/*** Get a name ***/
+const std::string& Chunk::getName(int index)
+{
+	return names.at(index);
+}
+
+/*** Print the instructions ***/
+void Chunk::dump(std::ostream& out)
+{
+	for(unsigned int i = 0; i < code.size(); i++)
+	{
+		Instruction& in = code[i];
+		out << i << '\t';
+		if(in.node != 0)
+			out << in.node->getLineNumber();
+		out << '\t' << opNames[in.op] << '\t' << in.arg;
+		if(in.name >= 0)
+			out << '\t' << names.at(in.name);
+		out << std::endl;
+	}
+}
+
+/*** Destructor ***/
+Chunk::~Chunk()
+{
+}
@@ -0,0 +1,142 @@
+#ifndef CHUNK_H
+#define CHUNK_H
+
+// ReRap Version 0.9
+// Copyright 2011 Matthew Mikolay.
+//
+// This file is part of ReRap.
+//
+// ReRap is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ReRap is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include "node.h"
+
+/*** Stack machine instructions ***/
+#define BC_EXEC			0	// Execute a node with the tree walker
+#define BC_EVAL			1	// Push the value of a node evaluated by the tree walker
+#define BC_INT			2	// Push an integer constant
+#define BC_POP			3	// Drop the top of the stack
+#define BC_LOAD			4	// Push a copy of a variable
+#define BC_STORE		5	// Assign the top of the stack to a variable
+#define BC_ADD			6
+#define BC_SUBTRACT		7
+#define BC_MULTIPLY		8
+#define BC_DIVIDE		9
+#define BC_INTDIVIDE	10
+#define BC_REMAINDER	11
+#define BC_EXPONENT		12
+#define BC_EQUAL		13
+#define BC_UNEQUAL		14
+#define BC_GREATER		15
+#define BC_LESS			16
+#define BC_GREATEQ		17
+#define BC_LESSEQ		18
+#define BC_AND			19
+#define BC_OR			20
+#define BC_NOT			21
+#define BC_NEGATE		22
+#define BC_LENGTH		23
+#define BC_CHKLOG		24	// Check that the top of the stack is logical
+#define BC_SELECT		25	// Select an element of a value
+#define BC_SELVAR		26	// Select an element of a variable without copying it
+#define BC_SLICE		27	// Slice a value; arg bits tell which indices are present
+#define BC_SEQ			28	// Build a sequence of the top arg values
+#define BC_CALL			29	// Call a procedure or function with arg arguments
+#define BC_CHKINDEX		30	// Check an index of an element assignment
+#define BC_SETELEM		31	// Assign an element of a variable
+#define BC_JUMP			32
+#define BC_JUMPF		33	// Pop a logical, jump if false
+#define BC_JUMPT		34	// Pop a logical, jump if true
+#define BC_CASEEQ		35	// Compare a when value with the case value below it
+#define BC_OUTPUT		36	// Pop and print a value; arg is its position
+#define BC_NEWLINE		37
+#define BC_RETURN		38	// Return, with the top of the stack if arg is set
+#define BC_END			39	// Return without a value
+#define BC_FORINIT		40	// Set the loop variable; arg is set if a from value was given
+#define BC_FORTEST		41	// Pop the step and the limit, jump to arg if done
+#define BC_FORSTEP		42	// Pop the step and add it to the loop variable
+#define BC_FORINC		43	// Add one to the loop variable
+#define BC_REPINIT		44	// Check the repeat count on the top of the stack
+#define BC_REPTEST		45	// Jump to arg if the repeat count is exhausted
+#define BC_REPDEC		46	// Decrement the repeat count
+#define BC_CHKINT		47	// Check that the top of the stack is an integer
+#define BC_LINE			48	// Note the start of a statement on line arg, for the profiler
+
+class Instruction
+{
+
+	public:
+
+		/*** Constructor ***/
+		Instruction(unsigned char pOp, int pArg, int pName, int pSlot, Node* pNode);
+
+		/*** The operation ***/
+		unsigned char op;
+
+		/*** The operand: a constant, a count or a jump target ***/
+		int arg;
+
+		/*** The index of a variable name, if any ***/
+		int name;
+
+		/*** The index of the variable in the scope of the chunk ***/
+		int slot;
+
+		/*** The node this instruction was compiled from ***/
+		Node* node;
+
+};
+
+class Chunk
+{
+
+	public:
+
+		/*** Constructor ***/
+		Chunk();
+
+		/*** Append an instruction, return its address ***/
+		unsigned int emit(unsigned char op, int arg, int name, int slot, Node* node);
+
+		/*** Get the address of the next instruction ***/
+		unsigned int getLength();
+
+		/*** Get an instruction ***/
+		Instruction& getInstruction(unsigned int addr);
+
+		/*** Get the index of a name, adding it if needed ***/
+		int getNameIndex(std::string name);
+
+		/*** Get a name ***/
+		const std::string& getName(int index);
+
+		/*** Print the instructions ***/
+		void dump(std::ostream& out);
+
+		/*** Destructor ***/
+		~Chunk();
+
+	private:
+
+		/*** The instructions ***/
+		std::vector<Instruction> code;
+
+		/*** The variable names used by the instructions ***/
+		std::vector<std::string> names;
+
+};
+
+#endif
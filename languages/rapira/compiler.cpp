@@ -0,0 +1,137 @@
+// ReRap Version 0.9
+// Copyright 2011 Matthew Mikolay.
+//
+// This file is part of ReRap.
+//
+// ReRap is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ReRap is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "compiler.h"
+#include "object.h"
+#include "profiler.h"
+
+/*** Constructor ***/
+Compiler::Compiler()
+{
+	chunk = 0;
+	scope = 0;
+}
+
+/*** Compile a list of statements, binding its variables in the given scope ***/
+Chunk* Compiler::compile(NodeList* list, Scope* pScope)
+{
+	scope = pScope;
+	chunk = new Chunk();
+	exits.clear();
+	compileList(list);
+	emit(BC_END, 0);
+	Chunk* result = chunk;
+	chunk = 0;
+	return result;
+}
+
+/*** Compile a statement ***/
+void Compiler::compileStatement(Node* node)
+{
+	if(Profiler::enabled)
+		emit(BC_LINE, node->getLineNumber(), node);
+
+	node->compile(*this);
+
+	// A call used as a statement drops its value
+	if(dynamic_cast<Object*>(node) != 0)
+		emit(BC_POP, node);
+}
+
+/*** Compile a list of statements in place ***/
+void Compiler::compileList(NodeList* list)
+{
+	if(list == 0)
+		return;
+	for(unsigned int i = 0; i < list->getLength(); i++)
+		compileStatement(list->getNode(i));
+}
+
+/*** Append an instruction, return its address ***/
+unsigned int Compiler::emit(unsigned char op, Node* node)
+{
+	return chunk->emit(op, 0, -1, 0, node);
+}
+
+/*** Append an instruction, return its address ***/
+unsigned int Compiler::emit(unsigned char op, int arg, Node* node)
+{
+	return chunk->emit(op, arg, -1, 0, node);
+}
+
+/*** Append an instruction using a variable, return its address ***/
+unsigned int Compiler::emit(unsigned char op, int arg, std::string name, Node* node)
+{
+	VariableManager manager;
+	return chunk->emit(op, arg, chunk->getNameIndex(name), manager.resolve(scope, name), node);
+}
+
+/*** Get the address of the next instruction ***/
+unsigned int Compiler::getAddress()
+{
+	return chunk->getLength();
+}
+
+/*** Set the target of a jump ***/
+void Compiler::patch(unsigned int addr, unsigned int target)
+{
+	chunk->getInstruction(addr).arg = target;
+}
+
+/*** Set the target of a list of jumps ***/
+void Compiler::patch(std::vector<unsigned int>& addrs, unsigned int target)
+{
+	for(unsigned int i = 0; i < addrs.size(); i++)
+		patch(addrs.at(i), target);
+}
+
+/*** Enter a loop ***/
+void Compiler::beginLoop()
+{
+	exits.push_back(std::vector<unsigned int>());
+}
+
+/*** Leave a loop, return the addresses of its exit jumps ***/
+std::vector<unsigned int> Compiler::endLoop()
+{
+	std::vector<unsigned int> result = exits.back();
+	exits.pop_back();
+	return result;
+}
+
+/*** Compile an exit from the innermost loop ***/
+void Compiler::emitExit(unsigned char op, Node* node)
+{
+	// Outside of a loop, an exit ends the procedure or program;
+	// a BC_EXEC with a negative target does the same.
+	if(exits.empty())
+	{
+		if(op == BC_EXEC)
+			emit(BC_EXEC, -1, node);
+		else
+			emit(BC_END, node);
+		return;
+	}
+	exits.back().push_back(emit(op, node));
+}
+
+/*** Destructor ***/
+Compiler::~Compiler()
+{
+	delete chunk;
+}
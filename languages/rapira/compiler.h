@@ -0,0 +1,94 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+// ReRap Version 0.9
+// Copyright 2011 Matthew Mikolay.
+//
+// This file is part of ReRap.
+//
+// ReRap is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ReRap is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <vector>
+#include "chunk.h"
+#include "nodelist.h"
+#include "varmanager.h"
+
+class Object;
+
+// The compiler turns a NodeList into a Chunk for the virtual machine.
+// Every node emits its own instructions from its compile() method;
+// nodes without one are run by the tree walker from a BC_EXEC or
+// BC_EVAL instruction, so both share the same variables and results.
+
+class Compiler
+{
+
+	public:
+
+		/*** Constructor ***/
+		Compiler();
+
+		/*** Compile a list of statements, binding its variables in the given scope ***/
+		Chunk* compile(NodeList* list, Scope* pScope);
+
+		/*** Compile a statement ***/
+		void compileStatement(Node* node);
+
+		/*** Compile a list of statements in place ***/
+		void compileList(NodeList* list);
+
+		/*** Append an instruction, return its address ***/
+		unsigned int emit(unsigned char op, Node* node);
+
+		/*** Append an instruction, return its address ***/
+		unsigned int emit(unsigned char op, int arg, Node* node);
+
+		/*** Append an instruction using a variable, return its address ***/
+		unsigned int emit(unsigned char op, int arg, std::string name, Node* node);
+
+		/*** Get the address of the next instruction ***/
+		unsigned int getAddress();
+
+		/*** Set the target of a jump ***/
+		void patch(unsigned int addr, unsigned int target);
+
+		/*** Set the target of a list of jumps ***/
+		void patch(std::vector<unsigned int>& addrs, unsigned int target);
+
+		/*** Enter a loop ***/
+		void beginLoop();
+
+		/*** Leave a loop, return the addresses of its exit jumps ***/
+		std::vector<unsigned int> endLoop();
+
+		/*** Compile an exit from the innermost loop ***/
+		void emitExit(unsigned char op, Node* node);
+
+		/*** Destructor ***/
+		~Compiler();
+
+	private:
+
+		/*** The chunk being compiled ***/
+		Chunk* chunk;
+
+		/*** The scope of the variables of the chunk ***/
+		Scope* scope;
+
+		/*** The exit jumps of the enclosing loops ***/
+		std::vector< std::vector<unsigned int> > exits;
+
+};
+
+#endif
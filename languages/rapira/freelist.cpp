@@ -0,0 +1,65 @@
+// ReRap Version 0.9
+// Copyright 2011 Matthew Mikolay.
+//
+// This file is part of ReRap.
+//
+// ReRap is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ReRap is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <new>
+#include "freelist.h"
+
+/*** Constructor, for objects of the given size ***/
+FreeList::FreeList(std::size_t pSize)
+{
+	size = pSize < sizeof(void*) ? sizeof(void*) : pSize;
+	head = 0;
+}
+
+/*** Get memory for an object ***/
+void* FreeList::allocate(std::size_t pSize)
+{
+	// A derived class of another size uses the heap
+	if(pSize > size)
+		return ::operator new(pSize);
+
+	if(head == 0)
+	{
+		char* block = static_cast<char*>(::operator new(size * FREELIST_BLOCK));
+		for(unsigned int i = 0; i < FREELIST_BLOCK; i++)
+			release(block + i * size, size);
+	}
+
+	void* ptr = head;
+	head = *static_cast<void**>(head);
+	return ptr;
+}
+
+/*** Give back the memory of an object ***/
+void FreeList::release(void* ptr, std::size_t pSize)
+{
+	if(ptr == 0)
+		return;
+	if(pSize > size)
+	{
+		::operator delete(ptr);
+		return;
+	}
+	*static_cast<void**>(ptr) = head;
+	head = ptr;
+}
+
+/*** Destructor ***/
+FreeList::~FreeList()
+{
+}
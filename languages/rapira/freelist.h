@@ -0,0 +1,59 @@
+#ifndef FREELIST_H
+#define FREELIST_H
+
+// ReRap Version 0.9
+// Copyright 2011 Matthew Mikolay.
+//
+// This file is part of ReRap.
+//
+// ReRap is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ReRap is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstddef>
+
+/*** Number of objects allocated at once when a list runs dry ***/
+#define FREELIST_BLOCK	64
+
+// Objects that are created and destroyed all the time (integers,
+// reals, logicals, texts and sequences) get their memory from a
+// free list per type instead of the heap. Memory given to a list
+// is kept for the life of the program.
+
+class FreeList
+{
+
+	public:
+
+		/*** Constructor, for objects of the given size ***/
+		FreeList(std::size_t pSize);
+
+		/*** Get memory for an object ***/
+		void* allocate(std::size_t pSize);
+
+		/*** Give back the memory of an object ***/
+		void release(void* ptr, std::size_t pSize);
+
+		/*** Destructor ***/
+		~FreeList();
+
+	private:
+
+		/*** The size of the objects ***/
+		std::size_t size;
+
+		/*** The first free object; each one points to the next ***/
+		void* head;
+
+};
+
+#endif
@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "node.h"
+#include "compiler.h"
 
 /*** Constructor ***/
 Node::Node()
@@ -55,3 +56,10 @@ unsigned int Node::getColumnNumber() const
 {
 	return colNum;
 }
+
+/*** Compile this node ***/
+void Node::compile(Compiler& c)
+{
+	// Run by the tree walker
+	c.emitExit(BC_EXEC, this);
+}
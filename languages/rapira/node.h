@@ -21,6 +21,8 @@
 
 #include "outcome.h"
 
+class Compiler;
+
 class Node
 {
 
@@ -50,6 +52,9 @@ class Node
 			return Outcome();
 		}
 
+		/*** Compile this node ***/
+		virtual void compile(Compiler& c);
+
 		/*** Clone this node ***/
 		virtual Node* clone() const { return new Node(*this); }
 
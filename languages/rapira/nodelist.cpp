@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "nodelist.h"
+#include "profiler.h"
 
 /*** Constructor ***/
 NodeList::NodeList()
@@ -76,6 +77,8 @@ Outcome NodeList::execute()
 {
 	for(unsigned int i = 0; i < getLength(); i++)
 	{
+		if(Profiler::enabled)
+			Profiler::line(getNode(i)->getLineNumber());
 		Outcome result = getNode(i)->execute();
 		if(result.getStatus() != S_SUCCESS)
 		{
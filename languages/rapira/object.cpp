@@ -1,4 +1,5 @@
 #include "object.h"
+#include "compiler.h"
 
 // ReRap Version 0.9
 // Copyright 2011 Matthew Mikolay.
@@ -28,3 +29,10 @@ Outcome Object::execute()
 {
 	return Outcome(S_SUCCESS);
 }
+
+/*** Compile this object ***/
+void Object::compile(Compiler& c)
+{
+	// Evaluated by the tree walker
+	c.emit(BC_EVAL, this);
+}
@@ -83,6 +83,9 @@ class Object : public Node
 			return clone();
 		}
 
+		/*** Compile this object ***/
+		void compile(Compiler& c);
+
 		/*** Clone this object ***/
 		Object* clone() const { return new Object(*this); }
 
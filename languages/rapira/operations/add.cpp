@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "add.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Add::Add()
@@ -88,7 +89,9 @@ Object* Add::evaluate()
 			Text* cast2 = static_cast<Text*>(obj2.get());
 			std::stringstream ss;
 			ss << cast1->getValue();
-			return new Text(ss.str() + cast2->getValue());
+			Text* txtResult = new Text(ss.str());
+			txtResult->append(cast2);
+			return txtResult;
 		}
 
 		throw InvalidTypeException(getLineNumber(), getColumnNumber(), OBJ_INTEGER | OBJ_REAL | OBJ_TEXT, obj2->getType(), 2);
@@ -115,7 +118,9 @@ Object* Add::evaluate()
 			Text* cast2 = static_cast<Text*>(obj2.get());
 			std::stringstream ss;
 			ss << cast1->getValue();
-			return new Text(ss.str() + cast2->getValue());
+			Text* txtResult = new Text(ss.str());
+			txtResult->append(cast2);
+			return txtResult;
 		}
 		
 		throw InvalidTypeException(getLineNumber(), getColumnNumber(), OBJ_INTEGER | OBJ_REAL | OBJ_TEXT, obj2->getType(), 2);
@@ -130,7 +135,9 @@ Object* Add::evaluate()
 			Integer* cast2 = static_cast<Integer*>(obj2.get());
 			std::stringstream ss;
 			ss << cast2->getValue();
-			return new Text(cast1->getValue() + ss.str());
+			Text* txtResult = cast1->clone();
+			txtResult->append(ss.str());
+			return txtResult;
 		}
 
 		if(obj2->getType() == OBJ_REAL)
@@ -138,13 +145,17 @@ Object* Add::evaluate()
 			Real* cast2 = static_cast<Real*>(obj2.get());
 			std::stringstream ss;
 			ss << cast2->getValue();
-			return new Text(cast1->getValue() + ss.str());
+			Text* txtResult = cast1->clone();
+			txtResult->append(ss.str());
+			return txtResult;
 		}
 
 		if(obj2->getType() == OBJ_TEXT)
 		{
 			Text* cast2 = static_cast<Text*>(obj2.get());
-			return new Text(cast1->getValue() + cast2->getValue());
+			Text* txtResult = cast1->clone();
+			txtResult->append(cast2);
+			return txtResult;
 		}
 		
 		throw InvalidTypeException(getLineNumber(), getColumnNumber(), OBJ_INTEGER | OBJ_REAL | OBJ_TEXT, obj2->getType(), 2);
@@ -158,7 +169,8 @@ Object* Add::evaluate()
 		Sequence* cast1 = static_cast<Sequence*>(obj1.get());
 		Sequence* cast2 = static_cast<Sequence*>(obj2.get());
 
-		Sequence* seqResult = new Sequence(cast1->getList());
+		// The result shares the objects of the first sequence
+		Sequence* seqResult = cast1->clone();
 		for(unsigned int i = 0; i < cast2->getLength(); i++)
 			seqResult->pushObject(cast2->getObject(i)->clone());
 
@@ -169,6 +181,19 @@ Object* Add::evaluate()
 	return 0;
 }
 
+/*** Compile this object ***/
+void Add::compile(Compiler& c)
+{
+	if(arg1 == 0 || arg2 == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+	arg1->compile(c);
+	arg2->compile(c);
+	c.emit(BC_ADD, this);
+}
+
 /*** Destructor ***/
 Add::~Add()
 {
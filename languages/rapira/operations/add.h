@@ -49,6 +49,9 @@ class Add : public Object
 		/*** Evaluate this object ***/
 		Object* evaluate();
 
+		/*** Compile this object ***/
+		void compile(Compiler& c);
+
 		/*** Clone this object ***/
 		Add* clone() const
 		{
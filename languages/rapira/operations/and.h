@@ -46,6 +46,9 @@ class And : public Object
 		/*** Evaluate this object ***/
 		Object* evaluate();
 
+		/*** Compile this object ***/
+		void compile(Compiler& c);
+
 		/*** Clone this object ***/
 		And* clone() const
 		{
@@ -17,6 +17,8 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "call.h"
+#include "../compiler.h"
+#include "../profiler.h"
 
 /*** Constructor ***/
 Call::Call()
@@ -42,12 +44,36 @@ void Call::setIdentifier(Object* pIden)
 	iden = pIden;
 }
 
+/*** Get the identifier ***/
+Object* Call::getIdentifier()
+{
+	return iden;
+}
+
 /*** Push an argument ***/
 void Call::pushArgument(Object* pArg, bool isInOut)
 {
 	args.push_back(std::pair<Object*, bool>(pArg, isInOut));
 }
 
+/*** Get the arguments ***/
+std::vector< std::pair<Object*, bool> > Call::getArguments()
+{
+	return args;
+}
+
+/*** Get an argument ***/
+Object* Call::getArgument(unsigned int index)
+{
+	return args.at(index).first;
+}
+
+/*** If an argument is in-out ***/
+bool Call::isInOutArgument(unsigned int index)
+{
+	return args.at(index).second;
+}
+
 /*** Execute this node ***/
 Outcome Call::execute()
 {
@@ -129,8 +155,11 @@ Object* Call::evaluate()
 		addArgs.push_back(std::pair<std::string, Object*>(proc->getParameterVariable(i)->getIdentifier(), argEval.release()));
 	}
 
+	if(Profiler::enabled)
+		Profiler::enter(iden->getType() == OP_VARIABLE ? static_cast<Variable*>(iden)->getIdentifier() : "?", proc->getLineNumber());
+
 	// Push a new entry onto the Variable Manager
-	manager.pushEntry();
+	manager.pushEntry(proc->getScope());
 
 	// Add a reference to the procedure which was
 	// called to the variable manager
@@ -170,9 +199,25 @@ Object* Call::evaluate()
 	// Pop an entry off the variable manager
 	manager.popEntry();
 
+	if(Profiler::enabled)
+		Profiler::leave();
+
 	return retVal.release();
 }
 
+/*** Compile this object ***/
+void Call::compile(Compiler& c)
+{
+	if(iden == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+	for(unsigned int i = 0; i < args.size(); i++)
+		args.at(i).first->compile(c);
+	c.emit(BC_CALL, args.size(), this);
+}
+
 /*** Destructor ***/
 Call::~Call()
 {
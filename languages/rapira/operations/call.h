@@ -43,6 +43,9 @@ class Call : public Object
 		/*** Set the identifier ***/
 		void setIdentifier(Object* pIden);
 
+		/*** Get the identifier ***/
+		Object* getIdentifier();
+
 		/*** Push an argument ***/
 		void pushArgument(Object* pArg, bool isInOut);
 
@@ -52,12 +55,18 @@ class Call : public Object
 		/*** Get an argument ***/
 		Object* getArgument(unsigned int index);
 
+		/*** If an argument is in-out ***/
+		bool isInOutArgument(unsigned int index);
+
 		/*** Execute this node ***/
 		Outcome execute();
 
 		/*** Evaluate this object ***/
 		Object* evaluate();
 
+		/*** Compile this object ***/
+		void compile(Compiler& c);
+
 		/*** Clone this object ***/
 		Call* clone() const
 		{
@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "divide.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Divide::Divide()
@@ -121,6 +122,19 @@ Object* Divide::evaluate()
 	return 0;
 }
 
+/*** Compile this object ***/
+void Divide::compile(Compiler& c)
+{
+	if(arg1 == 0 || arg2 == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+	arg1->compile(c);
+	arg2->compile(c);
+	c.emit(BC_DIVIDE, this);
+}
+
 /*** Destructor ***/
 Divide::~Divide()
 {
@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "equal.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Equal::Equal()
@@ -122,7 +123,7 @@ Object* Equal::evaluate()
 
 		Text* cast1 = static_cast<Text*>(obj1.get());
 		Text* cast2 = static_cast<Text*>(obj2.get());
-		return new Logical(cast1->getValue().compare(cast2->getValue()) == 0);
+		return new Logical(cast1->equals(cast2));
 	}
 
 	if(obj1->getType() == OBJ_SEQUENCE)
@@ -151,6 +152,19 @@ Object* Equal::evaluate()
 	return 0;
 }
 
+/*** Compile this object ***/
+void Equal::compile(Compiler& c)
+{
+	if(arg1 == 0 || arg2 == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+	arg1->compile(c);
+	arg2->compile(c);
+	c.emit(BC_EQUAL, this);
+}
+
 /*** Destructor ***/
 Equal::~Equal()
 {
@@ -48,6 +48,9 @@ class Exponent : public Object
 		/*** Evaluate this object ***/
 		Object* evaluate();
 
+		/*** Compile this object ***/
+		void compile(Compiler& c);
+
 		/*** Clone this object ***/
 		Exponent* clone() const
 		{
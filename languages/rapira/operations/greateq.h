@@ -50,6 +50,9 @@ class GreatEq : public Object
 		/*** Evaluate this object ***/
 		Object* evaluate();
 
+		/*** Compile this object ***/
+		void compile(Compiler& c);
+
 		/*** Clone this object ***/
 		GreatEq* clone() const
 		{
@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "greater.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Greater::Greater()
@@ -103,6 +104,19 @@ Object* Greater::evaluate()
 	return 0;
 }
 
+/*** Compile this object ***/
+void Greater::compile(Compiler& c)
+{
+	if(arg1 == 0 || arg2 == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+	arg1->compile(c);
+	arg2->compile(c);
+	c.emit(BC_GREATER, this);
+}
+
 /*** Destructor ***/
 Greater::~Greater()
 {
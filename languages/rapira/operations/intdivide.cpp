@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "intdivide.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 IntDivide::IntDivide()
@@ -75,6 +76,19 @@ Object* IntDivide::evaluate()
 	return new Integer(cast1->getValue() / cast2->getValue());
 }
 
+/*** Compile this object ***/
+void IntDivide::compile(Compiler& c)
+{
+	if(arg1 == 0 || arg2 == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+	arg1->compile(c);
+	arg2->compile(c);
+	c.emit(BC_INTDIVIDE, this);
+}
+
 /*** Destructor ***/
 IntDivide::~IntDivide()
 {
@@ -47,6 +47,9 @@ class IntDivide : public Object
 		/*** Evaluate this object ***/
 		Object* evaluate();
 
+		/*** Compile this object ***/
+		void compile(Compiler& c);
+
 		/*** Clone this object ***/
 		IntDivide* clone() const
 		{
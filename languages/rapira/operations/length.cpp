@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "length.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Length::Length()
@@ -69,6 +70,18 @@ Object* Length::evaluate()
 	return 0;
 }
 
+/*** Compile this object ***/
+void Length::compile(Compiler& c)
+{
+	if(arg == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+	arg->compile(c);
+	c.emit(BC_LENGTH, this);
+}
+
 /*** Destructor ***/
 Length::~Length()
 {
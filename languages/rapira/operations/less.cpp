@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "less.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Less::Less()
@@ -77,6 +78,19 @@ Object* Less::evaluate()
 	return result;
 }
 
+/*** Compile this object ***/
+void Less::compile(Compiler& c)
+{
+	if(arg1 == 0 || arg2 == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+	arg1->compile(c);
+	arg2->compile(c);
+	c.emit(BC_LESS, this);
+}
+
 /*** Destructor ***/
 Less::~Less()
 {
@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "lesseq.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 LessEq::LessEq()
@@ -74,6 +75,19 @@ Object* LessEq::evaluate()
 	return result;
 }
 
+/*** Compile this object ***/
+void LessEq::compile(Compiler& c)
+{
+	if(arg1 == 0 || arg2 == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+	arg1->compile(c);
+	arg2->compile(c);
+	c.emit(BC_LESSEQ, this);
+}
+
 /*** Destructor ***/
 LessEq::~LessEq()
 {
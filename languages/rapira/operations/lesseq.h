@@ -50,6 +50,9 @@ class LessEq : public Object
 		/*** Evaluate this object ***/
 		Object* evaluate();
 
+		/*** Compile this object ***/
+		void compile(Compiler& c);
+
 		/*** Clone this object ***/
 		LessEq* clone() const
 		{
@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "multiply.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Multiply::Multiply()
@@ -87,7 +88,7 @@ Object* Multiply::evaluate()
 			Text* txtResult = new Text();
 
 			for(unsigned int i = 0; i < (unsigned int) cast1->getValue(); i++)
-				txtResult->setValue(txtResult->getValue() + cast2->getValue());
+				txtResult->append(cast2);
 
 			return txtResult;
 		}
@@ -147,7 +148,7 @@ Object* Multiply::evaluate()
 		Text* txtResult = new Text();
 
 		for(unsigned int i = 0; i < (unsigned int) cast2->getValue(); i++)
-			txtResult->setValue(txtResult->getValue() + cast1->getValue());
+			txtResult->append(cast1);
 
 		return txtResult;
 	}
@@ -178,6 +179,19 @@ Object* Multiply::evaluate()
 	return 0;
 }
 
+/*** Compile this object ***/
+void Multiply::compile(Compiler& c)
+{
+	if(arg1 == 0 || arg2 == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+	arg1->compile(c);
+	arg2->compile(c);
+	c.emit(BC_MULTIPLY, this);
+}
+
 /*** Destructor ***/
 Multiply::~Multiply()
 {
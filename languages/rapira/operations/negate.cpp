@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "negate.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Negate::Negate()
@@ -66,6 +67,18 @@ Object* Negate::evaluate()
 	return 0;
 }
 
+/*** Compile this object ***/
+void Negate::compile(Compiler& c)
+{
+	if(arg == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+	arg->compile(c);
+	c.emit(BC_NEGATE, this);
+}
+
 /*** Destructor ***/
 Negate::~Negate()
 {
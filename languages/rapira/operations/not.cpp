@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "not.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Not::Not()
@@ -58,6 +59,18 @@ Object* Not::evaluate()
 	return new Logical(!cast->getValue());
 }
 
+/*** Compile this object ***/
+void Not::compile(Compiler& c)
+{
+	if(arg == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+	arg->compile(c);
+	c.emit(BC_NOT, this);
+}
+
 /*** Destructor ***/
 Not::~Not()
 {
@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "or.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Or::Or()
@@ -72,6 +73,20 @@ Object* Or::evaluate()
 	return new Logical(cast1->getValue() || cast2->getValue());
 }
 
+/*** Compile this object ***/
+void Or::compile(Compiler& c)
+{
+	if(arg1 == 0 || arg2 == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+	arg1->compile(c);
+	c.emit(BC_CHKLOG, 1, this);
+	arg2->compile(c);
+	c.emit(BC_OR, this);
+}
+
 /*** Destructor ***/
 Or::~Or()
 {
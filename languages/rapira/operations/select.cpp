@@ -17,6 +17,8 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "select.h"
+#include "../compiler.h"
+#include "../primitives/variable.h"
 
 /*** Constructor ***/
 Select::Select()
@@ -102,6 +104,27 @@ Object* Select::evaluate()
 	return 0;
 }
 
+/*** Compile this object ***/
+void Select::compile(Compiler& c)
+{
+	if(arg1 == 0 || arg2 == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+
+	// Select from a variable without copying all of it
+	if(arg1->getType() == OP_VARIABLE)
+	{
+		arg2->compile(c);
+		c.emit(BC_SELVAR, 0, static_cast<Variable*>(arg1)->getIdentifier(), this);
+		return;
+	}
+	arg1->compile(c);
+	arg2->compile(c);
+	c.emit(BC_SELECT, this);
+}
+
 /*** Destructor ***/
 Select::~Select()
 {
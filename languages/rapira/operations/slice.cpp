@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "slice.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Slice::Slice()
@@ -119,7 +120,7 @@ Object* Slice::evaluate()
 
 		if(index1 > index2)
 			return new Text();
-		return new Text(cast1->getValue().substr(index1 - 1, index2 - index1 + 1));
+		return cast1->getPart(index1 - 1, index2 - index1 + 1);
 	}
 
 	if(obj1->getType() == OBJ_SEQUENCE)
@@ -138,21 +139,31 @@ Object* Slice::evaluate()
 		if(index2 > (int) cast1->getLength())
 			throw InvalidIndexException(getLineNumber(), getColumnNumber(), index2, 2);
 
-		Sequence* seqResult = new Sequence();
-
-		if(index1 <= index2)
-		{
-			for(unsigned int i = index1 - 1; i < (unsigned) index2; i++)
-				seqResult->pushObject(cast1->getObject(i)->clone());
-		}
-
-		return seqResult;
+		if(index1 > index2)
+			return new Sequence();
+		return cast1->getPart(index1 - 1, index2 - index1 + 1);
 	}
 
 	throw InvalidTypeException(getLineNumber(), getColumnNumber(), OBJ_TEXT | OBJ_SEQUENCE, obj1->getType(), 1);
 	return 0;
 }
 
+/*** Compile this object ***/
+void Slice::compile(Compiler& c)
+{
+	if(arg1 == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+	arg1->compile(c);
+	if(arg2 != 0)
+		arg2->compile(c);
+	if(arg3 != 0)
+		arg3->compile(c);
+	c.emit(BC_SLICE, (arg2 != 0 ? 1 : 0) | (arg3 != 0 ? 2 : 0), this);
+}
+
 /*** Destructor ***/
 Slice::~Slice()
 {
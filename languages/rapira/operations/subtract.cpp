@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "subtract.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Subtract::Subtract()
@@ -103,6 +104,19 @@ Object* Subtract::evaluate()
 	return 0;
 }
 
+/*** Compile this object ***/
+void Subtract::compile(Compiler& c)
+{
+	if(arg1 == 0 || arg2 == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+	arg1->compile(c);
+	arg2->compile(c);
+	c.emit(BC_SUBTRACT, this);
+}
+
 /*** Destructor ***/
 Subtract::~Subtract()
 {
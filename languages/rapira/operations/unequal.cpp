@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "unequal.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Unequal::Unequal()
@@ -74,6 +75,19 @@ Object* Unequal::evaluate()
 	return notResult;
 }
 
+/*** Compile this object ***/
+void Unequal::compile(Compiler& c)
+{
+	if(arg1 == 0 || arg2 == 0)
+	{
+		Object::compile(c);
+		return;
+	}
+	arg1->compile(c);
+	arg2->compile(c);
+	c.emit(BC_UNEQUAL, this);
+}
+
 /*** Destructor ***/
 Unequal::~Unequal()
 {
@@ -84,6 +84,25 @@ void Parser::executeProgram()
 	//	throw ParserSyntaxException(list->getBreakToken(), "Invalid command!");
 }
 
+/*** Compile the program and run it on the virtual machine ***/
+void Parser::runProgram()
+{
+	Compiler compiler;
+	VariableManager manager;
+	std::auto_ptr<Chunk> code(compiler.compile(list, manager.getScope()));
+	VirtualMachine vm;
+	std::auto_ptr<Object> result(vm.run(code.get()));
+}
+
+/*** Print the compiled program ***/
+void Parser::dumpProgram(std::ostream& out)
+{
+	Compiler compiler;
+	VariableManager manager;
+	std::auto_ptr<Chunk> code(compiler.compile(list, manager.getScope()));
+	code->dump(out);
+}
+
 /*** Destructor ***/
 Parser::~Parser()
 {
@@ -1255,6 +1274,7 @@ Object* Parser::parseSubExpression1()
 		Token tok = getToken();
 		seq->setLineNumber(tok.getLineNumber());
 		seq->setColumnNumber(tok.getColumnNumber());
+		seq->setLiteral();
 
 		while(hasTokens() && peekToken().getType() != T_RARROW)
 		{
@@ -26,6 +26,8 @@
 #include "exceptions/parsersyntax.h"
 
 #include "nodelist.h"
+#include "compiler.h"
+#include "vm.h"
 #include "token.h"
 
 /*** Operations ***/
@@ -82,6 +84,12 @@ class Parser
 		/*** Descend the asbtract syntax tree ***/
 		void executeProgram();
 
+		/*** Compile the program and run it on the virtual machine ***/
+		void runProgram();
+
+		/*** Print the compiled program ***/
+		void dumpProgram(std::ostream& out);
+
 		/*** Destructor ***/
 		~Parser();
 
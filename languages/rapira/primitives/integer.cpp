@@ -18,6 +18,9 @@
 
 #include "integer.h"
 
+/*** The free list of integers ***/
+static FreeList freeIntegers(sizeof(Integer));
+
 /*** Constructor ***/
 Integer::Integer()
 {
@@ -80,6 +83,18 @@ Object* Integer::evaluate()
 	return clone();
 }
 
+/*** Allocate from the free list of integers ***/
+void* Integer::operator new(std::size_t size)
+{
+	return freeIntegers.allocate(size);
+}
+
+/*** Give back to the free list of integers ***/
+void Integer::operator delete(void* ptr, std::size_t size)
+{
+	freeIntegers.release(ptr, size);
+}
+
 /*** Destructor ***/
 Integer::~Integer()
 {
@@ -21,6 +21,7 @@
 
 #include <sstream>
 #include "../object.h"
+#include "../freelist.h"
 #include "../token.h"
 #include "../exceptions/invalidinit.h"
 
@@ -59,6 +60,12 @@ class Integer : public Object
 		/*** Clone this object ***/
 		Integer* clone() const { return new Integer(value); }
 
+		/*** Allocate from the free list of integers ***/
+		static void* operator new(std::size_t size);
+
+		/*** Give back to the free list of integers ***/
+		static void operator delete(void* ptr, std::size_t size);
+
 		/*** Destructor ***/
 		~Integer();
 
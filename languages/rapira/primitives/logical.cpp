@@ -18,6 +18,9 @@
 
 #include "logical.h"
 
+/*** The free list of logicals ***/
+static FreeList freeLogicals(sizeof(Logical));
+
 /*** Constructor ***/
 Logical::Logical()
 {
@@ -68,6 +71,18 @@ Object* Logical::evaluate()
 	return clone();
 }
 
+/*** Allocate from the free list of logicals ***/
+void* Logical::operator new(std::size_t size)
+{
+	return freeLogicals.allocate(size);
+}
+
+/*** Give back to the free list of logicals ***/
+void Logical::operator delete(void* ptr, std::size_t size)
+{
+	freeLogicals.release(ptr, size);
+}
+
 /*** Destructor ***/
 Logical::~Logical()
 {
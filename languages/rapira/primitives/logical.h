@@ -20,6 +20,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "../object.h"
+#include "../freelist.h"
 #include "../token.h"
 #include "../exceptions/invalidinit.h"
 
@@ -52,6 +53,12 @@ class Logical : public Object
 		/*** Clone this object ***/
 		Logical* clone() const { return new Logical(value); }
 
+		/*** Allocate from the free list of logicals ***/
+		static void* operator new(std::size_t size);
+
+		/*** Give back to the free list of logicals ***/
+		static void operator delete(void* ptr, std::size_t size);
+
 		/*** Destructor ***/
 		~Logical();
 
@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "procedure.h"
+#include "../chunk.h"
 
 /*** Constructor ***/
 Procedure::Procedure()
@@ -25,6 +26,9 @@ Procedure::Procedure()
 	isFunc = false;
 	ex = 0;
 	in = 0;
+	code = 0;
+	scope = new Scope();
+	owner = true;
 }
 
 /*** Constructor ***/
@@ -34,6 +38,9 @@ Procedure::Procedure(bool pIsFunc)
 	isFunc = pIsFunc;
 	ex = 0;
 	in = 0;
+	code = 0;
+	scope = new Scope();
+	owner = true;
 }
 
 /*** Constructor ***/
@@ -43,6 +50,24 @@ Procedure::Procedure(NodeList* pStmts, bool pIsFunc)
 	isFunc = pIsFunc;
 	ex = 0;
 	in = 0;
+	code = 0;
+	scope = new Scope();
+	owner = true;
+}
+
+/*** Constructor, refers to the contents of another procedure without owning them ***/
+Procedure::Procedure(Procedure* pProc)
+{
+	setStatements(pProc->stmts);
+	params = pProc->params;
+	isFunc = pProc->isFunc;
+	ex = pProc->ex;
+	in = pProc->in;
+	code = pProc->code;
+	scope = pProc->scope;
+	owner = false;
+	setLineNumber(pProc->getLineNumber());
+	setColumnNumber(pProc->getColumnNumber());
 }
 
 /*** Get this operation's type ***/
@@ -83,6 +108,36 @@ Variable* Procedure::getParameterVariable(unsigned int index)
 	return params.at(index).first;
 }
 
+/*** Get the number of parameters ***/
+unsigned int Procedure::getParameterCount()
+{
+	return params.size();
+}
+
+/*** If a parameter is in-out ***/
+bool Procedure::isInOutParameter(unsigned int index)
+{
+	return params.at(index).second;
+}
+
+/*** Set the compiled statements ***/
+void Procedure::setCode(Chunk* pCode)
+{
+	code = pCode;
+}
+
+/*** Get the compiled statements ***/
+Chunk* Procedure::getCode()
+{
+	return code;
+}
+
+/*** Get the scope of the variables ***/
+Scope* Procedure::getScope()
+{
+	return scope;
+}
+
 /*** Execute this node ***/
 Outcome Procedure::execute()
 {
@@ -122,6 +177,10 @@ Intern* Procedure::getIntern()
 /*** Destructor ***/
 Procedure::~Procedure()
 {
+	if(!owner)
+		return;
+	delete code;
+	delete scope;
 	delete ex;
 	delete in;
 	delete stmts;
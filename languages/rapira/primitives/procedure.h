@@ -21,10 +21,13 @@
 
 #include "../nodelist.h"
 #include "../object.h"
+#include "../scope.h"
 #include "variable.h"
 #include "../statements/intern.h"
 #include "../statements/extern.h"
 
+class Chunk;
+
 class Procedure : public Object
 {
 
@@ -39,6 +42,9 @@ class Procedure : public Object
 		/*** Constructor ***/
 		Procedure(bool pIsFunc);
 
+		/*** Constructor, refers to the contents of another procedure without owning them ***/
+		Procedure(Procedure* pProc);
+
 		/*** Get this operation's type ***/
 		unsigned char getType();
 
@@ -57,6 +63,21 @@ class Procedure : public Object
 		/*** Get a parameter ***/
 		Variable* getParameterVariable(unsigned int index);
 
+		/*** Get the number of parameters ***/
+		unsigned int getParameterCount();
+
+		/*** If a parameter is in-out ***/
+		bool isInOutParameter(unsigned int index);
+
+		/*** Set the compiled statements ***/
+		void setCode(Chunk* pCode);
+
+		/*** Get the compiled statements ***/
+		Chunk* getCode();
+
+		/*** Get the scope of the variables ***/
+		Scope* getScope();
+
 		/*** Execute this node ***/
 		Outcome execute();
 
@@ -73,6 +94,8 @@ class Procedure : public Object
 				result->setExtern(ex->clone());
 			if(in != 0)
 				result->setIntern(in->clone());
+			result->setLineNumber(getLineNumber());
+			result->setColumnNumber(getColumnNumber());
 			return result;
 		}
 
@@ -108,6 +131,15 @@ class Procedure : public Object
 		/*** The intern command for this procedure ***/
 		Intern* in;
 
+		/*** The compiled statements, if this procedure has been compiled ***/
+		Chunk* code;
+
+		/*** The scope of the variables ***/
+		Scope* scope;
+
+		/*** If this procedure owns its contents ***/
+		bool owner;
+
 };
 
 #endif
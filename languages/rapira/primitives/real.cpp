@@ -18,6 +18,9 @@
 
 #include "real.h"
 
+/*** The free list of reals ***/
+static FreeList freeReals(sizeof(Real));
+
 /*** Constructor ***/
 Real::Real()
 {
@@ -87,6 +90,18 @@ Object* Real::evaluate()
 	return clone();
 }
 
+/*** Allocate from the free list of reals ***/
+void* Real::operator new(std::size_t size)
+{
+	return freeReals.allocate(size);
+}
+
+/*** Give back to the free list of reals ***/
+void Real::operator delete(void* ptr, std::size_t size)
+{
+	freeReals.release(ptr, size);
+}
+
 /*** Destructor ***/
 Real::~Real()
 {
@@ -22,6 +22,7 @@
 #include <sstream>
 #include <cmath>
 #include "../object.h"
+#include "../freelist.h"
 #include "../token.h"
 #include "../exceptions/invalidinit.h"
 
@@ -60,6 +61,12 @@ class Real : public Object
 		/*** Clone this object ***/
 		Real* clone() const { return new Real(value); }
 
+		/*** Allocate from the free list of reals ***/
+		static void* operator new(std::size_t size);
+
+		/*** Give back to the free list of reals ***/
+		static void operator delete(void* ptr, std::size_t size);
+
 		/*** Destructor ***/
 		~Real();
 
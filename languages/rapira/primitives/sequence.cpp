@@ -17,27 +17,54 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "sequence.h"
+#include "../compiler.h"
+
+/*** The free list of sequences ***/
+static FreeList freeSequences(sizeof(Sequence));
 
 /*** Constructor ***/
 Sequence::Sequence()
 {
+	body = new Body();
+	body->refs = 1;
+	offset = 0;
+	length = 0;
+	literal = false;
 }
 
 /*** Constructor ***/
 Sequence::Sequence(std::vector<Object*> pSeq)
 {
+	body = new Body();
+	body->refs = 1;
+	offset = 0;
+	length = 0;
+	literal = false;
+
 	// Copy the objects from the
 	// given list to the current list
 	for(unsigned int i = 0; i < pSeq.size(); i++)
 		pushObject(pSeq.at(i)->clone());
 }
 
+/*** Copy constructor, shares the objects of the other sequence ***/
+Sequence::Sequence(const Sequence& other) : Object(other)
+{
+	body = other.body;
+	body->refs++;
+	offset = other.offset;
+	length = other.length;
+	literal = other.literal;
+}
+
 /*** Clear the sequence ***/
 void Sequence::clear()
 {
-	// Delete all objects
-	for(unsigned int i = 0; i < getLength(); i++)
-		delete list.at(i);
+	releaseBody();
+	body = new Body();
+	body->refs = 1;
+	offset = 0;
+	length = 0;
 }
 
 /*** Get this object's type ***/
@@ -49,40 +76,68 @@ unsigned char Sequence::getType()
 /*** Get this sequence's length ***/
 unsigned int Sequence::getLength()
 {
-	return list.size();
+	return length;
 }
 
 /*** Push an object onto this sequence ***/
 void Sequence::pushObject(Object* obj)
 {
-	list.push_back(obj);
+	if(offset + length != body->list.size())
+		detach();
+	body->list.push_back(obj);
+	length++;
 }
 
 /*** Pop an object off of this sequence ***/
 void Sequence::popObject()
 {
-	delete getObject(getLength() - 1);
-	list.pop_back();
+	detach();
+	delete body->list.back();
+	body->list.pop_back();
+	length--;
 }
 
 /*** Set an object at an index ***/
 void Sequence::setObject(unsigned int index, Object* obj)
 {
-	if(list.at(index) != 0)
-		delete list.at(index);
-	list.at(index) = obj;
+	detach();
+	if(body->list.at(index) != 0)
+		delete body->list.at(index);
+	body->list.at(index) = obj;
 }
 
 /*** Get an object at an index ***/
 Object* Sequence::getObject(unsigned int index)
 {
-	return list.at(index);
+	return body->list.at(offset + index);
+}
+
+/*** Get an object at an index, to be changed in place ***/
+Object* Sequence::getOwnObject(unsigned int index)
+{
+	detach();
+	return body->list.at(index);
+}
+
+/*** Get the part of this sequence from an index, sharing its objects ***/
+Sequence* Sequence::getPart(unsigned int index, unsigned int count)
+{
+	Sequence* part = clone();
+	part->offset += index;
+	part->length = count;
+	return part;
 }
 
 /*** Get the list of objects ***/
 std::vector<Object*> Sequence::getList()
 {
-	return list;
+	return std::vector<Object*>(body->list.begin() + offset, body->list.begin() + offset + length);
+}
+
+/*** Mark this sequence as written in a program, its objects to be evaluated ***/
+void Sequence::setLiteral()
+{
+	literal = true;
 }
 
 /*** Evaluate this object ***/
@@ -91,6 +146,9 @@ Object* Sequence::evaluate()
 	// Note to self: When a sequence is evaluated,
 	// a sequence is returned that contains only Objects
 	// that are not operations.
+	if(!literal)
+		return clone();
+
 	Sequence* result = new Sequence();
 
 	for(unsigned int i = 0; i < getLength(); i++)
@@ -102,8 +160,83 @@ Object* Sequence::evaluate()
 	return result;
 }
 
+/*** Compile this object ***/
+void Sequence::compile(Compiler& c)
+{
+	for(unsigned int i = 0; i < getLength(); i++)
+		getObject(i)->compile(c);
+	c.emit(BC_SEQ, getLength(), this);
+}
+
+/*** Allocate from the free list of sequences ***/
+void* Sequence::operator new(std::size_t size)
+{
+	return freeSequences.allocate(size);
+}
+
+/*** Give back to the free list of sequences ***/
+void Sequence::operator delete(void* ptr, std::size_t size)
+{
+	freeSequences.release(ptr, size);
+}
+
+/*** Let go of the body, deleting it if no other sequence shares it ***/
+void Sequence::releaseBody()
+{
+	if(--body->refs != 0)
+		return;
+	for(unsigned int i = 0; i < body->list.size(); i++)
+		delete body->list.at(i);
+	delete body;
+}
+
+/*** Get a body of its own, holding exactly this sequence's objects ***/
+void Sequence::detach()
+{
+	if(body->refs == 1 && offset == 0 && length == body->list.size())
+		return;
+
+	if(body->refs == 1)
+	{
+		// Only the objects outside of this sequence's part go
+		for(unsigned int i = 0; i < body->list.size(); i++)
+		{
+			if(i < offset || i >= offset + length)
+				delete body->list.at(i);
+		}
+		body->list.erase(body->list.begin() + offset + length, body->list.end());
+		body->list.erase(body->list.begin(), body->list.begin() + offset);
+		offset = 0;
+		return;
+	}
+
+	Body* own = new Body();
+	own->refs = 1;
+	own->list.reserve(length);
+	for(unsigned int i = 0; i < length; i++)
+		own->list.push_back(body->list.at(offset + i)->clone());
+	releaseBody();
+	body = own;
+	offset = 0;
+}
+
+/*** The free list of bodies ***/
+FreeList Sequence::Body::freeList(sizeof(Sequence::Body));
+
+/*** Allocate from the free list of bodies ***/
+void* Sequence::Body::operator new(std::size_t size)
+{
+	return freeList.allocate(size);
+}
+
+/*** Give back to the free list of bodies ***/
+void Sequence::Body::operator delete(void* ptr, std::size_t size)
+{
+	freeList.release(ptr, size);
+}
+
 /*** Destructor ***/
 Sequence::~Sequence()
 {
-	clear();
+	releaseBody();
 }
@@ -21,6 +21,7 @@
 
 #include <vector>
 #include "../object.h"
+#include "../freelist.h"
 
 class Sequence : public Object
 {
@@ -33,6 +34,9 @@ class Sequence : public Object
 		/*** Constructor ***/
 		Sequence(std::vector<Object*> pSeq);
 
+		/*** Copy constructor, shares the objects of the other sequence ***/
+		Sequence(const Sequence& other);
+
 		/*** Clear the sequence ***/
 		void clear();
 
@@ -54,25 +58,86 @@ class Sequence : public Object
 		/*** Get an object at an index ***/
 		Object* getObject(unsigned int index);
 
+		/*** Get an object at an index, to be changed in place ***/
+		Object* getOwnObject(unsigned int index);
+
+		/*** Get the part of this sequence from an index, sharing its objects ***/
+		Sequence* getPart(unsigned int index, unsigned int count);
+
 		/*** Get the list of objects ***/
 		std::vector<Object*> getList();
 
+		/*** Mark this sequence as written in a program, its objects to be evaluated ***/
+		void setLiteral();
+
 		/*** Evaluate this object ***/
 		Object* evaluate();
 
-		// Clone this object
-		Sequence* clone() const
-		{
-			return new Sequence(list);
-		}
+		/*** Compile this object ***/
+		void compile(Compiler& c);
+
+		/*** Clone this object ***/
+		Sequence* clone() const { return new Sequence(*this); }
+
+		/*** Allocate from the free list of sequences ***/
+		static void* operator new(std::size_t size);
+
+		/*** Give back to the free list of sequences ***/
+		static void operator delete(void* ptr, std::size_t size);
 
 		/*** Destructor ***/
 		~Sequence();
 
 	private:
 
-		/*** This sequence's list ***/
-		std::vector<Object*> list;
+		// The objects live in a body that the copies of a sequence
+		// share, each one seeing the part of it from its offset.
+		// A sequence whose part ends where the body ends appends
+		// to the body directly, since no other sequence sees the
+		// objects past its own part; any other change is made to
+		// a body of its own first.
+
+		class Body
+		{
+
+			public:
+
+				/*** The objects, owned by the body ***/
+				std::vector<Object*> list;
+
+				/*** The number of sequences sharing the body ***/
+				unsigned int refs;
+
+				/*** Allocate from the free list of bodies ***/
+				static void* operator new(std::size_t size);
+
+				/*** Give back to the free list of bodies ***/
+				static void operator delete(void* ptr, std::size_t size);
+
+			private:
+
+				/*** The free list of bodies ***/
+				static FreeList freeList;
+
+		};
+
+		/*** Let go of the body, deleting it if no other sequence shares it ***/
+		void releaseBody();
+
+		/*** Get a body of its own, holding exactly this sequence's objects ***/
+		void detach();
+
+		/*** The body ***/
+		Body* body;
+
+		/*** The index of the first object in the body ***/
+		unsigned int offset;
+
+		/*** The number of objects ***/
+		unsigned int length;
+
+		/*** If the objects are expressions, not values ***/
+		bool literal;
 
 };
 
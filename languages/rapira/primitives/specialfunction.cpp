@@ -59,12 +59,7 @@ Object* SpecialFunction::evaluate()
 			Text* cast1 = static_cast<Text*>(arg1.get());
 			Text* cast2 = static_cast<Text*>(arg2.get());
 
-			size_t index = cast2->getValue().find(cast1->getValue());
-
-			if(index != std::string::npos)
-				return new Integer(index + 1);
-
-			return new Integer(0);
+			return new Integer(cast2->find(cast1) + 1);
 		}
 
 		if(arg2->getType() == OBJ_SEQUENCE)
@@ -16,17 +16,24 @@
 // You should have received a copy of the GNU General Public License
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
+#include <cstring>
 #include "text.h"
 
+/*** The free list of texts ***/
+static FreeList freeTexts(sizeof(Text));
+
 /*** Constructor ***/
 Text::Text()
 {
+	body = 0;
 	setValue("");
 }
 
 /*** Constructor ***/
 Text::Text(Token tok)
 {
+	body = 0;
 	if(tok.getType() != T_STRING)
 		throw InvalidInitException(getLineNumber(), getColumnNumber(), OBJ_TEXT);
 
@@ -38,15 +45,34 @@ Text::Text(Token tok)
 /*** Constructor ***/
 Text::Text(std::string pValue)
 {
+	body = 0;
 	setValue(pValue);
 }
 
 /*** Constructor ***/
 Text::Text(char pValue)
 {
+	body = 0;
 	setValue(pValue);
 }
 
+/*** Copy constructor, shares the characters of the other text ***/
+Text::Text(const Text& other) : Object(other)
+{
+	body = other.body;
+	body->refs++;
+	offset = other.offset;
+	length = other.length;
+}
+
+/*** Constructor, taking a counted reference to a body ***/
+Text::Text(Body* pBody, unsigned int pOffset, unsigned int pLength)
+{
+	body = pBody;
+	offset = pOffset;
+	length = pLength;
+}
+
 /*** Get this object's type ***/
 unsigned char Text::getType()
 {
@@ -56,25 +82,206 @@ unsigned char Text::getType()
 /*** Get this text's length ***/
 unsigned int Text::getLength()
 {
-	return value.length();
+	return length;
 }
 
 /*** Set this text's value ***/
 void Text::setValue(std::string pValue)
 {
-	value = pValue;
+	if(body != 0)
+		releaseBody();
+	body = new Body();
+	body->value = pValue;
+	offset = 0;
+	length = pValue.length();
 }
 
 /*** Set this text's value ***/
 void Text::setValue(char pValue)
 {
-	value = std::string(1, pValue);
+	setValue(std::string(1, pValue));
 }
 
 /*** Get this text's value ***/
-std::string Text::getValue()
+const std::string& Text::getValue()
+{
+	if(body->left != 0 || offset != 0 || length != body->value.length())
+		detach();
+	return body->value;
+}
+
+/*** Append to this text ***/
+void Text::append(const std::string& pValue)
+{
+	if(body->left == 0 && offset + length == body->value.length())
+	{
+		body->value.append(pValue);
+		length += pValue.length();
+		return;
+	}
+
+	Text other(pValue);
+	append(&other);
+}
+
+/*** Append another text, sharing its characters ***/
+void Text::append(Text* other)
+{
+	// Hold on to the other text, which may share this text's body
+	Text tail(*other);
+
+	if(tail.length == 0)
+		return;
+	if(length == 0)
+	{
+		assign(tail.clone());
+		return;
+	}
+
+	if(tail.length < TEXT_LEAF)
+	{
+		Pieces pieces;
+		tail.getPieces(0, tail.length, pieces);
+		std::string chars;
+		for(unsigned int i = 0; i < pieces.size(); i++)
+			chars.append(pieces.at(i).first, pieces.at(i).second);
+
+		// Short texts are copied onto the end of the characters,
+		bool atEnd = body->left == 0 && offset + length == body->value.length();
+		if(!atEnd && length + tail.length < TEXT_LEAF)
+		{
+			detach();
+			atEnd = true;
+		}
+		if(atEnd)
+		{
+			body->value.append(chars);
+			length += tail.length;
+			return;
+		}
+
+		// or onto the end of the last linked text
+		if(body->left != 0 && offset == 0 && length == body->getSize() && body->right->length + tail.length < TEXT_LEAF)
+		{
+			Text* right = body->right->clone();
+			right->append(chars);
+			assign(link(body->left->clone(), right));
+			return;
+		}
+	}
+
+	assign(link(clone(), tail.clone()));
+	if(body->depth > TEXT_DEPTH)
+		rebalance();
+}
+
+/*** Get the part of this text from an index, sharing its characters ***/
+Text* Text::getPart(unsigned int index, unsigned int count)
 {
-	return value;
+	Text* part = clone();
+	part->offset += index;
+	part->length = count;
+	return part;
+}
+
+/*** Get the character at an index ***/
+char Text::getCharAt(unsigned int index)
+{
+	Body* cur = body;
+	index += offset;
+	while(cur->left != 0)
+	{
+		if(index < cur->left->length)
+		{
+			index += cur->left->offset;
+			cur = cur->left->body;
+		}
+		else
+		{
+			index += cur->right->offset - cur->left->length;
+			cur = cur->right->body;
+		}
+	}
+	return cur->value.at(index);
+}
+
+/*** Check if another text has the same characters ***/
+bool Text::equals(Text* other)
+{
+	if(length != other->length)
+		return false;
+
+	Pieces pieces1;
+	Pieces pieces2;
+	getPieces(0, length, pieces1);
+	other->getPieces(0, other->length, pieces2);
+
+	// Compare the runs of characters side by side
+	unsigned int i = 0, j = 0, done1 = 0, done2 = 0;
+	while(i < pieces1.size())
+	{
+		unsigned int count = std::min(pieces1.at(i).second - done1, pieces2.at(j).second - done2);
+		if(memcmp(pieces1.at(i).first + done1, pieces2.at(j).first + done2, count) != 0)
+			return false;
+		done1 += count;
+		done2 += count;
+		if(done1 == pieces1.at(i).second)
+		{
+			i++;
+			done1 = 0;
+		}
+		if(done2 == pieces2.at(j).second)
+		{
+			j++;
+			done2 = 0;
+		}
+	}
+	return true;
+}
+
+/*** Find the first index of another text in this one, -1 if it is not found ***/
+long Text::find(Text* pattern)
+{
+	const std::string& chars = pattern->getValue();
+	if(chars.empty())
+		return 0;
+
+	// The text is searched a window at a time, so that finding
+	// something near the start does not visit all of the text
+	for(unsigned int start = 0; start + chars.length() <= length; start += TEXT_WINDOW)
+	{
+		Pieces pieces;
+		getPieces(start, std::min((unsigned int) (TEXT_WINDOW + chars.length() - 1), length - start), pieces);
+
+		unsigned int base = start;
+		for(unsigned int k = 0; k < pieces.size(); k++)
+		{
+			const char* run = pieces.at(k).first;
+			unsigned int count = pieces.at(k).second;
+			for(unsigned int i = 0; i < count; i++)
+			{
+				const char* hit = static_cast<const char*>(memchr(run + i, chars.at(0), count - i));
+				if(hit == 0)
+					break;
+				i = hit - run;
+				if(base + i >= start + TEXT_WINDOW)
+					break;
+				if(matches(pieces, k, i, chars))
+					return base + i;
+			}
+			base += count;
+		}
+	}
+	return -1;
+}
+
+/*** Write this text to a stream ***/
+void Text::write(std::ostream& out)
+{
+	Pieces pieces;
+	getPieces(0, length, pieces);
+	for(unsigned int i = 0; i < pieces.size(); i++)
+		out.write(pieces.at(i).first, pieces.at(i).second);
 }
 
 /*** Evaluate this object ***/
@@ -86,10 +293,204 @@ Object* Text::evaluate()
 /*** Get a character ***/
 Text* Text::getChar(unsigned int index)
 {
-	return new Text(value.at(index));
+	return new Text(getCharAt(index));
+}
+
+/*** Link two texts, taking ownership of them ***/
+Text* Text::link(Text* left, Text* right)
+{
+	Body* joined = new Body();
+	joined->left = left;
+	joined->right = right;
+	joined->depth = std::max(left->body->depth, right->body->depth) + 1;
+	return new Text(joined, 0, left->length + right->length);
+}
+
+/*** Link a list of texts into a balanced rope, taking ownership of them ***/
+Text* Text::link(std::vector<Text*>& texts, unsigned int first, unsigned int last)
+{
+	if(last - first == 1)
+		return texts.at(first);
+	unsigned int middle = first + (last - first) / 2;
+	return link(link(texts, first, middle), link(texts, middle, last));
+}
+
+/*** Check if a text matches the pieces from an index in a piece ***/
+bool Text::matches(const Pieces& pieces, unsigned int piece, unsigned int index, const std::string& pattern)
+{
+	unsigned int done = 0;
+	while(done < pattern.length())
+	{
+		if(piece == pieces.size())
+			return false;
+		unsigned int count = std::min((unsigned int) pattern.length() - done, pieces.at(piece).second - index);
+		if(memcmp(pieces.at(piece).first + index, pattern.data() + done, count) != 0)
+			return false;
+		done += count;
+		piece++;
+		index = 0;
+	}
+	return true;
+}
+
+/*** Get the characters of a part of this text ***/
+void Text::getPieces(unsigned int index, unsigned int count, Pieces& pieces)
+{
+	if(count == 0)
+		return;
+	index += offset;
+	if(body->left == 0)
+	{
+		pieces.push_back(std::make_pair(body->value.data() + index, count));
+		return;
+	}
+
+	Text* left = body->left;
+	if(index < left->length)
+	{
+		unsigned int part = std::min(count, left->length - index);
+		left->getPieces(index, part, pieces);
+		index += part;
+		count -= part;
+	}
+	body->right->getPieces(index - left->length, count, pieces);
+}
+
+/*** Get texts for the bodies holding the characters of a part of this text ***/
+void Text::getLeaves(unsigned int index, unsigned int count, std::vector<Text*>& leaves)
+{
+	if(count == 0)
+		return;
+	index += offset;
+	if(body->left == 0)
+	{
+		body->refs++;
+		leaves.push_back(new Text(body, index, count));
+		return;
+	}
+
+	Text* left = body->left;
+	if(index < left->length)
+	{
+		unsigned int part = std::min(count, left->length - index);
+		left->getLeaves(index, part, leaves);
+		index += part;
+		count -= part;
+	}
+	body->right->getLeaves(index - left->length, count, leaves);
+}
+
+/*** Take the characters of another text, deleting it ***/
+void Text::assign(Text* other)
+{
+	other->body->refs++;
+	releaseBody();
+	body = other->body;
+	offset = other->offset;
+	length = other->length;
+	delete other;
+}
+
+/*** Rebuild the links as a balanced rope ***/
+void Text::rebalance()
+{
+	std::vector<Text*> leaves;
+	getLeaves(0, length, leaves);
+
+	// Neighbouring short texts are copied together
+	std::vector<Text*> texts;
+	for(unsigned int i = 0; i < leaves.size(); i++)
+	{
+		if(!texts.empty() && texts.back()->length + leaves.at(i)->length < TEXT_LEAF)
+		{
+			texts.back()->append(leaves.at(i));
+			delete leaves.at(i);
+		}
+		else
+			texts.push_back(leaves.at(i));
+	}
+
+	assign(link(texts, 0, texts.size()));
+}
+
+/*** Let go of the body, deleting it if no other text shares it ***/
+void Text::releaseBody()
+{
+	if(--body->refs != 0)
+		return;
+	delete body->left;
+	delete body->right;
+	delete body;
+}
+
+/*** Get a body of its own, holding exactly this text's characters themselves ***/
+void Text::detach()
+{
+	if(body->left == 0 && body->refs == 1)
+	{
+		body->value.erase(offset + length);
+		body->value.erase(0, offset);
+		offset = 0;
+		return;
+	}
+
+	Pieces pieces;
+	getPieces(0, length, pieces);
+	Body* own = new Body();
+	own->value.reserve(length);
+	for(unsigned int i = 0; i < pieces.size(); i++)
+		own->value.append(pieces.at(i).first, pieces.at(i).second);
+	releaseBody();
+	body = own;
+	offset = 0;
+}
+
+/*** Constructor ***/
+Text::Body::Body()
+{
+	left = 0;
+	right = 0;
+	depth = 0;
+	refs = 1;
+}
+
+/*** Get the number of characters ***/
+unsigned int Text::Body::getSize()
+{
+	if(left != 0)
+		return left->length + right->length;
+	return value.length();
+}
+
+/*** The free list of bodies ***/
+FreeList Text::Body::freeList(sizeof(Text::Body));
+
+/*** Allocate from the free list of bodies ***/
+void* Text::Body::operator new(std::size_t size)
+{
+	return freeList.allocate(size);
+}
+
+/*** Give back to the free list of bodies ***/
+void Text::Body::operator delete(void* ptr, std::size_t size)
+{
+	freeList.release(ptr, size);
+}
+
+/*** Allocate from the free list of texts ***/
+void* Text::operator new(std::size_t size)
+{
+	return freeTexts.allocate(size);
+}
+
+/*** Give back to the free list of texts ***/
+void Text::operator delete(void* ptr, std::size_t size)
+{
+	freeTexts.release(ptr, size);
 }
 
 /*** Destructor ***/
 Text::~Text()
 {
+	releaseBody();
 }
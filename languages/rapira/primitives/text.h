@@ -20,10 +20,22 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <string>
+#include <vector>
+#include <ostream>
 #include "../object.h"
+#include "../freelist.h"
 #include "../token.h"
 #include "../exceptions/invalidinit.h"
 
+/*** Texts shorter than this are copied when joined, longer ones are linked ***/
+#define TEXT_LEAF		256
+
+/*** Links deeper than this are rebalanced ***/
+#define TEXT_DEPTH		40
+
+/*** Number of characters searched at a time ***/
+#define TEXT_WINDOW		4096
+
 class Text : public Object
 {
 
@@ -41,6 +53,9 @@ class Text : public Object
 		/*** Constructor ***/
 		Text(char pValue);
 
+		/*** Copy constructor, shares the characters of the other text ***/
+		Text(const Text& other);
+
 		/*** Get this object's type ***/
 		unsigned char getType();
 
@@ -54,7 +69,28 @@ class Text : public Object
 		void setValue(char pValue);
 
 		/*** Get this text's value ***/
-		std::string getValue();
+		const std::string& getValue();
+
+		/*** Append to this text ***/
+		void append(const std::string& pValue);
+
+		/*** Append another text, sharing its characters ***/
+		void append(Text* other);
+
+		/*** Get the part of this text from an index, sharing its characters ***/
+		Text* getPart(unsigned int index, unsigned int count);
+
+		/*** Get the character at an index ***/
+		char getCharAt(unsigned int index);
+
+		/*** Check if another text has the same characters ***/
+		bool equals(Text* other);
+
+		/*** Find the first index of another text in this one, -1 if it is not found ***/
+		long find(Text* pattern);
+
+		/*** Write this text to a stream ***/
+		void write(std::ostream& out);
 
 		/*** Evaluate this object ***/
 		Object* evaluate();
@@ -65,13 +101,102 @@ class Text : public Object
 		/*** Clone this object ***/
 		Text* clone() const { return new Text(*this); }
 
+		/*** Allocate from the free list of texts ***/
+		static void* operator new(std::size_t size);
+
+		/*** Give back to the free list of texts ***/
+		static void operator delete(void* ptr, std::size_t size);
+
 		/*** Destructor ***/
 		~Text();
 
 	private:
 
-		/*** The value of this text ***/
-		std::string value;
+		// The characters live in a body that the copies of a text
+		// share, each one seeing the part of it from its offset,
+		// the same way as the objects of a sequence do. A body
+		// either holds characters itself or links two texts, so
+		// long texts are joined without copying them, forming
+		// a rope.
+
+		class Body
+		{
+
+			public:
+
+				/*** Constructor ***/
+				Body();
+
+				/*** Get the number of characters ***/
+				unsigned int getSize();
+
+				/*** The characters, if nothing is linked ***/
+				std::string value;
+
+				/*** The linked texts, or zero ***/
+				Text* left;
+				Text* right;
+
+				/*** The longest chain of links below this body ***/
+				unsigned int depth;
+
+				/*** The number of texts sharing the body ***/
+				unsigned int refs;
+
+				/*** Allocate from the free list of bodies ***/
+				static void* operator new(std::size_t size);
+
+				/*** Give back to the free list of bodies ***/
+				static void operator delete(void* ptr, std::size_t size);
+
+			private:
+
+				/*** The free list of bodies ***/
+				static FreeList freeList;
+
+		};
+
+		/*** Runs of characters, in order ***/
+		typedef std::vector< std::pair<const char*, unsigned int> > Pieces;
+
+		/*** Constructor, taking a counted reference to a body ***/
+		Text(Body* pBody, unsigned int pOffset, unsigned int pLength);
+
+		/*** Link two texts, taking ownership of them ***/
+		static Text* link(Text* left, Text* right);
+
+		/*** Link a list of texts into a balanced rope, taking ownership of them ***/
+		static Text* link(std::vector<Text*>& texts, unsigned int first, unsigned int last);
+
+		/*** Check if a text matches the pieces from an index in a piece ***/
+		static bool matches(const Pieces& pieces, unsigned int piece, unsigned int index, const std::string& pattern);
+
+		/*** Get the characters of a part of this text ***/
+		void getPieces(unsigned int index, unsigned int count, Pieces& pieces);
+
+		/*** Get texts for the bodies holding the characters of a part of this text ***/
+		void getLeaves(unsigned int index, unsigned int count, std::vector<Text*>& leaves);
+
+		/*** Take the characters of another text, deleting it ***/
+		void assign(Text* other);
+
+		/*** Rebuild the links as a balanced rope ***/
+		void rebalance();
+
+		/*** Let go of the body, deleting it if no other text shares it ***/
+		void releaseBody();
+
+		/*** Get a body of its own, holding exactly this text's characters themselves ***/
+		void detach();
+
+		/*** The body ***/
+		Body* body;
+
+		/*** The index of the first character in the body ***/
+		unsigned int offset;
+
+		/*** The number of characters ***/
+		unsigned int length;
 
 };
 
@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "variable.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Variable::Variable()
@@ -48,6 +49,8 @@ unsigned char Variable::getType()
 void Variable::setIdentifier(std::string pIden)
 {
 	iden = pIden;
+	scope = 0;
+	index = 0;
 }
 
 /*** Get this variable's identifier ***/
@@ -56,13 +59,34 @@ std::string Variable::getIdentifier()
 	return iden;
 }
 
+/*** Get the index of this variable in the current scope ***/
+int Variable::getIndex()
+{
+	// A variable is only ever used in the scope of the
+	// procedure containing it, so it is resolved once
+	VariableManager manager;
+	if(scope != manager.getScope())
+	{
+		scope = manager.getScope();
+		index = manager.resolve(scope, iden);
+	}
+	return index;
+}
+
 /*** Evaluate this object ***/
 Object* Variable::evaluate()
 {
 	VariableManager manager;
-	if(!manager.hasObject(getIdentifier()))
+	Object* obj = manager.getSlot(getIndex());
+	if(obj == 0)
 		return new Object();
-	return manager.getObject(getIdentifier())->clone();
+	return obj->clone();
+}
+
+/*** Compile this object ***/
+void Variable::compile(Compiler& c)
+{
+	c.emit(BC_LOAD, 0, getIdentifier(), this);
 }
 
 /*** Destructor ***/
@@ -47,9 +47,15 @@ class Variable : public Object
 		/*** Get this variable's identifier ***/
 		std::string getIdentifier();
 
+		/*** Get the index of this variable in the current scope ***/
+		int getIndex();
+
 		/*** Evaluate this object ***/
 		Object* evaluate();
 
+		/*** Compile this object ***/
+		void compile(Compiler& c);
+
 		/*** Clone this object ***/
 		Variable* clone() const { return new Variable(iden); }
 
@@ -61,6 +67,12 @@ class Variable : public Object
 		/*** The identifier of this variable ***/
 		std::string iden;
 
+		/*** The scope in which the index was resolved ***/
+		Scope* scope;
+
+		/*** The index of this variable in that scope ***/
+		int index;
+
 };
 
 #endif
@@ -0,0 +1,188 @@
+// ReRap Version 0.9
+// Copyright 2011 Matthew Mikolay.
+//
+// This file is part of ReRap.
+//
+// ReRap is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ReRap is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#ifdef _WIN32
+#include <ctime>
+#else
+#include <sys/time.h>
+#endif
+#include "profiler.h"
+
+/*** If the program is being profiled ***/
+bool Profiler::enabled = false;
+
+/*** The lines, by number ***/
+std::map<unsigned int, Profiler::LineProfile> Profiler::lines;
+
+/*** The procedures, by name and line ***/
+std::map<std::pair<std::string, unsigned int>, Profiler::ProcedureProfile> Profiler::procedures;
+
+/*** The calls not yet returned ***/
+std::vector<Profiler::Activation> Profiler::calls;
+
+/*** The line being run ***/
+unsigned int Profiler::current = 0;
+
+/*** The time of the last note ***/
+double Profiler::last = 0;
+
+/*** The time profiling started ***/
+double Profiler::begin = 0;
+
+/*** Order lines by the time spent, the most first ***/
+static bool moreTime(const std::pair<double, unsigned int>& a, const std::pair<double, unsigned int>& b)
+{
+	if(a.first != b.first)
+		return a.first > b.first;
+	return a.second < b.second;
+}
+
+/*** Order procedures by the time spent, the most first ***/
+static bool moreTimeCalls(const std::pair<double, std::pair<std::string, unsigned int> >& a, const std::pair<double, std::pair<std::string, unsigned int> >& b)
+{
+	if(a.first != b.first)
+		return a.first > b.first;
+	return a.second < b.second;
+}
+
+/*** Start profiling ***/
+void Profiler::start()
+{
+	enabled = true;
+	begin = last = now();
+}
+
+/*** Note the start of a statement on a line ***/
+void Profiler::line(unsigned int number)
+{
+	charge();
+	current = number;
+	lines[number].count++;
+}
+
+/*** Note a call of the procedure defined on a line ***/
+void Profiler::enter(const std::string& name, unsigned int number)
+{
+	charge();
+	Activation call;
+	call.procedure = std::make_pair(name, number);
+	call.caller = current;
+	call.start = last;
+	calls.push_back(call);
+
+	ProcedureProfile& proc = procedures[call.procedure];
+	proc.calls++;
+	proc.active++;
+}
+
+/*** Note the return from the last procedure called ***/
+void Profiler::leave()
+{
+	charge();
+	Activation call = calls.back();
+	calls.pop_back();
+
+	// A recursive procedure counts the time of its outermost call only
+	ProcedureProfile& proc = procedures[call.procedure];
+	if(--proc.active == 0)
+		proc.time += last - call.start;
+	current = call.caller;
+}
+
+/*** Print the report, quoting the lines of the source file ***/
+void Profiler::print(std::ostream& out, const std::string& filename)
+{
+	// Close the calls left by an error
+	while(!calls.empty())
+		leave();
+	charge();
+	double total = last - begin;
+
+	std::vector<std::string> source;
+	std::ifstream in(filename.c_str());
+	std::string text;
+	while(std::getline(in, text))
+		source.push_back(text);
+
+	std::vector< std::pair<double, unsigned int> > byLine;
+	for(std::map<unsigned int, LineProfile>::iterator i = lines.begin(); i != lines.end(); ++i)
+		byLine.push_back(std::make_pair(i->second.time, i->first));
+	std::sort(byLine.begin(), byLine.end(), moreTime);
+
+	out << std::fixed << std::setprecision(3);
+	out << "profile: " << total << " seconds" << std::endl;
+	out << std::setw(8) << "line" << std::setw(12) << "count" << std::setw(12) << "seconds" << std::setw(8) << "%" << "  source" << std::endl;
+	for(unsigned int i = 0; i < byLine.size() && i < PROFILE_TOP; i++)
+	{
+		unsigned int number = byLine.at(i).second;
+		LineProfile& profile = lines[number];
+		out << std::setw(8) << number << std::setw(12) << profile.count << std::setw(12) << profile.time;
+		out << std::setprecision(1) << std::setw(8) << (total > 0 ? 100 * profile.time / total : 0) << std::setprecision(3);
+		if(number >= 1 && number <= source.size())
+		{
+			std::string& line = source.at(number - 1);
+			std::string::size_type first = line.find_first_not_of(" \t");
+			if(first != std::string::npos)
+				out << "  " << line.substr(first, 40);
+		}
+		out << std::endl;
+	}
+
+	if(procedures.empty())
+		return;
+
+	std::vector< std::pair<double, std::pair<std::string, unsigned int> > > byProcedure;
+	for(std::map<std::pair<std::string, unsigned int>, ProcedureProfile>::iterator i = procedures.begin(); i != procedures.end(); ++i)
+		byProcedure.push_back(std::make_pair(i->second.time, i->first));
+	std::sort(byProcedure.begin(), byProcedure.end(), moreTimeCalls);
+
+	out << std::endl;
+	out << std::left << std::setw(24) << "procedure" << std::right << std::setw(8) << "line" << std::setw(12) << "calls" << std::setw(12) << "seconds" << std::setw(8) << "%" << std::endl;
+	for(unsigned int i = 0; i < byProcedure.size() && i < PROFILE_TOP; i++)
+	{
+		ProcedureProfile& profile = procedures[byProcedure.at(i).second];
+		out << std::left << std::setw(24) << byProcedure.at(i).second.first << std::right;
+		out << std::setw(8) << byProcedure.at(i).second.second << std::setw(12) << profile.calls << std::setw(12) << profile.time;
+		out << std::setprecision(1) << std::setw(8) << (total > 0 ? 100 * profile.time / total : 0) << std::setprecision(3) << std::endl;
+	}
+}
+
+/*** Get the wall clock time in seconds ***/
+double Profiler::now()
+{
+#ifdef _WIN32
+	// clock() counts wall clock time on Windows
+	return (double) clock() / CLOCKS_PER_SEC;
+#else
+	timeval tv;
+	gettimeofday(&tv, 0);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+#endif
+}
+
+/*** Give the time since the last note to the current line ***/
+void Profiler::charge()
+{
+	double time = now();
+	if(current != 0)
+		lines[current].time += time - last;
+	last = time;
+}
@@ -0,0 +1,132 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// ReRap Version 0.9
+// Copyright 2011 Matthew Mikolay.
+//
+// This file is part of ReRap.
+//
+// ReRap is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ReRap is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*** Number of lines and procedures printed in each part of the report ***/
+#define PROFILE_TOP		25
+
+// The profiler of rapira --profile. The tree walker and the virtual
+// machine note the start of every statement and every call of a
+// procedure. The time between the starts of two statements goes to
+// the line of the first; the time from a call to its return goes to
+// the procedure called.
+
+class Profiler
+{
+
+	public:
+
+		/*** If the program is being profiled ***/
+		static bool enabled;
+
+		/*** Start profiling ***/
+		static void start();
+
+		/*** Note the start of a statement on a line ***/
+		static void line(unsigned int number);
+
+		/*** Note a call of the procedure defined on a line ***/
+		static void enter(const std::string& name, unsigned int number);
+
+		/*** Note the return from the last procedure called ***/
+		static void leave();
+
+		/*** Print the report, quoting the lines of the source file ***/
+		static void print(std::ostream& out, const std::string& filename);
+
+	private:
+
+		class LineProfile
+		{
+
+			public:
+
+				/*** Number of statements started ***/
+				unsigned long count;
+
+				/*** Seconds spent ***/
+				double time;
+
+		};
+
+		class ProcedureProfile
+		{
+
+			public:
+
+				/*** Number of calls ***/
+				unsigned long calls;
+
+				/*** Seconds spent, including the procedures it calls ***/
+				double time;
+
+				/*** Number of calls not yet returned ***/
+				unsigned int active;
+
+		};
+
+		class Activation
+		{
+
+			public:
+
+				/*** The name and line of the procedure ***/
+				std::pair<std::string, unsigned int> procedure;
+
+				/*** The line of the call ***/
+				unsigned int caller;
+
+				/*** The time of the call ***/
+				double start;
+
+		};
+
+		/*** Get the wall clock time in seconds ***/
+		static double now();
+
+		/*** Give the time since the last note to the current line ***/
+		static void charge();
+
+		/*** The lines, by number ***/
+		static std::map<unsigned int, LineProfile> lines;
+
+		/*** The procedures, by name and line ***/
+		static std::map<std::pair<std::string, unsigned int>, ProcedureProfile> procedures;
+
+		/*** The calls not yet returned ***/
+		static std::vector<Activation> calls;
+
+		/*** The line being run ***/
+		static unsigned int current;
+
+		/*** The time of the last note ***/
+		static double last;
+
+		/*** The time profiling started ***/
+		static double begin;
+
+};
+
+#endif
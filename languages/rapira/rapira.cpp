@@ -20,6 +20,8 @@
 
 #include "lexer.h"
 #include "parser.h"
+#include "stats.h"
+#include "profiler.h"
 
 std::string filename;
 
@@ -42,18 +44,42 @@ void error(Excep& e)
 
 int main(int argc, char* argv[])
 {
-	if(argc != 2)
+	// Read the options
+	bool treeWalker = false;
+	bool dump = false;
+	bool stats = false;
+	bool profile = false;
+	int arg = 1;
+	for(; arg < argc && argv[arg][0] == '-'; arg++)
+	{
+		if(std::string(argv[arg]) == "-t")
+			treeWalker = true;
+		else if(std::string(argv[arg]) == "-d")
+			dump = true;
+		else if(std::string(argv[arg]) == "-s")
+			stats = true;
+		else if(std::string(argv[arg]) == "-p" || std::string(argv[arg]) == "--profile")
+			profile = true;
+		else
+			break;
+	}
+
+	if(arg != argc - 1)
 	{
 		std::cerr << "Invalid number of arguments!" << std::endl;
-		std::cerr << "Usage: rapira [filename]" << std::endl;
+		std::cerr << "Usage: rapira [-t] [-d] [-s] [-p] [filename]" << std::endl;
+		std::cerr << "  -t  run on the tree walker instead of the bytecode machine" << std::endl;
+		std::cerr << "  -d  print the compiled program instead of running it" << std::endl;
+		std::cerr << "  -s  print instruction (and allocation, if counted) counts when done" << std::endl;
+		std::cerr << "  -p, --profile  print the time spent on each line and procedure when done" << std::endl;
 		return 1;
 	}
 
 	// Set the filename
-	filename = argv[1];
+	filename = argv[arg];
 
 	// Initialize the lexer
-	Lexer lexer(argv[1]);
+	Lexer lexer(argv[arg]);
 
 	// Confirm that the input file has been opened correctly
 	if(!lexer.isOpen())
@@ -85,15 +111,30 @@ int main(int argc, char* argv[])
 	try
 	{
 		parser.parse();
-		parser.executeProgram();
+		Statistics::allocations = 0;
+		if(profile)
+			Profiler::start();
+		if(dump)
+			parser.dumpProgram(std::cout);
+		else if(treeWalker)
+			parser.executeProgram();
+		else
+			parser.runProgram();
 	}
 	catch(Excep& e)
 	{
 		error(e);
+		if(profile)
+			Profiler::print(std::cerr, filename);
 		//system("PAUSE");
 		return 1;
 	}
 
+	if(profile)
+		Profiler::print(std::cerr, filename);
+	if(stats)
+		Statistics::print(std::cerr);
+
 	//system("PAUSE");
 	return 0;
 }
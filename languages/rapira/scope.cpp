@@ -0,0 +1,65 @@
+// ReRap Version 0.9
+// Copyright 2011 Matthew Mikolay.
+//
+// This file is part of ReRap.
+//
+// ReRap is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ReRap is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "scope.h"
+
+/*** Constructor ***/
+Scope::Scope()
+{
+}
+
+/*** Get the index bound to a name, or SCOPE_UNBOUND ***/
+int Scope::lookup(const std::string& name)
+{
+	std::map<std::string, int>::iterator it = indices.find(name);
+	if(it == indices.end())
+		return SCOPE_UNBOUND;
+	return it->second;
+}
+
+/*** Bind a name to the next free slot, return the slot ***/
+int Scope::bind(const std::string& name)
+{
+	int slot = names.size();
+	names.push_back(name);
+	indices[name] = slot;
+	return slot;
+}
+
+/*** Bind a name to an index outside the frame ***/
+void Scope::bind(const std::string& name, int index)
+{
+	indices[name] = index;
+}
+
+/*** Get the number of slots ***/
+unsigned int Scope::getSize()
+{
+	return names.size();
+}
+
+/*** Get the name of a slot ***/
+const std::string& Scope::getName(unsigned int slot)
+{
+	return names.at(slot);
+}
+
+/*** Destructor ***/
+Scope::~Scope()
+{
+}
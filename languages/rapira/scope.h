@@ -0,0 +1,65 @@
+#ifndef SCOPE_H
+#define SCOPE_H
+
+// ReRap Version 0.9
+// Copyright 2011 Matthew Mikolay.
+//
+// This file is part of ReRap.
+//
+// ReRap is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ReRap is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <map>
+#include <string>
+#include <vector>
+
+/*** The index of a name which is not bound ***/
+#define SCOPE_UNBOUND	0x7fffffff
+
+class Scope
+{
+
+	public:
+
+		/*** Constructor ***/
+		Scope();
+
+		/*** Get the index bound to a name, or SCOPE_UNBOUND ***/
+		int lookup(const std::string& name);
+
+		/*** Bind a name to the next free slot, return the slot ***/
+		int bind(const std::string& name);
+
+		/*** Bind a name to an index outside the frame ***/
+		void bind(const std::string& name, int index);
+
+		/*** Get the number of slots ***/
+		unsigned int getSize();
+
+		/*** Get the name of a slot ***/
+		const std::string& getName(unsigned int slot);
+
+		/*** Destructor ***/
+		~Scope();
+
+	private:
+
+		/*** The indices bound to the names ***/
+		std::map<std::string, int> indices;
+
+		/*** The names of the slots ***/
+		std::vector<std::string> names;
+
+};
+
+#endif
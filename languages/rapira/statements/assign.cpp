@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "assign.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Assign::Assign()
@@ -54,7 +55,7 @@ Outcome Assign::execute()
 	VariableManager manager;
 	try
 	{
-		manager.setObject(target->getIdentifier(), expr->evaluate());
+		manager.setSlot(target->getIndex(), expr->evaluate());
 	}
 	catch(InvalidAssignmentException& e)
 	{
@@ -63,6 +64,18 @@ Outcome Assign::execute()
 	return Outcome(S_SUCCESS);
 }
 
+/*** Compile this node ***/
+void Assign::compile(Compiler& c)
+{
+	if(target == 0 || expr == 0)
+	{
+		Node::compile(c);
+		return;
+	}
+	expr->compile(c);
+	c.emit(BC_STORE, 0, target->getIdentifier(), this);
+}
+
 /*** Destructor ***/
 Assign::~Assign()
 {
@@ -42,6 +42,9 @@ class Assign : public Node
 		/*** Execute this node ***/
 		Outcome execute();
 
+		/*** Compile this node ***/
+		void compile(Compiler& c);
+
 		/*** Clone this object ***/
 		Assign* clone() const
 		{
@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "case.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Case::Case()
@@ -92,6 +93,32 @@ Outcome Case::execute()
 	return Outcome(S_SUCCESS);
 }
 
+/*** Compile this node ***/
+void Case::compile(Compiler& c)
+{
+	std::vector<unsigned int> ends;
+
+	// The case value stays on the stack until a when matches
+	if(condition != 0)
+		condition->compile(c);
+	for(unsigned int i = 0; i < whenStmts.size(); i++)
+	{
+		whenStmts.at(i).first->compile(c);
+		if(condition != 0)
+			c.emit(BC_CASEEQ, this);
+		unsigned int next = c.emit(BC_JUMPF, this);
+		if(condition != 0)
+			c.emit(BC_POP, this);
+		c.compileList(whenStmts.at(i).second);
+		ends.push_back(c.emit(BC_JUMP, this));
+		c.patch(next, c.getAddress());
+	}
+	if(condition != 0)
+		c.emit(BC_POP, this);
+	c.compileList(elseStmts);
+	c.patch(ends, c.getAddress());
+}
+
 /*** Destructor ***/
 Case::~Case()
 {
@@ -44,6 +44,9 @@ class Case : public Node
 		/*** Execute this node ***/
 		Outcome execute();
 
+		/*** Compile this node ***/
+		void compile(Compiler& c);
+
 		/*** Clone this object ***/
 		Case* clone() const
 		{
@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "do.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Do::Do()
@@ -88,6 +89,33 @@ Outcome Do::execute()
 	return result;
 }
 
+/*** Compile this node ***/
+void Do::compile(Compiler& c)
+{
+	std::vector<unsigned int> ends;
+
+	unsigned int top = c.getAddress();
+	c.beginLoop();
+	c.compileList(list);
+	std::vector<unsigned int> exits = c.endLoop();
+
+	if(until != 0)
+	{
+		until->compile(c);
+		ends.push_back(c.emit(BC_JUMPT, this));
+	}
+	c.patch(c.emit(BC_JUMP, this), top);
+
+	// An exit still evaluates the until condition
+	c.patch(exits, c.getAddress());
+	if(until != 0)
+	{
+		until->compile(c);
+		ends.push_back(c.emit(BC_JUMPT, this));
+	}
+	c.patch(ends, c.getAddress());
+}
+
 /*** Destructor ***/
 Do::~Do()
 {
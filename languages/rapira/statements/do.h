@@ -49,6 +49,9 @@ class Do : public Node
 		/*** Execute this node ***/
 		Outcome execute();
 
+		/*** Compile this node ***/
+		void compile(Compiler& c);
+
 		/*** Clone this object ***/
 		Do* clone() const
 		{
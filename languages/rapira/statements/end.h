@@ -32,6 +32,9 @@ class End : public Node
 		/*** Execute this node ***/
 		Outcome execute();
 
+		/*** Compile this node ***/
+		void compile(Compiler& c);
+
 		/*** Clone this object ***/
 		End* clone() const
 		{
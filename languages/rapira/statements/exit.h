@@ -32,6 +32,9 @@ class Exit : public Node
 		/*** Execute this node ***/
 		Outcome execute();
 
+		/*** Compile this node ***/
+		void compile(Compiler& c);
+
 		/*** Destructor ***/
 		~Exit();
 
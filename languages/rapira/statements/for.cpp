@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "for.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 For::For()
@@ -186,9 +187,72 @@ Outcome For::execute()
 	}
 	while(result.getStatus() == S_SUCCESS);
 
+	if(result.getStatus() == S_EXIT)
+		result = Outcome(S_SUCCESS);
+
 	return result;
 }
 
+/*** Compile this node ***/
+void For::compile(Compiler& c)
+{
+	if(forValue == 0 || forValue->getType() != OP_VARIABLE)
+	{
+		Node::compile(c);
+		return;
+	}
+	std::string name = static_cast<Variable*>(forValue)->getIdentifier();
+	std::vector<unsigned int> ends;
+
+	if(from != 0)
+		from->compile(c);
+	else
+		c.emit(BC_INT, 1, this);
+	c.emit(BC_FORINIT, from != 0, name, this);
+
+	unsigned int top = c.getAddress();
+	if(whileCond != 0)
+	{
+		whileCond->compile(c);
+		ends.push_back(c.emit(BC_JUMPF, this));
+	}
+	if(to != 0)
+	{
+		to->compile(c);
+		if(step != 0)
+			step->compile(c);
+		else
+			c.emit(BC_INT, 1, this);
+		ends.push_back(c.emit(BC_FORTEST, 0, name, this));
+	}
+
+	c.beginLoop();
+	c.compileList(list);
+	std::vector<unsigned int> exits = c.endLoop();
+
+	// An exit still steps the variable and evaluates the until condition
+	for(int pass = 0; pass < 2; pass++)
+	{
+		if(pass == 1)
+			c.patch(exits, c.getAddress());
+		if(step != 0)
+		{
+			step->compile(c);
+			c.emit(BC_FORSTEP, 0, name, this);
+		}
+		else
+			c.emit(BC_FORINC, 0, name, this);
+		if(untilCond != 0)
+		{
+			untilCond->compile(c);
+			ends.push_back(c.emit(BC_JUMPT, this));
+		}
+		if(pass == 0)
+			c.patch(c.emit(BC_JUMP, this), top);
+	}
+	c.patch(ends, c.getAddress());
+}
+
 /*** Destructor ***/
 For::~For()
 {
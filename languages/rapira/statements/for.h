@@ -61,6 +61,9 @@ class For : public Node
 		/*** Execute this node ***/
 		Outcome execute();
 
+		/*** Compile this node ***/
+		void compile(Compiler& c);
+
 		/*** Clone this object ***/
 		For* clone() const
 		{
@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "if.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 If::If()
@@ -68,6 +69,23 @@ Outcome If::execute()
 	return result;
 }
 
+/*** Compile this node ***/
+void If::compile(Compiler& c)
+{
+	ifExpr->compile(c);
+	unsigned int jumpElse = c.emit(BC_JUMPF, ifExpr);
+	c.compileList(ifStmts);
+	if(elseStmts == 0 || elseStmts->getLength() == 0)
+	{
+		c.patch(jumpElse, c.getAddress());
+		return;
+	}
+	unsigned int jumpEnd = c.emit(BC_JUMP, this);
+	c.patch(jumpElse, c.getAddress());
+	c.compileList(elseStmts);
+	c.patch(jumpEnd, c.getAddress());
+}
+
 /*** Destructor ***/
 If::~If()
 {
@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "output.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Output::Output()
@@ -66,7 +67,7 @@ Outcome Output::execute()
 		else if(val->getType() == OBJ_TEXT)
 		{
 			Text* cast = static_cast<Text*>(val.get());
-			std::cout << cast->getValue();
+			cast->write(std::cout);
 		}
 		else if(val->getType() == OBJ_LOGICAL)
 		{
@@ -99,6 +100,18 @@ Outcome Output::execute()
 	return Outcome(S_SUCCESS);
 }
 
+/*** Compile this node ***/
+void Output::compile(Compiler& c)
+{
+	for(unsigned int i = 0; i < exprs.size(); i++)
+	{
+		exprs.at(i)->compile(c);
+		c.emit(BC_OUTPUT, i + 1, this);
+	}
+	if(newline)
+		c.emit(BC_NEWLINE, this);
+}
+
 /*** Destructor ***/
 Output::~Output()
 {
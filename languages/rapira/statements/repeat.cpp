@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "repeat.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Repeat::Repeat()
@@ -107,6 +108,47 @@ Outcome Repeat::execute()
 	return result;
 }
 
+/*** Compile this node ***/
+void Repeat::compile(Compiler& c)
+{
+	std::vector<unsigned int> ends;
+
+	// The remaining count stays on the stack during the loop
+	counter->compile(c);
+	c.emit(BC_CHKINT, counter);
+	c.emit(BC_REPINIT, this);
+
+	unsigned int top = c.getAddress();
+	ends.push_back(c.emit(BC_REPTEST, this));
+	if(whileCond != 0)
+	{
+		whileCond->compile(c);
+		ends.push_back(c.emit(BC_JUMPF, whileCond));
+	}
+
+	c.beginLoop();
+	c.compileList(list);
+	std::vector<unsigned int> exits = c.endLoop();
+
+	if(untilCond != 0)
+	{
+		untilCond->compile(c);
+		ends.push_back(c.emit(BC_JUMPT, untilCond));
+	}
+	c.emit(BC_REPDEC, this);
+	c.patch(c.emit(BC_JUMP, this), top);
+
+	// An exit still evaluates the until condition
+	c.patch(exits, c.getAddress());
+	if(untilCond != 0)
+	{
+		untilCond->compile(c);
+		ends.push_back(c.emit(BC_JUMPT, untilCond));
+	}
+	c.patch(ends, c.getAddress());
+	c.emit(BC_POP, this);
+}
+
 /*** Destructor ***/
 Repeat::~Repeat()
 {
@@ -48,6 +48,9 @@ class Repeat : public Node
 		/*** Execute this node ***/
 		Outcome execute();
 
+		/*** Compile this node ***/
+		void compile(Compiler& c);
+
 		/*** Clone this object ***/
 		Repeat* clone() const
 		{
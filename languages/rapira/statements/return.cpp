@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "return.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 Return::Return()
@@ -51,6 +52,18 @@ Outcome Return::execute()
 	return retVal;
 }
 
+/*** Compile this node ***/
+void Return::compile(Compiler& c)
+{
+	if(expr == 0)
+	{
+		c.emit(BC_RETURN, 0, this);
+		return;
+	}
+	expr->compile(c);
+	c.emit(BC_RETURN, 1, this);
+}
+
 /*** Destructor ***/
 Return::~Return()
 {
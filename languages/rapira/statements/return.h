@@ -41,6 +41,9 @@ class Return : public Node
 		/*** Execute this node ***/
 		Outcome execute();
 
+		/*** Compile this node ***/
+		void compile(Compiler& c);
+
 		/*** Clone this node ***/
 		Return* clone() const
 		{
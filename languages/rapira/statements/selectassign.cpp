@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "selectassign.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 SelectAssign::SelectAssign()
@@ -85,10 +86,10 @@ Outcome SelectAssign::execute()
 		if(cast2->getLength() != 1)
 			throw InvalidAssignmentException(getLineNumber(), getColumnNumber(), target->getIdentifier(), "Cannot perform assignment with text value of length greater than one!");
 
-		std::string modified = cast1->getValue();
-		modified.replace(numIndex - 1, 1, cast2->getValue());
-
-		Text* modText = new Text(modified);
+		Text* modText = cast1->getPart(0, numIndex - 1);
+		std::auto_ptr<Text> rest(cast1->getPart(numIndex, cast1->getLength() - numIndex));
+		modText->append(cast2);
+		modText->append(rest.get());
 		return Assign(target->clone(), modText).execute();
 	}
 
@@ -108,6 +109,20 @@ Outcome SelectAssign::execute()
 	return 0;
 }
 
+/*** Compile this node ***/
+void SelectAssign::compile(Compiler& c)
+{
+	if(target == 0 || index == 0 || expr == 0)
+	{
+		Node::compile(c);
+		return;
+	}
+	index->compile(c);
+	c.emit(BC_CHKINDEX, this);
+	expr->compile(c);
+	c.emit(BC_SETELEM, 0, target->getIdentifier(), this);
+}
+
 /*** Destructor ***/
 SelectAssign::~SelectAssign()
 {
@@ -50,6 +50,9 @@ class SelectAssign : public Node
 		/*** Execute this node ***/
 		Outcome execute();
 
+		/*** Compile this node ***/
+		void compile(Compiler& c);
+
 		/*** Clone this object ***/
 		SelectAssign* clone() const
 		{
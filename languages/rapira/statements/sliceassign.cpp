@@ -97,12 +97,13 @@ Outcome SliceAssign::execute()
 		if(numIndex2 > (int) cast1->getLength())
 			throw InvalidIndexException(getLineNumber(), getColumnNumber(), numIndex2);
 
-		std::string modified = "";
-		modified.append(cast1->getValue().substr(0, numIndex1 - 1));
-		modified.append(cast2->getValue());
-		modified.append(cast1->getValue().substr(numIndex2, cast1->getLength() - numIndex2));
+		// The new text links to the parts of the old one
+		Text* modified = cast1->getPart(0, numIndex1 - 1);
+		std::auto_ptr<Text> rest(cast1->getPart(numIndex2, cast1->getLength() - numIndex2));
+		modified->append(cast2);
+		modified->append(rest.get());
 
-		return Assign(target->clone(), new Text(modified)).execute();
+		return Assign(target->clone(), modified).execute();
 	}
 
 	if(evalTarget->getType() == OBJ_SEQUENCE)
@@ -17,6 +17,7 @@
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "while.h"
+#include "../compiler.h"
 
 /*** Constructor ***/
 While::While()
@@ -99,6 +100,36 @@ Outcome While::execute()
 	return result;
 }
 
+/*** Compile this node ***/
+void While::compile(Compiler& c)
+{
+	std::vector<unsigned int> ends;
+
+	unsigned int top = c.getAddress();
+	cond->compile(c);
+	ends.push_back(c.emit(BC_JUMPF, cond));
+
+	c.beginLoop();
+	c.compileList(list);
+	std::vector<unsigned int> exits = c.endLoop();
+
+	if(until != 0)
+	{
+		until->compile(c);
+		ends.push_back(c.emit(BC_JUMPT, until));
+	}
+	c.patch(c.emit(BC_JUMP, this), top);
+
+	// An exit still evaluates the until condition
+	c.patch(exits, c.getAddress());
+	if(until != 0)
+	{
+		until->compile(c);
+		ends.push_back(c.emit(BC_JUMPT, until));
+	}
+	c.patch(ends, c.getAddress());
+}
+
 /*** Destructor ***/
 While::~While()
 {
@@ -0,0 +1,58 @@
+// ReRap Version 0.9
+// Copyright 2011 Matthew Mikolay.
+//
+// This file is part of ReRap.
+//
+// ReRap is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ReRap is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstdlib>
+#include <new>
+#include "stats.h"
+
+/*** The number of heap allocations ***/
+unsigned long Statistics::allocations = 0;
+
+/*** The number of instructions run by the virtual machine ***/
+unsigned long Statistics::instructions = 0;
+
+/*** Print the counters ***/
+void Statistics::print(std::ostream& out)
+{
+	out << "instructions: " << instructions << std::endl;
+#ifdef COUNT_ALLOCATIONS
+	out << "allocations: " << allocations << std::endl;
+	if(instructions != 0)
+		out << "allocations per instruction: " << (double) allocations / instructions << std::endl;
+#endif
+}
+
+#ifdef COUNT_ALLOCATIONS
+
+/*** Count the allocations of the program ***/
+void* operator new(std::size_t size)
+{
+	Statistics::allocations++;
+	void* ptr = std::malloc(size == 0 ? 1 : size);
+	if(ptr == 0)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+/*** Free memory allocated by operator new ***/
+void operator delete(void* ptr) throw()
+{
+	std::free(ptr);
+}
+
+#endif
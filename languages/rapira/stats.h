@@ -0,0 +1,45 @@
+#ifndef STATS_H
+#define STATS_H
+
+// ReRap Version 0.9
+// Copyright 2011 Matthew Mikolay.
+//
+// This file is part of ReRap.
+//
+// ReRap is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ReRap is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <ostream>
+
+// Counters printed by rapira -s. Allocations are counted only when
+// built with COUNT_ALLOCATIONS, which replaces the global operator
+// new: every use of it while the program runs counts; objects taken
+// from a free list do not.
+
+class Statistics
+{
+
+	public:
+
+		/*** The number of heap allocations ***/
+		static unsigned long allocations;
+
+		/*** The number of instructions run by the virtual machine ***/
+		static unsigned long instructions;
+
+		/*** Print the counters ***/
+		static void print(std::ostream& out);
+
+};
+
+#endif
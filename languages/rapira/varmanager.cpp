@@ -18,14 +18,27 @@
 
 #include "varmanager.h"
 
-/*** The entry of special values ***/
-std::map<std::string, Object*> VariableManager::special;
+/*** The names of the special values ***/
+std::vector<std::string> VariableManager::specialNames;
 
-/*** The stack of entries ***/
-std::stack< std::map<std::string, Object*> > VariableManager::stack;
+/*** The special values, at index -1 - i ***/
+std::vector<Object*> VariableManager::special;
 
-/*** The current entry ***/
-std::map<std::string, Object*> VariableManager::entry;
+/*** The slots of all entries ***/
+std::vector<Object*> VariableManager::slots;
+
+/*** The stack of entries, the current one on top ***/
+std::vector<Frame> VariableManager::frames;
+
+/*** The scope of the program ***/
+Scope VariableManager::global;
+
+/*** Constructor ***/
+Frame::Frame(Scope* pScope, unsigned int pBase)
+{
+	scope = pScope;
+	base = pBase;
+}
 
 /*** Constructor ***/
 VariableManager::VariableManager()
@@ -33,120 +46,193 @@ VariableManager::VariableManager()
 	// Set up special values
 	if(special.empty())
 	{
-		special["pi"]		= new Real(3.14159265358979323846);
-		special["lf"]		= new Text("\n");
-		special["abs"]		= new SpecialFunction(SPF_ABS);
-		special["sign"]		= new SpecialFunction(SPF_SIGN);
-		special["sqrt"]		= new SpecialFunction(SPF_SQRT);
-		special["entier"]	= new SpecialFunction(SPF_ENTIER);
-		special["round"]	= new SpecialFunction(SPF_ROUND);
-		special["rand"]		= new SpecialFunction(SPF_RAND);
-		special["int_rand"]	= new SpecialFunction(SPF_INTRAND);
-		special["index"]	= new SpecialFunction(SPF_INDEX);
-		special["is_empty"]	= new SpecialFunction(SPF_ISEMPTY);
-		special["is_log"]	= new SpecialFunction(SPF_ISLOG);
-		special["is_int"]	= new SpecialFunction(SPF_ISINT);
-		special["is_real"]	= new SpecialFunction(SPF_ISREAL);
-		special["is_text"]	= new SpecialFunction(SPF_ISTEXT);
-		special["is_seq"]	= new SpecialFunction(SPF_ISSEQ);
-		special["is_proc"]	= new SpecialFunction(SPF_ISPROC);
-		special["is_fun"]	= new SpecialFunction(SPF_ISFUN);
-		special["sin"]		= new SpecialFunction(SPF_SIN);
-		special["cos"]		= new SpecialFunction(SPF_COS);
-		special["tg"]		= new SpecialFunction(SPF_TG);
-		special["arcsin"]	= new SpecialFunction(SPF_ARCSIN);
-		special["arctg"]	= new SpecialFunction(SPF_ARCTG);
-		special["exp"]		= new SpecialFunction(SPF_EXP);
-		special["ln"]		= new SpecialFunction(SPF_LN);
-		special["lg"]		= new SpecialFunction(SPF_LG);
+		addSpecial("pi",		new Real(3.14159265358979323846));
+		addSpecial("lf",		new Text("\n"));
+		addSpecial("abs",		new SpecialFunction(SPF_ABS));
+		addSpecial("sign",		new SpecialFunction(SPF_SIGN));
+		addSpecial("sqrt",		new SpecialFunction(SPF_SQRT));
+		addSpecial("entier",	new SpecialFunction(SPF_ENTIER));
+		addSpecial("round",		new SpecialFunction(SPF_ROUND));
+		addSpecial("rand",		new SpecialFunction(SPF_RAND));
+		addSpecial("int_rand",	new SpecialFunction(SPF_INTRAND));
+		addSpecial("index",		new SpecialFunction(SPF_INDEX));
+		addSpecial("is_empty",	new SpecialFunction(SPF_ISEMPTY));
+		addSpecial("is_log",	new SpecialFunction(SPF_ISLOG));
+		addSpecial("is_int",	new SpecialFunction(SPF_ISINT));
+		addSpecial("is_real",	new SpecialFunction(SPF_ISREAL));
+		addSpecial("is_text",	new SpecialFunction(SPF_ISTEXT));
+		addSpecial("is_seq",	new SpecialFunction(SPF_ISSEQ));
+		addSpecial("is_proc",	new SpecialFunction(SPF_ISPROC));
+		addSpecial("is_fun",	new SpecialFunction(SPF_ISFUN));
+		addSpecial("sin",		new SpecialFunction(SPF_SIN));
+		addSpecial("cos",		new SpecialFunction(SPF_COS));
+		addSpecial("tg",		new SpecialFunction(SPF_TG));
+		addSpecial("arcsin",	new SpecialFunction(SPF_ARCSIN));
+		addSpecial("arctg",		new SpecialFunction(SPF_ARCTG));
+		addSpecial("exp",		new SpecialFunction(SPF_EXP));
+		addSpecial("ln",		new SpecialFunction(SPF_LN));
+		addSpecial("lg",		new SpecialFunction(SPF_LG));
 	}
+
+	// Set up the entry of the program
+	if(frames.empty())
+		frames.push_back(Frame(&global, 0));
 }
 
-/*** If an object exists in the current entry ***/
-bool VariableManager::hasObject(std::string id)
+/*** Add a special value ***/
+void VariableManager::addSpecial(const std::string& id, Object* obj)
 {
-	return (special.count(id) != 0 || entry.count(id) != 0);
+	specialNames.push_back(id);
+	special.push_back(obj);
 }
 
-/*** Set the object to which a variable refers ***/
-void VariableManager::setObject(std::string id, Object* obj)
+/*** Get the index of a name in a scope, binding it if needed ***/
+int VariableManager::resolve(Scope* scope, const std::string& id)
+{
+	int index = scope->lookup(id);
+	if(index != SCOPE_UNBOUND)
+		return index;
+
+	for(unsigned int i = 0; i < specialNames.size(); i++)
+	{
+		if(specialNames.at(i) == id)
+		{
+			scope->bind(id, -1 - (int) i);
+			return -1 - (int) i;
+		}
+	}
+	return scope->bind(id);
+}
+
+/*** Get the index of a name in the current scope, binding it if needed ***/
+int VariableManager::resolve(const std::string& id)
+{
+	return resolve(frames.back().scope, id);
+}
+
+/*** Get the object in a slot of the current entry, or 0 ***/
+Object* VariableManager::getSlot(int index)
+{
+	if(index < 0)
+		return special[-1 - index];
+	unsigned int pos = frames.back().base + index;
+	if(pos >= slots.size())
+		return 0;
+	return slots[pos];
+}
+
+/*** Set the object in a slot of the current entry ***/
+void VariableManager::setSlot(int index, Object* obj)
 {
-	if(special.count(id) != 0)
+	if(index < 0)
 	{
 		delete obj;
-		throw InvalidAssignmentException(id, "Cannot assign value to a special variable.");
+		throw InvalidAssignmentException(specialNames.at(-1 - index), "Cannot assign value to a special variable.");
 	}
-	if(entry.count(id) != 0)
-		delete entry[id];
-	entry[id] = obj;
+
+	// The current entry is the last one, so it can always grow
+	unsigned int pos = frames.back().base + index;
+	if(pos >= slots.size())
+		slots.resize(pos + 1, 0);
+	delete slots[pos];
+	slots[pos] = obj;
+}
+
+/*** If an object exists in the current entry ***/
+bool VariableManager::hasObject(const std::string& id)
+{
+	return getSlot(resolve(id)) != 0;
+}
+
+/*** Set the object to which a variable refers ***/
+void VariableManager::setObject(const std::string& id, Object* obj)
+{
+	setSlot(resolve(id), obj);
 }
 
 /*** Get the object to which a variable refers ***/
-Object* VariableManager::getObject(std::string id)
+Object* VariableManager::getObject(const std::string& id)
 {
-	if(special.count(id) != 0)
-		return special[id];
-	return entry[id];
+	return getSlot(resolve(id));
 }
-		
-/*** Push the current entry onto the manager ***/
-void VariableManager::pushEntry()
+
+/*** Get the scope of the current entry ***/
+Scope* VariableManager::getScope()
 {
-	stack.push(entry);
-	entry.clear();
+	return frames.back().scope;
+}
+
+/*** Push a new entry for the given scope onto the manager ***/
+void VariableManager::pushEntry(Scope* scope)
+{
+	frames.push_back(Frame(scope, slots.size()));
+	slots.resize(slots.size() + scope->getSize(), 0);
 }
 
 /*** Pop an entry off the manager ***/
 void VariableManager::popEntry()
 {
-	// Clear all items from the current entry
-	for(std::map<std::string, Object*>::iterator it = entry.begin(); it != entry.end(); it++)
-		delete it->second;
-	entry.clear();
-
-	if(stack.empty())
+	if(frames.empty())
 		return;
 
-	entry = stack.top();
-	stack.pop();
+	// Clear all items from the current entry
+	unsigned int base = frames.back().base;
+	for(unsigned int i = base; i < slots.size(); i++)
+		delete slots[i];
+	slots.resize(base);
+	frames.pop_back();
 }
 
 /*** Get an object on the top entry ***/
-Object* VariableManager::getTopLevelObject(std::string id)
+Object* VariableManager::getTopLevelObject(const std::string& id)
 {
-	if(stack.top().count(id) == 0)
+	Frame& lower = frames.at(frames.size() - 2);
+	int index = resolve(lower.scope, id);
+	if(index < 0)
+		return special[-1 - index];
+	unsigned int pos = lower.base + index;
+	if(pos >= frames.back().base)
 		return 0;
-	return stack.top()[id];
+	return slots[pos];
 }
 
 /*** Set an object on the top entry ***/
-void VariableManager::setTopLevelObject(std::string id, Object* obj)
+void VariableManager::setTopLevelObject(const std::string& id, Object* obj)
 {
-	if(special.count(id) != 0)
+	Frame& lower = frames.at(frames.size() - 2);
+	int index = resolve(lower.scope, id);
+	if(index < 0)
 		throw InvalidAssignmentException(id, "Cannot assign value to a special variable.");
-	if(stack.top().count(id) != 0)
-		delete stack.top()[id];
-	stack.top()[id] = obj;
+
+	// Make room in the lower entry if it is shorter than its scope
+	unsigned int pos = lower.base + index;
+	if(pos >= frames.back().base)
+	{
+		unsigned int grow = pos + 1 - frames.back().base;
+		slots.insert(slots.begin() + frames.back().base, grow, (Object*) 0);
+		frames.back().base += grow;
+	}
+	delete slots[pos];
+	slots[pos] = obj;
 }
 
 /*** Empty the manager ***/
 void VariableManager::empty()
 {
 	// Clear all items from the special entry
-	for(std::map<std::string, Object*>::iterator it = special.begin(); it != special.end(); it++)
-		delete it->second;
+	for(unsigned int i = 0; i < special.size(); i++)
+		delete special.at(i);
 	special.clear();
+	specialNames.clear();
 	// Clear all entries from the stack
-	while(!stack.empty())
+	while(!frames.empty())
 		popEntry();
-	// Clear the last entry, not stored on the stack
-	popEntry();
 }
 
 /*** Return the size of the stack ***/
 unsigned int VariableManager::getStackSize()
 {
-	return stack.size();
+	return frames.size() - 1;
 }
 
 /*** Destructor ***/
@@ -19,14 +19,34 @@
 // You should have received a copy of the GNU General Public License
 // along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
 
-#include <map>
-#include <stack>
+#include <string>
+#include <vector>
+#include "scope.h"
 #include "primitives/real.h"
 #include "primitives/text.h"
-#include "primitives/variable.h"
 #include "primitives/specialfunction.h"
 #include "exceptions/invalidassignment.h"
 
+// Variables live in slots of frames allocated from one contiguous stack.
+// A scope binds each name used by a procedure to a slot of its frames,
+// or to a negative index for the special values.
+
+class Frame
+{
+
+	public:
+
+		/*** Constructor ***/
+		Frame(Scope* pScope, unsigned int pBase);
+
+		/*** The scope of the frame ***/
+		Scope* scope;
+
+		/*** The position of the first slot ***/
+		unsigned int base;
+
+};
+
 class VariableManager
 {
 
@@ -35,26 +55,41 @@ class VariableManager
 		/*** Constructor ***/
 		VariableManager();
 
+		/*** Get the index of a name in a scope, binding it if needed ***/
+		int resolve(Scope* scope, const std::string& id);
+
+		/*** Get the index of a name in the current scope, binding it if needed ***/
+		int resolve(const std::string& id);
+
+		/*** Get the object in a slot of the current entry, or 0 ***/
+		Object* getSlot(int index);
+
+		/*** Set the object in a slot of the current entry ***/
+		void setSlot(int index, Object* obj);
+
 		/*** If an object exists in the current entry ***/
-		bool hasObject(std::string id);
+		bool hasObject(const std::string& id);
 
 		/*** Set the object to which a variable refers ***/
-		void setObject(std::string id, Object* obj);
+		void setObject(const std::string& id, Object* obj);
 
 		/*** Get the object to which a variable refers ***/
-		Object* getObject(std::string id);
-		
-		/*** Push the current entry onto the manager ***/
-		void pushEntry();
+		Object* getObject(const std::string& id);
+
+		/*** Get the scope of the current entry ***/
+		Scope* getScope();
+
+		/*** Push a new entry for the given scope onto the manager ***/
+		void pushEntry(Scope* scope);
 
 		/*** Pop an entry off the manager ***/
 		void popEntry();
 
 		/*** Get an object on the top entry ***/
-		Object* getTopLevelObject(std::string id);
+		Object* getTopLevelObject(const std::string& id);
 
 		/*** Set an object on the top entry ***/
-		void setTopLevelObject(std::string id, Object* obj);
+		void setTopLevelObject(const std::string& id, Object* obj);
 
 		/*** Empty the manager ***/
 		void empty();
@@ -67,14 +102,23 @@ class VariableManager
 
 	private:
 
-		/*** The entry of special values ***/
-		static std::map<std::string, Object*> special;
+		/*** Add a special value ***/
+		void addSpecial(const std::string& id, Object* obj);
+
+		/*** The names of the special values ***/
+		static std::vector<std::string> specialNames;
+
+		/*** The special values, at index -1 - i ***/
+		static std::vector<Object*> special;
+
+		/*** The slots of all entries ***/
+		static std::vector<Object*> slots;
 
-		/*** The stack of entries ***/
-		static std::stack< std::map<std::string, Object*> > stack;
+		/*** The stack of entries, the current one on top ***/
+		static std::vector<Frame> frames;
 
-		/*** The current entry ***/
-		static std::map<std::string, Object*> entry;
+		/*** The scope of the program ***/
+		static Scope global;
 
 };
 
@@ -0,0 +1,812 @@
+// ReRap Version 0.9
+// Copyright 2011 Matthew Mikolay.
+//
+// This file is part of ReRap.
+//
+// ReRap is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ReRap is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <iostream>
+#include <memory>
+#include "vm.h"
+#include "compiler.h"
+#include "operations/add.h"
+#include "operations/and.h"
+#include "operations/divide.h"
+#include "operations/equal.h"
+#include "operations/exponent.h"
+#include "operations/greater.h"
+#include "operations/greateq.h"
+#include "operations/intdivide.h"
+#include "operations/length.h"
+#include "operations/less.h"
+#include "operations/lesseq.h"
+#include "operations/multiply.h"
+#include "operations/negate.h"
+#include "operations/not.h"
+#include "operations/or.h"
+#include "operations/remainder.h"
+#include "operations/select.h"
+#include "operations/slice.h"
+#include "operations/subtract.h"
+#include "operations/unequal.h"
+#include "primitives/integer.h"
+#include "primitives/logical.h"
+#include "primitives/sequence.h"
+#include "statements/assign.h"
+#include "statements/output.h"
+#include "statements/selectassign.h"
+#include "exceptions/invalidindex.h"
+#include "exceptions/negativevalue.h"
+#include "stats.h"
+#include "profiler.h"
+
+/*** Make an integer value ***/
+static Value makeInteger(long pValue)
+{
+	Value val;
+	val.type = OBJ_INTEGER;
+	val.integer = pValue;
+	return val;
+}
+
+/*** Make a real value ***/
+static Value makeReal(double pValue)
+{
+	Value val;
+	val.type = OBJ_REAL;
+	val.real = pValue;
+	return val;
+}
+
+/*** Make a logical value ***/
+static Value makeLogical(bool pValue)
+{
+	Value val;
+	val.type = OBJ_LOGICAL;
+	val.logical = pValue;
+	return val;
+}
+
+/*** Hold an object in a value, unboxing integers, reals and logicals ***/
+static Value unbox(Object* obj)
+{
+	Value val;
+	val.type = obj->getType();
+	switch(val.type)
+	{
+		case OBJ_INTEGER:
+			val.integer = static_cast<Integer*>(obj)->getValue();
+			delete obj;
+			break;
+		case OBJ_REAL:
+			val.real = static_cast<Real*>(obj)->getValue();
+			delete obj;
+			break;
+		case OBJ_LOGICAL:
+			val.logical = static_cast<Logical*>(obj)->getValue();
+			delete obj;
+			break;
+		default:
+			val.object = obj;
+	}
+	return val;
+}
+
+/*** Copy the value of an object which stays with its owner ***/
+static Value copy(Object* obj)
+{
+	switch(obj->getType())
+	{
+		case OBJ_INTEGER:
+			return makeInteger(static_cast<Integer*>(obj)->getValue());
+		case OBJ_REAL:
+			return makeReal(static_cast<Real*>(obj)->getValue());
+		case OBJ_LOGICAL:
+			return makeLogical(static_cast<Logical*>(obj)->getValue());
+	}
+	Value val;
+	val.type = obj->getType();
+	val.object = obj->clone();
+	return val;
+}
+
+/*** Get an object holding a value, taking ownership of the value ***/
+static Object* box(const Value& val)
+{
+	switch(val.type)
+	{
+		case OBJ_INTEGER:
+			return new Integer(val.integer);
+		case OBJ_REAL:
+			return new Real(val.real);
+		case OBJ_LOGICAL:
+			return new Logical(val.logical);
+	}
+	return val.object;
+}
+
+/*** Box a value left on the stack, leaving nothing to delete behind ***/
+static Object* take(Value& val)
+{
+	Object* obj = box(val);
+	val.type = OBJ_EMPTY;
+	val.object = 0;
+	return obj;
+}
+
+/*** Delete the object of a value, if any ***/
+static void release(Value& val)
+{
+	if(val.isBoxed())
+		delete val.object;
+}
+
+/*** Constructor ***/
+ValueStack::ValueStack()
+{
+}
+
+/*** Push a value, taking ownership of it ***/
+void ValueStack::push(const Value& val)
+{
+	values.push_back(val);
+}
+
+/*** Pop a value, giving up ownership of it ***/
+Value ValueStack::pop()
+{
+	Value val = values.back();
+	values.pop_back();
+	return val;
+}
+
+/*** Get the value on the top ***/
+Value& ValueStack::top()
+{
+	return values.back();
+}
+
+/*** Get the address of the n topmost values ***/
+Value* ValueStack::topmost(unsigned int n)
+{
+	if(n == 0)
+		return 0;
+	return &values.at(values.size() - n);
+}
+
+/*** Drop the n topmost values ***/
+void ValueStack::drop(unsigned int n)
+{
+	for(unsigned int i = 0; i < n; i++)
+	{
+		release(values.back());
+		values.pop_back();
+	}
+}
+
+/*** Destructor, deletes any values left ***/
+ValueStack::~ValueStack()
+{
+	drop(values.size());
+}
+
+/*** Constructor ***/
+VirtualMachine::VirtualMachine()
+{
+}
+
+/*** Run a chunk, return the value it returns, if any ***/
+Object* VirtualMachine::run(Chunk* code)
+{
+	// Values are checked while still on the stack,
+	// so that the stack deletes them if an error is thrown
+	ValueStack stack;
+	unsigned int pc = 0;
+
+	for(;;)
+	{
+		Instruction& ins = code->getInstruction(pc++);
+		Statistics::instructions++;
+		switch(ins.op)
+		{
+			case BC_EXEC:
+			{
+				Outcome result = ins.node->execute();
+				if(result.getStatus() == S_EXIT)
+				{
+					if(ins.arg < 0)
+						return 0;
+					pc = ins.arg;
+				}
+				else if(result.getStatus() != S_SUCCESS)
+					return result.getObject();
+				break;
+			}
+			case BC_EVAL:
+				stack.push(unbox(static_cast<Object*>(ins.node)->evaluate()));
+				break;
+			case BC_INT:
+				stack.push(makeInteger(ins.arg));
+				break;
+			case BC_POP:
+				stack.drop(1);
+				break;
+			case BC_LOAD:
+				stack.push(load(ins.slot));
+				break;
+			case BC_STORE:
+				store(ins.slot, code->getName(ins.name), stack.pop(), ins.node);
+				break;
+			case BC_ADD:
+			case BC_SUBTRACT:
+			case BC_MULTIPLY:
+			case BC_DIVIDE:
+			case BC_INTDIVIDE:
+			case BC_REMAINDER:
+			case BC_EXPONENT:
+			case BC_EQUAL:
+			case BC_UNEQUAL:
+			case BC_GREATER:
+			case BC_LESS:
+			case BC_GREATEQ:
+			case BC_LESSEQ:
+			case BC_AND:
+			case BC_OR:
+			case BC_SELECT:
+			{
+				Value val2 = stack.pop();
+				Value val1 = stack.pop();
+				stack.push(binary(ins.op, val1, val2, ins.node));
+				break;
+			}
+			case BC_NOT:
+			case BC_NEGATE:
+			case BC_LENGTH:
+				stack.push(unary(ins.op, stack.pop(), ins.node));
+				break;
+			case BC_CHKLOG:
+				if(stack.top().type != OBJ_LOGICAL)
+					throw InvalidTypeException(ins.node->getLineNumber(), ins.node->getColumnNumber(), OBJ_LOGICAL, stack.top().type, ins.arg);
+				break;
+			case BC_SELVAR:
+				stack.push(selectVariable(ins.slot, stack.pop(), ins.node));
+				break;
+			case BC_SLICE:
+			{
+				Object* obj3 = (ins.arg & 2) ? box(stack.pop()) : 0;
+				Object* obj2 = (ins.arg & 1) ? box(stack.pop()) : 0;
+				Slice operation(box(stack.pop()), obj2, obj3);
+				operation.setLineNumber(ins.node->getLineNumber());
+				operation.setColumnNumber(ins.node->getColumnNumber());
+				stack.push(unbox(operation.evaluate()));
+				break;
+			}
+			case BC_SEQ:
+			{
+				Sequence* seq = new Sequence();
+				Value* elems = stack.topmost(ins.arg);
+				for(int i = 0; i < ins.arg; i++)
+					seq->pushObject(take(elems[i]));
+				stack.drop(ins.arg);
+				Value val;
+				val.type = OBJ_SEQUENCE;
+				val.object = seq;
+				stack.push(val);
+				break;
+			}
+			case BC_CALL:
+			{
+				Object* result = call(static_cast<Call*>(ins.node), stack.topmost(ins.arg), ins.arg);
+				stack.drop(ins.arg);
+				stack.push(unbox(result != 0 ? result : new Object()));
+				break;
+			}
+			case BC_CHKINDEX:
+				if(stack.top().type != OBJ_INTEGER)
+					throw InvalidTypeException(ins.node->getLineNumber(), ins.node->getColumnNumber(), OBJ_INTEGER, stack.top().type);
+				if(stack.top().integer <= 0)
+					throw InvalidIndexException(ins.node->getLineNumber(), ins.node->getColumnNumber(), stack.top().integer);
+				break;
+			case BC_SETELEM:
+			{
+				Value val = stack.pop();
+				setElement(ins.slot, code->getName(ins.name), stack.pop(), val, ins.node);
+				break;
+			}
+			case BC_JUMP:
+				pc = ins.arg;
+				break;
+			case BC_JUMPF:
+			case BC_JUMPT:
+				if(stack.top().type != OBJ_LOGICAL)
+					throw InvalidTypeException(ins.node->getLineNumber(), ins.node->getColumnNumber(), OBJ_LOGICAL, stack.top().type);
+				if(stack.pop().logical == (ins.op == BC_JUMPT))
+					pc = ins.arg;
+				break;
+			case BC_CASEEQ:
+			{
+				Value when = stack.pop();
+				Value cond = stack.top().isBoxed() ? copy(stack.top().object) : stack.top();
+				stack.push(binary(BC_EQUAL, when, cond, 0));
+				break;
+			}
+			case BC_OUTPUT:
+				output(stack.top(), ins.node, ins.arg);
+				stack.drop(1);
+				break;
+			case BC_NEWLINE:
+				std::cout << std::endl;
+				break;
+			case BC_RETURN:
+				if(ins.arg)
+					return box(stack.pop());
+				return 0;
+			case BC_END:
+				return 0;
+			case BC_FORINIT:
+				if(ins.arg && stack.top().type != OBJ_INTEGER && stack.top().type != OBJ_REAL)
+					throw InvalidTypeException(ins.node->getLineNumber(), ins.node->getColumnNumber(), OBJ_INTEGER | OBJ_REAL, stack.top().type);
+				Assign(new Variable(code->getName(ins.name)), box(stack.pop())).execute();
+				break;
+			case BC_FORTEST:
+			{
+				Value& step = stack.top();
+				if(step.type != OBJ_INTEGER && step.type != OBJ_REAL)
+					throw InvalidTypeException(ins.node->getLineNumber(), ins.node->getColumnNumber(), OBJ_INTEGER | OBJ_REAL, step.type);
+				double stepValue = (step.type == OBJ_INTEGER) ? step.integer : step.real;
+				stack.pop();
+				Value to = stack.pop();
+				if(stepValue == 0)
+				{
+					release(to);
+					break;
+				}
+				Value done = binary(stepValue > 0 ? BC_GREATER : BC_LESS, load(ins.slot), to, 0);
+				if(done.logical)
+					pc = ins.arg;
+				break;
+			}
+			case BC_FORSTEP:
+				if(stack.top().type != OBJ_INTEGER && stack.top().type != OBJ_REAL)
+					throw InvalidTypeException(ins.node->getLineNumber(), ins.node->getColumnNumber(), OBJ_INTEGER | OBJ_REAL, stack.top().type);
+				increment(ins.slot, code->getName(ins.name), stack.pop());
+				break;
+			case BC_FORINC:
+				increment(ins.slot, code->getName(ins.name), makeInteger(1));
+				break;
+			case BC_CHKINT:
+				if(stack.top().type != OBJ_INTEGER)
+					throw InvalidTypeException(ins.node->getLineNumber(), ins.node->getColumnNumber(), OBJ_INTEGER, stack.top().type);
+				break;
+			case BC_REPINIT:
+				if(stack.top().integer < 0)
+					throw NegativeValueException(ins.node->getLineNumber(), ins.node->getColumnNumber(), stack.top().integer);
+				break;
+			case BC_REPTEST:
+				if(stack.top().integer <= 0)
+					pc = ins.arg;
+				break;
+			case BC_REPDEC:
+				stack.top().integer--;
+				break;
+			case BC_LINE:
+				Profiler::line(ins.arg);
+				break;
+			default:
+				throw Excep(ins.node->getLineNumber(), ins.node->getColumnNumber(), "Invalid instruction!");
+		}
+	}
+}
+
+/*** Get a copy of a variable ***/
+Value VirtualMachine::load(int slot)
+{
+	Object* obj = manager.getSlot(slot);
+	if(obj == 0)
+	{
+		Value val;
+		val.type = OBJ_EMPTY;
+		val.object = new Object();
+		return val;
+	}
+	return copy(obj);
+}
+
+/*** Assign a value to a variable ***/
+void VirtualMachine::store(int slot, const std::string& name, Value val, Node* node)
+{
+	Object* old = manager.getSlot(slot);
+	if(old != 0)
+	{
+		unsigned char type = old->getType();
+		if(type == OBJ_PROCEDURE || type == OBJ_FUNCTION)
+		{
+			release(val);
+			throw InvalidAssignmentException(node->getLineNumber(), node->getColumnNumber(), name, "Cannot overwrite a procedure or function!");
+		}
+
+		// A variable keeps its object when it gets a new value of the same type
+		if(type == val.type && slot >= 0)
+		{
+			switch(type)
+			{
+				case OBJ_INTEGER:
+					static_cast<Integer*>(old)->setValue(val.integer);
+					return;
+				case OBJ_REAL:
+					static_cast<Real*>(old)->setValue(val.real);
+					return;
+				case OBJ_LOGICAL:
+					static_cast<Logical*>(old)->setValue(val.logical);
+					return;
+			}
+		}
+	}
+
+	try
+	{
+		manager.setSlot(slot, box(val));
+	}
+	catch(InvalidAssignmentException& e)
+	{
+		throw InvalidAssignmentException(node->getLineNumber(), node->getColumnNumber(), e.getIdentifier(), e.getInformation());
+	}
+}
+
+/*** Apply a binary operation ***/
+Value VirtualMachine::binary(unsigned char op, Value val1, Value val2, Node* node)
+{
+	// Numbers and logicals are handled here, the same way as the operation nodes do
+	if(val1.type == OBJ_INTEGER && val2.type == OBJ_INTEGER)
+	{
+		long a = val1.integer;
+		long b = val2.integer;
+		switch(op)
+		{
+			case BC_ADD:		return makeInteger(a + b);
+			case BC_SUBTRACT:	return makeInteger(a - b);
+			case BC_MULTIPLY:	return makeInteger(a * b);
+			case BC_DIVIDE:
+				if(b == 0)
+					break;
+				if(((double) a) / b == a / b)
+					return makeInteger(a / b);
+				return makeReal(a / b);
+			case BC_INTDIVIDE:
+				if(b == 0)
+					break;
+				return makeInteger(a / b);
+			case BC_REMAINDER:
+				if(b == 0)
+					break;
+				return makeInteger(a % b);
+			case BC_EQUAL:		return makeLogical(a == b);
+			case BC_UNEQUAL:	return makeLogical(!(a == b));
+			case BC_GREATER:	return makeLogical(a > b);
+			case BC_LESS:		return makeLogical(!(a > b || a == b));
+			case BC_GREATEQ:	return makeLogical(a > b || a == b);
+			case BC_LESSEQ:		return makeLogical(!(a > b));
+		}
+	}
+	else if((val1.type == OBJ_INTEGER || val1.type == OBJ_REAL) && (val2.type == OBJ_INTEGER || val2.type == OBJ_REAL))
+	{
+		double a = (val1.type == OBJ_INTEGER) ? val1.integer : val1.real;
+		double b = (val2.type == OBJ_INTEGER) ? val2.integer : val2.real;
+		switch(op)
+		{
+			case BC_ADD:		return makeReal(a + b);
+			case BC_SUBTRACT:	return makeReal(a - b);
+			case BC_MULTIPLY:	return makeReal(a * b);
+			case BC_DIVIDE:
+				if(b == 0)
+					break;
+				return makeReal(a / b);
+			case BC_EQUAL:		return makeLogical(a == b);
+			case BC_UNEQUAL:	return makeLogical(!(a == b));
+			case BC_GREATER:	return makeLogical(a > b);
+			case BC_LESS:		return makeLogical(!(a > b || a == b));
+			case BC_GREATEQ:	return makeLogical(a > b || a == b);
+			case BC_LESSEQ:		return makeLogical(!(a > b));
+		}
+	}
+	else if(val1.type == OBJ_LOGICAL && val2.type == OBJ_LOGICAL)
+	{
+		bool a = val1.logical;
+		bool b = val2.logical;
+		switch(op)
+		{
+			case BC_EQUAL:		return makeLogical(a == b);
+			case BC_UNEQUAL:	return makeLogical(!(a == b));
+			case BC_AND:		return makeLogical(a && b);
+			case BC_OR:			return makeLogical(a || b);
+		}
+	}
+
+	// Everything else, including every error, is left to the operation nodes
+	Object* obj1 = box(val1);
+	Object* obj2 = box(val2);
+	std::auto_ptr<Object> operation;
+	switch(op)
+	{
+		case BC_ADD:		operation.reset(new Add(obj1, obj2)); break;
+		case BC_SUBTRACT:	operation.reset(new Subtract(obj1, obj2)); break;
+		case BC_MULTIPLY:	operation.reset(new Multiply(obj1, obj2)); break;
+		case BC_DIVIDE:		operation.reset(new Divide(obj1, obj2)); break;
+		case BC_INTDIVIDE:	operation.reset(new IntDivide(obj1, obj2)); break;
+		case BC_REMAINDER:	operation.reset(new Remainder(obj1, obj2)); break;
+		case BC_EXPONENT:	operation.reset(new Exponent(obj1, obj2)); break;
+		case BC_EQUAL:		operation.reset(new Equal(obj1, obj2)); break;
+		case BC_UNEQUAL:	operation.reset(new Unequal(obj1, obj2)); break;
+		case BC_GREATER:	operation.reset(new Greater(obj1, obj2)); break;
+		case BC_LESS:		operation.reset(new Less(obj1, obj2)); break;
+		case BC_GREATEQ:	operation.reset(new GreatEq(obj1, obj2)); break;
+		case BC_LESSEQ:		operation.reset(new LessEq(obj1, obj2)); break;
+		case BC_AND:		operation.reset(new And(obj1, obj2)); break;
+		case BC_OR:			operation.reset(new Or(obj1, obj2)); break;
+		default:			operation.reset(new Select(obj1, obj2)); break;
+	}
+	if(node != 0)
+	{
+		operation->setLineNumber(node->getLineNumber());
+		operation->setColumnNumber(node->getColumnNumber());
+	}
+	return unbox(operation->evaluate());
+}
+
+/*** Apply a unary operation ***/
+Value VirtualMachine::unary(unsigned char op, Value val, Node* node)
+{
+	if(op == BC_NOT && val.type == OBJ_LOGICAL)
+		return makeLogical(!val.logical);
+	if(op == BC_NEGATE && val.type == OBJ_INTEGER)
+		return makeInteger(-val.integer);
+	if(op == BC_NEGATE && val.type == OBJ_REAL)
+		return makeReal(-val.real);
+	if(op == BC_LENGTH && (val.type == OBJ_TEXT || val.type == OBJ_SEQUENCE))
+	{
+		long length;
+		if(val.type == OBJ_TEXT)
+			length = static_cast<Text*>(val.object)->getLength();
+		else
+			length = static_cast<Sequence*>(val.object)->getLength();
+		release(val);
+		return makeInteger(length);
+	}
+
+	std::auto_ptr<Object> operation;
+	if(op == BC_NOT)
+		operation.reset(new Not(box(val)));
+	else if(op == BC_NEGATE)
+		operation.reset(new Negate(box(val)));
+	else
+		operation.reset(new Length(box(val)));
+	operation->setLineNumber(node->getLineNumber());
+	operation->setColumnNumber(node->getColumnNumber());
+	return unbox(operation->evaluate());
+}
+
+/*** Select an element of a variable ***/
+Value VirtualMachine::selectVariable(int slot, Value index, Node* node)
+{
+	// Copy only the selected element, not the whole variable
+	Object* obj = manager.getSlot(slot);
+	if(obj != 0 && index.type == OBJ_INTEGER)
+	{
+		long i = index.integer;
+		if(obj->getType() == OBJ_SEQUENCE && i > 0 && i <= (long) static_cast<Sequence*>(obj)->getLength())
+			return copy(static_cast<Sequence*>(obj)->getObject(i - 1));
+		if(obj->getType() == OBJ_TEXT && i > 0 && i <= (long) static_cast<Text*>(obj)->getLength())
+			return unbox(static_cast<Text*>(obj)->getChar(i - 1));
+	}
+
+	Select operation(obj != 0 ? obj->clone() : new Object(), box(index));
+	operation.setLineNumber(node->getLineNumber());
+	operation.setColumnNumber(node->getColumnNumber());
+	return unbox(operation.evaluate());
+}
+
+/*** Assign an element of a variable ***/
+void VirtualMachine::setElement(int slot, const std::string& name, Value index, Value val, Node* node)
+{
+	// Sequences are modified in place; the index was checked by BC_CHKINDEX
+	Object* target = manager.getSlot(slot);
+	long i = index.integer;
+	if(target != 0 && target->getType() == OBJ_SEQUENCE && i <= (long) static_cast<Sequence*>(target)->getLength())
+	{
+		Sequence* seq = static_cast<Sequence*>(target);
+		Object* elem = seq->getOwnObject(i - 1);
+		if(elem->getType() == val.type)
+		{
+			switch(val.type)
+			{
+				case OBJ_INTEGER:
+					static_cast<Integer*>(elem)->setValue(val.integer);
+					return;
+				case OBJ_REAL:
+					static_cast<Real*>(elem)->setValue(val.real);
+					return;
+				case OBJ_LOGICAL:
+					static_cast<Logical*>(elem)->setValue(val.logical);
+					return;
+			}
+		}
+		seq->setObject(i - 1, box(val));
+		return;
+	}
+
+	SelectAssign assign(new Variable(name), box(index), box(val));
+	assign.setLineNumber(node->getLineNumber());
+	assign.setColumnNumber(node->getColumnNumber());
+	assign.execute();
+}
+
+/*** Add to the variable of a for loop ***/
+void VirtualMachine::increment(int slot, const std::string& name, Value step)
+{
+	Object* var = manager.getSlot(slot);
+	if(var != 0 && var->getType() == OBJ_INTEGER && step.type == OBJ_INTEGER)
+	{
+		Integer* cast = static_cast<Integer*>(var);
+		cast->setValue(cast->getValue() + step.integer);
+		return;
+	}
+
+	Object* sum = Add(box(load(slot)), box(step)).evaluate();
+	Assign(new Variable(name), sum).execute();
+}
+
+/*** Print a value ***/
+void VirtualMachine::output(const Value& val, Node* node, unsigned int index)
+{
+	switch(val.type)
+	{
+		case OBJ_EMPTY:
+			std::cout << "empty";
+			break;
+		case OBJ_INTEGER:
+			std::cout << val.integer;
+			break;
+		case OBJ_REAL:
+			std::cout << val.real;
+			break;
+		case OBJ_TEXT:
+			static_cast<Text*>(val.object)->write(std::cout);
+			break;
+		case OBJ_LOGICAL:
+			if(val.logical == true)
+				std::cout << "yes";
+			else
+				std::cout << "no";
+			break;
+		case OBJ_SEQUENCE:
+		{
+			Sequence* seq = static_cast<Sequence*>(val.object);
+			std::cout << "<* ";
+			for(unsigned int i = 0; i < seq->getLength(); i++)
+			{
+				Output outElement(seq->getObject(i)->clone(), false);
+				outElement.execute();
+				if(i != seq->getLength() - 1)
+					std::cout << ", ";
+			}
+			std::cout << " *>";
+			break;
+		}
+		default:
+			throw InvalidTypeException(node->getLineNumber(), node->getColumnNumber(), OBJ_INTEGER | OBJ_REAL | OBJ_TEXT | OBJ_LOGICAL | OBJ_SEQUENCE, val.type, index);
+	}
+}
+
+/*** Call a procedure or function with the given arguments ***/
+Object* VirtualMachine::call(Call* node, Value* args, unsigned int argc)
+{
+	Object* iden = node->getIdentifier();
+	bool isVariable = iden->getType() == OP_VARIABLE;
+
+	// Use the procedure stored in a variable without copying it
+	std::auto_ptr<Object> idenEval;
+	Object* callee = isVariable ? manager.getSlot(static_cast<Variable*>(iden)->getIndex()) : 0;
+	if(callee == 0)
+	{
+		idenEval.reset(iden->evaluate());
+		callee = idenEval.get();
+	}
+
+	// Execute a special function if we need
+	if(callee->getType() == OBJ_SPFUNCTION)
+	{
+		std::auto_ptr<SpecialFunction> spf(static_cast<SpecialFunction*>(callee->clone()));
+		for(unsigned int i = 0; i < argc; i++)
+		{
+			if(node->isInOutArgument(i))
+				throw Excep(node->getLineNumber(), node->getColumnNumber(), "Special functions cannot receive in-out arguments!");
+			spf->addArgument(take(args[i]));
+		}
+		return spf->evaluate();
+	}
+
+	// Confirm that the given object is a procedure or function
+	if(callee->getType() != OBJ_PROCEDURE && callee->getType() != OBJ_FUNCTION)
+		throw InvalidTypeException(node->getLineNumber(), node->getColumnNumber(), OBJ_PROCEDURE | OBJ_FUNCTION, callee->getType());
+
+	Procedure* proc = static_cast<Procedure*>(callee);
+	if(proc->getParameterCount() != argc)
+		throw Excep(node->getLineNumber(), node->getColumnNumber(), "Invalid number of arguments passed to procedure or function!");
+
+	// Old and new names of the in-out arguments
+	std::vector< std::pair<std::string, std::string> > transfer;
+	for(unsigned int i = 0; i < argc; i++)
+	{
+		bool isInOut = node->isInOutArgument(i);
+		if(proc->getType() == OBJ_FUNCTION && isInOut)
+			throw Excep(node->getLineNumber(), node->getColumnNumber(), "Functions cannot receive in-out arguments!");
+		if(isInOut != proc->isInOutParameter(i))
+			throw Excep(node->getLineNumber(), node->getColumnNumber(), "Argument in/in-out type did not match parameter in/in-out type!");
+		if(isInOut && node->getArgument(i)->getType() == OP_VARIABLE)
+			transfer.push_back(std::pair<std::string, std::string>(static_cast<Variable*>(node->getArgument(i))->getIdentifier(), proc->getParameterVariable(i)->getIdentifier()));
+	}
+
+	// Compile the procedure the first time it is called
+	if(proc->getCode() == 0)
+	{
+		Compiler compiler;
+		proc->setCode(compiler.compile(proc->getStatements(), proc->getScope()));
+	}
+
+	if(Profiler::enabled)
+		Profiler::enter(isVariable ? static_cast<Variable*>(iden)->getIdentifier() : "?", proc->getLineNumber());
+
+	manager.pushEntry(proc->getScope());
+
+	// Refer to the procedure from its own entry, so that it can recurse,
+	// sharing its statements and code instead of copying them
+	if(isVariable)
+		manager.setObject(static_cast<Variable*>(iden)->getIdentifier(), new Procedure(proc));
+
+	for(unsigned int i = 0; i < argc; i++)
+	{
+		manager.setSlot(proc->getParameterVariable(i)->getIndex(), take(args[i]));
+	}
+
+	if(proc->getIntern() != 0)
+		proc->getIntern()->execute();
+	if(proc->getExtern() != 0)
+		proc->getExtern()->execute();
+
+	std::auto_ptr<Object> retVal(run(proc->getCode()));
+
+	// Use the transfer vector to set the variables on the lower level to the ones on the current level
+	for(unsigned int i = 0; i < transfer.size(); i++)
+		manager.setTopLevelObject(transfer.at(i).first, manager.getObject(transfer.at(i).second)->clone());
+
+	// Transfer any modified extern variables to the lower level
+	if(proc->getExtern() != 0)
+	{
+		std::vector<std::string> idens = proc->getExtern()->getIdentifiers();
+		for(unsigned int i = 0; i < idens.size(); i++)
+			manager.setTopLevelObject(idens.at(i), manager.getObject(idens.at(i))->clone());
+	}
+
+	manager.popEntry();
+
+	if(Profiler::enabled)
+		Profiler::leave();
+
+	return retVal.release();
+}
+
+/*** Destructor ***/
+VirtualMachine::~VirtualMachine()
+{
+}
@@ -0,0 +1,134 @@
+#ifndef VM_H
+#define VM_H
+
+// ReRap Version 0.9
+// Copyright 2011 Matthew Mikolay.
+//
+// This file is part of ReRap.
+//
+// ReRap is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// ReRap is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with ReRap.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <vector>
+#include "chunk.h"
+#include "varmanager.h"
+#include "operations/call.h"
+
+// Values on the stack of the virtual machine. Integers, reals and
+// logicals are held unboxed; every other value is an object owned
+// by the stack.
+
+class Value
+{
+
+	public:
+
+		/*** The type of the value ***/
+		unsigned char type;
+
+		/*** The contents, depending on the type ***/
+		union
+		{
+			long integer;
+			double real;
+			bool logical;
+			Object* object;
+		};
+
+		/*** If the value is held in an object ***/
+		bool isBoxed() const { return type != OBJ_INTEGER && type != OBJ_REAL && type != OBJ_LOGICAL; }
+
+};
+
+class ValueStack
+{
+
+	public:
+
+		/*** Constructor ***/
+		ValueStack();
+
+		/*** Push a value, taking ownership of it ***/
+		void push(const Value& val);
+
+		/*** Pop a value, giving up ownership of it ***/
+		Value pop();
+
+		/*** Get the value on the top ***/
+		Value& top();
+
+		/*** Get the address of the n topmost values ***/
+		Value* topmost(unsigned int n);
+
+		/*** Drop the n topmost values ***/
+		void drop(unsigned int n);
+
+		/*** Destructor, deletes any values left ***/
+		~ValueStack();
+
+	private:
+
+		/*** The values ***/
+		std::vector<Value> values;
+
+};
+
+class VirtualMachine
+{
+
+	public:
+
+		/*** Constructor ***/
+		VirtualMachine();
+
+		/*** Run a chunk, return the value it returns, if any ***/
+		Object* run(Chunk* code);
+
+		/*** Destructor ***/
+		~VirtualMachine();
+
+	private:
+
+		/*** Get a copy of a variable ***/
+		Value load(int slot);
+
+		/*** Assign a value to a variable ***/
+		void store(int slot, const std::string& name, Value val, Node* node);
+
+		/*** Apply a binary operation ***/
+		Value binary(unsigned char op, Value val1, Value val2, Node* node);
+
+		/*** Apply a unary operation ***/
+		Value unary(unsigned char op, Value val, Node* node);
+
+		/*** Select an element of a variable ***/
+		Value selectVariable(int slot, Value index, Node* node);
+
+		/*** Assign an element of a variable ***/
+		void setElement(int slot, const std::string& name, Value index, Value val, Node* node);
+
+		/*** Add to the variable of a for loop ***/
+		void increment(int slot, const std::string& name, Value step);
+
+		/*** Print a value ***/
+		void output(const Value& val, Node* node, unsigned int index);
+
+		/*** Call a procedure or function with the given arguments ***/
+		Object* call(Call* node, Value* args, unsigned int argc);
+
+		/*** The variables ***/
+		VariableManager manager;
+
+};
+
+#endif
@@ -14,6 +14,7 @@
 #include <time.h>
 
 #include "reg.h"
+#include "tindex.h"
 
 #ifndef ROOTDIR
 #define ROOTDIR         "/pub"          /* default root directory */
@@ -103,8 +104,9 @@ void find (char *pattern)
 	char *path, *p, *f, *d;
 	struct stat st;
 	REGEXP reg;
+	TINDEX *ti;
 	FILE *fd;
-	long size;
+	long size, *cand, ncand, next;
 	int i;
 	struct tm *ptm;
 	unsigned long mod;
@@ -127,8 +129,22 @@ void find (char *pattern)
 		exit (-1);
 	}
 
+	/* Take the candidate lines from the trigram index. */
+	cand = 0;
+	ncand = -1;
+	next = 0;
+	if (fstat (fileno (fd), &st) >= 0) {
+		ti = tindex_open (info, &st);
+		if (ti) {
+			ncand = tindex_find (ti, pattern, &cand);
+			tindex_close (ti);
+		}
+	}
+	if (verbose && ncand >= 0)
+		printf ("%ld candidates in the index\n", ncand);
+
 	i = 0;
-	while (fgets (info, sizeof (info), fd)) {
+	while (tindex_gets (info, sizeof (info), fd, cand, ncand, &next)) {
 		p = info;
 		if (! *p)
 			continue;
@@ -212,6 +228,8 @@ void find (char *pattern)
 		}
 	}
 	fclose (fd);
+	if (cand)
+		free (cand);
 
 	if (! i)
 		printf ("No matches found for `%s'\n", pattern);
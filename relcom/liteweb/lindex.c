@@ -7,6 +7,7 @@
  */
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -14,6 +15,8 @@
 #include <unistd.h>
 #include <time.h>
 
+#include "tindex.h"
+
 #define LINESZ 512
 #define MAXEXLEN 256
 #define ISDIGIT(c)	((c) >= '0' && (c) <= '9')
@@ -149,12 +152,18 @@ int runsort (char *dir)
 	close (pd[0]);
 	close (pd[1]);
 
-	return (0);
+	return (pid);
 }
 
 int kindex (char *dir)
 {
-	if (runsort (dir) < 0)
+	char idx [LINESZ];
+	int pid;
+
+	strcpy (idx, dir);
+	strcat (idx, "/.index");
+	pid = runsort (dir);
+	if (pid < 0)
 		return (-1);
 
 	stack_free ();
@@ -169,6 +178,15 @@ int kindex (char *dir)
 	}
 
 	fclose (stdout);
+
+	/* Wait until sort writes the index, then build
+	 * the trigram index for the search. */
+	waitpid (pid, 0, 0);
+	if (! tindex_build (idx)) {
+		fprintf (stderr, "%s: cannot build %s%s\n",
+			progname, idx, TINDEX_SUFFIX);
+		return (-1);
+	}
 	return (0);
 }
 
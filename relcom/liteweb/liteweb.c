@@ -15,6 +15,8 @@
 #include <dirent.h>
 #include <time.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <setjmp.h>
 #include <syslog.h>
 #include <ndbm.h>
 #include <libutil.h>
@@ -22,17 +24,36 @@
 #include <sys/param.h>
 #include <sys/wait.h>
 #include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#else
+#include <sys/event.h>
+#endif
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
 #include "reg.h"
 #include "map.h"
+#include "tindex.h"
 
 #define LINESZ          512                     /* maximum input line length */
 #define STACKSZ         10                      /* depth of if/endif */
 #define TIMEOUT         60                      /* keepalive connection timeout */
+#define NWORKERS        4                       /* default number of worker processes */
+#define MAXWORKERS      64                      /* maximum number of worker processes */
+#define MAXCONN         256                     /* connections per worker */
+#define WORKCONN        10000                   /* connections before worker restart */
+#define MAXEVENTS       64                      /* events per wait */
+#define CONNBUF         4096                    /* initial request buffer */
+#define MAXREQ          (1024*1024L)            /* largest request with body */
 #define ROOTDIR         "/pub"                  /* default root directory */
 #define DBNAME          "/var/db/liteweb/user"    /* user database file name */
+#define DBFILE          DBNAME ".db"            /* file written by dbm */
+#define CACHEDIR        "/var/db/liteweb/cache" /* rendered documents */
+#define CACHEMAGIC      "LiteWeb cache 1"       /* cache file signature */
 #define CONTENTS        "index.html"            /* directory contents file */
 #define HTTPVERSION     "HTTP/1.0"              /* our version of protocol */
 #define DATE822         "%a, %d %b %Y %T GMT"   /* RFC-822 date format */
@@ -51,6 +72,7 @@
 #define HS_Created              201
 #define HS_Accepted             202
 #define HS_NoContent            204
+#define HS_PartialContent       206
 #define HS_MultipleChoices      300
 #define HS_MovedPermanently     301
 #define HS_MovedTemporarily     302
@@ -59,6 +81,7 @@
 #define HS_Unauthorized         401
 #define HS_Forbidden            403
 #define HS_NotFound             404
+#define HS_RangeNotSatisfiable  416
 #define HS_InternalServerError  500
 #define HS_NotImplemented       501
 #define HS_BadGateway           502
@@ -124,6 +147,10 @@ typedef struct {
 	char *name;
 	char *path;
 	struct stat st;
+	char *icon;                     /* icon name, for files */
+	char *info;                     /* description from .info */
+	char *rinfo;                    /* russian description */
+	time_t infomod;                 /* time of .info file */
 } filerec;
 
 struct content_type {
@@ -232,6 +259,9 @@ char *h_pragma;
 char *h_authorization;
 char *h_from;
 char *h_if_modified_since;
+char *h_if_none_match;
+char *h_if_range;
+char *h_range;
 char *h_referer;
 char *h_user_agent;
 
@@ -293,6 +323,9 @@ struct header {
 	{ "authorization",      &h_authorization     },
 	{ "from",               &h_from              },
 	{ "if-modified-since",  &h_if_modified_since },
+	{ "if-none-match",      &h_if_none_match     },
+	{ "if-range",           &h_if_range          },
+	{ "range",              &h_range             },
 	{ "referer",            &h_referer           },
 	{ "user-agent",         &h_user_agent        },
 	{ "location",           &h_location          },
@@ -324,6 +357,7 @@ struct sockaddr_in my, peer;            /* server and client IP addresses */
 char line [LINESZ];
 char *inputptr;
 char hostname [40];
+char myhostname [40];                   /* from gethostname */
 char peername [40];
 char *rootdir;
 int reqcnt;                             /* count of requests per connection */
@@ -333,6 +367,48 @@ time_t now;                             /* time stamp of the request */
 time_t langstamp;                       /* last language change */
 FILE *reply;
 
+char *rootarg;                          /* root directory given by -d */
+int deflang;                            /* language given by -l */
+int workers = NWORKERS;                 /* number of worker processes */
+int standalone;                         /* running without inetd */
+int nullfd = -1;                        /* /dev/null, stdout between requests */
+int dropready;                          /* dropjmp is valid */
+sigjmp_buf dropjmp;                     /* return to the event loop */
+int sendfd = -1;                        /* file left for the event loop */
+off_t sendoff;                          /* its offset */
+unsigned long sendlen;                  /* bytes left to send */
+
+/*
+ * Connections of the standalone worker process.
+ * The request is collected in the connection buffer
+ * and processed when it has come completely.  Between requests
+ * the keep-alive connection waits for input in the event queue,
+ * with its state saved here.  A long file transfer also goes
+ * from the event queue, when the socket is ready for output.
+ */
+struct conn {
+	int fd;                         /* socket, -1 if free */
+	char *buf;                      /* received data */
+	long size;                      /* size of buffer */
+	long pos, len;                  /* processed and received bytes */
+	FILE *in;                       /* stream of the current request */
+	int sendfd;                     /* file being sent, or -1 */
+	off_t sendoff;                  /* its offset */
+	unsigned long sendlen;          /* bytes left to send */
+	int keep;                       /* keep-alive after the transfer */
+	int fresh;                      /* no requests yet */
+	time_t stamp;                   /* time of the last request */
+	struct sockaddr_in my, peer;
+	char peername [40];
+	char *rootdir;
+	char hostname [40];
+	int reqcnt;
+	int html, lang, os;
+	time_t langstamp;
+} conntab [MAXCONN];
+int nconn;                              /* connections in conntab */
+int evq = -1;                           /* epoll or kqueue descriptor */
+
 int translate;				/* charset translation flag */
 unsigned char touser[256];              /* from KOI8 to user charset */
 unsigned char fromuser[256];            /* from user charset to KOI8 */
@@ -440,6 +516,7 @@ extern int getpeername (int, struct sockaddr *, int *);
 extern time_t getdate (char *ctim);
 
 void error (int c, char *m, ...);
+void nonblock (int fd, int on);
 int fgetinfo (char *info, int maxlen, char *rinfo, int rmaxlen,
 	long *date, FILE *fd);
 
@@ -458,13 +535,23 @@ int fgetinfo (char *info, int maxlen, char *rinfo, int rmaxlen,
 int getuser (unsigned long myaddr, unsigned long peeraddr, char *agent, int os,
 	time_t *stamp)
 {
-	DBM *db;
+	static DBM *db;
+	static time_t dbopened;
+	struct stat st;
 	datum key, val;
 	char buf[4+4+1+32];
-	int ret;
 	long lval;
 
-	db = dbm_open (DBNAME, 0, 0644);
+	/* Keep the database open while the file is not modified
+	 * since the time it was opened (standalone mode). */
+	if (db && (stat (DBFILE, &st) < 0 || st.st_mtime >= dbopened)) {
+		dbm_close (db);
+		db = 0;
+	}
+	if (! db) {
+		dbopened = now;
+		db = dbm_open (DBNAME, 0, 0644);
+	}
 	if (! db) {
 		if (debug)
 			syslog (LOG_ERR, "cannot open %s", DBNAME);
@@ -482,14 +569,11 @@ int getuser (unsigned long myaddr, unsigned long peeraddr, char *agent, int os,
 		if (verbose > 1)
 			syslog (LOG_INFO, "[%s] not in db: 0x%x 0x%x %d `%s'", peername,
 				myaddr, peeraddr, os, agent);
-		dbm_close (db);
 		return (0);
 	}
 	memcpy (&lval, val.dptr, sizeof (long));
 	*stamp = lval;
-	ret = *(unsigned char*)(val.dptr+4);
-	dbm_close (db);
-	return ret;
+	return *(unsigned char*)(val.dptr+4);
 }
 
 /*
@@ -761,6 +845,41 @@ int getexpr (FILE *from, int *inside_comment)
 	return (-1);
 }
 
+/*
+ * Files the rendered document depends on: the document itself
+ * and all the files it includes.  A missing file is recorded
+ * with size -1, so that its appearance is noticed too.
+ */
+#define MAXDEPS         32
+
+struct dep {
+	char path [LINESZ];
+	long mtime;
+	long size;
+} deptab [MAXDEPS];
+int ndeps;                              /* > MAXDEPS on overflow */
+
+void adddep (char *path, FILE *fd)
+{
+	struct stat st;
+	struct dep *d;
+
+	if (ndeps >= MAXDEPS) {
+		ndeps = MAXDEPS + 1;
+		return;
+	}
+	d = deptab + ndeps++;
+	strncpy (d->path, path, sizeof (d->path) - 1);
+	d->path [sizeof (d->path) - 1] = 0;
+	if (fd && fstat (fileno (fd), &st) >= 0) {
+		d->mtime = st.st_mtime;
+		d->size = st.st_size;
+	} else {
+		d->mtime = 0;
+		d->size = -1;
+	}
+}
+
 /*
  * Parse the HTML file, and process preprocessor statements:
  * - Conditional statement: #if EXPR - #elif - #else - #endif
@@ -873,6 +992,7 @@ void preprocess (FILE *from, FILE *to, char *myname)
 					fprintf (to, "<!--Out of memory in ##include-->\r\n");
 				else {
 					FILE *fd = fopen (p, "r");
+					adddep (p, fd);
 					if (! fd)
 						fprintf (to, "<!--Cannot ##include %s-->\r\n",
 							p + strlen (rootdir));
@@ -909,6 +1029,100 @@ void preprocess (FILE *from, FILE *to, char *myname)
 	}
 }
 
+#define BLOCKSZ         16384                   /* copy buffer size */
+
+/*
+ * Eight bytes at a time: the high bits, and the test for '%'.
+ * Bytes below 0200 are never changed by the coding tables.
+ */
+#define HIGHBITS        0x8080808080808080ULL
+#define LOWBITS         0x0101010101010101ULL
+#define HASPERCENT(w)   ((((w) ^ LOWBITS*'%') - LOWBITS) & ~((w) ^ LOWBITS*'%') & HIGHBITS)
+
+/*
+ * Convert hex digit to the value.
+ */
+int hexval (int c)
+{
+	if (c >= 'A' && c <= 'F')
+		return (c - 'A' + 10);
+	if (c >= 'a' && c <= 'f')
+		return (c - 'a' + 10);
+	return (c & 0x0f);
+}
+
+/*
+ * Copy len bytes from the current position of the file,
+ * translating by the table tab, if any.  The translation keeps
+ * the length, so it is done in place, by blocks.  The %XX escapes
+ * are translated too; they are never split by the block boundary.
+ * Return 0 if the file ends earlier or the output fails.
+ */
+int copyout (FILE *from, FILE *to, unsigned long len, unsigned char *tab)
+{
+	unsigned char buf [BLOCKSZ+2], *p, *end;
+	unsigned long long w;
+	unsigned long n;
+	int c;
+
+	while (len > 0) {
+		n = fread (buf, 1, len < BLOCKSZ ? len : BLOCKSZ, from);
+		if (n == 0)
+			break;
+		len -= n;
+		end = buf + n;
+		for (p=buf; tab && p<end; ) {
+			/* Fast path: eight bytes without escapes. */
+			while (p + 8 <= end) {
+				memcpy (&w, p, 8);
+				if (HASPERCENT (w))
+					break;
+				if (w & HIGHBITS) {
+					p[0] = tab[p[0]]; p[1] = tab[p[1]];
+					p[2] = tab[p[2]]; p[3] = tab[p[3]];
+					p[4] = tab[p[4]]; p[5] = tab[p[5]];
+					p[6] = tab[p[6]]; p[7] = tab[p[7]];
+				}
+				p += 8;
+			}
+			if (p >= end)
+				break;
+			if (*p != '%') {
+				*p = tab[*p];
+				++p;
+				continue;
+			}
+			if (end - p < 3 && len > 0) {
+				/* Get the rest of the escape. */
+				n = 3 - (end - p);
+				if (n > len)
+					n = len;
+				n = fread (end, 1, n, from);
+				len -= n;
+				end += n;
+			}
+			if (p + 1 >= end)
+				break;
+			c = p[1];
+			if (! ((c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f') ||
+			    (c >= '0' && c <= '9'))) {
+				p[1] = tab[c];
+				p += 2;
+				continue;
+			}
+			if (p + 2 >= end)
+				break;
+			c = tab [hexval (c) << 4 | hexval (p[2])];
+			p[1] = "0123456789ABCDEF" [c>>4];
+			p[2] = "0123456789ABCDEF" [c&15];
+			p += 3;
+		}
+		if (fwrite (buf, 1, end - buf, to) != end - buf)
+			return (0);
+	}
+	return (len == 0);
+}
+
 void copy (FILE *from, FILE *to, unsigned long len, int transflag)
 {
 	unsigned char *tab = 0;
@@ -918,42 +1132,120 @@ void copy (FILE *from, FILE *to, unsigned long len, int transflag)
 	else if (transflag < 0)
 		tab = fromuser;
 	fseek (from, 0L, 0);
-	while (len-- > 0) {
-		int c = getc (from);
-		if (c < 0)
-			break;
-		if (tab) {
-			if (c == '%') {
-				if (len-- <= 0)
-					break;
-				c = getc (from);
-				if (c < 0)
-					break;
-				putc ('%', to);
-				if ((c >= 'A' && c <= 'F') ||
-				    (c >= 'a' && c <= 'f') ||
-				    (c >= '0' && c <= '9')) {
-					int d;
-					if (len-- <= 0)
-						break;
-					d = getc (from);
-					if (d < 0)
-						break;
-					if      (c >= 'A' && c <= 'F') c -= 'A' - 10;
-					else if (c >= 'a' && c <= 'f') c -= 'f' - 10;
-					else                           c &= 0x0f;
-					if      (d >= 'A' && d <= 'F') d -= 'A' - 10;
-					else if (d >= 'a' && d <= 'f') d -= 'f' - 10;
-					else                           d &= 0x0f;
-					c = tab [c<<4 | d];
-					putc ("0123456789ABCDEF" [c>>4], to);
-					putc ("0123456789ABCDEF" [c&15], to);
-					continue;
-				}
+	copyout (from, to, len, tab);
+}
+
+/*
+ * The socket buffer is full: leave the rest of the file
+ * to the event loop of the standalone worker, which sends it
+ * when the socket is ready.  Return 0 if not possible.
+ */
+int sendlater (FILE *from, unsigned long off, unsigned long len)
+{
+	sendfd = dup (fileno (from));
+	if (sendfd < 0)
+		return (0);
+	fcntl (sendfd, F_SETFD, 1);             /* close on exec */
+	sendoff = off;
+	sendlen = len;
+	return (1);
+}
+
+/*
+ * Send len bytes of the file from the offset off to stdout.
+ * Untranslated data go by sendfile() without copying through
+ * the user memory.  When stdout is not a socket (debug mode),
+ * sendfile() fails, and the data are copied by blocks.
+ * The standalone worker does not wait for a slow client:
+ * what does not fit into the socket buffer is left to
+ * the event loop.  The reply file is reused by the next request,
+ * so it is always sent here.
+ * When not all the data are sent, the client would wait for
+ * the rest of Content-Length, so the connection is not kept.
+ */
+void sendbody (FILE *from, unsigned long off, unsigned long len, int transflag)
+{
+	int later, gone;
+
+	fseek (from, (long) off, 0);
+	if (transflag) {
+		if (! copyout (from, stdout, len,
+		    transflag > 0 ? touser : fromuser))
+			keepalive = 0;
+		return;
+	}
+	fflush (stdout);
+	later = standalone && from != reply;
+	gone = 0;
+	if (later)
+		nonblock (1, 1);
+#ifdef __linux__
+	{
+	off_t o = off;
+	ssize_t n;
+
+	while (len > 0) {
+		n = sendfile (1, fileno (from), &o,
+			len > 0x40000000L ? 0x40000000L : len);
+		if (n > 0) {
+			len -= n;
+			continue;
+		}
+		if (n < 0 && errno == EAGAIN) {
+			if (sendlater (from, o, len))
+				return;
+			later = 0;
+			nonblock (1, 0);
+			continue;
+		}
+		if (! (n < 0 && o == off && (errno == EINVAL ||
+		    errno == ENOSYS)))
+			gone = 1;               /* client is gone */
+		break;                          /* or not supported */
+	}
+	off = o;
+	}
+#endif
+#ifdef __FreeBSD__
+	{
+	off_t sent;
+	unsigned long start = off;
+
+	while (len > 0) {
+		sent = 0;
+		if (sendfile (fileno (from), 1, (off_t) off, len, 0,
+		    &sent, 0) < 0 && sent == 0) {
+			if (errno == EAGAIN) {
+				if (sendlater (from, off, len))
+					return;
+				later = 0;
+				nonblock (1, 0);
+				continue;
 			}
-			c = tab[c];
+			if (! (off == start && (errno == ENOTSOCK ||
+			    errno == EOPNOTSUPP || errno == EINVAL)))
+				gone = 1;       /* client is gone */
+			break;                  /* or not supported */
+		}
+		if (sent == 0) {
+			gone = 1;               /* file is shorter */
+			break;
 		}
-		putc (c, to);
+		off += sent;
+		len -= sent;
+	}
+	}
+#endif
+	if (later)
+		nonblock (1, 0);
+	if (gone) {
+		keepalive = 0;
+		return;
+	}
+	if (len > 0) {
+		fseek (from, (long) off, 0);
+		if (! copyout (from, stdout, len, 0))
+			keepalive = 0;
 	}
 }
 
@@ -1013,7 +1305,19 @@ void put_reply ()
 	long len = ftell (reply);
 
 	printf ("Content-Length: %ld\r\n\r\n", len);
-	copy (reply, stdout, len, translate);
+	sendbody (reply, 0L, len, translate);
+}
+
+/*
+ * Close the connection after the reply.  The standalone worker
+ * returns to the event loop, the inetd server just exits.
+ */
+void drop ()
+{
+	fflush (stdout);
+	if (dropready)
+		siglongjmp (dropjmp, 1);
+	exit (-1);
 }
 
 void fatal (int code, char *msg)
@@ -1036,8 +1340,7 @@ void fatal (int code, char *msg)
 	fputs (header, stdout);
 	fputs (msg, stdout);
 	fputs (footer, stdout);
-	fflush (stdout);
-	exit (-1);
+	drop ();
 }
 
 void error (int c, char *m, ...)
@@ -1230,27 +1533,257 @@ char *icon (char *path)
 	return txt ? "text" : "binary";
 }
 
+/*
+ * Parse the Range header: one byte range of the entity
+ * of the given size.  Return 1 and set the offset and the length
+ * of the range, 0 if the header should be ignored (invalid syntax
+ * or several ranges), -1 if the range is not satisfiable.
+ */
+int getrange (char *range, unsigned long size, unsigned long *off,
+	unsigned long *len)
+{
+	unsigned long first, last;
+	char *p = range;
+
+	while (ISSPACE (*p))
+		++p;
+	if (strncasecmp (p, "bytes=", 6) != 0 || strchr (p, ','))
+		return (0);
+	p += 6;
+	while (ISSPACE (*p))
+		++p;
+	if (*p == '-') {
+		/* The last bytes of the file. */
+		++p;
+		if (! ISDIGIT (*p))
+			return (0);
+		last = strtoul (p, &p, 10);
+		while (ISSPACE (*p))
+			++p;
+		if (*p)
+			return (0);
+		if (last == 0 || size == 0)
+			return (-1);
+		if (last > size)
+			last = size;
+		*off = size - last;
+		*len = last;
+		return (1);
+	}
+	if (! ISDIGIT (*p))
+		return (0);
+	first = strtoul (p, &p, 10);
+	if (*p++ != '-')
+		return (0);
+	last = size - 1;
+	if (ISDIGIT (*p)) {
+		last = strtoul (p, &p, 10);
+		if (last < first)
+			return (0);
+	}
+	while (ISSPACE (*p))
+		++p;
+	if (*p)
+		return (0);
+	if (first >= size)
+		return (-1);
+	if (last >= size)
+		last = size - 1;
+	*off = first;
+	*len = last - first + 1;
+	return (1);
+}
+
+/*
+ * Cache of the rendered documents.
+ * Preprocessed HTML files and translated text files are kept
+ * in CACHEDIR, one file per variant.  The variant key is the file
+ * path, the language (it selects both the #if branches and
+ * the coding) and the HTML mode of the browser.  The cache file
+ * starts with the header:
+ *      LiteWeb cache 1
+ *      key <key>
+ *      etag <entity tag>
+ *      dep <mtime> <size> <path>       - one line per dependency
+ *      <empty line>
+ * followed by the document, ready to be sent as is.  The variant
+ * is valid while all the dependencies keep their time and size.
+ * The cache directory may be cleaned at any time.
+ */
+unsigned long strhash (char *p)
+{
+	unsigned long v = 0;
+
+	while (*p)
+		v = (unsigned char) *p++ + 65599 * v;
+	return (v & 0xffffffffL);
+}
+
+char *cachename (char *key, char *name)
+{
+	sprintf (name, "%s/%08lx", CACHEDIR, strhash (key));
+	return (name);
+}
+
+/*
+ * Open the valid cached variant.  Set the entity tag,
+ * the offset of the document in the file and its size.
+ * Return 0 if there is no valid variant.
+ */
+FILE *cacheopen (char *key, char *etag, unsigned long *body,
+	unsigned long *size)
+{
+	char buf [2*LINESZ], *p;
+	struct stat st;
+	long mtime, sz;
+	FILE *fd;
+
+	fd = fopen (cachename (key, buf), "r");
+	if (! fd)
+		return (0);
+	if (! fgets (buf, sizeof (buf), fd) ||
+	    strcmp (buf, CACHEMAGIC "\n") != 0)
+		goto bad;
+	if (! fgets (buf, sizeof (buf), fd) || ! (p = strchr (buf, '\n')))
+		goto bad;
+	*p = 0;
+	if (strncmp (buf, "key ", 4) != 0 || strcmp (buf+4, key) != 0)
+		goto bad;               /* another key with the same hash */
+	if (! fgets (buf, sizeof (buf), fd) || ! (p = strchr (buf, '\n')) ||
+	    strncmp (buf, "etag ", 5) != 0 || p - buf > 5 + 32)
+		goto bad;
+	*p = 0;
+	strcpy (etag, buf+5);
+	for (;;) {
+		if (! fgets (buf, sizeof (buf), fd))
+			goto bad;
+		if (buf[0] == '\n')
+			break;
+		p = strchr (buf, '\n');
+		if (! p || sscanf (buf, "dep %ld %ld", &mtime, &sz) != 2)
+			goto bad;
+		*p = 0;
+		p = strchr (buf+4, ' ');
+		if (p)
+			p = strchr (p+1, ' ');
+		if (! p)
+			goto bad;
+		if (stat (p+1, &st) < 0) {
+			if (sz >= 0)
+				goto bad;       /* removed */
+		} else if (st.st_mtime != mtime || st.st_size != sz)
+			goto bad;               /* modified */
+	}
+	if (fstat (fileno (fd), &st) < 0)
+		goto bad;
+	*body = ftell (fd);
+	*size = st.st_size - *body;
+	return (fd);
+bad:
+	*etag = 0;
+	fclose (fd);
+	return (0);
+}
+
+/*
+ * Create the cache file of the variant, write the header
+ * and set the entity tag.  The document is written by the caller,
+ * then cachedone() puts the file in place.  Return 0 if the variant
+ * cannot be cached.
+ */
+FILE *cachecreate (char *key, char *etag, char *tmpname)
+{
+	char buf [64];
+	unsigned long h;
+	FILE *fd;
+	int i;
+
+	if (ndeps > MAXDEPS)
+		return (0);
+	h = 0;
+	for (i=0; i<ndeps; ++i) {
+		/* The file modified this second may change once more
+		 * without the change of time. */
+		if (deptab[i].mtime >= now)
+			return (0);
+		sprintf (buf, "%ld %ld", deptab[i].mtime, deptab[i].size);
+		h = (h * 65599 + strhash (buf)) & 0xffffffffL;
+	}
+	sprintf (etag, "\"%08lx-%08lx\"", strhash (key), h);
+
+	sprintf (tmpname, "%s.%d", cachename (key, tmpname), (int) getpid ());
+	fd = fopen (tmpname, "w+");
+	if (! fd) {
+		/* No cache directory - make it. */
+		mkdir (CACHEDIR, 0755);
+		fd = fopen (tmpname, "w+");
+		if (! fd)
+			return (0);
+	}
+	fprintf (fd, "%s\nkey %s\netag %s\n", CACHEMAGIC, key, etag);
+	for (i=0; i<ndeps; ++i)
+		fprintf (fd, "dep %ld %ld %s\n", deptab[i].mtime,
+			deptab[i].size, deptab[i].path);
+	fprintf (fd, "\n");
+	return (fd);
+}
+
+/*
+ * Put the cache file in place.  On write error
+ * the file is removed and 0 returned.
+ */
+int cachedone (FILE *fd, char *key, char *tmpname)
+{
+	char name [LINESZ];
+
+	if (fflush (fd) == EOF || ferror (fd) ||
+	    rename (tmpname, cachename (key, name)) < 0) {
+		unlink (tmpname);
+		return (0);
+	}
+	return (1);
+}
+
+/*
+ * Check the entity tag against the If-None-Match list.
+ */
+int etagmatch (char *list, char *etag)
+{
+	while (ISSPACE (*list))
+		++list;
+	if (*list == '*')
+		return (1);
+	return (strstr (list, etag) != 0);
+}
+
+void notmodified (char *etag)
+{
+	printf ("%s 304 Document not modified\r\n", HTTPVERSION);
+	printf ("Server: %s (%s)\r\n", VERSION, COPYRIGHT);
+	if (keepalive)
+		printf ("Connection: Keep-Alive\r\n");
+	if (etag && *etag)
+		printf ("ETag: %s\r\n", etag);
+	printf ("Content-Length: 0\r\n");
+	printdate ("Date", now);
+	printf ("\r\n");
+	syslog (LOG_INFO, "[%s] file %s not modified",
+		peername, url.filepath);
+}
+
 void send_file ()
 {
 	struct tm *ptm;
-	FILE *fd;
-	char *type;
-	int textual;
+	FILE *fd, *from, *cf;
+	char *type, key [LINESZ+16], etag [40], tmpname [LINESZ];
+	int textual, prep, range, transflag;
 	time_t dmod = filestat.st_mtime;
-	unsigned long size;
+	unsigned long size, off, len, body;
 
 	if (dmod < langstamp)
 		dmod = langstamp;
 	if (dmod <= h_modstamp) {
-not_modified:   printf ("%s 304 Document not modified\r\n", HTTPVERSION);
-		printf ("Server: %s (%s)\r\n", VERSION, COPYRIGHT);
-		if (keepalive)
-			printf ("Connection: Keep-Alive\r\n");
-		printf ("Content-Length: 0\r\n");
-		printdate ("Date", now);
-		printf ("\r\n");
-		syslog (LOG_INFO, "[%s] file %s not modified",
-			peername, url.filepath);
+		notmodified (0);
 		return;
 	}
 
@@ -1260,17 +1793,90 @@ not_modified:   printf ("%s 304 Document not modified\r\n", HTTPVERSION);
 
 	size = filestat.st_size;
 	type = content_type (fd, &textual, url.ext);
-	if (! textual && filestat.st_mtime <= h_modstamp)
-		goto not_modified;
-	if (textual && strcmp (url.ext, ".html") == 0) {
-		mk_reply ();
-		preprocess (fd, reply, url.filepath);
-		size = ftell (reply);
+	if (! textual && filestat.st_mtime <= h_modstamp) {
+		fclose (fd);
+		notmodified (0);
+		return;
+	}
+	prep = textual && strcmp (url.ext, ".html") == 0;
+	transflag = textual ? translate : 0;
+	from = fd;
+	body = 0;
+	cf = 0;
+	if (! prep && ! transflag)
+		sprintf (etag, "\"%lx-%lx\"", (unsigned long) filestat.st_size,
+			(unsigned long) filestat.st_mtime);
+	else {
+		/* Rendered variant: get it from the cache, or make it. */
+		sprintf (key, "%s %d %d", url.filepath, lang, prep ? html : 0);
+		cf = cacheopen (key, etag, &body, &size);
+		if (! cf) {
+			ndeps = 0;
+			adddep (url.filepath, fd);
+			if (prep) {
+				mk_reply ();
+				preprocess (fd, reply, url.filepath);
+				size = ftell (reply);
+				from = reply;
+			}
+			cf = cachecreate (key, etag, tmpname);
+			if (cf) {
+				body = ftell (cf);
+				copy (from, cf, size, transflag);
+				if (! cachedone (cf, key, tmpname)) {
+					fclose (cf);
+					cf = 0;
+				}
+			}
+		}
+		if (cf) {
+			from = cf;
+			transflag = 0;
+		} else {
+			*etag = 0;
+			body = 0;
+		}
+	}
+	if (*etag && h_if_none_match && etagmatch (h_if_none_match, etag)) {
+		fclose (fd);
+		if (cf)
+			fclose (cf);
+		notmodified (etag);
+		return;
+	}
+
+	/* Byte ranges are served for the untranslated data only,
+	 * unless the document is changed since If-Range. */
+	off = 0;
+	len = size;
+	range = 0;
+	if (h_range && proto != PROTO_0_9 && from != reply && ! transflag &&
+	    (! h_if_range || (*h_if_range == '"' ?
+	    strcmp (h_if_range, etag) == 0 : getdate (h_if_range) == dmod)))
+		range = getrange (h_range, size, &off, &len);
+	if (range < 0) {
+		printf ("%s 416 Requested range not satisfiable\r\n",
+			HTTPVERSION);
+		printf ("Server: %s (%s)\r\n", VERSION, COPYRIGHT);
+		if (keepalive)
+			printf ("Connection: Keep-Alive\r\n");
+		printdate ("Date", now);
+		printf ("Content-Range: bytes */%lu\r\n", size);
+		printf ("Content-Length: 0\r\n\r\n");
+		syslog (LOG_INFO, "[%s] invalid range `%s' of file %s",
+			peername, h_range, url.filepath + strlen(rootdir));
+		fclose (fd);
+		if (cf)
+			fclose (cf);
+		return;
 	}
 	if (proto != PROTO_0_9) {
 		char dat [60];
 
-		printf ("%s 200 Document follows\r\n", HTTPVERSION);
+		if (range)
+			printf ("%s 206 Partial content\r\n", HTTPVERSION);
+		else
+			printf ("%s 200 Document follows\r\n", HTTPVERSION);
 		printf ("Server: %s (%s)\r\n", VERSION, COPYRIGHT);
 		if (keepalive)
 			printf ("Connection: Keep-Alive\r\n");
@@ -1278,14 +1884,23 @@ not_modified:   printf ("%s 304 Document not modified\r\n", HTTPVERSION);
 		ptm = gmtime (&dmod);
 		strftime (dat, sizeof (dat), DATE822, ptm);
 		printf ("Last-Modified: %s\r\n", dat);
+		if (*etag)
+			printf ("ETag: %s\r\n", etag);
 		printtype (type, textual);
-		printf ("Content-Length: %lu\r\n\r\n", size);
+		if (from != reply && ! transflag)
+			printf ("Accept-Ranges: bytes\r\n");
+		if (range)
+			printf ("Content-Range: bytes %lu-%lu/%lu\r\n",
+				off, off + len - 1, size);
+		printf ("Content-Length: %lu\r\n\r\n", len);
 
 		if (method == M_HEAD) {
 			syslog (LOG_INFO, "[%s] sent header of %s file %s",
 				peername, textual ? "text" : "binary",
 				url.filepath + strlen(rootdir));
 			fclose (fd);
+			if (cf)
+				fclose (cf);
 			return;
 		}
 	}
@@ -1293,18 +1908,20 @@ not_modified:   printf ("%s 304 Document not modified\r\n", HTTPVERSION);
 	if (proto == PROTO_0_9 && strcmp (url.ext, ".txt") == 0)
 		printf ("<PLAINTEXT>\r\n");
 
-	if (! textual)
-		copy (fd, stdout, size, 0);
-	else if (strcmp (url.ext, ".html") != 0)
-		copy (fd, stdout, size, translate);
-	else
-		copy (reply, stdout, size, translate);
-
+	sendbody (from, body + off, len, transflag);
 	fclose (fd);
+	if (cf)
+		fclose (cf);
 
-	syslog (LOG_INFO, "[%s] sent %s file %s total %lu bytes",
-		peername, textual ? "text" : "binary",
-		url.filepath + strlen(rootdir), size);
+	if (range)
+		syslog (LOG_INFO, "[%s] sent %s file %s bytes %lu-%lu",
+			peername, textual ? "text" : "binary",
+			url.filepath + strlen(rootdir), off, off + len - 1);
+	else
+		syslog (LOG_INFO, "[%s] sent %s file %s total %lu bytes%s",
+			peername, textual ? "text" : "binary",
+			url.filepath + strlen(rootdir), size,
+			from == cf && body ? " from cache" : "");
 }
 
 /*
@@ -1350,8 +1967,9 @@ void searchfile ()
 	struct tm *ptm;
 	struct stat st;
 	REGEXP reg;
+	TINDEX *ti;
 	FILE *fd;
-	long size;
+	long size, *cand, ncand, next;
 	int i, dirflag;
 
 	search = url.search;
@@ -1369,6 +1987,7 @@ void searchfile ()
 	if (! fd)
 		error (HS_NotFound, "no index file in directory `%s'",
 			url.filepath);
+	fstat (fileno (fd), &filestat);
 
 	if (proto != PROTO_0_9) {
 		char dat [60];
@@ -1378,7 +1997,6 @@ void searchfile ()
 		if (keepalive)
 			printf ("Connection: Keep-Alive\r\n");
 		printdate ("Date", now);
-		fstat (fileno (fd), &filestat);
 		ptm = gmtime (&filestat.st_mtime);
 		strftime (dat, sizeof (dat), DATE822, ptm);
 		printf ("Last-Modified: %s\r\n", dat);
@@ -1402,9 +2020,22 @@ void searchfile ()
 	fprintf (reply, "<h1>%s</h1><dl compact>\r\n",
 		lang == L_ENG ? "Results of search" : "Результаты поиска");
 
+	/* Take the candidate lines from the trigram index,
+	 * if it is built for this .index. */
+	cand = 0;
+	ncand = -1;
+	next = 0;
+	strcpy (file, url.filepath);
+	strcat (file, "/.index");
+	ti = tindex_open (file, &filestat);
+	if (ti) {
+		ncand = tindex_find (ti, search, &cand);
+		tindex_close (ti);
+	}
+
 	i = 0;
 	*sect = 0;
-	while (fgets (info, sizeof (info), fd)) {
+	while (tindex_gets (info, sizeof (info), fd, cand, ncand, &next)) {
 		p = info + strlen (info);
 		while (p>info && (p[-1]=='\n' || p[-1]=='\r'))
 			*--p = 0;
@@ -1481,6 +2112,8 @@ void searchfile ()
 		++i;
 	}
 	fclose (fd);
+	if (cand)
+		free (cand);
 	fprintf (reply, "</dl>\r\n");
 	if (i)
 		putsection (reply, ".footer.inc");
@@ -1539,47 +2172,110 @@ void printinfo (FILE *fd, char *s, int off, int indent)
 	fputs ("\r\n", fd);
 }
 
-void senddir ()
+/*
+ * Directory listing cache.
+ * The listings of the last DIRCACHE directories are kept in memory:
+ * the sorted entries with their stat data, icons and descriptions.
+ * The listing is valid while the directory keeps its modification
+ * time.  When only the .info subdirectory is changed, just the
+ * descriptions are reread.  A listing older than DIRTTL seconds
+ * is rebuilt anyway, to notice the files modified in place;
+ * until then their size, date and description in the listing,
+ * and the Last-Modified time, may lag behind.  The "not modified"
+ * reply is given only after checking the entries with dirchanged().
+ */
+#define DIRCACHE        16
+#define DIRTTL          60
+
+typedef struct {
+	char *path;                     /* directory name */
+	time_t mtime;                   /* modification time of directory */
+	time_t imtime;                  /* modification time of .info */
+	time_t stamp;                   /* when the entries were read */
+	time_t istamp;                  /* when the descriptions were read */
+	unsigned long used;             /* LRU clock */
+	filerec *tab;                   /* entries, directories first */
+	int nfile;                      /* number of entries */
+	int ndir;                       /* number of directories */
+} dirlist;
+
+dirlist dircache [DIRCACHE];
+unsigned long dirclock;
+
+void freeinfo (dirlist *l)
 {
-	char info [LINESZ], rinfo [LINESZ], path [LINESZ], name [LINESZ];
-	char dat[60], *iptr;
-	FILE *fd;
-	DIR *dd;
-	struct tm *ptm;
-	struct dirent *d;
-	filerec *filetab;
-	int filetabsz, nfile, ndir, i;
-	struct stat ist;
-	unsigned long mod;
-	time_t dmod;
+	int i;
 
-	if (*url.search) {
-		searchfile ();
-		return;
+	for (i=0; i<l->nfile; ++i) {
+		if (l->tab[i].info)
+			free (l->tab[i].info);
+		if (l->tab[i].rinfo)
+			free (l->tab[i].rinfo);
+		l->tab[i].info = l->tab[i].rinfo = 0;
+		l->tab[i].infomod = 0;
 	}
+}
 
-	if (url.filepath[strlen(url.filepath)-1] == '/')
-		sprintf (info, "%s%s", url.filepath, CONTENTS);
-	else
-		sprintf (info, "%s/%s", url.filepath, CONTENTS);
-	if (access (info, 4) == 0) {
-		strcpy (url.filepath, info);
-		url.ext = ".html";
-		url.trailing_slash = 0;
-		stat (url.filepath, &filestat);
-		send_file ();
-		return;
+void freedir (dirlist *l)
+{
+	int i;
+
+	freeinfo (l);
+	for (i=0; i<l->nfile; ++i) {
+		free (l->tab[i].path);
+		free (l->tab[i].name);
 	}
+	if (l->tab)
+		free (l->tab);
+	l->tab = 0;
+	l->nfile = l->ndir = 0;
+}
 
-	/* Compute the directory last modified time. */
-	dmod = filestat.st_mtime;
-	sprintf (info, "%s/.info", url.filepath);
-	if (stat (info, &ist) >= 0 && ist.st_mtime > dmod)
-		dmod = ist.st_mtime;
+/*
+ * Read the descriptions of all entries from the .info subdirectory.
+ */
+void readinfo (dirlist *l)
+{
+	char info [LINESZ], rinfo [LINESZ];
+	struct stat ist;
+	FILE *fd;
+	int i;
+
+	l->istamp = 0;
+	for (i=0; i<l->nfile; ++i) {
+		sprintf (info, "%s/.info/%s", l->path, l->tab[i].name);
+		fd = fopen (info, "r");
+		if (! fd)
+			continue;
+		if (fstat (fileno (fd), &ist) >= 0)
+			l->tab[i].infomod = ist.st_mtime;
+		fgetinfo (info, sizeof (info), rinfo, sizeof (rinfo), 0, fd);
+		fclose (fd);
+		if (*info)
+			l->tab[i].info = strdup (info);
+		if (*rinfo)
+			l->tab[i].rinfo = strdup (rinfo);
+		if ((*info && ! l->tab[i].info) || (*rinfo && ! l->tab[i].rinfo))
+			error (HS_InternalServerError,
+				"no memory for file description");
+	}
+	l->istamp = now;
+}
+
+/*
+ * Read the directory entries, sorted.
+ */
+void readentries (dirlist *l)
+{
+	char path [LINESZ];
+	struct dirent *d;
+	filerec *filetab;
+	int filetabsz, nfile, ndir;
+	DIR *dd;
 
-	dd = opendir (url.filepath);
+	dd = opendir (l->path);
 	if (! dd)
-		error (HS_NotFound, "cannot read directory `%s'", url.filepath);
+		error (HS_NotFound, "cannot read directory `%s'", l->path);
 
 	filetabsz = 32;
 	filetab = (filerec*) malloc (filetabsz * sizeof (filerec));
@@ -1599,27 +2295,166 @@ void senddir ()
 		}
 		if (d->d_name[0] == '.')
 			continue;
-		strcpy (path, url.filepath);
+		strcpy (path, l->path);
 		strcat (path, "/");
 		strcat (path, d->d_name);
 		if (stat (path, &filetab[nfile].st) < 0)
 			continue;
-		if ((filetab[nfile].st.st_mode & S_IFMT) == S_IFDIR)
+		if ((filetab[nfile].st.st_mode & S_IFMT) == S_IFDIR) {
+			filetab[nfile].icon = "dir";
 			++ndir;
-		else if ((filetab[nfile].st.st_mode & S_IFMT) != S_IFREG)
+		} else if ((filetab[nfile].st.st_mode & S_IFMT) == S_IFREG)
+			filetab[nfile].icon = icon (path);
+		else
 			continue;
-		if (filetab[nfile].st.st_mtime > dmod)
-			dmod = filetab[nfile].st.st_mtime;
 	        filetab[nfile].path = strdup (path);
 		filetab[nfile].name = strdup (d->d_name);
 		if (! filetab[nfile].path || ! filetab[nfile].name)
 			error (HS_InternalServerError,
 				"no memory for file name");
+		filetab[nfile].info = filetab[nfile].rinfo = 0;
+		filetab[nfile].infomod = 0;
 		++nfile;
 	}
 	closedir (dd);
 
 	qsort ((void*) filetab, nfile, sizeof (filerec), (int(*)())filecmp);
+	l->tab = filetab;
+	l->nfile = nfile;
+	l->ndir = ndir;
+	l->stamp = now;
+}
+
+/*
+ * Check the entries of the cached listing for the files
+ * and descriptions modified in place.  Return 1 if any is changed.
+ */
+int dirchanged (dirlist *l)
+{
+	char info [LINESZ];
+	struct stat st;
+	int i;
+
+	for (i=0; i<l->nfile; ++i) {
+		if (stat (l->tab[i].path, &st) < 0 ||
+		    st.st_mtime != l->tab[i].st.st_mtime ||
+		    st.st_size != l->tab[i].st.st_size ||
+		    st.st_mtime >= l->stamp)
+			return (1);
+		sprintf (info, "%s/.info/%s", l->path, l->tab[i].name);
+		if (stat (info, &st) < 0)
+			st.st_mtime = 0;
+		if (st.st_mtime != l->tab[i].infomod ||
+		    st.st_mtime >= l->istamp)
+			return (1);
+	}
+	return (0);
+}
+
+/*
+ * Get the listing of the directory with the given modification time,
+ * from the cache if it is still valid.
+ */
+dirlist *getdir (char *dir, time_t mtime)
+{
+	char info [LINESZ];
+	struct stat ist;
+	dirlist *l, *victim;
+	time_t imtime;
+
+	sprintf (info, "%s/.info", dir);
+	imtime = stat (info, &ist) >= 0 ? ist.st_mtime : 0;
+
+	victim = dircache;
+	for (l=dircache; l<dircache+DIRCACHE; ++l) {
+		if (l->path && strcmp (l->path, dir) == 0)
+			break;
+		if (l->used < victim->used)
+			victim = l;
+	}
+	if (l >= dircache+DIRCACHE) {
+		l = victim;
+		freedir (l);
+		if (l->path)
+			free (l->path);
+		l->path = strdup (dir);
+		if (! l->path)
+			error (HS_InternalServerError,
+				"no memory for directory name");
+	} else if (l->mtime != mtime || l->mtime >= l->stamp ||
+	    now - l->stamp >= DIRTTL) {
+		/* The directory is changed (maybe in the same second
+		 * when it was read), or the listing is too old. */
+		freedir (l);
+	} else if (l->imtime != imtime || l->imtime >= l->istamp) {
+		/* Only the descriptions are changed. */
+		freeinfo (l);
+		l->imtime = imtime;
+		readinfo (l);
+	}
+	l->used = ++dirclock;
+	if (! l->tab) {
+		l->mtime = mtime;
+		l->imtime = imtime;
+		readentries (l);
+		readinfo (l);
+	}
+	return (l);
+}
+
+void senddir ()
+{
+	char info [LINESZ], rinfo [LINESZ], path [LINESZ], name [LINESZ];
+	char dat[60], *iptr;
+	FILE *fd;
+	struct tm *ptm;
+	dirlist *l;
+	filerec *filetab;
+	int nfile, ndir, i;
+	struct stat ist;
+	unsigned long mod;
+	time_t dmod;
+
+	if (*url.search) {
+		searchfile ();
+		return;
+	}
+
+	if (url.filepath[strlen(url.filepath)-1] == '/')
+		sprintf (info, "%s%s", url.filepath, CONTENTS);
+	else
+		sprintf (info, "%s/%s", url.filepath, CONTENTS);
+	if (access (info, 4) == 0) {
+		strcpy (url.filepath, info);
+		url.ext = ".html";
+		url.trailing_slash = 0;
+		stat (url.filepath, &filestat);
+		send_file ();
+		return;
+	}
+
+	/* Compute the directory last modified time. */
+	dmod = filestat.st_mtime;
+	sprintf (info, "%s/.info", url.filepath);
+	if (stat (info, &ist) >= 0 && ist.st_mtime > dmod)
+		dmod = ist.st_mtime;
+
+	l = getdir (url.filepath, filestat.st_mtime);
+	if (h_modstamp && l->stamp < now && dirchanged (l)) {
+		/* The "not modified" reply needs the exact times
+		 * of the entries, not those of the cached listing. */
+		l->stamp = 0;
+		l = getdir (url.filepath, filestat.st_mtime);
+	}
+	filetab = l->tab;
+	nfile = l->nfile;
+	ndir = l->ndir;
+	for (i=0; i<nfile; ++i) {
+		if (filetab[i].st.st_mtime > dmod)
+			dmod = filetab[i].st.st_mtime;
+		if (filetab[i].infomod > dmod)
+			dmod = filetab[i].infomod;
+	}
 
 	sprintf (info, "%s/.info/%s", url.dirpath, url.basename);
 	fd = fopen (info, "r");
@@ -1701,15 +2536,11 @@ void senddir ()
 		strcpy (name, filetab[i].name);
 		canon (name);
 
-		sprintf (info, "%s/.info/%s", url.filepath, filetab[i].name);
-		fd = fopen (info, "r");
-		if (fd) {
-			if (fstat (fileno (fd), &ist) >= 0 &&
-			    ist.st_mtime > dmod)
-				dmod = ist.st_mtime;
-			fgetinfo (info, sizeof (info), rinfo, sizeof (rinfo), 0, fd);
-			iptr = (*rinfo && lang != L_ENG) ? rinfo : info;
-			fclose (fd);
+		iptr = (filetab[i].rinfo && lang != L_ENG) ?
+			filetab[i].rinfo : filetab[i].info;
+		if (iptr) {
+			strcpy (info, iptr);
+			iptr = info;
 			canon (iptr);
 		} else
 			iptr = "";
@@ -1752,22 +2583,18 @@ void senddir ()
 		strcpy (name, filetab[i].name);
 		canon (name);
 
-		sprintf (info, "%s/.info/%s", url.filepath, filetab[i].name);
-		fd = fopen (info, "r");
-		if (fd) {
-			if (fstat (fileno (fd), &ist) >= 0 &&
-			    ist.st_mtime > dmod)
-				dmod = ist.st_mtime;
-			fgetinfo (info, sizeof (info), rinfo, sizeof (rinfo), 0, fd);
-			iptr = (*rinfo && lang != L_ENG) ? rinfo : info;
-			fclose (fd);
+		iptr = (filetab[i].rinfo && lang != L_ENG) ?
+			filetab[i].rinfo : filetab[i].info;
+		if (iptr) {
+			strcpy (info, iptr);
+			iptr = info;
 			canon (iptr);
 		} else
 			iptr = "";
 
 		if (html & H_TABLES) {
 			fprintf (reply, "<tr valign=top><td><img src=\"/icons/%s.gif\" align=top>",
-				icon (filetab[i].path));
+				filetab[i].icon);
 			fprintf (reply, "&nbsp;<a href=\"");
 			if (! url.trailing_slash)
 				fprintf (reply, "%s/", url.basename);
@@ -1820,10 +2647,6 @@ void senddir ()
 				fprintf (reply, "\r\n");
 		}
 	}
-	for (i=0; i<nfile; ++i) {
-		free (filetab[i].path);
-		free (filetab[i].name);
-	}
 
 	if (html & H_TABLES) {
 		if (ndir == nfile)
@@ -2303,6 +3126,7 @@ void sendexec (char *arg)
 		}
 		fclose (fin);
 		close (pout[0]);
+		waitpid (pid, &status, 0);
 		goto done;
 	}
 
@@ -2597,6 +3421,71 @@ nomem:                  error (HS_InternalServerError,
 	}
 }
 
+/*
+ * Free the forward and authentication tables.
+ */
+void freetabs ()
+{
+	struct forward *f;
+	struct auth *a;
+
+	while ((f = forwlist)) {
+		forwlist = f->next;
+		if (f->sockfd)
+			fclose (f->sockfd);
+		free (f->dir);
+		free (f->host);
+		free (f->dest);
+		if (f->user)
+			free (f->user);
+		if (f->password)
+			free (f->password);
+		free (f);
+	}
+	while ((a = authlist)) {
+		authlist = a->next;
+		free (a->dir);
+		if (a->user)
+			free (a->user);
+		if (a->password)
+			free (a->password);
+		free (a->realm);
+		free (a);
+	}
+}
+
+/*
+ * Load the forward and authentication tables of the root directory.
+ * The standalone server has one root directory per IP address
+ * (multihome mode), so the tables are reloaded when it changes.
+ */
+void loadtabs ()
+{
+	static char *tabroot;
+	FILE *fd;
+
+	if (tabroot == rootdir)
+		return;
+	freetabs ();
+	tabroot = rootdir;
+
+	strcpy (line, rootdir);
+	strcat (line, "/.forward");
+	fd = fopen (line, "r");
+	if (fd) {
+		loadfwtab (fd);
+		fclose (fd);
+	}
+
+	strcpy (line, rootdir);
+	strcat (line, "/.auth");
+	fd = fopen (line, "r");
+	if (fd) {
+		loadauthtab (fd);
+		fclose (fd);
+	}
+}
+
 struct forward *findforward (char *path)
 {
 	struct forward *f;
@@ -2669,8 +3558,7 @@ void check_auth ()
 
 	syslog (LOG_INFO, "[%s] sent auth request for %s",
 		peername, url.filepath + strlen(rootdir));
-	fflush (stdout);
-	exit (-1);
+	drop ();
 }
 
 void sendforward (struct forward *f)
@@ -2845,149 +3733,70 @@ void sendforward (struct forward *f)
 		peername, url.filepath + strlen(rootdir), h_blen, status);
 }
 
-void main (int argc, char **argv)
+/*
+ * Get the addresses of the connection, the root directory
+ * and the client host name.
+ */
+void setpeer (int sock)
 {
-	int addrlen, keepopt;
 	struct hostent *h;
-	struct linger linger;
-	struct forward *f;
-	char *arg;
+	int addrlen;
 
-	progname = *argv;
-	for (;;) {
-		switch (getopt (argc, argv, "vDrd:l:")) {
-		case EOF:
-			break;
-		case 'v':
-			++verbose;
-			continue;
-		case 'D':
-			++debug;
-			continue;
-		case 'r':
-			++rusflag;
-			continue;
-		case 'd':
-			if (strchr (optarg, ':'))
-				addhome (optarg);
-			else
-				rootdir = optarg;
-			continue;
-		case 'l':
-			if (*optarg == 0)
-				lang = L_ENG;           /* english language */
-			else if (strcasecmp (optarg, "unix") == 0)
-				lang = L_KOI8;          /* russian koi8-r */
-			else if (strcasecmp (optarg, "win") == 0)
-				lang = L_WIN;           /* russian ms windows */
-			else if (strcasecmp (optarg, "dos") == 0)
-				lang = L_DOS;           /* russian ms dos */
-			else if (strcasecmp (optarg, "mac") == 0)
-				lang = L_MAC;           /* russian macintosh */
-			else
-				lang = L_ENG;           /* english by default */
-			continue;
-		}
-		break;
-	}
-	argc -= optind;
-	argv += optind;
-
-	/* On exit, wait 5 minutes for output to drain. */
-	linger.l_onoff = 1;
-	linger.l_linger = 5*60;
-	setsockopt (0, SOL_SOCKET, SO_LINGER, &linger, sizeof (linger));
-
-	keepopt = 1;
-	setsockopt (0, SOL_SOCKET, SO_KEEPALIVE, &keepopt, sizeof (keepopt));
-
-	openlog ("liteweb", LOG_PID, LOG_DAEMON);
-
-	if (argc != 0)
-		error (HS_InternalServerError, "invalid argument `%s'",
-			argv[0]);
-
-	if (gethostname (hostname, sizeof (hostname)) < 0)
+	addrlen = sizeof (my);
+	if (getsockname (sock, (struct sockaddr *) &my, &addrlen) < 0)
 		error (HS_InternalServerError,
-			"cannot determine my host name: %s", strerror (errno));
-
-	memset (&my, 0, sizeof (my));
-	memset (&peer, 0, sizeof (peer));
-	if (! debug) {
-		addrlen = sizeof (my);
-		if (getsockname (0, (struct sockaddr *) &my, &addrlen) < 0)
-			error (HS_InternalServerError,
-				"cannot determine my address: %s",
-				strerror (errno));
+			"cannot determine my address: %s",
+			strerror (errno));
 
-		if (! rootdir)
-			rootdir = findhome ();
+	strcpy (hostname, myhostname);
+	if (! rootarg)
+		rootdir = findhome ();
 
-		addrlen = sizeof (peer);
-		if (getpeername (0, (struct sockaddr *) &peer, &addrlen) < 0)
-			error (HS_InternalServerError,
-				"cannot determine peer address: %s",
-				strerror (errno));
+	addrlen = sizeof (peer);
+	if (getpeername (sock, (struct sockaddr *) &peer, &addrlen) < 0)
+		error (HS_InternalServerError,
+			"cannot determine peer address: %s",
+			strerror (errno));
 
-		h = gethostbyaddr ((char *) &peer.sin_addr, sizeof (peer.sin_addr), AF_INET);
-		if (h)
-			strcpy (peername, h->h_name);
-		else
-			strcpy (peername, inet_ntoa (peer.sin_addr));
-		syslog (LOG_INFO, "[%s] connection from %s port %d",
-			peername, inet_ntoa (peer.sin_addr),
-			ntohs (my.sin_port));
+	h = gethostbyaddr ((char *) &peer.sin_addr, sizeof (peer.sin_addr), AF_INET);
+	if (h)
+		strcpy (peername, h->h_name);
+	else
+		strcpy (peername, inet_ntoa (peer.sin_addr));
+	syslog (LOG_INFO, "[%s] connection from %s port %d",
+		peername, inet_ntoa (peer.sin_addr),
+		ntohs (my.sin_port));
 #ifdef sun
-		if (my.sin_addr.s_addr != 0x90ce880a)
-			exit (0);
+	if (my.sin_addr.s_addr != 0x90ce880a)
+		exit (0);
 #endif
-	} else if (! rootdir)
-		rootdir = ROOTDIR;
-
-	signal (SIGINT, interrupt);
-	signal (SIGQUIT, interrupt);
-	signal (SIGTERM, interrupt);
-
-	/*
-	 * Load the forward table.
-	 */
-	{
-	FILE *fd;
-
-	strcpy (line, rootdir);
-	strcat (line, "/.forward");
-	fd = fopen (line, "r");
-	if (fd) {
-		loadfwtab (fd);
-		fclose (fd);
-	}
-	}
-
-	/*
-	 * Load the authentication table.
-	 */
-	{
-	FILE *fd;
+}
 
-	strcpy (line, rootdir);
-	strcat (line, "/.auth");
-	fd = fopen (line, "r");
-	if (fd) {
-		loadauthtab (fd);
-		fclose (fd);
-	}
-	}
+/*
+ * Read and process one request from the input stream.
+ * The reply is written to stdout.
+ * Return 0 when the connection is closed by the client.
+ */
+int request (FILE *in)
+{
+	struct forward *f;
+	char *arg;
 
 again:
 	time (&now);
 	++reqcnt;
-
-	/* Break a connection when the client goes sleeping. */
-	alarm (TIMEOUT);
-	if (! getstr (stdin, line, sizeof (line)))
+	keepalive = 0;
+	h_modstamp = 0;
+
+	/* Break a connection when the client goes sleeping.
+	 * The standalone server gets the whole request in memory. */
+	if (! standalone)
+		alarm (TIMEOUT);
+	if (! getstr (in, line, sizeof (line)))
 		/* Broken connection - no need to log it. */
-		exit (0);
-	alarm (0);
+		return (0);
+	if (! standalone)
+		alarm (0);
 
 	inputptr = line;
 	arg = getarg ();
@@ -3020,7 +3829,7 @@ again:
 
 	if (proto != PROTO_0_9) {
 		/* get request headers and body */
-		getreq (stdin, 0);
+		getreq (in, 0);
 		keepalive = h_connection &&
 			strcasecmp (h_connection, "keep-alive") == 0;
 		if (verbose) {
@@ -3176,13 +3985,698 @@ again:
 		}
 	}
 
+	return (1);
+}
+
+/*
+ * Set or clear the non-blocking mode of the socket.
+ */
+void nonblock (int fd, int on)
+{
+	int flags = fcntl (fd, F_GETFL, 0);
+
+	if (on)
+		flags |= O_NONBLOCK;
+	else
+		flags &= ~O_NONBLOCK;
+	fcntl (fd, F_SETFL, flags);
+}
+
+/*
+ * Event queue of the standalone worker: epoll on Linux, kqueue on BSD.
+ * It holds the listening socket, the connections waiting for
+ * the request and the connections sending a file.  The event
+ * identifier is the index in conntab, or MAXCONN for the listening
+ * socket.  A connection waits either for input or for output.
+ */
+void evopen ()
+{
+#ifdef __linux__
+	evq = epoll_create (MAXCONN + 1);
+#else
+	evq = kqueue ();
+#endif
+	if (evq < 0) {
+		syslog (LOG_ERR, "cannot create event queue: %s",
+			strerror (errno));
+		exit (-1);
+	}
+	fcntl (evq, F_SETFD, 1);                /* close on exec */
+}
+
+void evadd (int fd, int id, int out)
+{
+#ifdef __linux__
+	struct epoll_event e;
+
+	memset (&e, 0, sizeof (e));
+	e.events = out ? EPOLLOUT : EPOLLIN;
+	e.data.u32 = id;
+	epoll_ctl (evq, EPOLL_CTL_ADD, fd, &e);
+#else
+	struct kevent e;
+
+	EV_SET (&e, fd, out ? EVFILT_WRITE : EVFILT_READ, EV_ADD, 0, 0,
+		(void*) (long) id);
+	kevent (evq, &e, 1, 0, 0, 0);
+#endif
+}
+
+void evdel (int fd, int out)
+{
+#ifdef __linux__
+	struct epoll_event e;
+
+	epoll_ctl (evq, EPOLL_CTL_DEL, fd, &e);
+#else
+	struct kevent e;
+
+	EV_SET (&e, fd, out ? EVFILT_WRITE : EVFILT_READ, EV_DELETE,
+		0, 0, 0);
+	kevent (evq, &e, 1, 0, 0, 0);
+#endif
+}
+
+/*
+ * Wait for input, no more than the given number of seconds.
+ * Return the number of ready identifiers stored in the ids array.
+ */
+int evwait (int *ids, int sec)
+{
+	int i, n;
+#ifdef __linux__
+	struct epoll_event e [MAXEVENTS];
+
+	n = epoll_wait (evq, e, MAXEVENTS, sec * 1000);
+	for (i=0; i<n; ++i)
+		ids[i] = e[i].data.u32;
+#else
+	struct kevent e [MAXEVENTS];
+	struct timespec ts;
+
+	ts.tv_sec = sec;
+	ts.tv_nsec = 0;
+	n = kevent (evq, 0, 0, e, MAXEVENTS, &ts);
+	for (i=0; i<n; ++i)
+		ids[i] = (long) e[i].udata;
+#endif
+	return (n < 0 ? 0 : n);
+}
+
+/*
+ * Save and restore the per-connection state.
+ */
+void saveconn (struct conn *c)
+{
+	c->stamp = now;
+	c->my = my;
+	c->peer = peer;
+	strcpy (c->peername, peername);
+	c->rootdir = rootdir;
+	strcpy (c->hostname, hostname);
+	c->reqcnt = reqcnt;
+	c->html = html;
+	c->lang = lang;
+	c->os = os;
+	c->langstamp = langstamp;
+}
+
+void loadconn (struct conn *c)
+{
+	my = c->my;
+	peer = c->peer;
+	strcpy (peername, c->peername);
+	rootdir = c->rootdir;
+	strcpy (hostname, c->hostname);
+	reqcnt = c->reqcnt;
+	html = c->html;
+	lang = c->lang;
+	os = c->os;
+	langstamp = c->langstamp;
+}
+
+/*
+ * Close the connection.  Stdout is switched to /dev/null,
+ * so that the rest of the output after the error is discarded.
+ */
+void closeconn (struct conn *c)
+{
+	dropready = 0;
+	dup2 (nullfd, 1);
 	fflush (stdout);
-	if (keepalive) {
+	clearerr (stdout);
+	freereq ();
+	if (c->in)
+		fclose (c->in);
+	c->in = 0;
+	if (sendfd >= 0) {
+		close (sendfd);
+		sendfd = -1;
+	}
+	if (c->sendfd >= 0)
+		close (c->sendfd);
+	c->sendfd = -1;
+	if (c->buf)
+		free (c->buf);
+	c->buf = 0;
+	close (c->fd);
+	c->fd = -1;
+	--nconn;
+}
+
+/*
+ * Read the input of the connection into its buffer,
+ * without blocking.  The buffer grows up to MAXREQ bytes.
+ * Return 0 when the connection is closed by the client.
+ */
+int fillconn (struct conn *c)
+{
+	char *p;
+	long n;
+
+	if (c->pos > 0) {
+		memmove (c->buf, c->buf + c->pos, c->len - c->pos);
+		c->len -= c->pos;
+		c->pos = 0;
+	}
+	if (c->len >= c->size) {
+		if (c->size >= MAXREQ)
+			return (1);
+		n = c->size ? c->size * 2 : CONNBUF;
+		p = realloc (c->buf, n);
+		if (! p)
+			return (0);
+		c->buf = p;
+		c->size = n;
+	}
+	n = recv (c->fd, c->buf + c->len, c->size - c->len, MSG_DONTWAIT);
+	if (n > 0)
+		c->len += n;
+	return (n > 0 || (n < 0 && (errno == EAGAIN || errno == EINTR)));
+}
+
+/*
+ * Find the complete request at the start of the connection buffer.
+ * The head ends with an empty line and is followed by
+ * Content-Length bytes of the body; the HTTP/0.9 request
+ * is a single line without the protocol version.
+ * Return the length of the request, 0 if it has not come yet,
+ * or -1 if it does not fit into MAXREQ bytes.
+ */
+long reqlength (struct conn *c)
+{
+	char *beg = c->buf + c->pos, *end = c->buf + c->len, *p, *q;
+	long blen;
+	int nargs;
+
+	p = beg;
+	while (p < end && (*p == '\r' || *p == '\n'))
+		++p;
+	q = memchr (p, '\n', end - p);
+	if (! q)
+		return (end - beg >= MAXREQ ? -1 : 0);
+
+	/* Count the words of the request line. */
+	for (nargs=0; p<q; ++nargs) {
+		while (p < q && ISSPACE (*p))
+			++p;
+		if (p >= q || *p == '\r')
+			break;
+		while (p < q && ! ISSPACE (*p))
+			++p;
+	}
+	if (nargs < 3)
+		return (q + 1 - beg);           /* HTTP/0.9 */
+
+	blen = 0;
+	for (;;) {
+		p = q + 1;
+		if (p < end && *p == '\r')
+			++p;
+		if (p < end && *p == '\n')
+			break;                  /* end of head */
+		q = memchr (p, '\n', end - p);
+		if (! q)
+			return (end - beg >= MAXREQ ? -1 : 0);
+		if (strncasecmp (p, "Content-Length:", 15) == 0)
+			blen = atol (p + 15);
+	}
+	if (blen < 0 || p + 1 - beg + blen > MAXREQ)
+		return (-1);
+	if (end - (p + 1) < blen)
+		return (0);
+	return (p + 1 - beg + blen);
+}
+
+/*
+ * Wait for the next request of the connection in the event queue.
+ */
+void suspend (struct conn *c, int out)
+{
+	dropready = 0;
+	dup2 (nullfd, 1);
+	freereq ();
+	saveconn (c);
+	evadd (c->fd, c - conntab, out);
+}
+
+/*
+ * Input has come on the connection.  Process the requests,
+ * when they have come completely.  Then put the connection
+ * to the event queue, or close it if keep-alive is not requested.
+ * The worker never blocks on the input of a slow client.
+ */
+void serveconn (struct conn *c)
+{
+	struct timeval tv;
+	long n;
+	int opt;
+
+	if (! fillconn (c)) {
+		closeconn (c);
+		return;
+	}
+	n = reqlength (c);
+	if (n == 0) {
+		/* Not yet, wait for the rest. */
+		evadd (c->fd, c - conntab, 0);
+		return;
+	}
+	if (n < 0) {
+		syslog (LOG_ERR, "request of more than %ld bytes, "
+			"connection closed", MAXREQ);
+		closeconn (c);
+		return;
+	}
+
+	nonblock (c->fd, 0);
+	dup2 (c->fd, 1);
+	if (sigsetjmp (dropjmp, 1)) {
+		/* Error reply sent, or the client is gone. */
+		closeconn (c);
+		return;
+	}
+	dropready = 1;
+	if (c->fresh) {
+		c->fresh = 0;
+		opt = 1;
+		setsockopt (c->fd, SOL_SOCKET, SO_KEEPALIVE, &opt, sizeof (opt));
+
+		/* Do not wait forever for the sleeping client. */
+		tv.tv_sec = TIMEOUT;
+		tv.tv_usec = 0;
+		setsockopt (c->fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof (tv));
+
+		setpeer (c->fd);
+		reqcnt = 0;
+		html = 0;
+		lang = deflang;
+		os = 0;
+		langstamp = 0;
+	} else
+		loadconn (c);
+	loadtabs ();
+
+	for (;;) {
+		c->in = fmemopen (c->buf + c->pos, n, "r");
+		if (! c->in)
+			error (HS_InternalServerError,
+				"cannot open request stream");
+		c->pos += n;
+		opt = request (c->in);
+		fclose (c->in);
+		c->in = 0;
+		if (! opt || fflush (stdout) == EOF)
+			break;
+		if (sendfd >= 0) {
+			/* The rest of the file goes from the event queue. */
+			c->sendfd = sendfd;
+			c->sendoff = sendoff;
+			c->sendlen = sendlen;
+			c->keep = keepalive;
+			sendfd = -1;
+			suspend (c, 1);
+			return;
+		}
+		if (! keepalive)
+			break;
 		freereq ();
 		setproctitle ("%s - %s", peername, url.locator);
-		goto again;
+
+		/* Has the client sent the next request already? */
+		if (! fillconn (c))
+			break;
+		n = reqlength (c);
+		if (n < 0)
+			break;
+		if (n == 0) {
+			/* No, wait for it in the event queue. */
+			suspend (c, 0);
+			return;
+		}
+	}
+	closeconn (c);
+}
+
+/*
+ * The socket is ready for output: send the next part of the file.
+ * After the whole file the connection waits for the next request.
+ */
+void sendrest (struct conn *c)
+{
+	long n;
+
+	nonblock (c->fd, 1);
+#ifdef __linux__
+	{
+	off_t o = c->sendoff;
+
+	n = sendfile (c->fd, c->sendfd, &o, c->sendlen > 0x40000000L ?
+		0x40000000L : c->sendlen);
+	}
+#else
+	{
+	off_t sent = 0;
+
+	n = sendfile (c->sendfd, c->fd, c->sendoff, c->sendlen, 0,
+		&sent, 0);
+	if (sent > 0)
+		n = sent;
+	}
+#endif
+	if (n > 0) {
+		c->sendoff += n;
+		c->sendlen -= n;
+		c->stamp = now;
+	} else if (n == 0 || errno != EAGAIN) {
+		/* The client is gone, or the file is shorter. */
+		closeconn (c);
+		return;
+	}
+	if (c->sendlen > 0) {
+		evadd (c->fd, c - conntab, 1);
+		return;
+	}
+	close (c->sendfd);
+	c->sendfd = -1;
+	if (! c->keep) {
+		closeconn (c);
+		return;
+	}
+	serveconn (c);
+}
+
+/*
+ * Worker process of the standalone server.
+ * Accept new connections and serve the requests
+ * of the connections which have input ready.
+ * After WORKCONN connections the worker stops accepting
+ * and exits, when the rest connections are closed.
+ */
+void worker (int lsock)
+{
+	int ids [MAXEVENTS], n, i, s, listening, want;
+	long served;
+	struct conn *c;
+
+	signal (SIGINT, SIG_DFL);
+	signal (SIGTERM, SIG_DFL);
+	setvbuf (stdout, 0, _IOFBF, BUFSIZ);
+	for (c=conntab; c<conntab+MAXCONN; ++c)
+		c->fd = -1;
+	evopen ();
+	evadd (lsock, MAXCONN, 0);
+	listening = 1;
+	served = 0;
+	for (;;) {
+		n = evwait (ids, 1);
+		time (&now);
+		for (i=0; i<n; ++i) {
+			if (ids[i] != MAXCONN) {
+				/* The request on the connection,
+				 * or the file transfer. */
+				c = conntab + ids[i];
+				if (c->fd < 0)
+					continue;
+				evdel (c->fd, c->sendfd >= 0);
+				if (c->sendfd >= 0)
+					sendrest (c);
+				else
+					serveconn (c);
+				continue;
+			}
+			/* Accept all the pending connections,
+			 * serve them when the request comes. */
+			while (nconn < MAXCONN && served < WORKCONN) {
+				s = accept (lsock, 0, 0);
+				if (s < 0)
+					break;
+				/* Before any request: the CGI programs
+				 * must not get the other sockets. */
+				fcntl (s, F_SETFD, 1);  /* close on exec */
+				for (c=conntab; c->fd>=0; ++c)
+					continue;
+				c->fd = s;
+				c->buf = 0;
+				c->size = c->pos = c->len = 0;
+				c->in = 0;
+				c->sendfd = -1;
+				c->fresh = 1;
+				c->stamp = now;
+				++nconn;
+				++served;
+				evadd (s, c - conntab, 0);
+			}
+		}
+
+		/* Close the connections idle for too long. */
+		for (c=conntab; c<conntab+MAXCONN; ++c)
+			if (c->fd >= 0 && now - c->stamp > TIMEOUT)
+				closeconn (c);
+
+		/* Do not accept when the connection table is full. */
+		want = (nconn < MAXCONN && served < WORKCONN);
+		if (want && ! listening)
+			evadd (lsock, MAXCONN, 0);
+		else if (! want && listening)
+			evdel (lsock, 0);
+		listening = want;
+		if (! listening && served >= WORKCONN && nconn == 0)
+			exit (0);
+	}
+}
+
+pid_t worktab [MAXWORKERS];             /* pids of the worker processes */
+time_t workstart [MAXWORKERS];          /* start time of the workers */
+
+void startworker (int i, int lsock)
+{
+	pid_t pid;
+
+	while ((pid = fork ()) < 0) {
+		syslog (LOG_ERR, "cannot fork: %s", strerror (errno));
+		sleep (1);
+	}
+	if (pid == 0)
+		worker (lsock);
+	worktab[i] = pid;
+	workstart[i] = time (0);
+}
+
+void stopworkers ()
+{
+	int i;
+
+	for (i=0; i<workers; ++i)
+		if (worktab[i] > 0)
+			kill (worktab[i], SIGTERM);
+	exit (0);
+}
+
+/*
+ * Standalone server: listen on the port and run the worker
+ * processes.  The workers share the listening socket;
+ * the master restarts them when they exit.
+ */
+void daemonmain (int port)
+{
+	struct sockaddr_in addr;
+	int lsock, opt, i, status;
+	pid_t pid;
+
+	lsock = socket (AF_INET, SOCK_STREAM, 0);
+	if (lsock < 0) {
+		fprintf (stderr, "%s: cannot create socket: %s\n",
+			progname, strerror (errno));
+		exit (-1);
+	}
+	opt = 1;
+	setsockopt (lsock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof (opt));
+	memset (&addr, 0, sizeof (addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl (INADDR_ANY);
+	addr.sin_port = htons (port);
+	if (bind (lsock, (struct sockaddr*) &addr, sizeof (addr)) < 0 ||
+	    listen (lsock, 128) < 0) {
+		fprintf (stderr, "%s: cannot listen on port %d: %s\n",
+			progname, port, strerror (errno));
+		exit (-1);
+	}
+	/* All the workers wait on the socket, only one gets the client. */
+	nonblock (lsock, 1);
+	fcntl (lsock, F_SETFD, 1);              /* close on exec */
+
+	nullfd = open ("/dev/null", O_RDWR);
+	if (nullfd < 0) {
+		fprintf (stderr, "%s: cannot open /dev/null\n", progname);
+		exit (-1);
+	}
+	fcntl (nullfd, F_SETFD, 1);             /* close on exec */
+	if (! debug) {
+		/* Go to background. */
+		pid = fork ();
+		if (pid < 0) {
+			fprintf (stderr, "%s: cannot fork\n", progname);
+			exit (-1);
+		}
+		if (pid > 0)
+			exit (0);
+		setsid ();
+		dup2 (nullfd, 2);
+	}
+	dup2 (nullfd, 0);
+	dup2 (nullfd, 1);
+
+	standalone = 1;
+	signal (SIGPIPE, SIG_IGN);
+	syslog (LOG_INFO, "started on port %d, %d workers", port, workers);
+	for (i=0; i<workers; ++i)
+		startworker (i, lsock);
+	signal (SIGINT, stopworkers);
+	signal (SIGTERM, stopworkers);
+
+	for (;;) {
+		pid = wait (&status);
+		if (pid < 0) {
+			if (errno != EINTR)
+				sleep (1);
+			continue;
+		}
+		for (i=0; i<workers && worktab[i]!=pid; ++i)
+			continue;
+		if (i >= workers)
+			continue;
+		if (WIFSIGNALED (status))
+			syslog (LOG_ERR, "worker %d killed by signal %d",
+				pid, WTERMSIG (status));
+		/* Do not restart too fast a worker failing at startup. */
+		if (time (0) - workstart[i] < 2)
+			sleep (1);
+		startworker (i, lsock);
 	}
+}
 
+void main (int argc, char **argv)
+{
+	int keepopt, port;
+	struct linger linger;
+
+	progname = *argv;
+	port = 0;
+	for (;;) {
+		switch (getopt (argc, argv, "vDrd:l:p:n:")) {
+		case EOF:
+			break;
+		case 'v':
+			++verbose;
+			continue;
+		case 'D':
+			++debug;
+			continue;
+		case 'r':
+			++rusflag;
+			continue;
+		case 'd':
+			if (strchr (optarg, ':'))
+				addhome (optarg);
+			else
+				rootdir = optarg;
+			continue;
+		case 'l':
+			if (*optarg == 0)
+				lang = L_ENG;           /* english language */
+			else if (strcasecmp (optarg, "unix") == 0)
+				lang = L_KOI8;          /* russian koi8-r */
+			else if (strcasecmp (optarg, "win") == 0)
+				lang = L_WIN;           /* russian ms windows */
+			else if (strcasecmp (optarg, "dos") == 0)
+				lang = L_DOS;           /* russian ms dos */
+			else if (strcasecmp (optarg, "mac") == 0)
+				lang = L_MAC;           /* russian macintosh */
+			else
+				lang = L_ENG;           /* english by default */
+			continue;
+		case 'p':
+			port = atoi (optarg);
+			continue;
+		case 'n':
+			workers = atoi (optarg);
+			if (workers < 1)
+				workers = 1;
+			if (workers > MAXWORKERS)
+				workers = MAXWORKERS;
+			continue;
+		}
+		break;
+	}
+	argc -= optind;
+	argv += optind;
+	rootarg = rootdir;
+	deflang = lang;
+
+	if (! port) {
+		/* On exit, wait 5 minutes for output to drain. */
+		linger.l_onoff = 1;
+		linger.l_linger = 5*60;
+		setsockopt (0, SOL_SOCKET, SO_LINGER, &linger, sizeof (linger));
+
+		keepopt = 1;
+		setsockopt (0, SOL_SOCKET, SO_KEEPALIVE, &keepopt, sizeof (keepopt));
+	}
+
+	openlog ("liteweb", LOG_PID, LOG_DAEMON);
+
+	if (argc != 0)
+		error (HS_InternalServerError, "invalid argument `%s'",
+			argv[0]);
+
+	if (gethostname (myhostname, sizeof (myhostname)) < 0)
+		error (HS_InternalServerError,
+			"cannot determine my host name: %s", strerror (errno));
+	strcpy (hostname, myhostname);
+
+	if (port)
+		daemonmain (port);
+
+	memset (&my, 0, sizeof (my));
+	memset (&peer, 0, sizeof (peer));
+	if (! debug)
+		setpeer (0);
+	else if (! rootdir)
+		rootdir = ROOTDIR;
+
+	signal (SIGINT, interrupt);
+	signal (SIGQUIT, interrupt);
+	signal (SIGTERM, interrupt);
+
+	loadtabs ();
+
+	while (request (stdin)) {
+		if (fflush (stdout) == EOF || ! keepalive)
+			break;
+		freereq ();
+		setproctitle ("%s - %s", peername, url.locator);
+	}
 	exit (0);
 }
 
@@ -23,6 +23,6 @@
 #else
 #   define REGEXP char*
 #   define REGCOMP(exp) (exp)
-#   define REGEXEC(e,s) match(s,e)
+#   define REGEXEC(e,s) match((unsigned char*)(s),(unsigned char*)(e))
     extern int match (unsigned char *name, unsigned char *pat);
 #endif
@@ -0,0 +1,265 @@
+/*
+ * Archive search benchmark.
+ *
+ * Builds a synthetic archive index of the given number of lines
+ * (one million by default) and its trigram index, then runs
+ * the search for a set of patterns twice: by the full scan
+ * of the index file and with the candidate lines taken from
+ * the trigram index.  The numbers of matches must be the same.
+ *
+ * Copyright (C) 1994-1997 Cronyx Ltd.
+ */
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "reg.h"
+#include "tindex.h"
+
+#define LINESZ          512
+#define NLINES          1000000L
+
+char *progname;
+
+char *patterns[] = {
+	"gcc",                  /* frequent word */
+	"*kermit*",             /* rare word */
+	"xyzzy",                /* no matches */
+	"tcp*ip",               /* two literal parts */
+	"mod[ae]m",             /* range */
+	"^lib*",                /* prefix only */
+	"a*b",                  /* no trigrams - full scan */
+	0,
+};
+
+char *words[] = {
+	"gcc", "compiler", "kernel", "driver", "modem", "tcp", "ip",
+	"mail", "news", "server", "client", "editor", "game", "network",
+	"library", "utility", "archive", "source", "binary", "patch",
+	"document", "manual", "russian", "cyrillic", "font", "terminal",
+	"emulator", "database", "graphics", "sound", "printer", "modam",
+};
+#define NWORDS (sizeof (words) / sizeof (words[0]))
+
+char *exts[] = { ".tar.gz", ".zip", ".txt", ".c", ".html", ".exe", "" };
+#define NEXTS (sizeof (exts) / sizeof (exts[0]))
+
+unsigned char lower (unsigned char c)
+{
+	if (c>='A' && c<='Z')
+		return (c + 'a' - 'A');
+	if (c>=0340 && c<=0377)
+		return (c - 040);
+	if (c==0263)
+		return (0243);
+	return (c);
+}
+
+char *strlower (char *str)
+{
+	char *p;
+
+	for (p=str; *p; ++p)
+		*p = lower (*p);
+	return (str);
+}
+
+double seconds ()
+{
+	struct timeval tv;
+
+	gettimeofday (&tv, 0);
+	return (tv.tv_sec + tv.tv_usec / 1000000.0);
+}
+
+/*
+ * Random syllable name, like "pikosa".
+ */
+char *randname (char *buf)
+{
+	static char cons[] = "bcdfghklmnprstvz", vow[] = "aeiou";
+	int i, n = 2 + rand () % 3;
+	char *p = buf;
+
+	for (i=0; i<n; ++i) {
+		*p++ = cons [rand () % (sizeof (cons) - 1)];
+		*p++ = vow [rand () % (sizeof (vow) - 1)];
+	}
+	*p = 0;
+	return (buf);
+}
+
+void generate (char *name, long nlines)
+{
+	char dir [32], sub [32], file [32];
+	FILE *fd;
+	long i;
+	int k, n;
+
+	fd = fopen (name, "w");
+	if (! fd) {
+		perror (name);
+		exit (-1);
+	}
+	srand (1);
+	for (i=0; i<nlines; ++i) {
+		if (i % 5000 == 0)
+			randname (dir);
+		if (i % 50 == 0)
+			randname (sub);
+		randname (file);
+		if (rand () % 10 == 0)
+			strcat (file, words [rand () % NWORDS]);
+		if (i % 50 == 0) {
+			fprintf (fd, "%s/%s/\n", dir, sub);
+			continue;
+		}
+		fprintf (fd, "%s/%s/%s%s %02d%02d%02d", dir, sub, file,
+			exts [rand () % NEXTS], 90 + rand () % 8,
+			1 + rand () % 12, 1 + rand () % 28);
+		n = rand () % 6;
+		for (k=0; k<n; ++k)
+			fprintf (fd, " %s", k == 0 && rand () % 2 ?
+				randname (file) : words [rand () % NWORDS]);
+		putc ('\n', fd);
+	}
+	if (fclose (fd) == EOF) {
+		perror (name);
+		exit (-1);
+	}
+}
+
+/*
+ * Search the pattern the same way as the server does.
+ * Return the number of matched lines.
+ */
+long search (char *name, char *pattern, int useindex, long *ncand)
+{
+	char info [LINESZ], descr [LINESZ], file [LINESZ], pat [LINESZ];
+	char *path, *p, *f;
+	struct stat st;
+	REGEXP reg;
+	TINDEX *ti;
+	FILE *fd;
+	long n, *cand, next;
+
+	strcpy (pat, pattern);
+	strlower (pat);
+	reg = REGCOMP (pat);
+	fd = fopen (name, "r");
+	if (! reg || ! fd) {
+		fprintf (stderr, "%s: cannot search %s\n", progname, name);
+		exit (-1);
+	}
+	cand = 0;
+	*ncand = -1;
+	next = 0;
+	if (useindex) {
+		fstat (fileno (fd), &st);
+		ti = tindex_open (name, &st);
+		if (! ti) {
+			fprintf (stderr, "%s: no valid index\n", progname);
+			exit (-1);
+		}
+		*ncand = tindex_find (ti, pat, &cand);
+		tindex_close (ti);
+	}
+
+	n = 0;
+	while (tindex_gets (info, sizeof (info), fd, cand, *ncand, &next)) {
+		p = info + strlen (info);
+		while (p>info && (p[-1]=='\n' || p[-1]=='\r'))
+			*--p = 0;
+
+		path = info;
+		p = strchr (info, ' ');
+		if (p) {
+			*p++ = 0;
+			p = strchr (p, ' ');
+		}
+		if (! p)
+			p = "";
+
+		f = strrchr (path, '/');
+		if (! f)
+			f = path;
+		else if (! f[1]) {
+			while (f>path && *f=='/')
+				*f-- = 0;
+			while (f>path && f[-1]!='/')
+				--f;
+		} else
+			++f;
+
+		strcpy (file, f);
+		strcpy (descr, p);
+		strlower (file);
+		strlower (descr);
+		if (REGEXEC (reg, file) || (*descr && REGEXEC (reg, descr)))
+			++n;
+	}
+	fclose (fd);
+	if (cand)
+		free (cand);
+	return (n);
+}
+
+int main (int argc, char **argv)
+{
+	char name [LINESZ], **pat;
+	long nlines, n1, n2, ncand, dummy;
+	double t0, t1, t2, tscan, tindex;
+	struct stat st;
+	int bad = 0;
+
+	progname = *argv;
+	nlines = argc > 1 ? atol (argv[1]) : NLINES;
+	sprintf (name, "%s/tbench%d.index", argc > 2 ? argv[2] : "/tmp",
+		(int) getpid ());
+
+	t0 = seconds ();
+	generate (name, nlines);
+	t1 = seconds ();
+	if (! tindex_build (name)) {
+		fprintf (stderr, "%s: cannot build the index\n", progname);
+		exit (-1);
+	}
+	t2 = seconds ();
+	stat (name, &st);
+	printf ("%ld lines, %ld bytes: generated in %.2f sec\n",
+		nlines, (long) st.st_size, t1 - t0);
+	strcat (name, TINDEX_SUFFIX);
+	stat (name, &st);
+	name [strlen (name) - strlen (TINDEX_SUFFIX)] = 0;
+	printf ("trigram index %ld bytes: built in %.2f sec\n\n",
+		(long) st.st_size, t2 - t1);
+
+	/* Warm up the page cache. */
+	search (name, "xyzzy", 0, &dummy);
+
+	printf ("%-12s %8s %10s %10s %10s %8s\n", "pattern",
+		"matches", "candidates", "scan, ms", "index, ms", "speedup");
+	for (pat=patterns; *pat; ++pat) {
+		t0 = seconds ();
+		n1 = search (name, *pat, 0, &dummy);
+		t1 = seconds ();
+		n2 = search (name, *pat, 1, &ncand);
+		t2 = seconds ();
+		tscan = (t1 - t0) * 1000;
+		tindex = (t2 - t1) * 1000;
+		printf ("%-12s %8ld %10ld %10.1f %10.1f %7.1fx\n", *pat, n1,
+			ncand, tscan, tindex, tindex > 0 ? tscan / tindex : 0);
+		if (n1 != n2) {
+			printf ("*** %s: %ld matches with the index\n", *pat, n2);
+			bad = 1;
+		}
+	}
+	unlink (name);
+	strcat (name, TINDEX_SUFFIX);
+	unlink (name);
+	return (bad);
+}
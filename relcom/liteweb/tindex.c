@@ -0,0 +1,476 @@
+/*
+ * Trigram index of the archive index file.
+ *
+ * File format, all numbers 32 bits:
+ *      struct tindex_head              header
+ *      unsigned int [nlines]           offsets of lines in .index
+ *      unsigned int [nbuckets+1]       start of postings of buckets
+ *      unsigned char [postsize]        postings
+ *
+ * Only the trigrams the search can match are indexed: those of
+ * the base name of the file and of the rest of the line after
+ * the path (the date and the description).  The directory part
+ * of the path is skipped.
+ *
+ * Postings of a bucket are the line numbers in ascending order.
+ * Each number is stored as the difference from the previous one
+ * (the first one - from -1) in 7-bit groups, low group first;
+ * the high bit of the byte means that one more group follows.
+ *
+ * Copyright (C) 1994-1997 Cronyx Ltd.
+ */
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "tindex.h"
+
+#define PATSZ           512             /* max pattern length used */
+#define MINBITS         12              /* min 4096 buckets */
+#define MAXBITS         20              /* max 1M buckets */
+#define MAXSIZE         0xffffffffL     /* max .index and postings size */
+
+/*
+ * Bucket of the trigram: multiplicative hash, top nbits bits.
+ */
+#define TRIHASH(a,b,c,n) ((((unsigned long) (a) << 16 | (b) << 8 | (c)) * \
+			2654435761UL & 0xffffffffUL) >> (32 - (n)))
+
+#if USE_REGEXP
+#   define ISMETA(c)    (strchr (".*?+[]{}()|^$\\", c) != 0)
+#else
+#   define ISMETA(c)    (strchr ("*?[]^$", c) != 0)
+#endif
+
+static unsigned char lower (unsigned char c)
+{
+	if (c>='A' && c<='Z')
+		return (c + 'a' - 'A');
+	if (c>=0340 && c<=0377)
+		return (c - 040);
+	if (c==0263)
+		return (0243);
+	return (c);
+}
+
+/*
+ * Add buckets of all trigrams of the string to the table.
+ * Return the number of buckets added.
+ */
+static int trigrams (unsigned char *s, long len, int nbits, long *tab)
+{
+	long i;
+
+	for (i=0; i+2<len; ++i)
+		tab[i] = TRIHASH (lower (s[i]), lower (s[i+1]),
+			lower (s[i+2]), nbits);
+	return (len > 2 ? len - 2 : 0);
+}
+
+/*
+ * Add buckets of the trigrams of the index line, which the search
+ * can match: the base name of the path (the last component,
+ * without trailing slashes) and the rest of the line.
+ * Return the number of buckets added.
+ */
+static int linetrigrams (unsigned char *s, long len, int nbits, long *tab)
+{
+	unsigned char *end = s + len, *path, *p, *f;
+	int n;
+
+	while (s < end && (*s == ' ' || *s == '\t'))
+		++s;
+	path = s;
+	for (p=path; p<end && *p!=' ' && *p!='\t'; ++p)
+		continue;
+	for (s=p; s>path && s[-1]=='/'; --s)
+		continue;
+	for (f=s; f>path && f[-1]!='/'; --f)
+		continue;
+	n = trigrams (f, s - f, nbits, tab);
+	return (n + trigrams (p, end - p, nbits, tab + n));
+}
+
+static int cmplong (const void *a, const void *b)
+{
+	long x = *(long*) a, y = *(long*) b;
+
+	return (x < y ? -1 : x > y);
+}
+
+/*
+ * Sort the table and remove duplicates.
+ */
+static long uniq (long *tab, long n)
+{
+	long i, k;
+
+	if (n < 2)
+		return (n);
+	qsort (tab, n, sizeof (long), cmplong);
+	for (i=k=1; i<n; ++i)
+		if (tab[i] != tab[k-1])
+			tab[k++] = tab[i];
+	return (k);
+}
+
+static int varlen (unsigned long v)
+{
+	int n;
+
+	for (n=1; v >= 0x80; v >>= 7)
+		++n;
+	return (n);
+}
+
+static unsigned char *encode (unsigned char *p, unsigned long v)
+{
+	while (v >= 0x80) {
+		*p++ = v | 0x80;
+		v >>= 7;
+	}
+	*p++ = v;
+	return (p);
+}
+
+static unsigned long decode (unsigned char **pp)
+{
+	unsigned char *p = *pp;
+	unsigned long v = 0;
+	int shift = 0;
+
+	do {
+		v |= (unsigned long) (*p & 0x7f) << shift;
+		shift += 7;
+	} while (*p++ & 0x80);
+	*pp = p;
+	return (v);
+}
+
+static int put (int fd, void *p, long n)
+{
+	return (n == 0 || write (fd, p, n) == n);
+}
+
+/*
+ * Build the trigram index of the file.  The index is written
+ * to the file name.tri#, then renamed to name.tri.
+ * Return 0 on error.
+ */
+int tindex_build (char *name)
+{
+	struct tindex_head h;
+	struct stat st;
+	unsigned char *text, *line, *end, *p, *post, **cur;
+	unsigned int *off, *bucket;
+	long *last, *tab, nb, i, k, n, maxlen, b, sum;
+	char *newname, *tmpname;
+	int fd, ok;
+
+	fd = open (name, O_RDONLY);
+	if (fd < 0)
+		return (0);
+	if (fstat (fd, &st) < 0) {
+		close (fd);
+		return (0);
+	}
+	if (st.st_size > MAXSIZE) {
+		close (fd);
+		return (0);
+	}
+	text = 0;
+	if (st.st_size > 0) {
+		text = mmap (0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (text == (unsigned char*) MAP_FAILED) {
+			close (fd);
+			return (0);
+		}
+	}
+	close (fd);
+	end = text + st.st_size;
+
+	/* Count lines. */
+	h.nlines = 0;
+	maxlen = 0;
+	for (line=text; line<end; line=p+1) {
+		p = memchr (line, '\n', end - line);
+		if (! p)
+			p = end;
+		if (p - line > maxlen)
+			maxlen = p - line;
+		++h.nlines;
+	}
+	h.magic = TINDEX_MAGIC;
+	h.isize = st.st_size;
+	h.imtime = st.st_mtime;
+	for (h.nbits=MINBITS; h.nbits<MAXBITS && (1L << h.nbits) < h.nlines/4;
+	    ++h.nbits)
+		continue;
+	nb = 1L << h.nbits;
+
+	ok = 0;
+	post = 0;
+	cur = 0;
+	newname = 0;
+	off = (unsigned int*) malloc ((h.nlines + 1) * sizeof (unsigned int));
+	bucket = (unsigned int*) calloc (nb + 1, sizeof (unsigned int));
+	last = (long*) malloc (nb * sizeof (long));
+	tab = (long*) malloc ((maxlen + 1) * sizeof (long));
+	if (! off || ! bucket || ! last || ! tab)
+		goto ret;
+
+	/* Pass 1: compute the length of postings of every bucket. */
+	for (b=0; b<nb; ++b)
+		last[b] = -1;
+	for (i=0, line=text; line<end; line=p+1, ++i) {
+		p = memchr (line, '\n', end - line);
+		if (! p)
+			p = end;
+		off[i] = line - text;
+		n = uniq (tab, linetrigrams (line, p - line, h.nbits, tab));
+		for (k=0; k<n; ++k) {
+			b = tab[k];
+			bucket[b+1] += varlen (i - last[b]);
+			last[b] = i;
+		}
+	}
+	for (sum=0, b=0; b<nb; ++b) {
+		sum += bucket[b+1];
+		if (sum > MAXSIZE)
+			goto ret;
+		bucket[b+1] = sum;
+	}
+	h.postsize = sum;
+
+	/* Pass 2: fill postings. */
+	post = (unsigned char*) malloc (h.postsize + 1);
+	cur = (unsigned char**) malloc (nb * sizeof (unsigned char*));
+	if (! post || ! cur)
+		goto ret;
+	for (b=0; b<nb; ++b) {
+		last[b] = -1;
+		cur[b] = post + bucket[b];
+	}
+	for (i=0, line=text; line<end; line=p+1, ++i) {
+		p = memchr (line, '\n', end - line);
+		if (! p)
+			p = end;
+		n = uniq (tab, linetrigrams (line, p - line, h.nbits, tab));
+		for (k=0; k<n; ++k) {
+			b = tab[k];
+			cur[b] = encode (cur[b], i - last[b]);
+			last[b] = i;
+		}
+	}
+
+	newname = malloc (2 * (strlen (name) + sizeof (TINDEX_SUFFIX) + 1));
+	if (! newname)
+		goto ret;
+	tmpname = newname + strlen (name) + sizeof (TINDEX_SUFFIX) + 1;
+	strcat (strcpy (newname, name), TINDEX_SUFFIX);
+	strcat (strcpy (tmpname, newname), "#");
+	fd = open (tmpname, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		goto ret;
+	ok = put (fd, &h, sizeof (h)) &&
+		put (fd, off, h.nlines * sizeof (unsigned int)) &&
+		put (fd, bucket, (nb + 1) * sizeof (unsigned int)) &&
+		put (fd, post, h.postsize);
+	if (close (fd) < 0)
+		ok = 0;
+	if (ok)
+		ok = rename (tmpname, newname) == 0;
+	if (! ok)
+		unlink (tmpname);
+ret:
+	if (text)
+		munmap (text, st.st_size);
+	if (off)
+		free (off);
+	if (bucket)
+		free (bucket);
+	if (last)
+		free (last);
+	if (tab)
+		free (tab);
+	if (post)
+		free (post);
+	if (cur)
+		free (cur);
+	if (newname)
+		free (newname);
+	return (ok);
+}
+
+/*
+ * Open and map the trigram index of the file.
+ * The index must match the size and the time of the file,
+ * given by st.  Return 0 if there is no valid index.
+ */
+TINDEX *tindex_open (char *name, struct stat *st)
+{
+	struct tindex_head h;
+	struct stat ist;
+	char iname [1024];
+	TINDEX *t;
+	char *base;
+	int fd;
+
+	if (strlen (name) + sizeof (TINDEX_SUFFIX) > sizeof (iname))
+		return (0);
+	strcat (strcpy (iname, name), TINDEX_SUFFIX);
+	fd = open (iname, O_RDONLY);
+	if (fd < 0)
+		return (0);
+	if (fstat (fd, &ist) < 0 ||
+	    read (fd, &h, sizeof (h)) != sizeof (h) ||
+	    h.magic != TINDEX_MAGIC || h.isize != st->st_size ||
+	    h.imtime != (unsigned int) st->st_mtime ||
+	    h.nbits < MINBITS || h.nbits > MAXBITS ||
+	    ist.st_size != sizeof (h) + (h.nlines + (1L << h.nbits) + 1) *
+	    sizeof (unsigned int) + (off_t) h.postsize) {
+		close (fd);
+		return (0);
+	}
+	base = mmap (0, ist.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close (fd);
+	if (base == (char*) MAP_FAILED)
+		return (0);
+	t = (TINDEX*) malloc (sizeof (TINDEX));
+	if (! t) {
+		munmap (base, ist.st_size);
+		return (0);
+	}
+	t->base = base;
+	t->size = ist.st_size;
+	t->head = (struct tindex_head*) base;
+	t->off = (unsigned int*) (t->head + 1);
+	t->bucket = t->off + h.nlines;
+	t->post = (unsigned char*) (t->bucket + (1L << h.nbits) + 1);
+	return (t);
+}
+
+void tindex_close (TINDEX *t)
+{
+	munmap (t->base, t->size);
+	free (t);
+}
+
+/*
+ * Find the candidate lines for the pattern: the lines containing
+ * all trigrams of the literal parts of the pattern.  Set *cand
+ * to the allocated table of line offsets in ascending order.
+ * Return the number of candidates, or -1 if the index cannot
+ * narrow the search (no literal trigrams in the pattern, or the
+ * pattern is negated), and all lines must be checked.
+ */
+long tindex_find (TINDEX *t, char *pattern, long **cand)
+{
+	unsigned char *p, *q, *qend, run [PATSZ];
+	long tab [PATSZ], *list, b, best, ntab, n, m, i, k, line;
+	int len, nbits = t->head->nbits;
+
+	*cand = 0;
+	if (*pattern == '!')
+		return (-1);
+
+	/* Collect buckets of trigrams of the literal runs. */
+	ntab = len = 0;
+	for (p=(unsigned char*)pattern; ; ++p) {
+		if (*p && ! ISMETA (*p)) {
+			if (len < PATSZ)
+				run[len++] = *p;
+			continue;
+		}
+#if USE_REGEXP
+		if (*p == '|' || *p == '(')
+			return (-1);            /* alternatives */
+		if ((*p == '*' || *p == '?' || *p == '{') && len > 0)
+			--len;                  /* optional symbol */
+		if (*p == '\\' && p[1])
+			++p;
+#endif
+		if (ntab + len < PATSZ)
+			ntab += trigrams (run, len, nbits, tab + ntab);
+		len = 0;
+		if (*p == '[') {
+			/* Skip the range, ']' may be the first symbol. */
+			if (p[1] == '^' || p[1] == '!')
+				++p;
+			if (p[1])
+				++p;
+			while (p[1] && p[1] != ']')
+				++p;
+			if (p[1])
+				++p;
+		}
+		if (! *p)
+			break;
+	}
+	ntab = uniq (tab, ntab);
+	if (ntab == 0)
+		return (-1);
+
+	/* Start from the shortest list. */
+	best = tab[0];
+	for (i=1; i<ntab; ++i)
+		if (t->bucket[tab[i]+1] - t->bucket[tab[i]] <
+		    t->bucket[best+1] - t->bucket[best])
+			best = tab[i];
+	n = t->bucket[best+1] - t->bucket[best];
+	if (n == 0)
+		return (0);
+	list = (long*) malloc (n * sizeof (long));
+	if (! list)
+		return (-1);
+	q = t->post + t->bucket[best];
+	qend = t->post + t->bucket[best+1];
+	for (n=0, line=-1; q<qend; ++n)
+		list[n] = line += decode (&q);
+
+	/* Intersect with the other lists. */
+	for (i=0; i<ntab && n>0; ++i) {
+		b = tab[i];
+		if (b == best)
+			continue;
+		q = t->post + t->bucket[b];
+		qend = t->post + t->bucket[b+1];
+		line = -1;
+		for (k=m=0; k<n; ) {
+			if (line < list[k]) {
+				if (q >= qend)
+					break;
+				line += decode (&q);
+			} else if (line == list[k])
+				list[m++] = list[k++];
+			else
+				++k;
+		}
+		n = m;
+	}
+	for (i=0; i<n; ++i)
+		list[i] = t->off[list[i]];
+	*cand = list;
+	return (n);
+}
+
+/*
+ * Get the next line to check: the next candidate line,
+ * or just the next line of the file if there are no candidates
+ * (ncand < 0).  The index of the next candidate is kept in *next.
+ */
+char *tindex_gets (char *buf, int len, FILE *fd, long *cand, long ncand,
+	long *next)
+{
+	if (ncand < 0)
+		return (fgets (buf, len, fd));
+	if (*next >= ncand || fseek (fd, cand[*next], 0) < 0)
+		return (0);
+	++*next;
+	return (fgets (buf, len, fd));
+}
@@ -0,0 +1,38 @@
+/*
+ * Trigram index of the archive index file.
+ *
+ * The file .index.tri is built by lindex next to .index.
+ * For every trigram (three successive bytes of the lowered
+ * file name or description) it keeps the list of the lines
+ * containing it.
+ * Trigrams are hashed into a table of buckets, so a bucket
+ * list may contain extra lines - the index gives the candidate
+ * lines only, and the pattern is still checked on each of them.
+ */
+struct tindex_head {
+	unsigned int magic;             /* TINDEX_MAGIC */
+	unsigned int isize;             /* size of .index */
+	unsigned int imtime;            /* modification time of .index */
+	unsigned int nlines;            /* number of lines */
+	unsigned int nbits;             /* log2 of the number of buckets */
+	unsigned int postsize;          /* length of postings */
+};
+
+typedef struct {
+	char *base;                     /* mapped address */
+	long size;                      /* file length */
+	struct tindex_head *head;       /* header */
+	unsigned int *off;              /* offsets of lines in .index */
+	unsigned int *bucket;           /* start of postings of buckets */
+	unsigned char *post;            /* postings */
+} TINDEX;
+
+#define TINDEX_MAGIC    0x54726932L     /* "Tri2" */
+#define TINDEX_SUFFIX   ".tri"
+
+int tindex_build (char *name);
+TINDEX *tindex_open (char *name, struct stat *st);
+void tindex_close (TINDEX *t);
+long tindex_find (TINDEX *t, char *pattern, long **cand);
+char *tindex_gets (char *buf, int len, FILE *fd, long *cand, long ncand,
+	long *next);
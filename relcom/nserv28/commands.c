@@ -52,6 +52,7 @@
 # include "groups.h"
 # include "header.h"
 # include "lang.h"
+# include "over.h"
 
 # define TMPFNAME "/tmp/NScXXXXXX"
 
@@ -731,6 +732,7 @@ char **av;
 	if (debug)
 		printf ("min=%d (%d)  max=%d (%d)\n", nmin, a->first, 
 			nmax, a->last);
+	overexpire (groupname (group), a->first);
 	for (n=nmax, ndeleted=0; n>=nmin && ndeleted<100; --n)
 		if (! indexarticle (group, n, longflag))
 			++ndeleted;
@@ -881,54 +883,48 @@ doforget ()
 		printf (you_are_not_registered);
 }
 
+/*
+ * Заголовок статьи берется из обзора группы,
+ * спул читается, только если статьи в обзоре нет.
+ */
+
 indexarticle (g, n, longflag)
 long g;
 {
-	char filename [512];
-	register char *p, *s;
-	long size;
-	FILE *fd;
+	register struct overview *ov;
+	char *s;
 
-	strcpy (filename, NEWSSPOOLDIR);
-	p = filename + strlen (filename);
-	*p++ = '/';
 	s = groupname (g);
 	if (! s)
 		return (0);
-	for (; *s; ++s)
-		*p++ = *s=='.' ? '/' : *s;
-	sprintf (p, "/%d", n);
-
-	fd = fopen (filename, "r");
-	if (! fd)
+	ov = overget (s, (long) n);
+	if (! ov)
 		return (0);
-	scanheader (fd);
-	fclose (fd);
-	size = filesize (filename);
 
 	if (longflag) {
 		printf ("Issue: %d\n", n);
-		if (h_subject)
-			printf ("Subject: %s\n", h_subject);
-		if (h_from)
-			printf ("From: %s\n", h_from);
-		printf ("Date: %s\n", canondate (h_date));
-		if (h_message_id)
-			printf ("Message-ID: %s\n", h_message_id);
-		printf ("Size: %s\n", size2a (size));
+		if (*ov->subject)
+			printf ("Subject: %s\n", ov->subject);
+		if (*ov->from)
+			printf ("From: %s\n", ov->from);
+		printf ("Date: %s\n", canondate (*ov->date ? ov->date :
+			(char *) 0));
+		if (*ov->msgid)
+			printf ("Message-ID: %s\n", ov->msgid);
+		printf ("Size: %s\n", size2a (ov->size));
 		printf ("\n");
 	} else {
-		char *sendername = getsendername (h_from);
+		char *sendername = getsendername (ov->from);
 		int len = strlen (sendername);
 
-		printf ("-ART %6d %-4s %-25s ", n, size2a (size),
+		printf ("-ART %6d %-4s %-25s ", n, size2a (ov->size),
 			sendername);
-		if (h_subject)
-			putsubj (h_subject, len<=25 ? 35 : len<60 ? 60-len : 0);
+		if (*ov->subject)
+			putsubj (ov->subject,
+				len<=25 ? 35 : len<60 ? 60-len : 0);
 		else
 			printf ("<none>\n");
 	}
-	freeheader ();
 	return (1);
 }
 
@@ -18,7 +18,8 @@
  * All rights reserved.
  */
 
-extern int MAXARTS;         /* Макс. число рассылаемых статей в одном newnews */
+extern int MAXARTS;         /* Длина таблицы рассылки в памяти, больше - на диск */
+extern int SCANPROCS;       /* Число процессов, просматривающих статьи в newnews */
 extern int MAXNEWGROUPS;    /* Если появилось БОЛЬШЕ новых групп - это ошибка, синхронизуем файлы */
 extern int MAXNEWARTS;      /* Если появилось БОЛЬШЕ статей - признак аварии, синхронизуем файлы  */
 extern int LISTSIZE;        /* Макс. размер листа - килобайт */
@@ -61,6 +62,7 @@ int FEEDTIME            = 60;   /* minutes */
 int NOTIFYTIME          = 360;  /* minutes */
 int BATCHSIZE           = 50;   /* in kilobytes */
 int MAXARTS             = 80000;
+int SCANPROCS           = 4;
 int MAXNEWGROUPS        = 100;
 int MAXNEWARTS          = 12000;
 int LISTSIZE            = 50;
@@ -75,6 +77,7 @@ struct {
 } inttable [] = {
 	"feedlimit",            &FEEDLIMIT,
 	"maxarticles",          &MAXARTS,
+	"scanprocs",            &SCANPROCS,
 	"maxnewgroups",         &MAXNEWGROUPS,
 	"maxnewarticles",       &MAXNEWARTS,
 	"daemondelay",          &DAEMONDELAY,
@@ -21,13 +21,28 @@
  *       тип, 0 - группа, 1 - пользователь
  *
  * Важно, что все теги отличаются от нуля.
+ *
+ * Рядом с базой лежит ее индекс groups.idx (см. sidx.h),
+ * отображаемый в память.  Пока индекс соответствует базе,
+ * выборки по тегу и имени, таблицы подписки групп и
+ * пользователей и списки тегов берутся из него.
+ * Номер последней статьи и флаги пользователя меняются
+ * в индексе на месте.  Любое другое изменение базы
+ * отключает индекс до конца работы; при закрытии базы
+ * он строится заново.  Индекс с неверным штампом файлов
+ * базы или с флагом dirty перестраивается при открытии.
+ * Утилиты проверки и преобразования базы работают
+ * без индекса (groupsnoindex), прямо с записями DBM.
  */
 
 # include <stdio.h>
+# include <sys/types.h>
+# include <sys/stat.h>
 # include <fcntl.h>
 # include "cdbm.h"
 # include "vdbm.h"
 # include "groups.h"
+# include "sidx.h"
 # include "tagdefs.h"
 # include "config.h"
 
@@ -37,12 +52,265 @@
 
 static CDBM *dbf;       /* дескриптор базы данных */
 static char *groupsfile = "groups";
+static char dbname [200];       /* полное имя базы */
+
+static SIDX *idx;       /* индекс базы */
+static int idxstale;    /* индекс отключен, база менялась */
+static int noindex;     /* работа без индекса */
+
+# define INDEXED        (idx && ! idxstale)
+
+static void makeindex (), dropindex ();
+static struct subscrtab *fetchsubscr ();
+static long *subscrgroups ();
+static char *getAddrByTag ();
+static long getValByTag ();
+long *taglist ();
 
 extern errno;
-extern char *malloc (), *mktemp (), *strcpy (), *strcat (), *strncpy ();
-extern char *strchr ();
+extern char *malloc (), *calloc (), *realloc (), *mktemp (), *strcpy ();
+extern char *strcat (), *strncpy (), *strchr (), *bsearch ();
 extern long time ();
 
+static cmptag (a, b)
+register long *a, *b;
+{
+	if (*a != *b)
+		return (*a > *b ? 1 : -1);
+	return (0);
+}
+
+/*
+ * Штамп файлов базы: номер inode, время изменения и длина
+ * основного файла и файла изменений.  Снимается, когда база
+ * закрыта или только что открыта, и запоминается в индексе.
+ */
+
+static void dbstamp (stamp)
+long *stamp;
+{
+	char name [210];
+	struct stat st;
+	int i;
+
+	for (i=0; i<SIDX_STAMP; ++i)
+		stamp [i] = 0;
+	if (stat (dbname, &st) == 0) {
+		stamp [0] = st.st_ino;
+		stamp [1] = st.st_mtime;
+		stamp [2] = st.st_size;
+	}
+	sprintf (name, "%s+", dbname);
+	if (stat (name, &st) == 0) {
+		stamp [3] = st.st_ino;
+		stamp [4] = st.st_mtime;
+		stamp [5] = st.st_size;
+	}
+}
+
+/*
+ * Подключение индекса после открытия базы.
+ * Если индекса нет или он не соответствует базе,
+ * строим новый.
+ */
+
+static void openindex ()
+{
+	long stamp [SIDX_STAMP];
+	char name [210];
+	int i;
+
+	idxstale = 0;
+	sprintf (name, "%s.idx", dbname);
+	idx = sidx_open (name);
+	if (noindex) {
+		/* Индекс не используется, а при закрытии
+		 * строится заново по записям базы. */
+		if (idx) {
+			sidx_touch (idx);
+			idxstale = 1;
+		}
+		return;
+	}
+	if (idx && ! idx->dirty) {
+		dbstamp (stamp);
+		for (i=0; i<SIDX_STAMP; ++i)
+			if (idx->head->stamp [i] != stamp [i])
+				break;
+		if (i >= SIDX_STAMP)
+			return;
+	}
+	if (idx)
+		sidx_close (idx);
+	makeindex ();
+}
+
+/*
+ * Отключение индекса перед изменением базы.
+ * Отображение остается до закрытия базы, так что
+ * выданные раньше указатели не портятся.
+ */
+
+static void dropindex ()
+{
+	if (INDEXED) {
+		sidx_touch (idx);
+		idxstale = 1;
+	}
+}
+
+/*
+ * Добавление куска памяти в растущий буфер.
+ * Возвращает 0, если не хватило памяти.
+ */
+
+static int addbuf (buf, len, size, p, n)
+char **buf, *p;
+long *len, *size, n;
+{
+	while (*len + n > *size) {
+		*size = *size ? *size * 2 : 4096;
+		*buf = realloc (*buf, *size);
+		if (! *buf)
+			return (0);
+	}
+	memcpy (*buf + *len, p, n);
+	*len += n;
+	return (1);
+}
+
+/*
+ * Построение индекса по базе.  На время построения
+ * индекс отключен, все выборки идут через DBM.
+ * Группы и пользователи упорядочиваются по тегу.
+ * Таблица пользователь -> группы получается
+ * обращением таблиц подписки групп.
+ */
+
+static void makeindex ()
+{
+	char name [210], *p, *names;
+	struct sidx_rec *rec, *r, *ur;
+	struct subscrtab *subscr, *s;
+	long *gl, *ul, *up, namelen, namesize, nsubscr, subscrsize, gsubscr;
+	int ng, nu, n, i, k;
+
+	idx = 0;
+	idxstale = 0;
+	names = 0;
+	subscr = 0;
+	namelen = namesize = nsubscr = subscrsize = 0;
+	gl = taglist ('G', &ng);
+	ul = taglist ('U', &nu);
+	rec = (struct sidx_rec *) calloc (ng + nu + 1, sizeof (struct sidx_rec));
+	if (! rec)
+		goto ret;
+	if (ng)
+		qsort ((char *) gl, ng, sizeof (long), cmptag);
+	if (nu)
+		qsort ((char *) ul, nu, sizeof (long), cmptag);
+
+	for (i=0; i<ng+nu; ++i) {
+		r = rec + i;
+		r->tag = i<ng ? gl [i] : ul [i-ng];
+		p = getAddrByTag (r->tag | TAGNAME);
+		if (! p)
+			p = "";
+		r->name = namelen;
+		if (! addbuf (&names, &namelen, &namesize, p, strlen (p) + 1L))
+			goto ret;
+		if (i >= ng) {
+			r->val = getValByTag (r->tag | TAGUFLAGS);
+			continue;
+		}
+		r->val = getValByTag (r->tag | TAGLASTART);
+		s = fetchsubscr (r->tag, &n);
+		r->subscr = nsubscr / sizeof (struct subscrtab);
+		r->nsubscr = n;
+		if (! addbuf ((char **) &subscr, &nsubscr, &subscrsize,
+		    (char *) s, n * (long) sizeof (struct subscrtab)))
+			goto ret;
+	}
+	gsubscr = nsubscr / sizeof (struct subscrtab);
+
+	/* Считаем подписку каждого пользователя */
+	for (k=0; k<gsubscr; ++k) {
+		up = (long *) bsearch ((char *) &subscr[k].tag, (char *) ul,
+			nu, sizeof (long), cmptag);
+		if (up)
+			++rec [ng + (up - ul)].subscr;
+	}
+	n = gsubscr;
+	for (r=rec+ng; r<rec+ng+nu; ++r) {
+		k = r->subscr;
+		r->subscr = n;
+		n += k;
+	}
+	while (n * (long) sizeof (struct subscrtab) > subscrsize) {
+		subscrsize *= 2;
+		subscr = (struct subscrtab *) realloc ((char *) subscr,
+			subscrsize);
+		if (! subscr)
+			goto ret;
+	}
+	nsubscr = n;
+
+	/* Раскладываем подписку групп по пользователям */
+	for (r=rec; r<rec+ng; ++r) {
+		for (k=r->subscr; k<r->subscr+r->nsubscr; ++k) {
+			up = (long *) bsearch ((char *) &subscr[k].tag,
+				(char *) ul, nu, sizeof (long), cmptag);
+			if (! up)
+				continue;
+			ur = rec + ng + (up - ul);
+			s = subscr + ur->subscr + ur->nsubscr++;
+			s->tag = r->tag;
+			s->mode = subscr[k].mode;
+		}
+	}
+
+	sprintf (name, "%s.idx", dbname);
+	if (sidx_write (name, rec, (long) ng, (long) nu, subscr, nsubscr,
+	    names, namelen))
+		idx = sidx_open (name);
+	else
+		error ("cannot write %s", name);
+ret:
+	if (gl)
+		free ((char *) gl);
+	if (ul)
+		free ((char *) ul);
+	if (rec)
+		free ((char *) rec);
+	if (names)
+		free (names);
+	if (subscr)
+		free ((char *) subscr);
+}
+
+/*
+ * Работа без индекса: все выборки идут через DBM.
+ * Вызывается до loadgroups.  Применяется утилитами,
+ * которые проверяют и заполняют сами записи базы,
+ * чтобы не доверять проверяемой базе в виде индекса.
+ */
+
+void groupsnoindex ()
+{
+	noindex = 1;
+}
+
+/*
+ * Выдает 1, если выборки идут через индекс.
+ * Имена, выданные по индексу, не портятся
+ * следующими выборками.
+ */
+
+int groupsindexed ()
+{
+	return (INDEXED);
+}
+
 /*
  * Загрузка базы данных.
  * Причем DBM блокирует базу, чтобы всякие прочие
@@ -62,6 +330,7 @@ int loadgroups (waitflag)
 		strcat (name, "/");
 	}
 	strcat (name, groupsfile);
+	strcpy (dbname, name);
 tryagain:
 	dbf = cdbm_open (name, O_RDWR | O_CREAT, 0664);
 	if (! dbf) {
@@ -76,6 +345,7 @@ tryagain:
 		return (0);
 	}
 	dbf->updatelimit = DFLTLIMIT;
+	openindex ();
 	return (1);
 }
 
@@ -85,9 +355,21 @@ tryagain:
 
 int savegroups ()
 {
+	long stamp [SIDX_STAMP];
+
 	if (dbf) {
+		if (idx && idxstale) {
+			sidx_close (idx);
+			makeindex ();
+		}
 		cdbm_close (dbf);
 		dbf = 0;
+		if (idx) {
+			dbstamp (stamp);
+			sidx_seal (idx, stamp);
+			sidx_close (idx);
+			idx = 0;
+		}
 	}
 	return (1);
 }
@@ -113,11 +395,16 @@ static long getTagByName (typ, name)
 char *name;
 {
 	char buf [200];
+	struct sidx_rec *r;
 	datum key, rez;
 	int len;
 	long tag;
 
 	len = strlen (name);
+	if (INDEXED && len < sizeof (buf)) {
+		r = sidx_name (idx, typ == 'U', name);
+		return (r ? r->tag : 0);
+	}
 	/*
 	 * Если длина имени слишком большая,
 	 * укорачиваем.  Это, конечно, плохо,
@@ -151,8 +438,13 @@ char *name;
 static char *getAddrByTag (tag)
 long tag;
 {
+	struct sidx_rec *r;
 	datum key, rez;
 
+	if (INDEXED && (tag & TAGFLAGMASK) == TAGNAME) {
+		r = sidx_tag (idx, tag & ~TAGFLAGMASK);
+		return (r ? SIDX_NAME (idx, r) : 0);
+	}
 	key.dptr = (char *) &tag;
 	key.dsize = sizeof (tag);
 	rez = cdbm_fetch (dbf, key);
@@ -161,6 +453,22 @@ long tag;
 	return (rez.dptr);
 }
 
+/*
+ * Запись индекса, в которой хранится число по тегу:
+ * номер последней статьи группы или флаги пользователя.
+ */
+
+static struct sidx_rec *valrec (tag)
+long tag;
+{
+	switch (tag & (TAGUSER | TAGFLAGMASK)) {
+	case TAGLASTART:
+	case TAGUSER | TAGUFLAGS:
+		return (sidx_tag (idx, tag & ~TAGFLAGMASK));
+	}
+	return (0);
+}
+
 /*
  * Выборка из базы числа по тегу.  Применяется для
  * выдачи флагов пользователя или номера статьи в группе.
@@ -171,9 +479,12 @@ long tag;
 static long getValByTag (tag)
 long tag;
 {
+	struct sidx_rec *r;
 	datum key, rez;
 	long val;
 
+	if (INDEXED && (r = valrec (tag)))
+		return (r->val);
 	key.dptr = (char *) &tag;
 	key.dsize = sizeof (tag);
 	rez = cdbm_fetch (dbf, key);
@@ -212,6 +523,7 @@ long tag;
 	/*
 	 * Добавляем запись в базу.
 	 */
+	dropindex ();
 	key.dptr = buf;
 	key.dsize = len+2;
 	val.dptr = (char *) &tag;
@@ -231,6 +543,7 @@ char *addr;
 {
 	datum key, val;
 
+	dropindex ();
 	key.dptr = (char *) &tag;
 	key.dsize = sizeof (tag);
 	val.dptr = addr;
@@ -247,8 +560,15 @@ char *addr;
 static putValByTag (tag, v)
 long tag, v;
 {
+	struct sidx_rec *r;
 	datum key, val;
 
+	if (INDEXED) {
+		if (r = valrec (tag))
+			sidx_setval (idx, r, v);
+		else
+			dropindex ();
+	}
 	key.dptr = (char *) &tag;
 	key.dsize = sizeof (tag);
 	val.dptr = (char *) &v;
@@ -268,6 +588,7 @@ long tag;
 {
 	datum key;
 
+	dropindex ();
 	key.dptr = (char *) &tag;
 	key.dsize = sizeof (tag);
 	cdbm_delete (dbf, key);
@@ -298,6 +619,7 @@ char *name;
 	strncpy (buf+1, name, len);
 	buf [len+1] = 0;
 
+	dropindex ();
 	key.dptr = buf;
 	key.dsize = len+2;
 	cdbm_delete (dbf, key);
@@ -344,8 +666,27 @@ int *cnt;
 	long tag;
 	int len, ptr;
 	datum key;
+	struct sidx_rec *r;
 
 	*cnt = ptr = 0;
+	if (INDEXED) {
+		if (typ == 'U') {
+			r = idx->rec + idx->head->ngroups;
+			len = idx->head->nusers;
+		} else {
+			r = idx->rec;
+			len = idx->head->ngroups;
+		}
+		if (! len)
+			return (0);
+		tab = (long *) malloc (len * sizeof (long));
+		if (! tab)
+			return (0);
+		for (ptr=0; ptr<len; ++ptr)
+			tab [ptr] = r[ptr].tag;
+		*cnt = len;
+		return (tab);
+	}
 	len = 512;
 
 	key = cdbm_firstkey (dbf);
@@ -453,12 +794,35 @@ char *name;
 /*
  * Выдает таблицу подписки по тегу группы.
  * В cnt записывает количество пользователей в таблице
- * или 0.
+ * или 0.  Таблицу из индекса менять нельзя, она
+ * отображена только на чтение.
  */
 
 struct subscrtab *groupsubscr (g, cnt)
 long g;
 int *cnt;
+{
+	struct sidx_rec *r;
+
+	if (INDEXED) {
+		r = sidx_tag (idx, g);
+		if (! r || ! r->nsubscr) {
+			*cnt = 0;
+			return (0);     /* нет такого */
+		}
+		*cnt = r->nsubscr;
+		return (SIDX_SUBSCR (idx, r));
+	}
+	return (fetchsubscr (g, cnt));
+}
+
+/*
+ * Выборка таблицы подписки группы из базы.
+ */
+
+static struct subscrtab *fetchsubscr (g, cnt)
+long g;
+int *cnt;
 {
 	datum key, rez;
 
@@ -483,19 +847,13 @@ void groupstat (g, sm, fm, rm)
 long g;
 int *sm, *fm, *rm;
 {
-	datum key, rez;
 	struct subscrtab *s;
 	int cnt;
 
 	*sm = *fm = *rm = 0;
-	g |= TAGSUBSCR;
-	key.dptr = (char *) &g;
-	key.dsize = sizeof (g);
-	rez = cdbm_fetch (dbf, key);
-	if (! rez.dptr)
+	s = groupsubscr (g, &cnt);
+	if (! s)
 		return;
-	cnt = rez.dsize / sizeof (struct subscrtab);
-	s = (struct subscrtab *) rez.dptr;
 	for (; cnt>0; --cnt, ++s) {
 		switch (s->mode) {
 		case 's':       ++*sm;  break;
@@ -523,6 +881,24 @@ long *tab;
 	st = (struct stattab *) calloc (n, sizeof (struct stattab));
 	if (! st)
 		return (0);
+	if (INDEXED) {
+		struct sidx_rec *r;
+
+		for (i=0; i<n; ++i) {
+			r = sidx_tag (idx, tab [i]);
+			if (! r)
+				continue;
+			s = SIDX_SUBSCR (idx, r);
+			for (k=0; k<r->nsubscr; ++k) {
+				switch (s[k].mode) {
+				case 's':       ++st[i].subs;  break;
+				case 'f':       ++st[i].feed;  break;
+				default:        ++st[i].rfeed; break;
+				}
+			}
+		}
+		return (st);
+	}
 	for (g=firstgroup(); g; g=nextgroup(g)) {
 		s = groupsubscr (g, &cnt);
 		if (! s)
@@ -543,6 +919,23 @@ long *tab;
 	return (st);
 }
 
+static void putsubscr (g, mode, s, len, ptr)
+long g;
+struct subscrtab **s;
+int *len, *ptr;
+{
+	if (*ptr >= *len) {
+		*len += 10;
+		*s = (struct subscrtab *) realloc ((char *) *s,
+			*len * sizeof (struct subscrtab));
+		if (! *s)
+			return;
+	}
+	(*s)[*ptr].tag = g;
+	(*s)[*ptr].mode = mode;
+	++*ptr;
+}
+
 static void addsubscr (u, g, s, len, ptr)
 long u, g;
 struct subscrtab **s;
@@ -554,19 +947,54 @@ int *len, *ptr;
 	gs = groupsubscr (g, &ns);
 	if (! gs)
 		return;
-	for (n=0; n<ns; ++n, ++gs)
-		if (gs->tag == u) {
-			if (*ptr >= *len) {
-				*len += 10;
-				*s = (struct subscrtab *) realloc ((char *) *s,
-					*len * sizeof (struct subscrtab));
-				if (! *s)
-					return;
-			}
-			(*s)[*ptr].tag = g;
-			(*s)[*ptr].mode = gs->mode;
-			++*ptr;
+	for (n=0; n<ns && *s; ++n, ++gs)
+		if (gs->tag == u)
+			putsubscr (g, gs->mode, s, len, ptr);
+}
+
+/*
+ * Выдает таблицу подписки пользователя по индексу.
+ * Без фильтра по именам групп таблица берется прямо
+ * из отображения.
+ */
+
+static struct subscrtab *idxusersubscr (u, gtab, cnt, s)
+long u;
+char **gtab;
+int *cnt;
+struct subscrtab **s;
+{
+	struct sidx_rec *r;
+	struct subscrtab *us;
+	int slen, sptr, n;
+
+	r = sidx_tag (idx, u);
+	if (! r || ! r->nsubscr)
+		return (0);
+	us = SIDX_SUBSCR (idx, r);
+	if (! gtab || ! *gtab) {
+		*cnt = r->nsubscr;
+		return (us);
+	}
+	sptr = 0;
+	slen = 10;
+	*s = (struct subscrtab *) malloc (slen * sizeof (struct subscrtab));
+	for (; *gtab && *s; ++gtab) {
+		int len = strlen (*gtab);
+		for (n=0; n<r->nsubscr && *s; ++n) {
+			char *gname = groupname (us[n].tag);
+			if (! gname)
+				continue;
+			if (! strncmp (*gtab, gname, len) &&
+			    gname[len]==0 || gname[len]=='.')
+				putsubscr (us[n].tag, us[n].mode,
+					s, &slen, &sptr);
 		}
+	}
+	if (! *s || ! sptr)
+		return (0);
+	*cnt = sptr;
+	return (*s);
 }
 
 /*
@@ -588,6 +1016,8 @@ int *cnt;
 		s = 0;
 	}
 	*cnt = sptr = 0;
+	if (INDEXED)
+		return (idxusersubscr (u, gtab, cnt, &s));
 	slen = 10;
 	s = (struct subscrtab *) malloc (slen * sizeof (struct subscrtab));
 	if (! s)
@@ -748,6 +1178,7 @@ long u, g;
 	char *p;
 	int n, i;
 
+	dropindex ();           /* таблица меняется на месте */
 	s = groupsubscr (g, &n);
 	for (i=0; i<n; ++i)
 		if (s[i].tag == u) {
@@ -810,6 +1241,7 @@ long u, g;
 	struct subscrtab *s;
 	int n, i;
 
+	dropindex ();           /* таблица меняется на месте */
 	s = groupsubscr (g, &n);
 	if (! s)
 		return (0);
@@ -834,12 +1266,106 @@ long u, g;
 unsubscrall (u)
 long u;
 {
-	long g;
+	long *gl, g;
+	int n, i;
 
+	gl = subscrgroups (&u, 1, &n);
+	if (gl) {
+		for (i=0; i<n; ++i)
+			unsubscribe (u, gl [i]);
+		free ((char *) gl);
+		return;
+	}
 	for (g=firstgroup(); g; g=nextgroup(g))
 		unsubscribe (u, g);
 }
 
+/*
+ * Список групп, на которые подписаны пользователи, по индексу:
+ * теги по возрастанию, без повторов.  Память освобождает
+ * вызывающий.  Если индекса нет, возвращает 0.
+ */
+
+static long *subscrgroups (tab, len, cnt)
+long *tab;
+int len, *cnt;
+{
+	struct sidx_rec *r;
+	struct subscrtab *s;
+	long *gl;
+	int n, i, k;
+
+	if (! INDEXED)
+		return (0);
+	n = 0;
+	for (k=0; k<len; ++k)
+		if (r = sidx_tag (idx, tab [k]))
+			n += r->nsubscr;
+	gl = (long *) malloc ((n + 1) * sizeof (long));
+	if (! gl)
+		return (0);
+	n = 0;
+	for (k=0; k<len; ++k) {
+		r = sidx_tag (idx, tab [k]);
+		if (! r)
+			continue;
+		s = SIDX_SUBSCR (idx, r);
+		for (i=0; i<r->nsubscr; ++i)
+			gl [n++] = s[i].tag;
+	}
+	if (n > 1) {
+		qsort ((char *) gl, n, sizeof (long), cmptag);
+		for (i=0, k=1; k<n; ++k)
+			if (gl [k] != gl [i])
+				gl [++i] = gl [k];
+		n = i + 1;
+	}
+	*cnt = n;
+	return (gl);
+}
+
+/*
+ * Отписать пользователей tab от группы g.
+ * Возвращает 0, если не хватило памяти.
+ */
+
+static int unsubscr1 (g, tab, len, cnttab)
+long g, *tab;
+int len, *cnttab;
+{
+	struct subscrtab *s, *p;
+	int n, i, k, delflag;
+
+	delflag = 0;
+	s = groupsubscr (g, &n);
+	if (! s)
+		return (1);
+	p = (struct subscrtab *) malloc (n * sizeof (struct subscrtab));
+	if (! p) {
+		error ("out of memory in unsubscrtab");
+		return (0);
+	}
+	memcpy ((char *) p, (char *) s, n * sizeof (struct subscrtab));
+	s = p;
+	for (i=0; i<n; ++i) {
+		for (k=0; k<len; ++k)
+			if (s[i].tag == tab[k]) {
+				struct subscrtab *olds = s;
+				int rez = shrinksubscr (&s, --n, i);
+				free ((char *) olds);
+				if (! rez)
+					return (0);
+				++cnttab[k];
+				++delflag;
+			}
+	}
+	if (delflag)
+		putAddrByTag (g | TAGSUBSCR, (char *) s,
+			sizeof (struct subscrtab) * n);
+	free ((char *) s);
+	return (1);
+}
+
 /*
  * Отписать пользователей от всех групп.
  * Возвращает кто на сколько групп был подписан.
@@ -850,10 +1376,9 @@ int *unsubscrtab (tab, len)
 long *tab;
 int len;
 {
-	struct subscrtab *s, *p;
-	int n, i, k, delflag;
 	static int *cnttab;
-	long g;
+	long *gl, g;
+	int n, i, k;
 
 	if (! len)
 		return (0);
@@ -864,39 +1389,28 @@ int len;
 		return (0);
 	for (k=0; k<len; ++k)
 		cnttab [k] = 0;
-	for (g=firstgroup(); g; g=nextgroup(g)) {
-		delflag = 0;
-		s = groupsubscr (g, &n);
-		if (! s)
-			continue;
-		p = (struct subscrtab *) malloc (n * sizeof (struct subscrtab));
-		if (! p) {
-			error ("out of memory in unsubscrtab");
-			free ((char *) cnttab);
-			return (0);
-		}
-		memcpy ((char *) p, (char *) s, n * sizeof (struct subscrtab));
-		s = p;
-		for (i=0; i<n; ++i) {
-			for (k=0; k<len; ++k)
-				if (s[i].tag == tab[k]) {
-					struct subscrtab *olds = s;
-					int rez = shrinksubscr (&s, --n, i);
-					free ((char *) olds);
-					if (! rez) {
-						free ((char *) cnttab);
-						return (0);
-					}
-					++cnttab[k];
-					++delflag;
-				}
-		}
-		if (delflag)
-			putAddrByTag (g | TAGSUBSCR, (char *) s,
-				sizeof (struct subscrtab) * n);
-		free ((char *) s);
+	/*
+	 * По индексу обходим только группы, на которые
+	 * пользователи подписаны, иначе - все группы.
+	 */
+	gl = subscrgroups (tab, len, &n);
+	if (gl) {
+		for (i=0; i<n; ++i)
+			if (! unsubscr1 (gl [i], tab, len, cnttab))
+				break;
+		free ((char *) gl);
+		if (i < n)
+			goto nomem;
+		return (cnttab);
 	}
+	for (g=firstgroup(); g; g=nextgroup(g))
+		if (! unsubscr1 (g, tab, len, cnttab))
+			goto nomem;
 	return (cnttab);
+nomem:
+	free ((char *) cnttab);
+	cnttab = 0;
+	return (0);
 }
 
 long grouplast (tag)
@@ -969,6 +1483,7 @@ char *k;
 {
 	datum key;
 
+	dropindex ();
 	key.dptr = k;
 	key.dsize = sz;
 	cdbm_delete (dbf, key);
@@ -154,6 +154,8 @@ extern void groupsdump (ARGS( int (*) () ));
 extern void groupsdelrec (ARGS2( char *, int ));
 extern void groupslimit (ARGS( int ));
 extern void groupssync (ARGS( void ));
+extern int groupsindexed (ARGS( void ));
+extern void groupsnoindex (ARGS( void ));
 
 extern void setuserflags (ARGS2( long tag, long flags ));
 extern void setsubscr (ARGS3( long g, struct subscrtab *tab, int n ));
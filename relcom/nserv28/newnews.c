@@ -25,6 +25,8 @@
  */
 
 # include <stdio.h>
+# include <sys/types.h>
+# include <sys/mman.h>
 # include <sys/fcntl.h>
 # include "config.h"
 # include "header.h"
@@ -32,10 +34,12 @@
 # include "lang.h"
 # include "lock.h"
 # include "vdbm.h"
+# include "over.h"
 
 # define NADDRPERCMD 30
 
 # define TMPFNAME "/tmp/NSfXXXXXX"
+# define RUNFNAME "/tmp/NSrXXXXXX"
 
 # ifndef FILEMASK
 # define FILEMASK 7
@@ -46,8 +50,23 @@
 # define MPACK  3
 # define MGPACK 4
 
-struct feedtab {
+# define MAXSCANPROCS 32
+
+# define RUNBUF 8192            /* буфер чтения отрезка */
+
+/*
+ * Сведения о статье, общие для всех ее подписчиков.
+ */
+struct artinfo {
 	char *msgid;
+	char *from;             /* адрес отправителя */
+	char *subject;
+	long size;
+	struct artinfo *next;   /* список статей текущего отрезка */
+};
+
+struct feedtab {
+	struct artinfo *art;    /* статья, только в arttab */
 	long user;
 	long group;
 	long issue;
@@ -57,6 +76,47 @@ struct feedtab {
 struct feedtab *arttab;         /* Общая таблица рассылки */
 int nart;
 int arttablen;
+long nsubscr;                   /* Всего записей в таблице рассылки */
+struct artinfo *artlist;        /* Статьи, на которые ссылается arttab */
+
+/*
+ * Когда arttab заполняется (MAXARTS записей), она сортируется
+ * и сбрасывается в файл очередным отрезком.  В конце отрезки
+ * сливаются, так что память не зависит от объема рассылки.
+ */
+FILE *runfd;                    /* Файл отрезков arttab */
+long *runtab;                   /* Начала отрезков в файле */
+int nrun;
+int runtablen;
+char runname[] = RUNFNAME;
+
+/*
+ * Запись отрезка в файле.  За ней идут message-id,
+ * адрес отправителя и тема, через нулевой байт.
+ */
+struct runrec {
+	long user;
+	long group;
+	long issue;
+	long size;
+	short mode;
+	short lmsgid, lfrom, lsubject;  /* длины строк */
+};
+
+# define RUNREC (sizeof (struct runrec) + 3*256)
+
+/*
+ * Отрезок при слиянии: в файле или в памяти (остаток arttab).
+ */
+struct run {
+	long pos, end;          /* непрочитанная часть в файле */
+	char *buf;              /* буфер чтения */
+	int len, ptr;           /* длина данных в буфере, позиция */
+	struct feedtab *p, *q;  /* непрочитанная часть в памяти */
+	struct feedtab cur;     /* текущая запись */
+	struct artinfo art;     /* ее статья, строки в буфере */
+	int eof;                /* отрезок кончился */
+};
 
 struct feedtab *feedtab;        /* Таблица неупакованной рассылки */
 int nfeed;
@@ -70,28 +130,47 @@ struct feedtab *gpacktab;       /* Таблица групповой упак. 
 int ngpack;
 int gpacktablen;
 
+/*
+ * Группа, новые статьи которой нужно разослать.
+ */
+struct scangroup {
+	long group;
+	long first, last;       /* номера новых статей */
+	long low;               /* первая статья в спуле */
+	char *name;             /* имя группы */
+};
+
+/*
+ * Результат просмотра статьи.
+ */
+struct scantab {
+	short found;            /* статья есть в спуле */
+	short done;             /* статья просмотрена */
+	char line [OVLINE];     /* строка обзора */
+};
+
+struct scangroup *sgtab;        /* Таблица групп с новыми статьями */
+int nsg;
+int sgtablen;
+
+int scanmapped;                 /* Результаты в общей памяти */
+int scanchild;                  /* Процесс, просматривающий статьи */
+
 int debug;
 char tmpname[] = TMPFNAME;
 
 VDBM *userdb;
 
 extern char *bsearch (), *strcopy (), *malloc (), *realloc (), *strcpy ();
+extern char *calloc (), *getsendername ();
 extern char *getsendername (), *ctime (), *groupclass (), *groupiclass ();
 extern char *mktemp (), *strncpy (), *strchr ();
 extern long filesize (), time ();
 extern FILE *f2open ();
 
-static cmpmode (a, b)
-register struct feedtab *a, *b;
-{
-	if (a->mode != b->mode)
-		return (a->mode > b->mode ? 1 : -1);
-	if (a->group != b->group)
-		return (a->group > b->group ? 1 : -1);
-	if (a->issue != b->issue)
-		return (a->issue > b->issue ? 1 : -1);
-	return (0);
-}
+static struct scantab *scanarticles ();
+static char *groupdir ();
+static int freescan (), scanpart ();
 
 static cmpfeedtab (a, b)
 register struct feedtab *a, *b;
@@ -118,7 +197,7 @@ register struct feedtab *a, *b;
 {
 	int rez;
 
-	rez = strcmp (a->msgid, b->msgid);
+	rez = strcmp (a->art->msgid, b->art->msgid);
 	if (rez)
 		return (rez);
 	if (a->user != b->user)
@@ -160,6 +239,8 @@ long u;
 {
 	vdatum key, rez;
 
+	if (! userdb)
+		return (username (u));
 	key.dptr = (char *) &u;
 	key.dsize = sizeof (u);
 	rez = vdbm_fetch (userdb, key);
@@ -198,6 +279,7 @@ usage:          fprintf (stderr, "usage: %s [config]\n", argv [0]);
 		exit (-1);
 	}
 	mktemp (tmpname);
+	mktemp (runname);
 
 	setlang (sudomain (MYDOMAIN) ? 'r' : 'l');
 
@@ -221,19 +303,6 @@ usage:          fprintf (stderr, "usage: %s [config]\n", argv [0]);
 		quit ();
 	}
 
-	/* Build in-core table of user names */
-	userdb = vdbm_open (0);
-	if (! userdb) {
-		error ("cannot create VDBM user database");
-		quit ();
-	}
-	for (u=firstuser(); u; u=nextuser(u)) {
-		char *uname = username (u);
-		if (! uname)
-			continue;
-		storeuser (u, uname);
-	}
-
 	/* Make /usr/spool/newsserv/newgroups - new groups */
 	if (debug)
 		printf ("Making list of new groups\n");
@@ -249,6 +318,24 @@ usage:          fprintf (stderr, "usage: %s [config]\n", argv [0]);
 		printf ("Updating list of groups\n");
 	updategroups ();
 
+	/*
+	 * Build in-core table of user names, unless the groups
+	 * index is mapped: its names stay valid till the end.
+	 */
+	if (! groupsindexed ()) {
+		userdb = vdbm_open (0);
+		if (! userdb) {
+			error ("cannot create VDBM user database");
+			quit ();
+		}
+		for (u=firstuser(); u; u=nextuser(u)) {
+			char *uname = username (u);
+			if (! uname)
+				continue;
+			storeuser (u, uname);
+		}
+	}
+
 	arttab = (struct feedtab *) malloc (sizeof (struct feedtab));
 	feedtab = (struct feedtab *) malloc (sizeof (struct feedtab));
 	packtab = (struct feedtab *) malloc (sizeof (struct feedtab));
@@ -274,22 +361,16 @@ usage:          fprintf (stderr, "usage: %s [config]\n", argv [0]);
 		printf ("Creating table of new articles\n");
 	mknewarticles ();
 
-	/* Remove cross-posted articles from list */
-	nocrosspost ();
-	messg ("detected %d unique message-ids", nart);
-
-	/* Sort articles by (1) subscription mode, (2) group, (3) issue. */
-	if (nart)
-		qsort ((char *) arttab, nart, sizeof (struct feedtab), cmpmode);
-
-	/* Update /usr/spool/newsserv/newarticles - list of arrived articles */
+	/*
+	 * Merge runs of arttab, removing cross-posted articles.
+	 * Append /usr/spool/newsserv/newX - lists of arrived articles,
+	 * split the rest into feedtab, packtab, gpacktab.
+	 */
 	if (debug)
 		printf ("Appending list of new articles\n");
-	updatenewarts ();
+	mergearts ();
+	messg ("detected %d unique message-ids", nart);
 	messg ("list of new articles updated");
-
-	/* Split arttab into feedtab, packtab, gpacktab */
-	splittab ();
 	free ((char *) arttab);
 	arttab = 0;
 	arttablen = 0;
@@ -351,6 +432,8 @@ locknewnews ()
 
 quit ()
 {
+	if (scanchild)
+		_exit (-1);
 	savegroups ();
 	exit (-1);
 }
@@ -486,11 +569,14 @@ updategroups ()
 
 mknewarticles ()
 {
-	long g, last, olast, totalnew, n;
+	long g, last, olast, totalnew, nscan, k, n;
 	int ns, nused;
 	struct activetab *a;
 	char *name;
 	struct subscrtab *s, *ss;
+	struct scangroup *sg;
+	struct scantab *scan;
+	struct overview *ov;
 
 	/*
 	 * Подсчитываем общее число новых статей.
@@ -525,7 +611,11 @@ mknewarticles ()
 		return;
 	}
 	messg ("total %ld new articles", totalnew);
-	nused = 0;
+
+	/*
+	 * Составляем список групп, у которых есть подписчики.
+	 */
+	nscan = 0;
 	for (g=firstgroup(); g; g=nextgroup(g)) {
 		name = groupname (g);
 		if (! name)
@@ -539,12 +629,43 @@ mknewarticles ()
 			olast = 0;
 		if (last <= olast)
 			continue;
-		s = groupsubscr (g, &ns);
+		groupsubscr (g, &ns);
 		if (! ns) {
 			if (last != olast)
 				setgrouplast (g, last);
 			continue;
 		}
+		if (nsg >= sgtablen) {
+			sgtablen += 64;
+			sgtab = (struct scangroup *) (sgtab ?
+				realloc ((char *) sgtab, (unsigned) (sgtablen *
+				sizeof (struct scangroup))) :
+				malloc ((unsigned) (sgtablen *
+				sizeof (struct scangroup))));
+			if (! sgtab) {
+				error ("out of memory in mknewarticles");
+				quit ();
+			}
+		}
+		sg = &sgtab[nsg++];
+		sg->group = g;
+		sg->first = olast + 1;
+		sg->last = last;
+		sg->low = a->first;
+		sg->name = strcopy (name);
+		nscan += last - olast;
+	}
+
+	/*
+	 * Просматриваем статьи всех групп сразу, затем
+	 * по порядку заносим их в обзор и раскладываем
+	 * по подписчикам.
+	 */
+	scan = nscan ? scanarticles (nscan) : 0;
+	nused = 0;
+	for (sg=sgtab, k=0; sg<sgtab+nsg; k+=sg->last-sg->first+1, ++sg) {
+		g = sg->group;
+		s = groupsubscr (g, &ns);
 		ss = (struct subscrtab *) malloc (ns *
 			sizeof (struct subscrtab));
 		if (! ss) {
@@ -555,53 +676,201 @@ mknewarticles ()
 		memcpy (ss, s, ns * sizeof (struct subscrtab));
 		s = ss;
 		if (debug)
-			printf ("Group %s %d..%d x%d\n", groupname (g),
-				olast+1, last, ns);
-		for (n=olast+1; n<=last && nart<MAXARTS; ++n, ++nused)
-			storeinfo (g, n, s, ns);
+			printf ("Group %s %d..%d x%d\n", sg->name,
+				sg->first, sg->last, ns);
+		overexpire (sg->name, sg->low);
+		for (n=sg->first; n<=sg->last; ++n, ++nused) {
+			if (! scan)
+				ov = overget (sg->name, n);
+			else if (scan[k+n-sg->first].found)
+				ov = overput (sg->name, scan[k+n-sg->first].line);
+			else
+				ov = 0;
+			if (ov)
+				storeinfo (g, n, s, ns, ov);
+		}
 		setgrouplast (g, n-1);
 		free ((char *) s);
 	}
+	if (scan)
+		freescan (scan, nscan);
+	for (sg=sgtab; sg<sgtab+nsg; ++sg)
+		free (sg->name);
+	nsg = 0;
 	messg ("%d articles used", nused);
-	messg ("total %d subscriptions", nart);
+	messg ("total %ld subscriptions", nsubscr);
 }
 
-nocrosspost ()
-{
-	register struct feedtab *fp, *fq;
+/*
+ * Сброс arttab на диск очередным отрезком.  Отрезок сортируется
+ * по (1) message ID, (2) user, (3) rev. mode; статьи, на которые
+ * ссылались его записи, освобождаются.
+ */
 
-	if (! nart)
-		return;
+spillarts ()
+{
+	register struct feedtab *p;
 
-	/* Sort articles by (1) message ID, (2) user, (3) rev. mode. */
+	if (! runfd) {
+		runfd = fopen (runname, "w+");
+		if (! runfd) {
+			error ("cannot create %s", runname);
+			quit ();
+		}
+		unlink (runname);
+	}
+	if (nrun >= runtablen) {
+		runtablen += 16;
+		runtab = (long *) (runtab ? realloc ((char *) runtab,
+			(unsigned) (runtablen * sizeof (long))) :
+			malloc ((unsigned) (runtablen * sizeof (long))));
+		if (! runtab) {
+			error ("out of memory in spillarts");
+			quit ();
+		}
+	}
+	runtab [nrun++] = ftell (runfd);
 	qsort ((char *) arttab, nart, sizeof (struct feedtab), cmpmsgid);
-
-	/* Delete articles with the same msgID and user (cross-postings). */
-	for (fq=arttab, fp=fq+1; fp<arttab+nart; ++fp) {
-		if (fp->user==fq->user && !strcmp (fp->msgid, fq->msgid))
-			continue;
-		++fq;
-		if (fp == fq)
-			continue;
-		/* DON'T free message-id, it can be cross-referenced
-		 * free (fq->msgid);
-		 */
-		*fq = *fp;
+	for (p=arttab; p<arttab+nart; ++p)
+		putrun (p);
+	if (fflush (runfd) == EOF || ferror (runfd)) {
+		error ("cannot write %s", runname);
+		quit ();
 	}
-	nart = fq - arttab + 1;
 	if (debug)
-		printf ("Detected %d unique message-ids\n", nart);
+		printf ("Run %d: %d subscriptions\n", nrun, nart);
+	nart = 0;
+	freearts ();
 }
 
-updatenewarts ()
+/*
+ * Запись в файл отрезков.
+ */
+
+putrun (p)
+register struct feedtab *p;
 {
-	FILE *fd [FILEMASK+1];
-	char artfname [16];
-	register struct feedtab *p, *q;
+	struct runrec r;
+
+	r.user = p->user;
+	r.group = p->group;
+	r.issue = p->issue;
+	r.size = p->art->size;
+	r.mode = p->mode;
+	r.lmsgid = strlen (p->art->msgid);
+	r.lfrom = strlen (p->art->from);
+	r.lsubject = strlen (p->art->subject);
+	fwrite ((char *) &r, sizeof (r), 1, runfd);
+	fwrite (p->art->msgid, r.lmsgid + 1, 1, runfd);
+	fwrite (p->art->from, r.lfrom + 1, 1, runfd);
+	fwrite (p->art->subject, r.lsubject + 1, 1, runfd);
+}
+
+/*
+ * Следующая запись отрезка в r->cur.
+ * Возвращает 0, если отрезок кончился.
+ */
+
+runnext (r)
+register struct run *r;
+{
+	struct runrec h;
+	register char *p;
 	int n;
 
-	if (! nart)
+	if (! r->buf) {
+		/* отрезок в памяти */
+		if (r->p >= r->q)
+			return (0);
+		r->cur = *r->p++;
+		return (1);
+	}
+	if (r->len - r->ptr < RUNREC && r->pos < r->end) {
+		/* запись может не уместиться - дочитываем буфер */
+		n = r->len - r->ptr;
+		memcpy (r->buf, r->buf + r->ptr, n);
+		r->len = RUNBUF - n;
+		if (r->len > r->end - r->pos)
+			r->len = r->end - r->pos;
+		fseek (runfd, r->pos, 0);
+		if (fread (r->buf + n, 1, r->len, runfd) != r->len) {
+			error ("cannot read %s", runname);
+			quit ();
+		}
+		r->pos += r->len;
+		r->len += n;
+		r->ptr = 0;
+	}
+	if (r->ptr >= r->len)
+		return (0);
+	p = r->buf + r->ptr;
+	memcpy ((char *) &h, p, sizeof (h));
+	p += sizeof (h);
+	r->cur.art = &r->art;
+	r->cur.user = h.user;
+	r->cur.group = h.group;
+	r->cur.issue = h.issue;
+	r->cur.mode = h.mode;
+	r->art.size = h.size;
+	r->art.msgid = p;
+	p += h.lmsgid + 1;
+	r->art.from = p;
+	p += h.lfrom + 1;
+	r->art.subject = p;
+	p += h.lsubject + 1;
+	r->ptr = p - r->buf;
+	return (1);
+}
+
+/*
+ * Слияние отрезков arttab: сброшенных на диск и остатка в памяти.
+ * Записи идут по (1) message ID, (2) user, (3) rev. mode; из записей
+ * с одинаковыми message ID и пользователем (кросс-постинги) берем
+ * первую.  Записи в режиме MSUBS сразу дописываем в списки новых
+ * статей newX, остальные раскладываем по feedtab, packtab, gpacktab.
+ * В nart остается число оставшихся записей.
+ */
+
+mergearts ()
+{
+	FILE *fd [FILEMASK+1];
+	char artfname [16], lastmsgid [256];
+	register struct run *r, *rmin;
+	struct run *rtab;
+	struct feedtab f;
+	long total, lastuser;
+	int nr, n;
+
+	nr = nrun + (nart > 0);
+	if (! nr)
 		return;
+	rtab = (struct run *) calloc ((unsigned) nr, sizeof (struct run));
+	if (! rtab) {
+		error ("out of memory in mergearts");
+		quit ();
+	}
+	if (nrun)
+		total = ftell (runfd);
+	for (n=0; n<nrun; ++n) {
+		r = &rtab[n];
+		r->pos = runtab [n];
+		r->end = n+1<nrun ? runtab [n+1] : total;
+		r->buf = malloc (RUNBUF);
+		if (! r->buf) {
+			error ("out of memory in mergearts");
+			quit ();
+		}
+	}
+	if (nart) {
+		/* Sort by (1) message ID, (2) user, (3) rev. mode. */
+		qsort ((char *) arttab, nart, sizeof (struct feedtab), cmpmsgid);
+		r = &rtab[nrun];
+		r->p = arttab;
+		r->q = arttab + nart;
+	}
+	for (r=rtab; r<rtab+nr; ++r)
+		r->eof = ! runnext (r);
+
 	new_lock();
 	for (n=0; n<=FILEMASK; ++n) {
 		strcpy (artfname, "newX");
@@ -612,10 +881,31 @@ updatenewarts ()
 			quit ();
 		}
 	}
-	for (p=arttab; p<arttab+nart && p->mode==MSUBS; p=q) {
-		for (q=p+1; q<arttab+nart && q->mode==MSUBS &&
-			p->group==q->group && p->issue==q->issue; ++q);
-		storeart (p->group, p->issue, p, q, fd);
+	nart = 0;
+	lastuser = 0;
+	*lastmsgid = 0;
+	for (;;) {
+		rmin = 0;
+		for (r=rtab; r<rtab+nr; ++r)
+			if (! r->eof && (! rmin ||
+			    cmpmsgid (&r->cur, &rmin->cur) < 0))
+				rmin = r;
+		if (! rmin)
+			break;
+		f = rmin->cur;
+		if (f.user != lastuser || strcmp (f.art->msgid, lastmsgid)) {
+			/* DON'T free message-id, it can be cross-referenced */
+			lastuser = f.user;
+			strcpy (lastmsgid, f.art->msgid);
+			++nart;
+			if (f.mode == MSUBS)
+				storeart (&f, fd);
+			else {
+				f.art = 0;
+				addtab (&f, f.mode);
+			}
+		}
+		rmin->eof = ! runnext (rmin);
 	}
 	for (n=0; n<=FILEMASK; ++n) {
 		if (ftell (fd [n]) == 0) {
@@ -627,6 +917,34 @@ updatenewarts ()
 		fclose (fd [n]);
 	}
 	new_unlock();
+
+	for (r=rtab; r<rtab+nrun; ++r)
+		free (r->buf);
+	free ((char *) rtab);
+	if (runfd)
+		fclose (runfd);
+	runfd = 0;
+	freearts ();
+	if (debug)
+		printf ("Detected %d unique message-ids\n", nart);
+}
+
+/*
+ * Освобождение статей, на которые ссылалась arttab.
+ */
+
+freearts ()
+{
+	register struct artinfo *a;
+
+	while (artlist) {
+		a = artlist;
+		artlist = a->next;
+		free (a->msgid);
+		free (a->from);
+		free (a->subject);
+		free ((char *) a);
+	}
 }
 
 addtab (p, mode)
@@ -639,7 +957,7 @@ struct feedtab *p;
 			feedtab = (struct feedtab *) realloc ((char *) feedtab,
 				(unsigned) (feedtablen * sizeof (struct feedtab)));
 			if (! feedtab) {
-				error ("out of memory in splittab (feed)");
+				error ("out of memory in addtab (feed)");
 				return;
 			}
 		}
@@ -652,7 +970,7 @@ struct feedtab *p;
 			packtab = (struct feedtab *) realloc ((char *) packtab,
 				(unsigned) (packtablen * sizeof (struct feedtab)));
 			if (! packtab) {
-				error ("out of memory in splittab (pack)");
+				error ("out of memory in addtab (pack)");
 				return;
 			}
 		}
@@ -665,7 +983,7 @@ struct feedtab *p;
 			gpacktab = (struct feedtab *) realloc ((char *) gpacktab,
 				(unsigned) (gpacktablen * sizeof (struct feedtab)));
 			if (! gpacktab) {
-				error ("out of memory in splittab (gpack)");
+				error ("out of memory in addtab (gpack)");
 				return;
 			}
 		}
@@ -675,71 +993,44 @@ struct feedtab *p;
 	}
 }
 
-splittab ()
-{
-	register struct feedtab *p;
-
-	for (p=arttab; p<arttab+nart; ++p)
-		switch (p->mode) {
-		case MFEED:
-		case MPACK:
-		case MGPACK:
-			addtab (p, p->mode);
-			break;
-		}
-}
+/*
+ * Запись о статье в список новых статей для notify:
+ * Кому
+ * Группа
+ * Номер статьи
+ * Обьем статьи
+ * ИД
+ * От кого
+ * Тема
+ */
 
-storeart (g, n, p, q, fd)
-long g, n;
-struct feedtab *p, *q;
+storeart (p, fd)
+register struct feedtab *p;
 FILE **fd;
 {
-	char from [256];
-	char subject [512];
-	char *fromaddr, *gname;
-	long size;
+	char *unam, *up, *gname;
+	int findex;
 
-	if (! scanarticle (g, n, from, subject, &size, (char *) 0))
-		return;
-	gname = groupname (g);
+	unam = fetchuser (p->user);
+	gname = groupname (p->group);
 	if (! gname)
 		return;
-	gname = strcopy (gname);
-	fromaddr = getsendername (from);
+	if (! unam) {
+		error ("null user name 0x%x (group %s, art %d)",
+			p->user, gname, p->issue);
+		return;
+	}
 	/*
-	 * Режим уведомления:
-	 * Кому
-	 * Группа
-	 * Номер статьи
-	 * Обьем статьи
-	 * ИД
-	 * От кого
-	 * Тема
+	 * Так как распределение по именам очень неоднородно,
+	 * попытаемся раскидать по именам машин дополнительно
 	 */
-	for (; p<q; ++p) {
-		char *unam = fetchuser (p->user);
-		char *up;
-		int findex;
-
-		if (! unam) {
-			error ("null user name 0x%x (group %s, art %d)",
-				p->user, gname, n);
-			continue;
-		}
-		/*
-		 * Так как распределение по именам очень неоднородно,
-		 * попытаемся раскидать по именам машин дополнительно
-		 */
-		findex = unam[0];
-		up = strchr (unam, '@');
-		if (up && up [1])
-			findex += up [1];
-		fprintf (fd [findex & FILEMASK],
-			"%s %s %ld %ld %s %s\n", unam,
-			gname, n, size, fromaddr, subject);
-	}
-	free (gname);
-	free (fromaddr);
+	findex = unam[0];
+	up = strchr (unam, '@');
+	if (up && up [1])
+		findex += up [1];
+	fprintf (fd [findex & FILEMASK],
+		"%s %s %ld %ld %s %s\n", unam,
+		gname, p->issue, p->art->size, p->art->from, p->art->subject);
 }
 
 sendgpack ()
@@ -955,20 +1246,123 @@ sendfeed ()
 	free (buf);
 }
 
-storeinfo (g, artnum, s, ns)
+/*
+ * Просмотр новых статей групп из sgtab параллельно SCANPROCS
+ * процессами.  Процессы берут статьи списка через одну и пишут
+ * результат в общую память на место статьи в списке, так что он
+ * не зависит от того, кто и когда просмотрел статью.  Статьи,
+ * оставшиеся непросмотренными (не удался fork, процесс убит),
+ * досматриваем сами.  Возвращает таблицу результатов или 0.
+ */
+
+static struct scantab *scanarticles (nscan)
+long nscan;
+{
+	struct scantab *tab;
+	int nprocs, nchild, k, status;
+
+	nprocs = SCANPROCS;
+	if (nprocs > MAXSCANPROCS)
+		nprocs = MAXSCANPROCS;
+	if (nprocs > nscan)
+		nprocs = nscan;
+	tab = 0;
+	scanmapped = 0;
+# ifdef MAP_ANON
+	if (nprocs > 1) {
+		tab = (struct scantab *) mmap ((char *) 0,
+			nscan * sizeof (struct scantab),
+			PROT_READ | PROT_WRITE, MAP_ANON | MAP_SHARED, -1, 0L);
+		if (tab == (struct scantab *) -1)
+			tab = 0;
+		else
+			scanmapped = 1;
+	}
+# endif
+	if (! tab) {
+		tab = (struct scantab *) calloc ((unsigned) nscan,
+			sizeof (struct scantab));
+		if (! tab)
+			return (0);
+		nprocs = 1;
+	}
+	if (debug)
+		printf ("Scanning %ld articles by %d processes\n",
+			nscan, nprocs);
+	nchild = 0;
+	if (nprocs > 1) {
+		fflush (stdout);
+		for (k=0; k<nprocs; ++k) {
+			switch (fork ()) {
+			case -1:
+				continue;
+			case 0:
+				scanchild = 1;
+				scanpart (tab, k, nprocs);
+				_exit (0);
+			}
+			++nchild;
+		}
+		while (nchild > 0 && wait (&status) != -1)
+			--nchild;
+	}
+	scanpart (tab, 0, 1);
+	return (tab);
+}
+
+static freescan (tab, nscan)
+struct scantab *tab;
+long nscan;
+{
+# ifdef MAP_ANON
+	if (scanmapped) {
+		munmap ((char *) tab, nscan * sizeof (struct scantab));
+		return;
+	}
+# endif
+	free ((char *) tab);
+}
+
+/*
+ * Просмотр k-й из каждых nprocs статей списка.
+ * Базу групп и обзоры не трогаем: процессы делят
+ * их дескрипторы.
+ */
+
+static scanpart (tab, k, nprocs)
+register struct scantab *tab;
+{
+	register struct scangroup *sg;
+	char filename [512];
+	long n, i;
+
+	i = 0;
+	for (sg=sgtab; sg<sgtab+nsg; ++sg)
+		for (n=sg->first; n<=sg->last; ++n, ++i) {
+			if (i % nprocs != k || tab[i].done)
+				continue;
+			groupdir (sg->name, filename);
+			sprintf (filename + strlen (filename), "/%ld", n);
+			tab[i].found = overscan (filename, n, tab[i].line);
+			tab[i].done = 1;
+		}
+}
+
+storeinfo (g, artnum, s, ns, ov)
 long g, artnum;
 struct subscrtab *s;
 int ns;
+struct overview *ov;
 {
 	int feedlimit, n;
-	char msgid [256], *msgidptr;
+	char *msgid;
+	struct artinfo *art;
 	long size;
 
 	if (! ns)
 		return;
-	*msgid = 0;
-	if (! scanarticle (g, artnum, (char *) 0, (char *) 0, &size, msgid))
-		return;
+	msgid = ov->msgid;
+	size = ov->size;
 	if (*msgid != '<')
 	{
 		if (*msgid)
@@ -979,7 +1373,19 @@ int ns;
 				groupname (g), artnum);
 		return;
 	}
-	msgidptr = strcopy (msgid);
+	if (nart + ns > MAXARTS && nart)
+		spillarts ();
+	art = (struct artinfo *) malloc (sizeof (struct artinfo));
+	if (! art) {
+		error ("out of memory in storeinfo");
+		return;
+	}
+	art->msgid = strcopy (msgid);
+	art->from = getsendername (ov->from);
+	art->subject = strcopy (ov->subject);
+	art->size = size;
+	art->next = artlist;
+	artlist = art;
 	for (n=0; n<ns; ++n, ++s) {
 		switch (s->mode) {
 		default:        continue;
@@ -1013,7 +1419,7 @@ int ns;
 		 * 4) Номер статьи
 		 * 5) Режим подписки
 		 */
-		arttab[nart].msgid = msgidptr;
+		arttab[nart].art = art;
 		arttab[nart].user = s->tag;
 		arttab[nart].group = g;
 		arttab[nart].issue = artnum;
@@ -1026,55 +1432,25 @@ int ns;
 		else
 			arttab[nart].mode = MPACK;
 		++nart;
+		++nsubscr;
 	}
 }
 
-scanarticle (g, n, from, subj, size, msgid)
-long g, n;
-char *from, *subj, *msgid;
-long *size;
+/*
+ * Имя каталога группы в спуле новостей.
+ */
+
+static char *groupdir (name, buf)
+register char *name;
+char *buf;
 {
-	char filename [512];
-	register char *p, *s;
-	FILE *fd;
+	register char *p;
 
-	strcpy (filename, NEWSSPOOLDIR);
-	p = filename + strlen (filename);
+	strcpy (buf, NEWSSPOOLDIR);
+	p = buf + strlen (buf);
 	*p++ = '/';
-	for (s=groupname(g); *s; ++s)
-		*p++ = *s=='.' ? '/' : *s;
-	sprintf (p, "/%ld", n);
-
-	fd = fopen (filename, "r");
-	if (! fd)
-		return (0);     /* article is already expired */
-
-	if (from)
-		*from = 0;
-	if (subj)
-		*subj = 0;
-	scanheader (fd);
-
-	if (from) {
-		if (h_from)
-			strncpy (from, h_from, 255), from [255] = 0;
-		else if (h_reply_to)
-			strncpy (from, h_reply_to, 255), from [255] = 0;
-		else if (h_resent_from)
-			strncpy (from, h_resent_from, 255), from [255] = 0;
-		else if (h_sender)
-			strncpy (from, h_sender, 255), from [255] = 0;
-	}
-	if (subj && h_subject)
-		strncpy (subj, h_subject, 255), subj [255] = 0;
-
-	if (msgid)
-		*msgid = 0;
-	if (h_message_id && msgid)
-		strncpy (msgid, h_message_id, 255), msgid [255] = 0;
-
-	*size = filesize (filename);
-	freeheader ();
-	fclose (fd);
-	return (1);
+	for (; *name; ++name)
+		*p++ = *name=='.' ? '/' : *name;
+	*p = 0;
+	return (buf);
 }
@@ -67,6 +67,7 @@ char **argv;
 		if (verbose)
 			printf ("Using file %s\n", *argv);
 	}
+	groupsnoindex ();
 loop:	switch (loadgroups (0)) {
 	case -1:
 		if (verbose)
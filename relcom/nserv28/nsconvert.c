@@ -77,6 +77,7 @@ char **argv;
 		if (verbose)
 			printf ("%s opened\n", txtfile);
 	}
+	groupsnoindex ();
 loop:	switch (loadgroups (0)) {
 	case -1:
 		printf ("Groups database locked, waiting...\n");
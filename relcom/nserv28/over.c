@@ -0,0 +1,363 @@
+/*
+ * Обзор статей группы: кэш заголовков.
+ *
+ * В памяти держится обзор одной группы, последней, к которой
+ * обращались: таблица записей, индексированная номером статьи.
+ * Номера статей группы идут подряд, так что таблица плотная.
+ * Файл обзора открывается на дописывание один раз на группу.
+ */
+# include <stdio.h>
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include "config.h"
+# include "header.h"
+# include "over.h"
+
+# define OVDIR  "over"                  /* подкаталог SERVDIR */
+
+static char *ovgroup;                   /* группа, обзор которой загружен */
+static struct overview **ovtab;         /* записи по номеру статьи - ovbase */
+static long ovbase;                     /* номер статьи ovtab [0] */
+static long ovlen;                      /* длина ovtab */
+static int ovfd = -1;                   /* файл обзора, на дописывание */
+
+extern char *malloc (), *calloc (), *strcopy (), *strcpy (), *strchr ();
+extern void free ();
+
+/*
+ * Имя файла обзора группы.
+ */
+
+static char *overname (gname, buf)
+char *gname, *buf;
+{
+	sprintf (buf, "%s/%s/%s", SERVDIR, OVDIR, gname);
+	return (buf);
+}
+
+/*
+ * Разбор строки обзора.  Запись и копия строки занимают
+ * один кусок памяти.  Испорченную строку отвергаем.
+ */
+
+static struct overview *overparse (line)
+char *line;
+{
+	register struct overview *ov;
+	register char *p;
+	char **field [4];
+	int i;
+
+	ov = (struct overview *) malloc ((unsigned) (sizeof (struct overview) +
+		strlen (line) + 1));
+	if (! ov)
+		return (0);
+	p = strcpy ((char *) (ov + 1), line);
+	if (sscanf (p, "%ld\t%ld\t%ld\t", &ov->num, &ov->size,
+	    &ov->body) != 3 || ov->num <= 0)
+		goto bad;
+	for (i=0; i<3; ++i) {
+		p = strchr (p, '\t');
+		if (! p)
+			goto bad;
+		++p;
+	}
+	field [0] = &ov->msgid;
+	field [1] = &ov->from;
+	field [2] = &ov->date;
+	field [3] = &ov->subject;
+	for (i=0; i<4; ++i) {
+		*field [i] = p;
+		while (*p && *p!='\t' && *p!='\n')
+			++p;
+		if (i < 3 && *p != '\t')
+			goto bad;
+		*p++ = 0;
+	}
+	return (ov);
+bad:
+	free ((char *) ov);
+	return (0);
+}
+
+/*
+ * Занесение записи в таблицу.  Таблица растет в ту сторону,
+ * куда вышел номер статьи, не меньше чем вдвое.
+ */
+
+static int overstore (ov)
+register struct overview *ov;
+{
+	register struct overview **tab;
+	long base, end, i;
+
+	if (! ovtab || ov->num < ovbase || ov->num >= ovbase + ovlen) {
+		if (! ovtab) {
+			base = ov->num;
+			end = ov->num + 64;
+		} else if (ov->num < ovbase) {
+			base = ov->num;
+			if (base > ovbase - ovlen)
+				base = ovbase - ovlen;
+			if (base < 1)
+				base = 1;
+			end = ovbase + ovlen;
+		} else {
+			base = ovbase;
+			end = ov->num + 1;
+			if (end < ovbase + 2 * ovlen)
+				end = ovbase + 2 * ovlen;
+		}
+		tab = (struct overview **) calloc ((unsigned) (end - base),
+			sizeof (struct overview *));
+		if (! tab)
+			return (0);
+		for (i=0; i<ovlen; ++i)
+			tab [ovbase - base + i] = ovtab [i];
+		if (ovtab)
+			free ((char *) ovtab);
+		ovtab = tab;
+		ovbase = base;
+		ovlen = end - base;
+	}
+	tab = ovtab + ov->num - ovbase;
+	if (*tab)
+		free ((char *) *tab);
+	*tab = ov;
+	return (1);
+}
+
+/*
+ * Освобождение обзора текущей группы.
+ */
+
+static void overfree ()
+{
+	long i;
+
+	if (ovfd >= 0)
+		close (ovfd);
+	ovfd = -1;
+	for (i=0; i<ovlen; ++i)
+		if (ovtab [i])
+			free ((char *) ovtab [i]);
+	if (ovtab)
+		free ((char *) ovtab);
+	ovtab = 0;
+	ovbase = ovlen = 0;
+	if (ovgroup)
+		free (ovgroup);
+	ovgroup = 0;
+}
+
+/*
+ * Загрузка обзора группы, если он еще не в памяти.
+ */
+
+static void overload (gname)
+char *gname;
+{
+	register struct overview *ov;
+	char name [512], line [OVLINE+2];
+	FILE *fd;
+
+	if (ovgroup && ! strcmp (ovgroup, gname))
+		return;
+	overfree ();
+	ovgroup = strcopy (gname);
+	fd = fopen (overname (gname, name), "r");
+	if (! fd)
+		return;
+	while (fgets (line, sizeof (line), fd)) {
+		ov = overparse (line);
+		if (ov && ! overstore (ov))
+			free ((char *) ov);
+	}
+	fclose (fd);
+}
+
+/*
+ * Дописывание строки в файл обзора текущей группы.
+ * Строка пишется одним вызовом write, так что строки
+ * от разных процессов не перемешиваются.
+ */
+
+static void overappend (line)
+char *line;
+{
+	char name [512];
+
+	if (ovfd < 0) {
+		overname (ovgroup, name);
+		ovfd = open (name, O_WRONLY | O_APPEND | O_CREAT, 0664);
+		if (ovfd < 0) {
+			/* нет каталога обзоров - создаем */
+			sprintf (name, "%s/%s", SERVDIR, OVDIR);
+			mkdir (name, 0775);
+			overname (ovgroup, name);
+			ovfd = open (name, O_WRONLY | O_APPEND | O_CREAT, 0664);
+		}
+		if (ovfd < 0)
+			return;
+		fcntl (ovfd, F_SETFD, 1);       /* close on exec */
+	}
+	write (ovfd, line, strlen (line));
+}
+
+/*
+ * Добавление поля к строке обзора.  Табуляции и переводы
+ * строк заменяются пробелами, длина ограничивается OVFIELD.
+ */
+
+static char *overfield (p, val, sep)
+register char *p, *val;
+{
+	register int i;
+
+	if (val)
+		for (i=0; *val && i<OVFIELD; ++val, ++i)
+			*p++ = (*val=='\t' || *val=='\n') ? ' ' : *val;
+	*p++ = sep;
+	*p = 0;
+	return (p);
+}
+
+/*
+ * Просмотр заголовка статьи n из файла filename.
+ * Строка обзора кладется в line [OVLINE].
+ * Возвращает 0, если статьи нет.
+ */
+
+int overscan (filename, n, line)
+char *filename, *line;
+long n;
+{
+	register char *p, *from;
+	struct stat st;
+	FILE *fd;
+	long body;
+
+	fd = fopen (filename, "r");
+	if (! fd)
+		return (0);     /* article is already expired */
+	scanheader (fd);
+	body = ftell (fd);
+	if (fstat (fileno (fd), &st) < 0)
+		st.st_size = 0;
+
+	if (h_from)
+		from = h_from;
+	else if (h_reply_to)
+		from = h_reply_to;
+	else if (h_resent_from)
+		from = h_resent_from;
+	else
+		from = h_sender;
+
+	sprintf (line, "%ld\t%ld\t%ld\t", n, (long) st.st_size, body);
+	p = line + strlen (line);
+	p = overfield (p, h_message_id, '\t');
+	p = overfield (p, from, '\t');
+	p = overfield (p, h_date, '\t');
+	p = overfield (p, h_subject, '\n');
+
+	freeheader ();
+	fclose (fd);
+	return (1);
+}
+
+/*
+ * Добавление строки обзора группы gname (в память и в файл).
+ * Возвращает запись или 0, если строка испорчена.
+ */
+
+struct overview *overput (gname, line)
+char *gname, *line;
+{
+	register struct overview *ov;
+
+	overload (gname);
+	ov = overparse (line);
+	if (! ov)
+		return (0);
+	if (! overstore (ov)) {
+		error ("out of memory in overput");
+		free ((char *) ov);
+		return (0);
+	}
+	overappend (line);
+	return (ov);
+}
+
+/*
+ * Запись обзора статьи n группы gname.  Если статьи
+ * нет в обзоре, просматриваем ее и дописываем в обзор.
+ * Возвращает 0, если статьи нет.
+ */
+
+struct overview *overget (gname, n)
+char *gname;
+long n;
+{
+	char filename [512], line [OVLINE];
+	register char *p, *s;
+
+	overload (gname);
+	if (n >= ovbase && n < ovbase + ovlen && ovtab [n - ovbase])
+		return (ovtab [n - ovbase]);
+
+	strcpy (filename, NEWSSPOOLDIR);
+	p = filename + strlen (filename);
+	*p++ = '/';
+	for (s=gname; *s; ++s)
+		*p++ = *s=='.' ? '/' : *s;
+	sprintf (p, "/%ld", n);
+
+	if (! overscan (filename, n, line))
+		return (0);
+	return (overput (gname, line));
+}
+
+/*
+ * Удаление из обзора группы статей с номерами меньше first
+ * (истекших).  Файл переписывается, только если что-то удалено.
+ */
+
+void overexpire (gname, first)
+char *gname;
+long first;
+{
+	register struct overview *ov;
+	char name [512], tmp [512];
+	FILE *fd;
+	long i, n;
+
+	overload (gname);
+	n = 0;
+	for (i=0; i<ovlen && ovbase+i<first; ++i)
+		if (ovtab [i]) {
+			free ((char *) ovtab [i]);
+			ovtab [i] = 0;
+			++n;
+		}
+	if (! n)
+		return;
+	if (ovfd >= 0)
+		close (ovfd);
+	ovfd = -1;
+	overname (gname, name);
+	sprintf (tmp, "%s#", name);
+	fd = fopen (tmp, "w");
+	if (! fd)
+		return;
+	for (i=0; i<ovlen; ++i) {
+		ov = ovtab [i];
+		if (ov)
+			fprintf (fd, "%ld\t%ld\t%ld\t%s\t%s\t%s\t%s\n",
+				ov->num, ov->size, ov->body, ov->msgid,
+				ov->from, ov->date, ov->subject);
+	}
+	if (fclose (fd) == EOF || rename (tmp, name) < 0)
+		unlink (tmp);
+}
@@ -0,0 +1,42 @@
+/*
+ * Обзор статей группы: кэш заголовков.
+ *
+ * Для каждой группы в каталоге SERVDIR/over хранится файл
+ * с именем группы, по строке на статью:
+ *
+ *      номер  размер  смещение тела  message-id  from  date  subject
+ *
+ * Поля разделены табуляцией.  Строки дописываются в конец
+ * по мере прихода статей (newnews) или при первом обращении
+ * к статье (команда INDEX), так что спул читается один раз.
+ * Обзор - только кэш: если строка потерялась, статья будет
+ * просмотрена заново.
+ */
+
+/*
+ * struct overview *overget (char *gname, long n)
+ *
+ * struct overview *overput (char *gname, char *line)
+ *
+ * int overscan (char *filename, long n, char *line)
+ *
+ * void overexpire (char *gname, long first)
+ */
+
+# define OVLINE         1200            /* макс. длина строки обзора */
+# define OVFIELD        255             /* макс. длина поля заголовка */
+
+struct overview {
+	long num;                       /* номер статьи */
+	long size;                      /* размер статьи */
+	long body;                      /* смещение тела статьи */
+	char *msgid;                    /* Message-ID */
+	char *from;                     /* адрес отправителя */
+	char *date;                     /* Date */
+	char *subject;                  /* Subject */
+};
+
+extern struct overview *overget ();
+extern struct overview *overput ();
+extern int overscan ();
+extern void overexpire ();
@@ -399,6 +399,21 @@ r:      result = groupssync_1 (voidarg, server);
 		BADCALL ("groupssync");
 }
 
+/*
+ * Индекс базы ведет rgroupd, имена приходят в буферах RPC.
+ */
+int groupsindexed ()
+{
+	return (0);
+}
+
+/*
+ * Индекса на стороне клиента нет, выключать нечего.
+ */
+void groupsnoindex ()
+{
+}
+
 void setuserflags (tag, flags)
 long tag, flags;
 {
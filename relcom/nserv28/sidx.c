@@ -0,0 +1,306 @@
+/*
+ * Индекс базы данных подписки, отображаемый в память.
+ *
+ * Формат файла:
+ *      struct sidx_head                заголовок
+ *      struct sidx_rec [nrec]          записи о группах, затем о пользователях
+ *      long [tabsize]                  хэш-таблица по тегу
+ *      long [tabsize]                  хэш-таблица по имени
+ *      struct subscrtab [nsubscr]      таблицы подписки групп, затем
+ *                                      таблицы подписки пользователей
+ *      char [namesize]                 имена, через нулевой байт
+ *
+ * Хэш-таблицы с открытой адресацией и линейным опробованием
+ * содержат номер записи плюс один, ноль - пустая ячейка.
+ * Таблицы заполнены не больше, чем наполовину.
+ */
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <fcntl.h>
+# include "groups.h"
+# include "sidx.h"
+
+/*
+ * Хэш-функция тега.  Номер в теге случайный,
+ * но перемешать биты все равно не мешает.
+ */
+# define TAGHASH(t)     ((unsigned long) (t) * 1103515245L >> 8)
+
+extern char *malloc (), *calloc (), *strcpy (), *strcat ();
+extern void free ();
+extern long lseek ();
+
+/*
+ * Хэш-функция имени (из SDBM).
+ */
+
+static unsigned long namehash (p)
+register char *p;
+{
+	register unsigned long v;
+
+	v = 0;
+	while (*p)
+		v = (unsigned char) *p++ + 65599 * v;
+	return (v);
+}
+
+/*
+ * Длина файла индекса по заголовку.
+ */
+
+static long sidx_size (h)
+register struct sidx_head *h;
+{
+	return (sizeof (struct sidx_head) +
+		(h->ngroups + h->nusers) * sizeof (struct sidx_rec) +
+		2 * h->tabsize * sizeof (long) +
+		h->nsubscr * sizeof (struct subscrtab) +
+		h->namesize);
+}
+
+/*
+ * Запись куска памяти в файл.
+ * Возвращает 1, если все записано.
+ */
+
+static int sidx_put (fd, p, n)
+char *p;
+long n;
+{
+	return (n == 0 || write (fd, p, n) == n);
+}
+
+/*
+ * Открытие и отображение индекса.
+ * Если файла нет или он испорчен, возвращает 0.
+ * Флаг dirty и штамп проверяет вызывающий.
+ */
+
+SIDX *sidx_open (name)
+char *name;
+{
+	struct sidx_head h;
+	struct stat st;
+	register SIDX *ix;
+	char *base;
+	int fd;
+
+	fd = open (name, O_RDWR);
+	if (fd < 0)
+		return (0);
+	if (fstat (fd, &st) < 0 ||
+	    read (fd, (char *) &h, sizeof (h)) != sizeof (h) ||
+	    h.magic != SIDX_MAGIC || h.tabsize <= h.ngroups + h.nusers ||
+	    (h.tabsize & (h.tabsize - 1)) || sidx_size (&h) != st.st_size) {
+		close (fd);
+		return (0);
+	}
+	base = mmap ((char *) 0, st.st_size, PROT_READ, MAP_SHARED, fd, 0L);
+	if (base == (char *) -1) {
+		close (fd);
+		return (0);
+	}
+	ix = (SIDX *) malloc (sizeof (SIDX));
+	if (! ix) {
+		munmap (base, st.st_size);
+		close (fd);
+		return (0);
+	}
+	fcntl (fd, F_SETFD, 1);         /* close on exec */
+	ix->fd = fd;
+	ix->dirty = h.dirty != 0;
+	ix->base = base;
+	ix->size = st.st_size;
+	ix->head = (struct sidx_head *) base;
+	ix->rec = (struct sidx_rec *) (ix->head + 1);
+	ix->tagtab = (long *) (ix->rec + h.ngroups + h.nusers);
+	ix->nametab = ix->tagtab + h.tabsize;
+	ix->subscr = (struct subscrtab *) (ix->nametab + h.tabsize);
+	ix->names = (char *) (ix->subscr + h.nsubscr);
+	return (ix);
+}
+
+void sidx_close (ix)
+register SIDX *ix;
+{
+	munmap (ix->base, ix->size);
+	close (ix->fd);
+	free ((char *) ix);
+}
+
+/*
+ * Поиск записи по тегу (без флагов).
+ */
+
+struct sidx_rec *sidx_tag (ix, tag)
+register SIDX *ix;
+long tag;
+{
+	register unsigned long h, mask;
+	register struct sidx_rec *r;
+
+	mask = ix->head->tabsize - 1;
+	for (h=TAGHASH(tag)&mask; ix->tagtab[h]; h=(h+1)&mask) {
+		r = ix->rec + ix->tagtab[h] - 1;
+		if (r->tag == tag)
+			return (r);
+	}
+	return (0);
+}
+
+/*
+ * Поиск записи о группе (user == 0) или пользователе по имени.
+ */
+
+struct sidx_rec *sidx_name (ix, user, name)
+register SIDX *ix;
+char *name;
+{
+	register unsigned long h, mask;
+	register struct sidx_rec *r;
+
+	mask = ix->head->tabsize - 1;
+	for (h=namehash(name)&mask; ix->nametab[h]; h=(h+1)&mask) {
+		r = ix->rec + ix->nametab[h] - 1;
+		if (SIDX_USER (ix, r) == (user != 0) &&
+		    ! strcmp (SIDX_NAME (ix, r), name))
+			return (r);
+	}
+	return (0);
+}
+
+/*
+ * Установка флага dirty перед первым изменением.
+ * Флаг сбрасывается на диск до того, как изменится база,
+ * так что после сбоя индекс не будет принят за правильный.
+ */
+
+void sidx_touch (ix)
+register SIDX *ix;
+{
+	long one;
+
+	if (ix->dirty)
+		return;
+	one = 1;
+	lseek (ix->fd, (long) ((char *) &ix->head->dirty - ix->base), 0);
+	write (ix->fd, (char *) &one, sizeof (one));
+	fsync (ix->fd);
+	ix->dirty = 1;
+}
+
+/*
+ * Изменение значения в записи.  Пишем через дескриптор,
+ * отображение увидит новое значение само.
+ */
+
+void sidx_setval (ix, r, val)
+register SIDX *ix;
+struct sidx_rec *r;
+long val;
+{
+	sidx_touch (ix);
+	lseek (ix->fd, (long) ((char *) &r->val - ix->base), 0);
+	write (ix->fd, (char *) &val, sizeof (val));
+}
+
+/*
+ * Индекс соответствует базе: запоминаем штамп файлов
+ * базы и сбрасываем флаг dirty.
+ */
+
+void sidx_seal (ix, stamp)
+register SIDX *ix;
+long *stamp;
+{
+	struct sidx_head h;
+	int i;
+
+	h = *ix->head;
+	for (i=0; i<SIDX_STAMP; ++i)
+		h.stamp [i] = stamp [i];
+	h.dirty = 0;
+	fsync (ix->fd);
+	lseek (ix->fd, 0L, 0);
+	write (ix->fd, (char *) &h, sizeof (h));
+	fsync (ix->fd);
+	ix->dirty = 0;
+}
+
+/*
+ * Запись нового индекса.  Хэш-таблицы строятся здесь,
+ * остальное готовит вызывающий.  Файл пишется под именем
+ * name# и затем переименовывается, так что старый индекс
+ * заменяется целиком.  Новый индекс имеет флаг dirty,
+ * его сбрасывает sidx_seal().  Возвращает 1, если все в порядке.
+ */
+
+int sidx_write (name, rec, ngroups, nusers, subscr, nsubscr, names, namesize)
+char *name, *names;
+struct sidx_rec *rec;
+long ngroups, nusers, nsubscr, namesize;
+struct subscrtab *subscr;
+{
+	struct sidx_head h;
+	long *tagtab, *nametab, nrec, i;
+	unsigned long mask, k;
+	char *newname;
+	int fd, ok;
+
+	nrec = ngroups + nusers;
+	h.magic = SIDX_MAGIC;
+	h.dirty = 1;
+	for (i=0; i<SIDX_STAMP; ++i)
+		h.stamp [i] = 0;
+	h.ngroups = ngroups;
+	h.nusers = nusers;
+	for (h.tabsize=64; h.tabsize<2*nrec; h.tabsize*=2);
+	h.nsubscr = nsubscr;
+	h.namesize = namesize;
+
+	tagtab = (long *) calloc (h.tabsize, sizeof (long));
+	nametab = (long *) calloc (h.tabsize, sizeof (long));
+	newname = malloc (strlen (name) + 2);
+	if (! tagtab || ! nametab || ! newname) {
+		ok = 0;
+		goto ret;
+	}
+	mask = h.tabsize - 1;
+	for (i=0; i<nrec; ++i) {
+		for (k=TAGHASH(rec[i].tag)&mask; tagtab[k]; k=(k+1)&mask);
+		tagtab [k] = i + 1;
+		for (k=namehash(names+rec[i].name)&mask; nametab[k]; k=(k+1)&mask);
+		nametab [k] = i + 1;
+	}
+
+	strcpy (newname, name);
+	strcat (newname, "#");
+	fd = open (newname, O_WRONLY | O_CREAT | O_TRUNC, 0664);
+	if (fd < 0) {
+		ok = 0;
+		goto ret;
+	}
+	ok = sidx_put (fd, (char *) &h, (long) sizeof (h)) &&
+		sidx_put (fd, (char *) rec, nrec * sizeof (struct sidx_rec)) &&
+		sidx_put (fd, (char *) tagtab, h.tabsize * sizeof (long)) &&
+		sidx_put (fd, (char *) nametab, h.tabsize * sizeof (long)) &&
+		sidx_put (fd, (char *) subscr,
+			nsubscr * sizeof (struct subscrtab)) &&
+		sidx_put (fd, names, namesize);
+	if (close (fd) < 0)
+		ok = 0;
+	if (ok)
+		ok = rename (newname, name) == 0;
+	if (! ok)
+		unlink (newname);
+ret:
+	if (tagtab)
+		free ((char *) tagtab);
+	if (nametab)
+		free ((char *) nametab);
+	if (newname)
+		free (newname);
+	return (ok);
+}
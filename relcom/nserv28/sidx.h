@@ -0,0 +1,88 @@
+/*
+ * Индекс базы данных подписки, отображаемый в память.
+ *
+ * Индекс строится по базе groups и хранится рядом с ней
+ * в файле groups.idx.  Он содержит записи о всех группах
+ * и пользователях, две хэш-таблицы с открытой адресацией
+ * (по тегу и по имени) и таблицы подписки в двух видах:
+ * группа -> пользователи и пользователь -> группы.
+ * Таблица подписки каждой группы и каждого пользователя
+ * лежит в файле непрерывным куском, поэтому выдается
+ * прямо из отображения, без выборки и разбора записей DBM.
+ *
+ * Файл отображается только на чтение.  Изменения (номер
+ * последней статьи, флаги пользователя) пишутся в файл
+ * через дескриптор.  Пока индекс может расходиться с базой,
+ * в заголовке стоит флаг dirty, и такой индекс не используется.
+ */
+
+/*
+ * SIDX *sidx_open (char *name)
+ *
+ * void sidx_close (SIDX *ix)
+ *
+ * int sidx_write (char *name, struct sidx_rec *rec, long ngroups,
+ *      long nusers, struct subscrtab *subscr, long nsubscr,
+ *      char *names, long namesize)
+ *
+ * struct sidx_rec *sidx_tag (SIDX *ix, long tag)
+ *
+ * struct sidx_rec *sidx_name (SIDX *ix, int user, char *name)
+ *
+ * void sidx_setval (SIDX *ix, struct sidx_rec *r, long val)
+ *
+ * void sidx_touch (SIDX *ix)
+ *
+ * void sidx_seal (SIDX *ix, long *stamp)
+ */
+
+# define SIDX_MAGIC     0x53494478L     /* "SIDx" */
+# define SIDX_STAMP     6               /* длина штампа файлов базы */
+
+struct sidx_head {
+	long magic;                     /* SIDX_MAGIC */
+	long dirty;                     /* индекс может расходиться с базой */
+	long stamp [SIDX_STAMP];        /* состояние файлов базы */
+	long ngroups;                   /* количество групп */
+	long nusers;                    /* количество пользователей */
+	long tabsize;                   /* длина хэш-таблиц, степень двойки */
+	long nsubscr;                   /* длина таблицы подписки */
+	long namesize;                  /* длина таблицы имен */
+};
+
+struct sidx_rec {
+	long tag;                       /* тег группы или пользователя */
+	long val;                       /* номер посл. статьи или флаги */
+	long name;                      /* смещение имени в таблице имен */
+	long subscr;                    /* начало куска таблицы подписки */
+	long nsubscr;                   /* длина куска таблицы подписки */
+};
+
+typedef struct {
+	int fd;                         /* дескриптор файла индекса */
+	int dirty;                      /* флаг dirty уже записан */
+	char *base;                     /* адрес отображения */
+	long size;                      /* длина файла */
+	struct sidx_head *head;         /* заголовок */
+	struct sidx_rec *rec;           /* записи: группы, затем пользователи */
+	long *tagtab;                   /* хэш по тегу: номер записи + 1 */
+	long *nametab;                  /* хэш по имени: номер записи + 1 */
+	struct subscrtab *subscr;       /* таблица подписки */
+	char *names;                    /* таблица имен */
+} SIDX;
+
+/* Имя и таблица подписки записи */
+# define SIDX_NAME(ix,r)        ((ix)->names + (r)->name)
+# define SIDX_SUBSCR(ix,r)      ((ix)->subscr + (r)->subscr)
+
+/* Запись является записью о пользователе */
+# define SIDX_USER(ix,r)        ((r) - (ix)->rec >= (ix)->head->ngroups)
+
+extern SIDX             *sidx_open ();
+extern void             sidx_close ();
+extern int              sidx_write ();
+extern struct sidx_rec  *sidx_tag ();
+extern struct sidx_rec  *sidx_name ();
+extern void             sidx_setval ();
+extern void             sidx_touch ();
+extern void             sidx_seal ();